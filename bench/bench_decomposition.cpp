@@ -0,0 +1,174 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <vector>
+
+#include "bench/benchmark.h"
+#include "ml/batch.h"
+#include "ml/cholesky.h"
+#include "ml/eigen.h"
+#include "ml/lu.h"
+#include "ml/qr.h"
+#include "ml/svd.h"
+
+// Factorizations of size x size matrices. Flops are the customary
+// operation counts of each algorithm.
+
+namespace {
+
+const int kMinSize = 16;
+const int kMaxSize = 2048;
+
+// Diagonally dominant, so every factorization succeeds.
+Matrix dominantMatrix(int size) {
+    Matrix mat(size, size);
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            mat.at(i, j) = ((i * 37 + j * 11) % 19 - 9) / 9.0;
+        }
+        mat.at(i, i) += size;
+    }
+    return mat;
+}
+
+void luFactor(bench::State* state) {
+    int n = state->size();
+    Matrix a = dominantMatrix(n);
+    while (state->keepRunning()) {
+        Lu lu(a);
+        bench::doNotOptimize(lu);
+    }
+    state->setFlops(2.0 / 3.0 * n * n * n);
+}
+
+void luSolve(bench::State* state) {
+    int n = state->size();
+    Lu lu(dominantMatrix(n));
+    Vector b(n, 1.0);
+    while (state->keepRunning()) {
+        Vector x = b;
+        lu.solveInPlace(&x);
+        bench::doNotOptimize(x);
+    }
+    state->setFlops(2.0 * n * n);
+    state->setBytes(sizeof(double) * n * n);
+}
+
+void choleskyFactor(bench::State* state) {
+    int n = state->size();
+    Matrix a = dominantMatrix(n);
+    Matrix spd = a + Matrix(a.transposed());
+    while (state->keepRunning()) {
+        Cholesky cholesky(spd);
+        bench::doNotOptimize(cholesky);
+    }
+    state->setFlops(1.0 / 3.0 * n * n * n);
+}
+
+// size systems of 8 x 8, one right-hand side each.
+void choleskyBatch(bench::State* state) {
+    const int kDims = 8;
+    int count = state->size();
+    Matrix one = dominantMatrix(kDims);
+    Matrix spd = one + Matrix(one.transposed());
+    std::vector<double> a, b(static_cast<size_t>(count) * kDims, 1.0);
+    for (int i = 0; i < count; i++) {
+        a.insert(a.end(), spd.ptr(), spd.ptr() + spd.size());
+    }
+    std::vector<double> work;
+    while (state->keepRunning()) {
+        work = a;
+        choleskySolveBatch(count, kDims, 1, work.data(), b.data());
+        bench::doNotOptimize(b);
+    }
+    state->setFlops((1.0 / 3.0 * kDims + 2.0) * kDims * kDims * count);
+}
+
+// size systems of 8 x 8, one right-hand side each, solved by LU.
+void luBatch(bench::State* state) {
+    const int kDims = 8;
+    int count = state->size();
+    Matrix one = dominantMatrix(kDims);
+    MatrixBatch a(count, kDims, kDims);
+    for (int i = 0; i < count; i++) {
+        a.set(i, one);
+    }
+    MatrixBatch b(count, 1, kDims), x(count, 1, kDims);
+    while (state->keepRunning()) {
+        solveBatch(a, b, &x);
+        bench::doNotOptimize(x);
+    }
+    state->setFlops((2.0 / 3.0 * kDims + 2.0) * kDims * kDims * count);
+}
+
+void qrFactor(bench::State* state) {
+    int n = state->size();
+    Matrix a = dominantMatrix(n);
+    while (state->keepRunning()) {
+        Qr qr(a);
+        bench::doNotOptimize(qr);
+    }
+    state->setFlops(4.0 / 3.0 * n * n * n);
+}
+
+// Least squares on a 64n x n system, where lstsq picks TSQR.
+void tallLstsq(bench::State* state) {
+    int n = state->size();
+    Matrix a(n, 64 * n);
+    for (int i = 0; i < a.rows(); i++) {
+        for (int j = 0; j < n; j++) {
+            a.at(i, j) = ((i * 31 + j * 17) % 97) / 97.0 + (i == j ? n : 0);
+        }
+    }
+    Vector b(a.rows(), 1.0);
+    while (state->keepRunning()) {
+        Vector x = lstsq(a, b);
+        bench::doNotOptimize(x);
+    }
+    state->setFlops(2.0 * n * n * (a.rows() - n / 3.0));
+}
+
+void symmetricEigen(bench::State* state) {
+    int n = state->size();
+    Matrix a = dominantMatrix(n);
+    Matrix symmetric = a + Matrix(a.transposed());
+    while (state->keepRunning()) {
+        SymmetricEigen eigen(symmetric);
+        bench::doNotOptimize(eigen);
+    }
+    state->setFlops(9.0 * n * n * n);
+}
+
+void thinSvd(bench::State* state) {
+    int n = state->size();
+    Matrix a = dominantMatrix(n);
+    while (state->keepRunning()) {
+        Svd svd(a);
+        bench::doNotOptimize(svd);
+    }
+    state->setFlops(22.0 * n * n * n);
+}
+
+// The top 16 singular triplets, two power iterations.
+void randomizedSvdTop16(bench::State* state) {
+    int n = state->size();
+    Matrix a = dominantMatrix(n);
+    const int kTop = 16;
+    while (state->keepRunning()) {
+        Svd svd = randomizedSvd(a, kTop);
+        bench::doNotOptimize(svd);
+    }
+    state->setFlops(12.0 * n * n * (kTop + 10));
+}
+
+}  // namespace
+
+BENCHMARK(luFactor)->range(kMinSize, kMaxSize);
+BENCHMARK(luSolve)->range(kMinSize, kMaxSize);
+BENCHMARK(choleskyFactor)->range(kMinSize, kMaxSize);
+BENCHMARK(qrFactor)->range(kMinSize, kMaxSize);
+BENCHMARK(tallLstsq)->range(kMinSize, 256);
+BENCHMARK(symmetricEigen)->range(kMinSize, kMaxSize);
+BENCHMARK(thinSvd)->range(kMinSize, 1024);
+BENCHMARK(randomizedSvdTop16)->range(64, kMaxSize);
+BENCHMARK(choleskyBatch)->range(kMinSize, 65536);
+BENCHMARK(luBatch)->range(kMinSize, 65536);
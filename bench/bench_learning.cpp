@@ -0,0 +1,163 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <math.h>
+
+#include <vector>
+
+#include "bench/benchmark.h"
+#include "ml/kmeans.h"
+#include "ml/logistic.h"
+#include "ml/regression.h"
+
+// Training and prediction on size samples of kFeatures features. Flops
+// are the multiply-adds of the underlying kernels.
+
+namespace {
+
+const int kMinSize = 1024;
+const int kMaxSize = 1024 * 1024;
+const int kFeatures = 64;
+
+Matrix samples(int size) {
+    Matrix x(kFeatures, size);
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < kFeatures; j++) {
+            x.at(i, j) = sin(i * (j + 1) * 0.37 + j);
+        }
+    }
+    return x;
+}
+
+Vector targets(const Matrix& x) {
+    Vector y(x.rows());
+    for (int i = 0; i < x.rows(); i++) {
+        y.at(i) = x.at(i, 0) - 2 * x.at(i, kFeatures - 1) + 1;
+    }
+    return y;
+}
+
+void ridgeFit(bench::State* state) {
+    int n = state->size();
+    Matrix x = samples(n);
+    Vector y = targets(x);
+    while (state->keepRunning()) {
+        LinearRegression model = fitLinearRegression(x, y, 1e-3);
+        bench::doNotOptimize(model);
+    }
+    state->setFlops(2.0 * n * kFeatures * kFeatures);
+}
+
+// One epoch of mini-batch SGD.
+void sgdEpoch(bench::State* state) {
+    int n = state->size();
+    Matrix x = samples(n);
+    Vector y = targets(x);
+    SgdRegression sgd(kFeatures);
+    while (state->keepRunning()) {
+        sgd.partialFit(x, y);
+        bench::doNotOptimize(sgd);
+    }
+    state->setFlops(4.0 * n * kFeatures);
+    state->setBytes(sizeof(double) * n * (kFeatures + 1.0));
+}
+
+void linearPredict(bench::State* state) {
+    int n = state->size();
+    Matrix x = samples(n);
+    LinearRegression model = fitLinearRegression(x, targets(x));
+    Vector y(n);
+    while (state->keepRunning()) {
+        model.predict(x, &y);
+        bench::doNotOptimize(y);
+    }
+    state->setFlops(2.0 * n * kFeatures);
+    state->setBytes(sizeof(double) * n * (kFeatures + 1.0));
+}
+
+// Labels of classes classes from the first features of each sample.
+std::vector<int> classLabels(const Matrix& x, int classes) {
+    std::vector<int> labels(x.rows());
+    for (int i = 0; i < x.rows(); i++) {
+        labels[i] = static_cast<int>((x.at(i, 0) + 1) * classes / 2.001);
+    }
+    return labels;
+}
+
+// Ten L-BFGS iterations; flops count one pass per iteration.
+void logisticFit(bench::State* state, int classes) {
+    int n = state->size();
+    Matrix x = samples(n);
+    std::vector<int> labels = classLabels(x, classes);
+    LogisticOptions options;
+    options.lbfgs.maxIterations = 10;
+    options.lbfgs.tolerance = 0;
+    while (state->keepRunning()) {
+        LogisticRegression model = fitLogisticRegression(x, labels, classes,
+                                                         options);
+        bench::doNotOptimize(model);
+    }
+    int k = classes == 2 ? 1 : classes;
+    state->setFlops(10 * 4.0 * n * kFeatures * k);
+}
+
+void binaryLogisticFit(bench::State* state) {
+    logisticFit(state, 2);
+}
+
+void softmaxLogisticFit(bench::State* state) {
+    logisticFit(state, 8);
+}
+
+const int kClusters = 16;
+
+// Ten k-means iterations; flops count a full assignment for each.
+void kmeansFit(bench::State* state, KMeansBounds bounds) {
+    int n = state->size();
+    Matrix x = samples(n);
+    KMeansOptions options;
+    options.maxIterations = 10;
+    options.tolerance = 0;
+    options.bounds = bounds;
+    while (state->keepRunning()) {
+        KMeans kmeans(x, kClusters, options);
+        bench::doNotOptimize(kmeans);
+    }
+    state->setFlops(10 * 2.0 * n * kFeatures * kClusters);
+}
+
+void lloydFit(bench::State* state) {
+    kmeansFit(state, kKMeansLloyd);
+}
+
+void hamerlyFit(bench::State* state) {
+    kmeansFit(state, kKMeansHamerly);
+}
+
+void elkanFit(bench::State* state) {
+    kmeansFit(state, kKMeansElkan);
+}
+
+// One mini-batch k-means step over all samples.
+void miniBatchKMeans(bench::State* state) {
+    int n = state->size();
+    Matrix x = samples(n);
+    MiniBatchKMeans kmeans(kClusters, kFeatures);
+    while (state->keepRunning()) {
+        kmeans.partialFit(x);
+        bench::doNotOptimize(kmeans);
+    }
+    state->setFlops(2.0 * n * kFeatures * (kClusters + 1));
+    state->setBytes(sizeof(double) * n * kFeatures);
+}
+
+}  // namespace
+
+BENCHMARK(ridgeFit)->range(kMinSize, kMaxSize);
+BENCHMARK(sgdEpoch)->range(kMinSize, kMaxSize);
+BENCHMARK(linearPredict)->range(kMinSize, kMaxSize);
+BENCHMARK(binaryLogisticFit)->range(kMinSize, kMaxSize);
+BENCHMARK(softmaxLogisticFit)->range(kMinSize, kMaxSize);
+BENCHMARK(lloydFit)->range(kMinSize, kMaxSize);
+BENCHMARK(hamerlyFit)->range(kMinSize, kMaxSize);
+BENCHMARK(elkanFit)->range(kMinSize, kMaxSize);
+BENCHMARK(miniBatchKMeans)->range(kMinSize, kMaxSize);
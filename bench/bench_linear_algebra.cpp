@@ -0,0 +1,337 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "bench/benchmark.h"
+#include "ml/arena.h"
+#include "ml/batch.h"
+#include "ml/fixed.h"
+#include "ml/linear_algebra.h"
+
+// Vector benchmarks use size as the dimension, matrix benchmarks run on
+// size x size matrices. Bytes count the compulsory traffic only: every
+// operand read once and the result written once.
+
+namespace {
+
+const int kMinSize = 4;
+const int kMaxSize = 8192;
+
+Vector filledVector(int dims, double value) {
+    Vector vec(dims);
+    for (int i = 0; i < dims; i++) {
+        vec.at(i) = value + i % 7;
+    }
+    return vec;
+}
+
+Matrix filledMatrix(int size, double value) {
+    Matrix mat(size, size);
+    double* data = mat.ptr();
+    for (size_t i = 0; i < mat.size(); i++) {
+        data[i] = value + i % 7;
+    }
+    return mat;
+}
+
+void vectorAdd(bench::State* state) {
+    int n = state->size();
+    Vector x = filledVector(n, 1.0), y = filledVector(n, 2.0), z(n);
+    while (state->keepRunning()) {
+        z = x + y;
+        bench::doNotOptimize(z);
+    }
+    state->setFlops(n);
+    state->setBytes(3.0 * sizeof(double) * n);
+}
+
+void vectorAxpy(bench::State* state) {
+    int n = state->size();
+    Vector x = filledVector(n, 1.0), y = filledVector(n, 2.0), z(n);
+    while (state->keepRunning()) {
+        z = 0.5 * x + y;
+        bench::doNotOptimize(z);
+    }
+    state->setFlops(2.0 * n);
+    state->setBytes(3.0 * sizeof(double) * n);
+}
+
+void vectorScale(bench::State* state) {
+    int n = state->size();
+    Vector x = filledVector(n, 1.0);
+    while (state->keepRunning()) {
+        x *= 1.0000001;
+        bench::doNotOptimize(x);
+    }
+    state->setFlops(n);
+    state->setBytes(2.0 * sizeof(double) * n);
+}
+
+void vectorDot(bench::State* state) {
+    int n = state->size();
+    Vector x = filledVector(n, 1.0), y = filledVector(n, 2.0);
+    while (state->keepRunning()) {
+        double result = dot(x, y);
+        bench::doNotOptimize(result);
+    }
+    state->setFlops(2.0 * n);
+    state->setBytes(2.0 * sizeof(double) * n);
+}
+
+void vectorLength(bench::State* state) {
+    int n = state->size();
+    Vector x = filledVector(n, 1.0);
+    while (state->keepRunning()) {
+        double result = x.length();
+        bench::doNotOptimize(result);
+    }
+    state->setFlops(2.0 * n);
+    state->setBytes(1.0 * sizeof(double) * n);
+}
+
+void matrixAdd(bench::State* state) {
+    int n = state->size();
+    Matrix a = filledMatrix(n, 1.0), b = filledMatrix(n, 2.0), c(n, n);
+    while (state->keepRunning()) {
+        c = a + b;
+        bench::doNotOptimize(c);
+    }
+    state->setFlops(1.0 * n * n);
+    state->setBytes(3.0 * sizeof(double) * n * n);
+}
+
+void matrixSub(bench::State* state) {
+    int n = state->size();
+    Matrix a = filledMatrix(n, 1.0), b = filledMatrix(n, 2.0), c(n, n);
+    while (state->keepRunning()) {
+        c = a - b;
+        bench::doNotOptimize(c);
+    }
+    state->setFlops(1.0 * n * n);
+    state->setBytes(3.0 * sizeof(double) * n * n);
+}
+
+void matrixScalar(bench::State* state) {
+    int n = state->size();
+    Matrix a = filledMatrix(n, 1.0), c(n, n);
+    while (state->keepRunning()) {
+        c = 2.0 * a;
+        bench::doNotOptimize(c);
+    }
+    state->setFlops(1.0 * n * n);
+    state->setBytes(2.0 * sizeof(double) * n * n);
+}
+
+// Every iteration builds a new result, so the allocator is on the path.
+void matrixTemporary(bench::State* state) {
+    int n = state->size();
+    Matrix a = filledMatrix(n, 1.0), b = filledMatrix(n, 2.0);
+    while (state->keepRunning()) {
+        Matrix c = a + b;
+        bench::doNotOptimize(c);
+    }
+    state->setFlops(1.0 * n * n);
+    state->setBytes(3.0 * sizeof(double) * n * n);
+}
+
+void matrixTemporaryArena(bench::State* state) {
+    int n = state->size();
+    Matrix a = filledMatrix(n, 1.0), b = filledMatrix(n, 2.0);
+    Arena arena;
+    while (state->keepRunning()) {
+        {
+            AllocatorScope scope(&arena);
+            Matrix c = a + b;
+            bench::doNotOptimize(c);
+        }
+        arena.reset();
+    }
+    state->setFlops(1.0 * n * n);
+    state->setBytes(3.0 * sizeof(double) * n * n);
+}
+
+void matrixMultiply(bench::State* state) {
+    int n = state->size();
+    Matrix a = filledMatrix(n, 1.0), b = filledMatrix(n, 2.0), c(n, n);
+    while (state->keepRunning()) {
+        c = a * b;
+        bench::doNotOptimize(c);
+    }
+    state->setFlops(2.0 * n * n * n);
+    state->setBytes(3.0 * sizeof(double) * n * n);
+}
+
+void matrixVector(bench::State* state) {
+    int n = state->size();
+    Matrix a = filledMatrix(n, 1.0);
+    Vector x = filledVector(n, 2.0), y(n);
+    while (state->keepRunning()) {
+        multiply(a.view(), x, &y);
+        bench::doNotOptimize(y);
+    }
+    state->setFlops(2.0 * n * n);
+    state->setBytes(sizeof(double) * (1.0 * n * n + 2.0 * n));
+}
+
+void matrixTransposedVector(bench::State* state) {
+    int n = state->size();
+    Matrix a = filledMatrix(n, 1.0);
+    Vector x = filledVector(n, 2.0), y(n);
+    while (state->keepRunning()) {
+        multiply(a.transposed(), x, &y);
+        bench::doNotOptimize(y);
+    }
+    state->setFlops(2.0 * n * n);
+    state->setBytes(sizeof(double) * (1.0 * n * n + 2.0 * n));
+}
+
+void floatMatrixVector(bench::State* state) {
+    int n = state->size();
+    FloatMatrix a = elementCast<float>(filledMatrix(n, 1.0));
+    FloatVector x = elementCast<float>(filledVector(n, 2.0)), y(n);
+    while (state->keepRunning()) {
+        multiply(a.view(), x, &y);
+        bench::doNotOptimize(y);
+    }
+    state->setFlops(2.0 * n * n);
+    state->setBytes(sizeof(float) * (1.0 * n * n + 2.0 * n));
+}
+
+void matrixTranspose(bench::State* state) {
+    int n = state->size();
+    Matrix a = filledMatrix(n, 1.0), t(n, n);
+    while (state->keepRunning()) {
+        t = a.transposed();
+        bench::doNotOptimize(t);
+    }
+    state->setBytes(2.0 * sizeof(double) * n * n);
+}
+
+void matrixTransposeInPlace(bench::State* state) {
+    int n = state->size();
+    Matrix a = filledMatrix(n, 1.0);
+    while (state->keepRunning()) {
+        a.transposeInPlace();
+        bench::doNotOptimize(a);
+    }
+    state->setBytes(2.0 * sizeof(double) * n * n);
+}
+
+void floatVectorDot(bench::State* state) {
+    int n = state->size();
+    FloatVector x = elementCast<float>(filledVector(n, 1.0));
+    FloatVector y = elementCast<float>(filledVector(n, 2.0));
+    while (state->keepRunning()) {
+        float result = dot(x, y);
+        bench::doNotOptimize(result);
+    }
+    state->setFlops(2.0 * n);
+    state->setBytes(2.0 * sizeof(float) * n);
+}
+
+void int8VectorDot(bench::State* state) {
+    int n = state->size();
+    Int8Vector x = elementCast<int8_t>(filledVector(n, 1.0));
+    Int8Vector y = elementCast<int8_t>(filledVector(n, 2.0));
+    while (state->keepRunning()) {
+        int32_t result = dot(x, y);
+        bench::doNotOptimize(result);
+    }
+    state->setFlops(2.0 * n);
+    state->setBytes(2.0 * sizeof(int8_t) * n);
+}
+
+void floatMatrixMultiply(bench::State* state) {
+    int n = state->size();
+    FloatMatrix a = elementCast<float>(filledMatrix(n, 1.0));
+    FloatMatrix b = elementCast<float>(filledMatrix(n, 2.0));
+    FloatMatrix c(n, n);
+    while (state->keepRunning()) {
+        c = a * b;
+        bench::doNotOptimize(c);
+    }
+    state->setFlops(2.0 * n * n * n);
+    state->setBytes(3.0 * sizeof(float) * n * n);
+}
+
+void matrixIdentity(bench::State* state) {
+    int n = state->size();
+    while (state->keepRunning()) {
+        Matrix identity = Matrix::identity(n);
+        bench::doNotOptimize(identity);
+    }
+    state->setBytes(1.0 * sizeof(double) * n * n);
+}
+
+// size products of 4 x 4 matrices, one Matrix or FixedMatrix product
+// at a time and all at once as a batch.
+void smallMatrixMultiply(bench::State* state) {
+    int count = state->size();
+    std::vector<Matrix> a(count, filledMatrix(4, 1.0));
+    std::vector<Matrix> b(count, filledMatrix(4, 2.0));
+    std::vector<Matrix> c(count, Matrix(4, 4));
+    while (state->keepRunning()) {
+        for (int i = 0; i < count; i++) {
+            c[i] = a[i] * b[i];
+        }
+        bench::doNotOptimize(c);
+    }
+    state->setFlops(2.0 * 4 * 4 * 4 * count);
+}
+
+void fixedMatrixMultiply(bench::State* state) {
+    int count = state->size();
+    FixedMatrix<4, 4> one(filledMatrix(4, 1.0)), two(filledMatrix(4, 2.0));
+    std::vector<FixedMatrix<4, 4> > a(count, one), b(count, two), c(count);
+    while (state->keepRunning()) {
+        for (int i = 0; i < count; i++) {
+            c[i] = a[i] * b[i];
+        }
+        bench::doNotOptimize(c);
+    }
+    state->setFlops(2.0 * 4 * 4 * 4 * count);
+    state->setBytes(3.0 * sizeof(double) * 4 * 4 * count);
+}
+
+void batchMatrixMultiply(bench::State* state) {
+    int count = state->size();
+    MatrixBatch a(count, 4, 4), b(count, 4, 4), c(count, 4, 4);
+    for (int i = 0; i < count; i++) {
+        a.set(i, filledMatrix(4, 1.0));
+        b.set(i, filledMatrix(4, 2.0));
+    }
+    while (state->keepRunning()) {
+        multiplyBatch(a, b, &c);
+        bench::doNotOptimize(c);
+    }
+    state->setFlops(2.0 * 4 * 4 * 4 * count);
+    state->setBytes(3.0 * sizeof(double) * 4 * 4 * count);
+}
+
+}  // namespace
+
+BENCHMARK(vectorAdd)->range(kMinSize, kMaxSize);
+BENCHMARK(vectorAxpy)->range(kMinSize, kMaxSize);
+BENCHMARK(vectorScale)->range(kMinSize, kMaxSize);
+BENCHMARK(vectorDot)->range(kMinSize, kMaxSize);
+BENCHMARK(vectorLength)->range(kMinSize, kMaxSize);
+BENCHMARK(matrixAdd)->range(kMinSize, kMaxSize);
+BENCHMARK(matrixSub)->range(kMinSize, kMaxSize);
+BENCHMARK(matrixScalar)->range(kMinSize, kMaxSize);
+BENCHMARK(matrixTemporary)->range(kMinSize, kMaxSize);
+BENCHMARK(matrixTemporaryArena)->range(kMinSize, kMaxSize);
+BENCHMARK(matrixMultiply)->range(kMinSize, kMaxSize);
+BENCHMARK(matrixVector)->range(kMinSize, kMaxSize);
+BENCHMARK(matrixTransposedVector)->range(kMinSize, kMaxSize);
+BENCHMARK(matrixTranspose)->range(kMinSize, kMaxSize);
+BENCHMARK(matrixTransposeInPlace)->range(kMinSize, kMaxSize);
+BENCHMARK(matrixIdentity)->range(kMinSize, kMaxSize);
+BENCHMARK(smallMatrixMultiply)->range(kMinSize, 65536);
+BENCHMARK(fixedMatrixMultiply)->range(kMinSize, 65536);
+BENCHMARK(batchMatrixMultiply)->range(kMinSize, 65536);
+BENCHMARK(floatVectorDot)->range(kMinSize, kMaxSize);
+BENCHMARK(int8VectorDot)->range(kMinSize, kMaxSize);
+BENCHMARK(floatMatrixMultiply)->range(kMinSize, kMaxSize);
+BENCHMARK(floatMatrixVector)->range(kMinSize, kMaxSize);
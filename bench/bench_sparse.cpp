@@ -0,0 +1,70 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "bench/benchmark.h"
+#include "ml/sparse.h"
+
+// size x size sparse matrices with about one element in a hundred set.
+// Flops and bytes count the stored elements only.
+
+namespace {
+
+const int kMinSize = 256;
+const int kMaxSize = 65536;
+const int kDenseCols = 64;
+
+CsrMatrix sparseMatrix(int size) {
+    CooMatrix coo(size, size);
+    int perRow = size / 100 + 1;
+    coo.reserve(static_cast<size_t>(size) * perRow);
+    for (int i = 0; i < size; i++) {
+        for (int k = 0; k < perRow; k++) {
+            coo.add(i, (i * 7919 + k * 104729) % size, 1.0 + k % 3);
+        }
+    }
+    return CsrMatrix(coo);
+}
+
+void csrSpmv(bench::State* state) {
+    int n = state->size();
+    CsrMatrix a = sparseMatrix(n);
+    Vector x(n, 1.0);
+    while (state->keepRunning()) {
+        Vector y = a * x;
+        bench::doNotOptimize(y);
+    }
+    state->setFlops(2.0 * a.nonZeros());
+    state->setBytes((sizeof(double) + sizeof(int)) * a.nonZeros() +
+                    2.0 * sizeof(double) * n);
+}
+
+void csrSpmm(bench::State* state) {
+    int n = state->size();
+    CsrMatrix a = sparseMatrix(n);
+    Matrix b(kDenseCols, n, 1.0);
+    while (state->keepRunning()) {
+        Matrix c = a * b;
+        bench::doNotOptimize(c);
+    }
+    state->setFlops(2.0 * a.nonZeros() * kDenseCols);
+    state->setBytes((sizeof(double) + sizeof(int)) * a.nonZeros() +
+                    2.0 * sizeof(double) * n * kDenseCols);
+}
+
+void cscSpmv(bench::State* state) {
+    int n = state->size();
+    CscMatrix a(sparseMatrix(n));
+    Vector x(n, 1.0);
+    while (state->keepRunning()) {
+        Vector y = a * x;
+        bench::doNotOptimize(y);
+    }
+    state->setFlops(2.0 * a.nonZeros());
+    state->setBytes((sizeof(double) + sizeof(int)) * a.nonZeros() +
+                    2.0 * sizeof(double) * n);
+}
+
+}  // namespace
+
+BENCHMARK(csrSpmv)->range(kMinSize, kMaxSize);
+BENCHMARK(csrSpmm)->range(kMinSize, kMaxSize);
+BENCHMARK(cscSpmv)->range(kMinSize, kMaxSize);
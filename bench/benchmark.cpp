@@ -0,0 +1,238 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "bench/benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include "ml/thread_pool.h"
+#include "src/simd.h"
+
+namespace bench {
+
+namespace {
+
+std::vector<Benchmark*>& registry() {
+    static std::vector<Benchmark*> benchmarks;
+    return benchmarks;
+}
+
+struct Options {
+    Options() : json(false), minTime(0.5), maxSize(0) {}
+
+    bool json;
+    std::string out;
+    std::string filter;
+    double minTime;
+    int maxSize;
+};
+
+struct Result {
+    std::string name;
+    int size;
+    int64_t iterations;
+    double seconds;
+    double flops;
+    double bytes;
+
+    double nanosPerIteration() const { return seconds * 1e9 / iterations; }
+    double gflops() const { return flops * iterations / seconds / 1e9; }
+    double gbytes() const { return bytes * iterations / seconds / 1e9; }
+};
+
+double now() {
+    typedef std::chrono::steady_clock Clock;  // NOLINT(build/c++11)
+    return std::chrono::duration<double>(  // NOLINT(build/c++11)
+        Clock::now().time_since_epoch()).count();
+}
+
+// Grows the iteration count until a run is long enough to trust.
+Result run(const Benchmark& benchmark, int size, double minTime) {
+    int64_t iterations = 1;
+    for (;;) {
+        State state(size, iterations);
+        benchmark.function()(&state);
+        double seconds = state.seconds();
+
+        if (seconds >= minTime || iterations >= (int64_t(1) << 40)) {
+            Result result;
+            result.name = benchmark.name();
+            result.size = size;
+            result.iterations = iterations;
+            result.seconds = seconds;
+            result.flops = state.flops();
+            result.bytes = state.bytes();
+            return result;
+        }
+
+        // Aim 40% past the target so the next run usually is the last.
+        double scale = seconds > 0 ? 1.4 * minTime / seconds : 100.0;
+        scale = std::min(std::max(scale, 2.0), 100.0);
+        iterations = static_cast<int64_t>(iterations * scale);
+    }
+}
+
+std::vector<int> sizes(const Benchmark& benchmark, int maxSize) {
+    int max = benchmark.max();
+    if (maxSize > 0) {
+        max = std::min(max, maxSize);
+    }
+
+    std::vector<int> result;
+    for (int64_t size = benchmark.min(); size < max;
+         size *= benchmark.multiplier()) {
+        result.push_back(static_cast<int>(size));
+    }
+    if (benchmark.min() <= max) {
+        result.push_back(max);
+    }
+    return result;
+}
+
+void printTable(FILE* out, const Result& result) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s/%d", result.name.c_str(), result.size);
+    fprintf(out, "%-28s %14.0f %12lld %10.2f %10.2f\n", name,
+            result.nanosPerIteration(),
+            static_cast<long long>(result.iterations),  // NOLINT(runtime/int)
+            result.gflops(), result.gbytes());
+    fflush(out);
+}
+
+void printJson(FILE* out, const std::vector<Result>& results) {
+    char date[32];
+    time_t seconds = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&seconds));
+
+    fprintf(out, "{\n  \"context\": {\n");
+    fprintf(out, "    \"date\": \"%s\",\n", date);
+    fprintf(out, "    \"isa\": \"%s\",\n",
+            kernels::isaName(kernels::activeIsa()));
+    fprintf(out, "    \"threads\": %d\n", ThreadPool::global().threads());
+    fprintf(out, "  },\n  \"benchmarks\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        fprintf(out, "%s\n    {", i == 0 ? "" : ",");
+        fprintf(out, "\"name\": \"%s/%d\", ", result.name.c_str(),
+                result.size);
+        fprintf(out, "\"size\": %d, ", result.size);
+        fprintf(out, "\"iterations\": %lld, ",
+                static_cast<long long>(result.iterations));  // NOLINT
+        fprintf(out, "\"real_time_ns\": %.6g, ", result.nanosPerIteration());
+        fprintf(out, "\"gflops\": %.6g, ", result.gflops());
+        fprintf(out, "\"gbytes_per_second\": %.6g}", result.gbytes());
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+bool parseFlag(const char* arg, const char* flag, const char** value) {
+    size_t length = strlen(flag);
+    if (strncmp(arg, flag, length) != 0 || arg[length] != '=') {
+        return false;
+    }
+    *value = arg + length + 1;
+    return true;
+}
+
+void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s [--filter=SUBSTRING] [--min-time=SECONDS]\n"
+            "       [--max-size=N] [--format=table|json] [--out=FILE]\n",
+            program);
+}
+
+}  // namespace
+
+void State::start() {
+    started_ = true;
+    start_ = now();
+}
+
+void State::stop() {
+    seconds_ = now() - start_;
+}
+
+Benchmark::Benchmark(const char* name, Function function)
+    : name_(name), function_(function), min_(1), max_(1), multiplier_(4) {
+}
+
+Benchmark* Benchmark::range(int min, int max, int multiplier) {
+    min_ = min;
+    max_ = max;
+    multiplier_ = std::max(multiplier, 2);
+    return this;
+}
+
+Benchmark* registerBenchmark(const char* name, Function function) {
+    Benchmark* benchmark = new Benchmark(name, function);
+    registry().push_back(benchmark);
+    return benchmark;
+}
+
+}  // namespace bench
+
+int main(int argc, char** argv) {
+    bench::Options options;
+    for (int i = 1; i < argc; i++) {
+        const char* value;
+        if (bench::parseFlag(argv[i], "--filter", &value)) {
+            options.filter = value;
+        } else if (bench::parseFlag(argv[i], "--min-time", &value)) {
+            options.minTime = atof(value);
+        } else if (bench::parseFlag(argv[i], "--max-size", &value)) {
+            options.maxSize = atoi(value);
+        } else if (bench::parseFlag(argv[i], "--format", &value) &&
+                   (strcmp(value, "json") == 0 ||
+                    strcmp(value, "table") == 0)) {
+            options.json = strcmp(value, "json") == 0;
+        } else if (bench::parseFlag(argv[i], "--out", &value)) {
+            options.out = value;
+        } else {
+            bench::usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // The table goes to stderr when stdout carries JSON.
+    FILE* table = options.json ? stderr : stdout;
+    fprintf(table, "%-28s %14s %12s %10s %10s\n", "Benchmark", "Time(ns)",
+            "Iterations", "GFLOP/s", "GB/s");
+
+    std::vector<bench::Result> results;
+    const std::vector<bench::Benchmark*>& benchmarks = bench::registry();
+    for (size_t i = 0; i < benchmarks.size(); i++) {
+        const bench::Benchmark& benchmark = *benchmarks[i];
+        if (benchmark.name().find(options.filter) == std::string::npos) {
+            continue;
+        }
+
+        std::vector<int> sizes = bench::sizes(benchmark, options.maxSize);
+        for (size_t j = 0; j < sizes.size(); j++) {
+            results.push_back(bench::run(benchmark, sizes[j],
+                                         options.minTime));
+            bench::printTable(table, results.back());
+        }
+    }
+
+    if (options.json) {
+        bench::printJson(stdout, results);
+    }
+    if (!options.out.empty()) {
+        FILE* out = fopen(options.out.c_str(), "w");
+        if (out == NULL) {
+            perror(options.out.c_str());
+            return 1;
+        }
+        bench::printJson(out, results);
+        fclose(out);
+    }
+
+    return 0;
+}
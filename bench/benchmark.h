@@ -0,0 +1,117 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef BENCH_BENCHMARK_H_
+#define BENCH_BENCHMARK_H_
+
+#include <stdint.h>
+
+#include <string>
+
+// Minimal benchmark harness in the spirit of Google Benchmark, so the
+// suite builds with nothing but the compiler. A benchmark is a function
+// taking a State; the timed part is the body of the keepRunning() loop:
+//
+//     void vectorAdd(bench::State* state) {
+//         Vector x(state->size()), y(state->size()), z(state->size());
+//         while (state->keepRunning()) {
+//             z = x + y;
+//         }
+//         state->setFlops(state->size());
+//         state->setBytes(3.0 * sizeof(double) * state->size());
+//     }
+//     BENCHMARK(vectorAdd)->range(4, 8192);
+//
+// Each (benchmark, size) pair is rerun with more iterations until it
+// takes at least --min-time seconds; results are printed as a table or
+// as JSON (--format=json, or --out=FILE to keep the table on screen).
+namespace bench {
+
+class State {
+ public:
+    State(int size, int64_t iterations)
+        : size_(size), iterations_(iterations), left_(iterations),
+          started_(false), start_(0), seconds_(0), flops_(0), bytes_(0) {}
+
+    int size() const { return size_; }
+    int64_t iterations() const { return iterations_; }
+    // Time spent inside the keepRunning() loop.
+    double seconds() const { return seconds_; }
+
+    // The clock starts on the first call and stops on the last one.
+    bool keepRunning() {
+        if (!started_) {
+            start();
+        }
+        if (left_ > 0) {
+            left_--;
+            return true;
+        }
+        stop();
+        return false;
+    }
+
+    // Work done by one iteration of the loop.
+    void setFlops(double flops) { flops_ = flops; }
+    void setBytes(double bytes) { bytes_ = bytes; }
+    double flops() const { return flops_; }
+    double bytes() const { return bytes_; }
+
+ private:
+    void start();
+    void stop();
+
+    int size_;
+    int64_t iterations_;
+    int64_t left_;
+    bool started_;
+    double start_;
+    double seconds_;
+    double flops_;
+    double bytes_;
+};
+
+typedef void (*Function)(State* state);
+
+class Benchmark {
+ public:
+    Benchmark(const char* name, Function function);
+
+    // Runs on sizes min, min*multiplier, ... and always on max.
+    Benchmark* range(int min, int max, int multiplier = 4);
+
+    const std::string& name() const { return name_; }
+    Function function() const { return function_; }
+    int min() const { return min_; }
+    int max() const { return max_; }
+    int multiplier() const { return multiplier_; }
+
+ private:
+    std::string name_;
+    Function function_;
+    int min_;
+    int max_;
+    int multiplier_;
+};
+
+Benchmark* registerBenchmark(const char* name, Function function);
+
+// Keeps the compiler from dropping a computation whose result is unused.
+template <class T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    volatile const T* sink = &value;
+    (void)sink;
+#endif
+}
+
+}  // namespace bench
+
+#define BENCHMARK_CONCAT2(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT2(a, b)
+#define BENCHMARK(function)                                             \
+    static bench::Benchmark* BENCHMARK_CONCAT(benchmark_, __LINE__) =   \
+        bench::registerBenchmark(#function, function)
+
+#endif  // BENCH_BENCHMARK_H_
@@ -0,0 +1,81 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_ALLOCATOR_H_
+#define INCLUDE_ML_ALLOCATOR_H_
+
+#include <stddef.h>
+
+// Memory policy behind vector and matrix storage. Every buffer goes
+// back to the allocator that produced it, so the default can be
+// swapped at any time without disturbing live matrices.
+class Allocator {
+ public:
+    // Buffers are aligned to a cache line, so vector loads of a row
+    // never straddle two lines.
+    static const size_t kAlignment = 64;
+
+    virtual ~Allocator() {}
+
+    // Returns at least bytes (> 0) of kAlignment-aligned memory; throws
+    // std::bad_alloc when the memory is exhausted.
+    virtual void* allocate(size_t bytes) = 0;
+    // bytes is the value passed to the allocate() call that returned p.
+    virtual void deallocate(void* p, size_t bytes) = 0;
+};
+
+// Straight to the system allocator. Buffers of kHugePageBytes or more
+// are aligned to a huge page and advised to use transparent huge pages
+// where the platform has them.
+class AlignedAllocator : public Allocator {
+ public:
+    static const size_t kHugePageBytes = 2 << 20;
+
+    void* allocate(size_t bytes);
+    void deallocate(void* p, size_t bytes);
+};
+
+// Keeps freed buffers in per-thread free lists, one per size class, and
+// hands them out again before asking the system. Size classes are four
+// per power of two, so a buffer wastes at most a quarter of its size.
+// Buffers above kMaxPooledBytes bypass the pool. A buffer freed on
+// another thread joins that thread's lists; each thread caches at most
+// kMaxCachedBytes and releases the rest.
+class PooledAllocator : public Allocator {
+ public:
+    static const size_t kMaxPooledBytes = 64 << 20;
+    static const size_t kMaxCachedBytes = 256 << 20;
+
+    void* allocate(size_t bytes);
+    void deallocate(void* p, size_t bytes);
+
+    // Bytes sitting in the calling thread's free lists.
+    static size_t cachedBytes();
+    // Returns the calling thread's cached buffers to the system.
+    static void trim();
+};
+
+// Allocator used for new buffers: the innermost AllocatorScope of the
+// calling thread, else the global default, a PooledAllocator unless
+// replaced.
+Allocator* defaultAllocator();
+// Replaces the global default. allocator must outlive every buffer it
+// allocates; NULL restores the built-in pool.
+void setDefaultAllocator(Allocator* allocator);
+
+// Makes allocator the default of the calling thread for the lifetime of
+// the scope. Scopes nest; other threads are not affected. A NULL
+// allocator falls back to the global default, for results that must
+// outlive the allocator of an enclosing scope.
+class AllocatorScope {
+ public:
+    explicit AllocatorScope(Allocator* allocator);
+    ~AllocatorScope();
+
+ private:
+    AllocatorScope(const AllocatorScope&);
+    AllocatorScope& operator =(const AllocatorScope&);
+
+    Allocator* previous_;
+};
+
+#endif  // INCLUDE_ML_ALLOCATOR_H_
@@ -0,0 +1,72 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_ARENA_H_
+#define INCLUDE_ML_ARENA_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "ml/allocator.h"
+
+// Bump allocator for the temporaries of one computation step. Buffers
+// are carved out of large chunks one after another; freeing one only
+// gives its memory back when it is the last one handed out, everything
+// else is reclaimed at once by reset(). Typical use:
+//
+//     Arena arena;
+//     for (...) {
+//         {
+//             AllocatorScope scope(&arena);
+//             Matrix grad = x.transposed() * (x * w - y);
+//             w -= rate * grad;  // w lives outside the arena
+//         }
+//         arena.reset();
+//     }
+//
+// An arena belongs to one thread at a time and must outlive the buffers
+// it hands out.
+class Arena : public Allocator {
+ public:
+    static const size_t kDefaultChunkBytes = 1 << 20;
+
+    explicit Arena(size_t chunkBytes = kDefaultChunkBytes);
+    ~Arena();
+
+    void* allocate(size_t bytes);
+    void deallocate(void* p, size_t bytes);
+
+    // Makes all the memory available again; every buffer from the arena
+    // must be freed by then. If the last step spilled into several
+    // chunks they are merged, so the next one fits in a single chunk.
+    void reset();
+
+    // Buffers handed out and not freed yet.
+    size_t liveBuffers() const { return live_; }
+    // Bytes handed out since the last reset(), minus those given back.
+    size_t usedBytes() const;
+    // Bytes held by all the chunks.
+    size_t reservedBytes() const;
+
+ private:
+    Arena(const Arena&);
+    Arena& operator =(const Arena&);
+
+    struct Chunk {
+        char* data;
+        size_t size;
+    };
+
+    void addChunk(size_t size);
+    void releaseChunks();
+
+    std::vector<Chunk> chunks_;
+    size_t chunkBytes_;
+    size_t current_;
+    size_t offset_;
+    size_t spilled_;
+    size_t live_;
+    AlignedAllocator system_;
+};
+
+#endif  // INCLUDE_ML_ARENA_H_
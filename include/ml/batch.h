@@ -0,0 +1,85 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_BATCH_H_
+#define INCLUDE_ML_BATCH_H_
+
+#include "ml/linear_algebra.h"
+#include "ml/storage.h"
+
+// A batch of count small matrices of the same shape, of doubles or
+// floats, in one buffer. The matrices are interleaved in groups of
+// kLanes: element (i, j) of the kLanes matrices of a group is one
+// contiguous, 64-byte aligned run, so the batch operations below work
+// on kLanes matrices at once with every vector instruction, whatever
+// the size of the matrices. The padding of the last group is zero.
+template <class T>
+class BasicMatrixBatch {
+ public:
+    // Matrices per group: one cache line of each element.
+    static const int kLanes = 64 / sizeof(T);
+
+    BasicMatrixBatch(int count, int cols, int rows);
+    // Packs count row-major rows x cols matrices stored one after
+    // another.
+    BasicMatrixBatch(int count, int cols, int rows, const T* matrices);
+
+    int count() const { return count_; }
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int groups() const { return (count_ + kLanes - 1) / kLanes; }
+
+    // Element (i, j) of matrix index.
+    T& at(int index, int i, int j) { return storage_[offset(index, i, j)]; }
+    const T& at(int index, int i, int j) const {
+        return storage_[offset(index, i, j)];
+    }
+    BasicMatrix<T> get(int index) const;
+    void set(int index, const BasicMatrix<T>& mat);
+    // Unpacks into count row-major matrices one after another.
+    void copyTo(T* matrices) const;
+
+    // The rows x cols x kLanes elements of group g.
+    T* group(int g) { return storage_.data() + offset(g * kLanes, 0, 0); }
+    const T* group(int g) const {
+        return storage_.data() + offset(g * kLanes, 0, 0);
+    }
+
+ private:
+    size_t offset(int index, int i, int j) const {
+        size_t group = static_cast<size_t>(index / kLanes) * rows_ * cols_;
+        return (group + static_cast<size_t>(i) * cols_ + j) * kLanes +
+               index % kLanes;
+    }
+
+    BasicStorage<T> storage_;
+    int count_;
+    int cols_;
+    int rows_;
+};
+
+typedef BasicMatrixBatch<double> MatrixBatch;
+typedef BasicMatrixBatch<float> FloatMatrixBatch;
+
+// Element-wise operations on batches: c(k) = a(k) b(k) and a(k) + b(k)
+// for every k. c must already have the right count and shape. Groups
+// run in parallel on ThreadPool::global() for large batches.
+template <class T>
+void multiplyBatch(const BasicMatrixBatch<T>& a, const BasicMatrixBatch<T>& b,
+                   BasicMatrixBatch<T>* c);
+template <class T>
+void addBatch(const BasicMatrixBatch<T>& a, const BasicMatrixBatch<T>& b,
+              BasicMatrixBatch<T>* c);
+
+// x(k) with a(k) x(k) = b(k), and the inverses of a(k), by LU with
+// partial pivoting; the row swaps of each matrix are blended in per
+// lane. Returns the number of singular matrices, which have a zero
+// pivot; if singular is not NULL, its count entries tell which they
+// are. The results for singular matrices are not meaningful.
+template <class T>
+int solveBatch(const BasicMatrixBatch<T>& a, const BasicMatrixBatch<T>& b,
+               BasicMatrixBatch<T>* x, bool* singular = NULL);
+template <class T>
+int inverseBatch(const BasicMatrixBatch<T>& a, BasicMatrixBatch<T>* inverse,
+                 bool* singular = NULL);
+
+#endif  // INCLUDE_ML_BATCH_H_
@@ -0,0 +1,73 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_CHOLESKY_H_
+#define INCLUDE_ML_CHOLESKY_H_
+
+#include "ml/linear_algebra.h"
+
+// Cholesky factorization A = L L^T of a symmetric positive definite
+// matrix of doubles or floats, such as a covariance matrix or the X^T X
+// of the normal equations. Only the lower triangle of A is read. The
+// factorization is blocked: diagonal blocks are factored directly, the
+// rows below them are solved in parallel and the trailing matrix is
+// updated through GEMM.
+//
+// A matrix that is not positive definite, to rounding, leaves
+// positiveDefinite() false; solving with it then throws
+// std::runtime_error.
+template <class T>
+class BasicCholesky {
+ public:
+    // Pass an rvalue to factor a matrix in place of its storage.
+    explicit BasicCholesky(BasicMatrix<T> a);
+
+    int dims() const { return factor_.rows(); }
+    bool positiveDefinite() const { return positiveDefinite_; }
+    // L, zero above the diagonal.
+    const BasicMatrix<T>& factor() const { return factor_; }
+
+    T determinant() const;
+    // log(det A), which unlike det A rarely overflows.
+    T logDeterminant() const;
+
+    // x with A x = b; columns of a matrix b are separate systems.
+    BasicVector<T> solve(const BasicVector<T>& b) const;
+    BasicMatrix<T> solve(const BasicMatrix<T>& b) const;
+    void solveInPlace(BasicVector<T>* b) const;
+    void solveInPlace(BasicMatrix<T>* b) const;
+    // The two halves of solve(): L y = b, then L^T x = y.
+    void solveLowerInPlace(BasicMatrix<T>* b) const;
+    void solveUpperInPlace(BasicMatrix<T>* b) const;
+    BasicMatrix<T> inverse() const;
+
+    // Refactor A + x x^T and A - x x^T in O(n^2 k) for the k columns of
+    // x (n x k) instead of O(n^3). A downdate that would leave A
+    // indefinite returns false and keeps the factorization unchanged.
+    void update(const BasicVector<T>& x);
+    void update(const BasicMatrix<T>& x);
+    bool downdate(const BasicVector<T>& x);
+    bool downdate(const BasicMatrix<T>& x);
+
+ private:
+    void check() const;
+    bool modify(const T* x, int k, T sign);
+
+    BasicMatrix<T> factor_;
+    bool positiveDefinite_;
+};
+
+typedef BasicCholesky<double> Cholesky;
+typedef BasicCholesky<float> FloatCholesky;
+
+// Solves count independent SPD systems of the same shape in parallel,
+// without per-system allocation. a holds count n x n matrices one after
+// another, row-major, and is overwritten with their factors L; b holds
+// count n x nrhs right-hand sides, overwritten with the solutions.
+// Returns the number of matrices that are not positive definite; their
+// right-hand sides are left as they were and, if positiveDefinite is
+// not NULL, their entries in it (count of them) are set to false.
+template <class T>
+int choleskySolveBatch(int count, int n, int nrhs, T* a, T* b,
+                       bool* positiveDefinite = NULL);
+
+#endif  // INCLUDE_ML_CHOLESKY_H_
@@ -0,0 +1,43 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_EIGEN_H_
+#define INCLUDE_ML_EIGEN_H_
+
+#include "ml/linear_algebra.h"
+
+// Eigendecomposition A = V diag(w) V^T of a symmetric matrix of doubles
+// or floats, such as a covariance matrix. Only the lower triangle of A
+// is read.
+//
+// A is first reduced to tridiagonal form by Householder reflectors,
+// 32 at a time, with half of the work in GEMM updates of the trailing
+// matrix. The eigenvectors of the tridiagonal matrix come from
+// divide-and-conquer: the two halves are solved in parallel, and each
+// merge solves its secular equation in parallel and forms its vectors
+// through GEMM. The reflectors are applied to them in compact WY form.
+// Eigenvalues alone come from implicit QL iterations in O(n^2).
+//
+// Eigenvalues are in ascending order. A matrix with non-finite
+// elements in its lower triangle, or QL iterations that do not
+// converge, throw std::runtime_error.
+template <class T>
+class BasicSymmetricEigen {
+ public:
+    // Pass an rvalue to reduce a matrix in place of its storage.
+    explicit BasicSymmetricEigen(BasicMatrix<T> a, bool vectors = true);
+
+    int dims() const { return values_.dims(); }
+    const BasicVector<T>& values() const { return values_; }
+    // Column i is the unit eigenvector of values()(i); empty when the
+    // vectors were not asked for.
+    const BasicMatrix<T>& vectors() const { return vectors_; }
+
+ private:
+    BasicVector<T> values_;
+    BasicMatrix<T> vectors_;
+};
+
+typedef BasicSymmetricEigen<double> SymmetricEigen;
+typedef BasicSymmetricEigen<float> FloatSymmetricEigen;
+
+#endif  // INCLUDE_ML_EIGEN_H_
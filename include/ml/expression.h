@@ -0,0 +1,343 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_EXPRESSION_H_
+#define INCLUDE_ML_EXPRESSION_H_
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <type_traits>  // NOLINT(build/c++11)
+
+#include "ml/scalar.h"
+
+// Element-wise arithmetic on vectors and matrices does not compute
+// anything by itself: it builds a small expression node, and the whole
+// tree is evaluated in one fused pass when it is assigned to a Vector
+// or a Matrix. Nodes hold references to their Vector and Matrix
+// operands, so an expression has to be consumed in the statement that
+// builds it.
+//
+// Every node has a Scalar element type; both operands of a binary node
+// must have the same one, use elementCast() to convert between them.
+
+template <class T>
+class BasicVector;
+template <class T>
+class BasicMatrix;
+
+template <class E>
+class VectorExpression {
+ public:
+    const E& self() const { return static_cast<const E&>(*this); }
+    int dims() const { return self().dims(); }
+};
+
+template <class E>
+class MatrixExpression {
+ public:
+    const E& self() const { return static_cast<const E&>(*this); }
+    int rows() const { return self().rows(); }
+    int cols() const { return self().cols(); }
+};
+
+// Nodes are copied into their parents; containers are referenced.
+template <class E>
+struct ExpressionOperand {
+    typedef const E type;
+};
+
+template <class T>
+struct ExpressionOperand<BasicVector<T> > {
+    typedef const BasicVector<T>& type;
+};
+
+template <class T>
+struct ExpressionOperand<BasicMatrix<T> > {
+    typedef const BasicMatrix<T>& type;
+};
+
+// Operations, carried out in the accumulator type of T (see
+// ml/scalar.h). kernel() and scalarKernel() are the SIMD paths used
+// when both operands are plain containers; they live in
+// linear_algebra.cpp.
+struct AddOp {
+    template <class T>
+    static T apply(T a, T b) {
+        typedef typename ScalarTraits<T>::Accumulator Accumulator;
+        return ScalarTraits<T>::narrow(Accumulator(a) + Accumulator(b));
+    }
+    template <class T>
+    static void kernel(const T* a, const T* b, T* out, size_t n);
+    template <class T>
+    static void scalarKernel(T a, const T* b, T* out, size_t n);
+};
+
+struct SubOp {
+    template <class T>
+    static T apply(T a, T b) {
+        typedef typename ScalarTraits<T>::Accumulator Accumulator;
+        return ScalarTraits<T>::narrow(Accumulator(a) - Accumulator(b));
+    }
+    template <class T>
+    static void kernel(const T* a, const T* b, T* out, size_t n);
+};
+
+struct MulOp {
+    template <class T>
+    static T apply(T a, T b) {
+        typedef typename ScalarTraits<T>::Accumulator Accumulator;
+        return ScalarTraits<T>::narrow(Accumulator(a) * Accumulator(b));
+    }
+    template <class T>
+    static void kernel(const T* a, const T* b, T* out, size_t n);
+    template <class T>
+    static void scalarKernel(T a, const T* b, T* out, size_t n);
+};
+
+//
+// Vector nodes
+//
+template <class Op, class L, class R>
+class VectorBinary : public VectorExpression<VectorBinary<Op, L, R> > {
+ public:
+    typedef typename L::Scalar Scalar;
+    static_assert(std::is_same<Scalar, typename R::Scalar>::value,
+                  "operands have different element types");
+
+    VectorBinary(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {
+        assert(lhs.dims() == rhs.dims());
+    }
+    int dims() const { return lhs_.dims(); }
+    Scalar at(int i) const {
+        return Op::apply(Scalar(lhs_.at(i)), Scalar(rhs_.at(i)));
+    }
+    const L& lhs() const { return lhs_; }
+    const R& rhs() const { return rhs_; }
+
+ private:
+    typename ExpressionOperand<L>::type lhs_;
+    typename ExpressionOperand<R>::type rhs_;
+};
+
+// Op applied to a scalar on the left and every element on the right.
+template <class Op, class E>
+class VectorScalar : public VectorExpression<VectorScalar<Op, E> > {
+ public:
+    typedef typename E::Scalar Scalar;
+
+    VectorScalar(Scalar scalar, const E& expr)
+        : scalar_(scalar), expr_(expr) {}
+    int dims() const { return expr_.dims(); }
+    Scalar at(int i) const { return Op::apply(scalar_, Scalar(expr_.at(i))); }
+    Scalar scalar() const { return scalar_; }
+    const E& expr() const { return expr_; }
+
+ private:
+    Scalar scalar_;
+    typename ExpressionOperand<E>::type expr_;
+};
+
+template <class L, class R>
+VectorBinary<AddOp, L, R> operator +(const VectorExpression<L>& lhs,
+                                     const VectorExpression<R>& rhs) {
+    return VectorBinary<AddOp, L, R>(lhs.self(), rhs.self());
+}
+
+template <class L, class R>
+VectorBinary<SubOp, L, R> operator -(const VectorExpression<L>& lhs,
+                                     const VectorExpression<R>& rhs) {
+    return VectorBinary<SubOp, L, R>(lhs.self(), rhs.self());
+}
+
+// Element-wise product.
+template <class L, class R>
+VectorBinary<MulOp, L, R> operator *(const VectorExpression<L>& lhs,
+                                     const VectorExpression<R>& rhs) {
+    return VectorBinary<MulOp, L, R>(lhs.self(), rhs.self());
+}
+
+template <class E>
+VectorScalar<MulOp, E> operator *(const typename E::Scalar& a,
+                                  const VectorExpression<E>& vec) {
+    return VectorScalar<MulOp, E>(a, vec.self());
+}
+
+template <class E>
+VectorScalar<AddOp, E> operator +(const typename E::Scalar& a,
+                                  const VectorExpression<E>& vec) {
+    return VectorScalar<AddOp, E>(a, vec.self());
+}
+
+template <class E>
+VectorScalar<AddOp, E> operator +(const VectorExpression<E>& vec,
+                                  const typename E::Scalar& a) {
+    return VectorScalar<AddOp, E>(a, vec.self());
+}
+
+template <class L, class R>
+bool operator ==(const VectorExpression<L>& lhs,
+                 const VectorExpression<R>& rhs) {
+    if (lhs.dims() != rhs.dims()) {
+        return false;
+    }
+
+    for (int i = 0; i < lhs.dims(); i++) {
+        if (lhs.self().at(i) != rhs.self().at(i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <class L, class R>
+bool operator !=(const VectorExpression<L>& lhs,
+                 const VectorExpression<R>& rhs) {
+    return !(lhs == rhs);
+}
+
+//
+// Matrix nodes
+//
+template <class Op, class L, class R>
+class MatrixBinary : public MatrixExpression<MatrixBinary<Op, L, R> > {
+ public:
+    typedef typename L::Scalar Scalar;
+    static_assert(std::is_same<Scalar, typename R::Scalar>::value,
+                  "operands have different element types");
+
+    MatrixBinary(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {
+        assert(lhs.rows() == rhs.rows() && lhs.cols() == rhs.cols());
+    }
+    int rows() const { return lhs_.rows(); }
+    int cols() const { return lhs_.cols(); }
+    Scalar at(int i, int j) const {
+        return Op::apply(Scalar(lhs_.at(i, j)), Scalar(rhs_.at(i, j)));
+    }
+    const L& lhs() const { return lhs_; }
+    const R& rhs() const { return rhs_; }
+
+ private:
+    typename ExpressionOperand<L>::type lhs_;
+    typename ExpressionOperand<R>::type rhs_;
+};
+
+template <class Op, class E>
+class MatrixScalar : public MatrixExpression<MatrixScalar<Op, E> > {
+ public:
+    typedef typename E::Scalar Scalar;
+
+    MatrixScalar(Scalar scalar, const E& expr)
+        : scalar_(scalar), expr_(expr) {}
+    int rows() const { return expr_.rows(); }
+    int cols() const { return expr_.cols(); }
+    Scalar at(int i, int j) const {
+        return Op::apply(scalar_, Scalar(expr_.at(i, j)));
+    }
+    Scalar scalar() const { return scalar_; }
+    const E& expr() const { return expr_; }
+
+ private:
+    Scalar scalar_;
+    typename ExpressionOperand<E>::type expr_;
+};
+
+template <class L, class R>
+MatrixBinary<AddOp, L, R> operator +(const MatrixExpression<L>& lhs,
+                                     const MatrixExpression<R>& rhs) {
+    return MatrixBinary<AddOp, L, R>(lhs.self(), rhs.self());
+}
+
+template <class L, class R>
+MatrixBinary<SubOp, L, R> operator -(const MatrixExpression<L>& lhs,
+                                     const MatrixExpression<R>& rhs) {
+    return MatrixBinary<SubOp, L, R>(lhs.self(), rhs.self());
+}
+
+template <class E>
+MatrixScalar<MulOp, E> operator *(const typename E::Scalar& a,
+                                  const MatrixExpression<E>& mat) {
+    return MatrixScalar<MulOp, E>(a, mat.self());
+}
+
+template <class E>
+MatrixScalar<AddOp, E> operator +(const typename E::Scalar& a,
+                                  const MatrixExpression<E>& mat) {
+    return MatrixScalar<AddOp, E>(a, mat.self());
+}
+
+template <class E>
+MatrixScalar<AddOp, E> operator +(const MatrixExpression<E>& mat,
+                                  const typename E::Scalar& a) {
+    return MatrixScalar<AddOp, E>(a, mat.self());
+}
+
+template <class L, class R>
+bool operator ==(const MatrixExpression<L>& lhs,
+                 const MatrixExpression<R>& rhs) {
+    if (lhs.rows() != rhs.rows() || lhs.cols() != rhs.cols()) {
+        return false;
+    }
+
+    for (int i = 0; i < lhs.rows(); i++) {
+        for (int j = 0; j < lhs.cols(); j++) {
+            if (lhs.self().at(i, j) != rhs.self().at(i, j)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+template <class L, class R>
+bool operator !=(const MatrixExpression<L>& lhs,
+                 const MatrixExpression<R>& rhs) {
+    return !(lhs == rhs);
+}
+
+//
+// Element type conversion
+//
+template <class T, class E>
+class VectorCast : public VectorExpression<VectorCast<T, E> > {
+ public:
+    typedef T Scalar;
+
+    explicit VectorCast(const E& expr) : expr_(expr) {}
+    int dims() const { return expr_.dims(); }
+    Scalar at(int i) const { return ScalarTraits<T>::cast(expr_.at(i)); }
+
+ private:
+    typename ExpressionOperand<E>::type expr_;
+};
+
+template <class T, class E>
+class MatrixCast : public MatrixExpression<MatrixCast<T, E> > {
+ public:
+    typedef T Scalar;
+
+    explicit MatrixCast(const E& expr) : expr_(expr) {}
+    int rows() const { return expr_.rows(); }
+    int cols() const { return expr_.cols(); }
+    Scalar at(int i, int j) const {
+        return ScalarTraits<T>::cast(expr_.at(i, j));
+    }
+
+ private:
+    typename ExpressionOperand<E>::type expr_;
+};
+
+// Converts every element to T as ScalarTraits<T>::cast() does, for
+// example BasicMatrix<float> m = elementCast<float>(doubleMatrix).
+template <class T, class E>
+VectorCast<T, E> elementCast(const VectorExpression<E>& vec) {
+    return VectorCast<T, E>(vec.self());
+}
+
+template <class T, class E>
+MatrixCast<T, E> elementCast(const MatrixExpression<E>& mat) {
+    return MatrixCast<T, E>(mat.self());
+}
+
+#endif  // INCLUDE_ML_EXPRESSION_H_
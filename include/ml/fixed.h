@@ -0,0 +1,281 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_FIXED_H_
+#define INCLUDE_ML_FIXED_H_
+
+#include <assert.h>
+#include <math.h>
+
+#include <type_traits>  // NOLINT(build/c++11)
+
+#include "ml/linear_algebra.h"
+
+// Vectors and matrices of doubles or floats whose dimensions are
+// template arguments. The elements live inside the object, so these
+// are plain values: no allocation, no stored dimensions, and at()
+// indexes with constants. They are meant for small sizes on hot paths;
+// Matrix and Vector take over past a few dozen elements.
+//
+// Arithmetic is eager and its loops have compile-time trip counts. Up
+// to kFixedUnroll iterations they are unrolled by template recursion,
+// so a 4 x 4 product compiles to straight-line code; longer ones stay
+// loops for the compiler to vectorize. Dimensions are checked at
+// compile time, except when converting from and to the dynamic
+// classes.
+
+// Longest loop unrolled in full.
+const int kFixedUnroll = 16;
+
+// FixedLoop<N>::run(f) calls f(0), ..., f(N - 1).
+template <int N, bool Unrolled = (N <= kFixedUnroll)>
+struct FixedLoop {
+    template <class F>
+    static void run(const F& f) {
+        FixedLoop<N - 1>::run(f);
+        f(N - 1);
+    }
+};
+
+template <>
+struct FixedLoop<0, true> {
+    template <class F>
+    static void run(const F&) {}
+};
+
+template <int N>
+struct FixedLoop<N, false> {
+    template <class F>
+    static void run(const F& f) {
+        for (int i = 0; i < N; i++) {
+            f(i);
+        }
+    }
+};
+
+template <class T, int Dims>
+class BasicFixedVector {
+ public:
+    static_assert(std::is_floating_point<T>::value,
+                  "fixed-size vectors hold doubles or floats");
+    static_assert(Dims > 0, "fixed-size vectors are not empty");
+    typedef T Scalar;
+
+    BasicFixedVector() : data_() {}
+    explicit BasicFixedVector(T value) {
+        FixedLoop<Dims>::run([this, value](int i) { data_[i] = value; });
+    }
+    explicit BasicFixedVector(const BasicVector<T>& vec) {
+        assert(vec.dims() == Dims);
+        const T* source = vec.ptr();
+        FixedLoop<Dims>::run([this, source](int i) { data_[i] = source[i]; });
+    }
+
+    T at(int i) const { return data_[i]; }
+    T& at(int i) { return data_[i]; }
+    static int dims() { return Dims; }
+    T* ptr() { return data_; }
+    const T* ptr() const { return data_; }
+    static size_t size() { return Dims; }
+
+    BasicVector<T> toVector() const {
+        BasicVector<T> vec(Dims);
+        T* target = vec.ptr();
+        FixedLoop<Dims>::run([this, target](int i) { target[i] = data_[i]; });
+        return vec;
+    }
+
+    BasicFixedVector& operator +=(const BasicFixedVector& vec) {
+        FixedLoop<Dims>::run([this, &vec](int i) { data_[i] += vec.data_[i]; });
+        return *this;
+    }
+    BasicFixedVector& operator -=(const BasicFixedVector& vec) {
+        FixedLoop<Dims>::run([this, &vec](int i) { data_[i] -= vec.data_[i]; });
+        return *this;
+    }
+    BasicFixedVector& operator *=(T a) {
+        FixedLoop<Dims>::run([this, a](int i) { data_[i] *= a; });
+        return *this;
+    }
+
+    T length() const { return sqrt(dot(*this, *this)); }
+
+ private:
+    T data_[Dims];
+};
+
+template <int Dims>
+using FixedVector = BasicFixedVector<double, Dims>;
+template <int Dims>
+using FloatFixedVector = BasicFixedVector<float, Dims>;
+
+// A Rows x Cols matrix, stored row after row; the arguments come in the
+// order of the BasicMatrix(cols, rows) constructor.
+template <class T, int Cols, int Rows>
+class BasicFixedMatrix {
+ public:
+    static_assert(std::is_floating_point<T>::value,
+                  "fixed-size matrices hold doubles or floats");
+    static_assert(Cols > 0 && Rows > 0, "fixed-size matrices are not empty");
+    typedef T Scalar;
+
+    BasicFixedMatrix() : data_() {}
+    explicit BasicFixedMatrix(T value) {
+        FixedLoop<Cols * Rows>::run([this, value](int e) {
+            data_[e] = value;
+        });
+    }
+    explicit BasicFixedMatrix(const BasicMatrix<T>& mat) {
+        assert(mat.cols() == Cols && mat.rows() == Rows);
+        const T* source = mat.ptr();
+        FixedLoop<Cols * Rows>::run([this, source](int e) {
+            data_[e] = source[e];
+        });
+    }
+
+    T at(int i, int j) const { return data_[i * Cols + j]; }
+    T& at(int i, int j) { return data_[i * Cols + j]; }
+    static int cols() { return Cols; }
+    static int rows() { return Rows; }
+    T* ptr() { return data_; }
+    const T* ptr() const { return data_; }
+    static size_t size() { return Cols * Rows; }
+
+    // Views aliasing this matrix: they run the dynamic kernels on it
+    // and assign it to or from any matrix expression.
+    BasicMatrixView<T> view() {
+        return BasicMatrixView<T>(data_, Rows, Cols, Cols);
+    }
+    BasicMatrixView<const T> view() const {
+        return BasicMatrixView<const T>(data_, Rows, Cols, Cols);
+    }
+    BasicMatrix<T> toMatrix() const { return BasicMatrix<T>(view()); }
+
+    BasicFixedMatrix<T, Rows, Cols> transposed() const {
+        BasicFixedMatrix<T, Rows, Cols> result;
+        const T* source = data_;
+        T* target = result.ptr();
+        FixedLoop<Rows>::run([source, target](int i) {
+            FixedLoop<Cols>::run([source, target, i](int j) {
+                target[j * Rows + i] = source[i * Cols + j];
+            });
+        });
+        return result;
+    }
+
+    BasicFixedMatrix& operator +=(const BasicFixedMatrix& mat) {
+        FixedLoop<Cols * Rows>::run([this, &mat](int e) {
+            data_[e] += mat.data_[e];
+        });
+        return *this;
+    }
+    BasicFixedMatrix& operator -=(const BasicFixedMatrix& mat) {
+        FixedLoop<Cols * Rows>::run([this, &mat](int e) {
+            data_[e] -= mat.data_[e];
+        });
+        return *this;
+    }
+    BasicFixedMatrix& operator *=(T a) {
+        FixedLoop<Cols * Rows>::run([this, a](int e) { data_[e] *= a; });
+        return *this;
+    }
+
+    static BasicFixedMatrix identity() {
+        static_assert(Cols == Rows, "identity matrices are square");
+        BasicFixedMatrix result;
+        FixedLoop<Rows>::run([&result](int i) { result.at(i, i) = T(1); });
+        return result;
+    }
+
+ private:
+    T data_[Cols * Rows];
+};
+
+template <int Cols, int Rows>
+using FixedMatrix = BasicFixedMatrix<double, Cols, Rows>;
+template <int Cols, int Rows>
+using FloatFixedMatrix = BasicFixedMatrix<float, Cols, Rows>;
+
+template <class T, int Dims>
+T dot(const BasicFixedVector<T, Dims>& vec1,
+      const BasicFixedVector<T, Dims>& vec2) {
+    T sum = 0;
+    FixedLoop<Dims>::run([&sum, &vec1, &vec2](int i) {
+        sum += vec1.at(i) * vec2.at(i);
+    });
+    return sum;
+}
+
+template <class T, int Dims>
+BasicFixedVector<T, Dims> operator +(BasicFixedVector<T, Dims> lhs,
+                                     const BasicFixedVector<T, Dims>& rhs) {
+    return lhs += rhs;
+}
+
+template <class T, int Dims>
+BasicFixedVector<T, Dims> operator -(BasicFixedVector<T, Dims> lhs,
+                                     const BasicFixedVector<T, Dims>& rhs) {
+    return lhs -= rhs;
+}
+
+template <class T, int Dims>
+BasicFixedVector<T, Dims> operator *(T a, BasicFixedVector<T, Dims> vec) {
+    return vec *= a;
+}
+
+template <class T, int Cols, int Rows>
+BasicFixedMatrix<T, Cols, Rows> operator +(
+        BasicFixedMatrix<T, Cols, Rows> lhs,
+        const BasicFixedMatrix<T, Cols, Rows>& rhs) {
+    return lhs += rhs;
+}
+
+template <class T, int Cols, int Rows>
+BasicFixedMatrix<T, Cols, Rows> operator -(
+        BasicFixedMatrix<T, Cols, Rows> lhs,
+        const BasicFixedMatrix<T, Cols, Rows>& rhs) {
+    return lhs -= rhs;
+}
+
+template <class T, int Cols, int Rows>
+BasicFixedMatrix<T, Cols, Rows> operator *(
+        T a, BasicFixedMatrix<T, Cols, Rows> mat) {
+    return mat *= a;
+}
+
+// Row i of the product accumulates the rows of b scaled by row i of a,
+// so the innermost, contiguous loop runs along rows of b and c.
+template <class T, int Cols, int Inner, int Rows>
+BasicFixedMatrix<T, Cols, Rows> operator *(
+        const BasicFixedMatrix<T, Inner, Rows>& a,
+        const BasicFixedMatrix<T, Cols, Inner>& b) {
+    BasicFixedMatrix<T, Cols, Rows> c;
+    const T* pa = a.ptr();
+    const T* pb = b.ptr();
+    T* pc = c.ptr();
+    FixedLoop<Rows>::run([pa, pb, pc](int i) {
+        FixedLoop<Inner>::run([pa, pb, pc, i](int k) {
+            T aik = pa[i * Inner + k];
+            FixedLoop<Cols>::run([pb, pc, i, k, aik](int j) {
+                pc[i * Cols + j] += aik * pb[k * Cols + j];
+            });
+        });
+    });
+    return c;
+}
+
+template <class T, int Cols, int Rows>
+BasicFixedVector<T, Rows> operator *(const BasicFixedMatrix<T, Cols, Rows>& a,
+                                     const BasicFixedVector<T, Cols>& x) {
+    BasicFixedVector<T, Rows> y;
+    const T* pa = a.ptr();
+    const T* px = x.ptr();
+    T* py = y.ptr();
+    FixedLoop<Rows>::run([pa, px, py](int i) {
+        FixedLoop<Cols>::run([pa, px, py, i](int j) {
+            py[i] += pa[i * Cols + j] * px[j];
+        });
+    });
+    return y;
+}
+
+#endif  // INCLUDE_ML_FIXED_H_
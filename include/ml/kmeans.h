@@ -0,0 +1,107 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_KMEANS_H_
+#define INCLUDE_ML_KMEANS_H_
+
+#include <vector>
+
+#include "ml/linear_algebra.h"
+
+enum KMeansBounds {
+    // Every iteration computes all sample-center distances by GEMM.
+    kKMeansLloyd,
+    // One upper and one lower bound per sample (Hamerly): skips samples
+    // whose center cannot have changed. Memory for 2 n bounds.
+    kKMeansHamerly,
+    // An upper bound and k lower bounds per sample (Elkan): also skips
+    // the individual centers that cannot be closer. Memory for n k
+    // bounds; best with few samples and many dimensions.
+    kKMeansElkan
+};
+
+struct KMeansOptions {
+    KMeansOptions()
+        : maxIterations(100), tolerance(1e-4), bounds(kKMeansHamerly),
+          seed(0) {}
+
+    int maxIterations;
+    // Converged once the squared distances the centers move add up to
+    // at most tolerance times the mean variance of the features, or no
+    // sample changes cluster.
+    double tolerance;
+    KMeansBounds bounds;
+    // Seeds the k-means++ sampling; results depend on it only.
+    unsigned seed;
+};
+
+// k-means clustering of the rows of a matrix of doubles or floats.
+//
+// Centers start from k-means++ sampling and move by Lloyd iterations.
+// Squared distances are |x|^2 - 2 x.c + |c|^2 with the norms computed
+// once: a whole assignment is one GEMM of the samples by the centers,
+// single distances are a dot product. The triangle inequality bounds
+// of kKMeansHamerly and kKMeansElkan skip most distances once the
+// centers settle. Assignment runs in parallel over blocks of samples,
+// the update in parallel over centers, summing each cluster in sample
+// order, so results do not depend on the number of threads. A center
+// that loses all its samples stays where it is.
+template <class T>
+class BasicKMeans {
+ public:
+    BasicKMeans(const BasicMatrix<T>& x, int k,
+                const KMeansOptions& options = KMeansOptions());
+
+    // k x dims centers.
+    const BasicMatrix<T>& centers() const { return centers_; }
+    // The cluster of every sample.
+    const std::vector<int>& labels() const { return labels_; }
+    // Sum of squared distances of the samples to their centers.
+    double inertia() const { return inertia_; }
+    int iterations() const { return iterations_; }
+    bool converged() const { return converged_; }
+
+    // The nearest center of every row of x.
+    std::vector<int> predict(const BasicMatrix<T>& x) const;
+
+ private:
+    BasicMatrix<T> centers_;
+    std::vector<int> labels_;
+    double inertia_;
+    int iterations_;
+    bool converged_;
+};
+
+typedef BasicKMeans<double> KMeans;
+typedef BasicKMeans<float> FloatKMeans;
+
+// Mini-batch k-means (Sculley) for samples streamed in batches. The
+// first batch, of at least k samples, seeds the centers by k-means++;
+// every batch is then assigned by GEMM and each center moves towards
+// its samples with step 1 / (samples it has seen), in parallel over
+// centers.
+template <class T>
+class BasicMiniBatchKMeans {
+ public:
+    BasicMiniBatchKMeans(int k, int dims,
+                         const KMeansOptions& options = KMeansOptions());
+
+    void partialFit(const BasicMatrix<T>& batch);
+
+    bool initialized() const { return initialized_; }
+    const BasicMatrix<T>& centers() const { return centers_; }
+    // Samples seen by each center.
+    const std::vector<int64_t>& counts() const { return counts_; }
+
+    std::vector<int> predict(const BasicMatrix<T>& x) const;
+
+ private:
+    BasicMatrix<T> centers_;
+    std::vector<int64_t> counts_;
+    KMeansOptions options_;
+    bool initialized_;
+};
+
+typedef BasicMiniBatchKMeans<double> MiniBatchKMeans;
+typedef BasicMiniBatchKMeans<float> FloatMiniBatchKMeans;
+
+#endif  // INCLUDE_ML_KMEANS_H_
@@ -0,0 +1,55 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_LBFGS_H_
+#define INCLUDE_ML_LBFGS_H_
+
+#include <functional>
+
+#include "ml/linear_algebra.h"
+
+struct LbfgsOptions {
+    LbfgsOptions() : history(10), maxIterations(100), tolerance(1e-5) {}
+
+    // Correction pairs kept for the inverse Hessian estimate.
+    int history;
+    int maxIterations;
+    // Converged once |gradient| <= tolerance * max(1, |x|).
+    double tolerance;
+};
+
+// Limited-memory BFGS minimization of a smooth function of doubles or
+// floats (Nocedal and Wright, algorithm 7.5). Search directions come
+// from the two-loop recursion over the last history steps; steps are
+// found by backtracking until the Armijo condition holds, and pairs
+// without positive curvature are dropped. All vector arithmetic runs
+// through the SIMD kernels; the objective is free to evaluate on the
+// thread pool.
+template <class T>
+class BasicLbfgs {
+ public:
+    // Returns f(x) and writes its gradient, which has x.dims() elements.
+    typedef std::function<T(const BasicVector<T>& x,
+                            BasicVector<T>* gradient)> Objective;
+
+    explicit BasicLbfgs(const LbfgsOptions& options = LbfgsOptions());
+
+    // Minimizes f from *x, leaving the minimizer there, and returns its
+    // value. Stops at the tolerance, after maxIterations, or when the
+    // line search makes no progress.
+    T minimize(const Objective& f, BasicVector<T>* x);
+
+    bool converged() const { return converged_; }
+    int iterations() const { return iterations_; }
+    int evaluations() const { return evaluations_; }
+
+ private:
+    LbfgsOptions options_;
+    bool converged_;
+    int iterations_;
+    int evaluations_;
+};
+
+typedef BasicLbfgs<double> Lbfgs;
+typedef BasicLbfgs<float> FloatLbfgs;
+
+#endif  // INCLUDE_ML_LBFGS_H_
@@ -4,65 +4,408 @@
 #ifndef INCLUDE_ML_LINEAR_ALGEBRA_H_
 #define INCLUDE_ML_LINEAR_ALGEBRA_H_
 
+#include <stdint.h>
+
 #include <vector>
 #include <iostream>
 
-class Vector {
+#include "ml/expression.h"
+#include "ml/scalar.h"
+#include "ml/span.h"
+#include "ml/storage.h"
+#include "ml/view.h"
+
+// Vectors and matrices of any element type from ml/scalar.h: double,
+// float, int8_t or BFloat16. Vector and Matrix hold doubles.
+template <class T>
+class BasicVector : public VectorExpression<BasicVector<T> > {
  public:
-    explicit Vector(int dims, double defaultValue = 0);
-    Vector(const Vector& vec);
-    double at(int i) const;
-    double& at(int i);
-    int dims() const;
-    Vector& operator =(const Vector& vec);
-    Vector operator +(const Vector& vec) const;
-    Vector operator -(const Vector& vec) const;
-    Vector operator *(const Vector& vec) const;
-    bool operator ==(const Vector& vec) const;
-    bool operator !=(const Vector& vec) const;
-    std::vector<double> data() const;
+    typedef T Scalar;
+
+    explicit BasicVector(int dims, T defaultValue = T());
+    BasicVector(const BasicVector& vec);
+    BasicVector(BasicVector&& vec) noexcept;  // NOLINT(build/c++11)
+    template <class E>
+    BasicVector(const VectorExpression<E>& expr);  // NOLINT(runtime/explicit)
+    T at(int i) const { return data_[i]; }
+    T& at(int i) { return data_[i]; }
+    int dims() const { return dims_; }
+    BasicVector& operator =(const BasicVector& vec);
+    BasicVector& operator =(BasicVector&& vec) noexcept;  // NOLINT
+    template <class E>
+    BasicVector& operator =(const VectorExpression<E>& expr);
+    // In-place arithmetic; *= with a vector is element-wise.
+    template <class E>
+    BasicVector& operator +=(const VectorExpression<E>& expr);
+    template <class E>
+    BasicVector& operator -=(const VectorExpression<E>& expr);
+    template <class E>
+    BasicVector& operator *=(const VectorExpression<E>& expr);
+    BasicVector& operator *=(T a);
+    // Zero-copy access to the elements.
+    T* ptr() { return data_.data(); }
+    const T* ptr() const { return data_.data(); }
+    size_t size() const { return data_.size(); }
+    Span<T> span() { return Span<T>(ptr(), size()); }
+    Span<const T> span() const {
+        return Span<const T>(ptr(), size());
+    }
+    // Returns a copy of the elements; prefer span() or ptr().
+    std::vector<T> data() const;
     double length() const;
+
  private:
-    std::vector<double> data_;
+    template <class E>
+    void assign(const E& expr);
+    template <class Op>
+    void assign(const VectorBinary<Op, BasicVector, BasicVector>& expr);
+    template <class Op>
+    void assign(const VectorScalar<Op, BasicVector>& expr);
+    void assign(const VectorBinary<AddOp, BasicVector,
+                                   VectorScalar<MulOp, BasicVector> >& expr);
+    void assign(const VectorBinary<AddOp, VectorScalar<MulOp, BasicVector>,
+                                   BasicVector>& expr);
+
+    BasicStorage<T> data_;
     int dims_;
 };
 
-std::ostream& operator <<(std::ostream& os, const Vector& vec);
+typedef BasicVector<double> Vector;
+typedef BasicVector<float> FloatVector;
+typedef BasicVector<int8_t> Int8Vector;
+typedef BasicVector<BFloat16> BFloat16Vector;
 
-Vector operator *(const double& a, const Vector& mat);
-Vector operator +(const double& a, const Vector& mat);
-Vector operator +(const Vector& mat, const double& a);
+template <class T>
+std::ostream& operator <<(std::ostream& os, const BasicVector<T>& vec);
 
-double dot(const Vector& vec1, const Vector& vec2);
+template <class E>
+std::ostream& operator <<(std::ostream& os, const VectorExpression<E>& expr) {
+    return os << BasicVector<typename E::Scalar>(expr);
+}
 
-class Matrix {
+template <class T>
+typename ScalarTraits<T>::Accumulator dot(const BasicVector<T>& vec1,
+                                          const BasicVector<T>& vec2);
+
+template <class T, class U>
+typename ScalarTraits<T>::Accumulator dot(const BasicVector<T>& vec,
+                                          const BasicVectorView<U>& view) {
+    assert(vec.dims() == view.dims());
+    return dot<T>(vec.ptr(), 1, view.ptr(), view.stride(), vec.dims());
+}
+
+template <class T, class U>
+typename ScalarTraits<T>::Accumulator dot(const BasicVectorView<U>& view,
+                                          const BasicVector<T>& vec) {
+    return dot(vec, view);
+}
+
+template <class T>
+class BasicMatrix : public MatrixExpression<BasicMatrix<T> > {
  public:
-    Matrix(int cols, int rows, double defaultValue = 0);
-    Matrix(const Matrix& mat);
-    double at(int i, int j) const;
-    double& at(int i, int j);
-    Matrix& operator =(const Matrix& mat);
-    Matrix operator +(const Matrix& mat) const;
-    Matrix operator -(const Matrix& mat) const;
-    Matrix operator *(const Matrix& mat) const;
-    bool operator ==(const Matrix& mat) const;
-    bool operator !=(const Matrix& mat) const;
-    int cols() const;
-    int rows() const;
-    Vector row(int i);
-    Vector col(int j);
-    std::vector<double> data() const;
-    static Matrix identity(int dims);
+    typedef T Scalar;
+
+    BasicMatrix(int cols, int rows, T defaultValue = T());
+    // Adopts storage of cols*rows elements laid out row after row.
+    BasicMatrix(int cols, int rows, BasicStorage<T> storage);
+    BasicMatrix(const BasicMatrix& mat);
+    BasicMatrix(BasicMatrix&& mat) noexcept;  // NOLINT(build/c++11)
+    template <class E>
+    BasicMatrix(const MatrixExpression<E>& expr);  // NOLINT(runtime/explicit)
+    T at(int i, int j) const {
+        return data_[static_cast<size_t>(cols_)*i + j];
+    }
+    T& at(int i, int j) {
+        return data_[static_cast<size_t>(cols_)*i + j];
+    }
+    BasicMatrix& operator =(const BasicMatrix& mat);
+    BasicMatrix& operator =(BasicMatrix&& mat) noexcept;  // NOLINT
+    template <class E>
+    BasicMatrix& operator =(const MatrixExpression<E>& expr);
+    template <class E>
+    BasicMatrix& operator +=(const MatrixExpression<E>& expr);
+    template <class E>
+    BasicMatrix& operator -=(const MatrixExpression<E>& expr);
+    BasicMatrix& operator *=(T a);
+    BasicMatrix operator *(const BasicMatrix& mat) const;
+    int cols() const { return cols_; }
+    int rows() const { return rows_; }
+    // Views aliasing this matrix; see ml/view.h.
+    BasicVectorView<T> row(int i) {
+        assert(0 <= i && i < rows_);
+        return BasicVectorView<T>(
+            ptr() + static_cast<size_t>(i)*cols_, cols_);
+    }
+    BasicVectorView<const T> row(int i) const {
+        assert(0 <= i && i < rows_);
+        return BasicVectorView<const T>(
+            ptr() + static_cast<size_t>(i)*cols_, cols_);
+    }
+    BasicVectorView<T> col(int j) {
+        assert(0 <= j && j < cols_);
+        return BasicVectorView<T>(ptr() + j, rows_, cols_);
+    }
+    BasicVectorView<const T> col(int j) const {
+        assert(0 <= j && j < cols_);
+        return BasicVectorView<const T>(ptr() + j, rows_, cols_);
+    }
+    BasicMatrixView<T> view() {
+        return BasicMatrixView<T>(ptr(), rows_, cols_, cols_);
+    }
+    BasicMatrixView<const T> view() const {
+        return BasicMatrixView<const T>(ptr(), rows_, cols_, cols_);
+    }
+    // rows x cols sub-matrix whose top-left element is (i, j).
+    BasicMatrixView<T> block(int i, int j, int rows, int cols) {
+        return view().block(i, j, rows, cols);
+    }
+    BasicMatrixView<const T> block(int i, int j, int rows, int cols) const {
+        return view().block(i, j, rows, cols);
+    }
+    // A transposed view costs nothing; assigning it to a matrix, as in
+    // Matrix t = m.transposed(), copies it through the blocked SIMD
+    // transpose, and m = m.transposed() transposes m in place.
+    BasicMatrixView<T> transposed() { return view().transposed(); }
+    BasicMatrixView<const T> transposed() const {
+        return view().transposed();
+    }
+    // Transposes in place without a second buffer: square matrices swap
+    // blocks (in parallel when large), others follow the cycles of the
+    // permutation on one thread, with a bit per element of scratch.
+    void transposeInPlace();
+    // Zero-copy access to the elements, stored row after row.
+    T* ptr() { return data_.data(); }
+    const T* ptr() const { return data_.data(); }
+    size_t size() const { return data_.size(); }
+    Span<T> span() { return Span<T>(ptr(), size()); }
+    Span<const T> span() const {
+        return Span<const T>(ptr(), size());
+    }
+    // Returns a copy of the elements; prefer span() or ptr().
+    std::vector<T> data() const;
+    static BasicMatrix identity(int dims);
 
  private:
-    std::vector<double> data_;
+    template <class E>
+    void assign(const E& expr);
+    template <class Op>
+    void assign(const MatrixBinary<Op, BasicMatrix, BasicMatrix>& expr);
+    template <class Op>
+    void assign(const MatrixScalar<Op, BasicMatrix>& expr);
+    void assign(const MatrixBinary<AddOp, BasicMatrix,
+                                   MatrixScalar<MulOp, BasicMatrix> >& expr);
+    void assign(const MatrixBinary<AddOp, MatrixScalar<MulOp, BasicMatrix>,
+                                   BasicMatrix>& expr);
+    void assign(const BasicMatrixView<const T>& view);
+    void assign(const BasicMatrixView<T>& view) {
+        assign(BasicMatrixView<const T>(view));
+    }
+
+    BasicStorage<T> data_;
     int cols_;
     int rows_;
 };
 
-std::ostream& operator <<(std::ostream& os, const Matrix& mat);
+typedef BasicMatrix<double> Matrix;
+typedef BasicMatrix<float> FloatMatrix;
+typedef BasicMatrix<int8_t> Int8Matrix;
+typedef BasicMatrix<BFloat16> BFloat16Matrix;
+
+template <class T>
+std::ostream& operator <<(std::ostream& os, const BasicMatrix<T>& mat);
+
+template <class E>
+std::ostream& operator <<(std::ostream& os, const MatrixExpression<E>& expr) {
+    return os << BasicMatrix<typename E::Scalar>(expr);
+}
+
+// Matrix products are not element-wise, so their operands are
+// evaluated first and the product runs through GEMM.
+template <class L, class R>
+BasicMatrix<typename L::Scalar> operator *(const MatrixExpression<L>& lhs,
+                                           const MatrixExpression<R>& rhs) {
+    typedef BasicMatrix<typename L::Scalar> Result;
+    return Result(lhs) * Result(rhs);
+}
+
+template <class T, class R>
+BasicMatrix<T> operator *(const BasicMatrix<T>& lhs,
+                          const MatrixExpression<R>& rhs) {
+    return lhs * BasicMatrix<T>(rhs);
+}
+
+template <class L, class T>
+BasicMatrix<T> operator *(const MatrixExpression<L>& lhs,
+                          const BasicMatrix<T>& rhs) {
+    return BasicMatrix<T>(lhs) * rhs;
+}
+
+// Matrix-vector products (GEMV): y = a * x into a y of a.rows()
+// elements that is reused rather than reallocated; y may be x itself
+// when a is square, at the cost of a copy of x. Views with either
+// stride equal to one, such as mat.transposed(), run through the SIMD
+// kernels without a copy; large products split across
+// ThreadPool::global().
+template <class T>
+void multiply(const BasicMatrixView<const T>& a, const BasicVector<T>& x,
+              BasicVector<T>* y);
+
+template <class T>
+void multiply(const BasicMatrixView<T>& a, const BasicVector<T>& x,
+              BasicVector<T>* y) {
+    multiply(BasicMatrixView<const T>(a), x, y);
+}
+
+template <class T>
+BasicVector<T> operator *(const BasicMatrix<T>& a, const BasicVector<T>& x);
+
+template <class U, class T>
+BasicVector<T> operator *(const BasicMatrixView<U>& a,
+                          const BasicVector<T>& x) {
+    BasicVector<T> y(a.rows());
+    multiply(BasicMatrixView<const T>(a), x, &y);
+    return y;
+}
+
+template <class T, class E>
+BasicVector<T> operator *(const BasicMatrix<T>& a,
+                          const VectorExpression<E>& x) {
+    return a * BasicVector<T>(x);
+}
+
+// x * a is the row vector x^T a, that is a^T x.
+template <class T>
+BasicVector<T> operator *(const BasicVector<T>& x, const BasicMatrix<T>& a);
+
+//
+// Expression evaluation
+//
+template <class T>
+template <class E>
+BasicVector<T>::BasicVector(const VectorExpression<E>& expr) : dims_(0) {
+    assign(expr.self());
+}
+
+template <class T>
+template <class E>
+BasicVector<T>& BasicVector<T>::operator =(const VectorExpression<E>& expr) {
+    assign(expr.self());
+    return *this;
+}
+
+// x op= e is evaluated as x = x op e, which picks the same kernels.
+template <class T>
+template <class E>
+BasicVector<T>& BasicVector<T>::operator +=(const VectorExpression<E>& expr) {
+    assign(VectorBinary<AddOp, BasicVector, E>(*this, expr.self()));
+    return *this;
+}
+
+template <class T>
+template <class E>
+BasicVector<T>& BasicVector<T>::operator -=(const VectorExpression<E>& expr) {
+    assign(VectorBinary<SubOp, BasicVector, E>(*this, expr.self()));
+    return *this;
+}
+
+template <class T>
+template <class E>
+BasicVector<T>& BasicVector<T>::operator *=(const VectorExpression<E>& expr) {
+    assign(VectorBinary<MulOp, BasicVector, E>(*this, expr.self()));
+    return *this;
+}
+
+// Every element is read from the operands and written once. Operands
+// are only ever read at the index being written, so the destination
+// may appear in the expression.
+template <class T>
+template <class E>
+void BasicVector<T>::assign(const E& expr) {
+    dims_ = expr.dims();
+    data_.resize(dims_);
+    for (int i = 0; i < dims_; i++) {
+        data_[i] = expr.at(i);
+    }
+}
+
+template <class T>
+template <class Op>
+void BasicVector<T>::assign(
+        const VectorBinary<Op, BasicVector, BasicVector>& expr) {
+    dims_ = expr.dims();
+    data_.resize(dims_);
+    Op::kernel(expr.lhs().ptr(), expr.rhs().ptr(),
+               ptr(), dims_);
+}
+
+template <class T>
+template <class Op>
+void BasicVector<T>::assign(const VectorScalar<Op, BasicVector>& expr) {
+    dims_ = expr.dims();
+    data_.resize(dims_);
+    Op::scalarKernel(expr.scalar(), expr.expr().ptr(), ptr(),
+                     dims_);
+}
+
+template <class T>
+template <class E>
+BasicMatrix<T>::BasicMatrix(const MatrixExpression<E>& expr)
+    : cols_(0), rows_(0) {
+    assign(expr.self());
+}
+
+template <class T>
+template <class E>
+BasicMatrix<T>& BasicMatrix<T>::operator =(const MatrixExpression<E>& expr) {
+    assign(expr.self());
+    return *this;
+}
+
+template <class T>
+template <class E>
+BasicMatrix<T>& BasicMatrix<T>::operator +=(const MatrixExpression<E>& expr) {
+    assign(MatrixBinary<AddOp, BasicMatrix, E>(*this, expr.self()));
+    return *this;
+}
+
+template <class T>
+template <class E>
+BasicMatrix<T>& BasicMatrix<T>::operator -=(const MatrixExpression<E>& expr) {
+    assign(MatrixBinary<SubOp, BasicMatrix, E>(*this, expr.self()));
+    return *this;
+}
+
+template <class T>
+template <class E>
+void BasicMatrix<T>::assign(const E& expr) {
+    rows_ = expr.rows();
+    cols_ = expr.cols();
+    data_.resize(static_cast<size_t>(rows_)*cols_);
+    for (int i = 0; i < rows_; i++) {
+        T* row = ptr() + static_cast<size_t>(i)*cols_;
+        for (int j = 0; j < cols_; j++) {
+            row[j] = expr.at(i, j);
+        }
+    }
+}
+
+template <class T>
+template <class Op>
+void BasicMatrix<T>::assign(
+        const MatrixBinary<Op, BasicMatrix, BasicMatrix>& expr) {
+    rows_ = expr.rows();
+    cols_ = expr.cols();
+    data_.resize(static_cast<size_t>(rows_)*cols_);
+    Op::kernel(expr.lhs().ptr(), expr.rhs().ptr(), ptr(), size());
+}
+
+template <class T>
+template <class Op>
+void BasicMatrix<T>::assign(const MatrixScalar<Op, BasicMatrix>& expr) {
+    rows_ = expr.rows();
+    cols_ = expr.cols();
+    data_.resize(static_cast<size_t>(rows_)*cols_);
+    Op::scalarKernel(expr.scalar(), expr.expr().ptr(), ptr(), size());
+}
 
-Matrix operator *(const double& a, const Matrix& mat);
-Matrix operator +(const double& a, const Matrix& mat);
-Matrix operator +(const Matrix& mat, const double& a);
 #endif  // INCLUDE_ML_LINEAR_ALGEBRA_H_
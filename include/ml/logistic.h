@@ -0,0 +1,67 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_LOGISTIC_H_
+#define INCLUDE_ML_LOGISTIC_H_
+
+#include <vector>
+
+#include "ml/lbfgs.h"
+#include "ml/linear_algebra.h"
+
+// Logistic regression over samples x of dims features, of doubles or
+// floats, labelled 0 to classes - 1. Two classes are scored by one
+// weight vector through the sigmoid, more classes by one weight row
+// per class through the softmax. Samples are the rows of a matrix.
+template <class T>
+class BasicLogisticRegression {
+ public:
+    // weights has one row (two classes) or one row per class, with an
+    // intercept each.
+    BasicLogisticRegression(int classes, BasicMatrix<T> weights,
+                            BasicVector<T> intercepts);
+
+    int classes() const { return classes_; }
+    int dims() const { return weights_.cols(); }
+    const BasicMatrix<T>& weights() const { return weights_; }
+    const BasicVector<T>& intercepts() const { return intercepts_; }
+
+    // x.rows() x classes() matrix of class probabilities, by GEMM (GEMV
+    // for two classes).
+    BasicMatrix<T> predictProbabilities(const BasicMatrix<T>& x) const;
+    // The most probable class of every row.
+    std::vector<int> predict(const BasicMatrix<T>& x) const;
+
+ private:
+    int classes_;
+    BasicMatrix<T> weights_;
+    BasicVector<T> intercepts_;
+};
+
+typedef BasicLogisticRegression<double> LogisticRegression;
+typedef BasicLogisticRegression<float> FloatLogisticRegression;
+
+struct LogisticOptions {
+    LogisticOptions() : l2(1e-4), shards(0), intercept(true) {}
+
+    // Penalty l2 |W|^2 / 2 on the weights, not the intercepts.
+    double l2;
+    // Row ranges evaluated in parallel, their gradients summed in
+    // order. Zero means one per thread of ThreadPool::global(); fix it
+    // for results that do not depend on the number of threads.
+    int shards;
+    bool intercept;
+    LbfgsOptions lbfgs;
+};
+
+// Minimizes the mean cross-entropy of the model on (x, labels) plus
+// the l2 penalty by L-BFGS. Each loss and gradient evaluation is one
+// parallel pass over the data: every shard walks its rows a cache-sized
+// block at a time, computing the scores by GEMM, their probabilities,
+// loss and residuals, and the gradient of the block by a second GEMM
+// while the block is still in cache.
+template <class T>
+BasicLogisticRegression<T> fitLogisticRegression(
+    const BasicMatrix<T>& x, const std::vector<int>& labels, int classes,
+    const LogisticOptions& options = LogisticOptions());
+
+#endif  // INCLUDE_ML_LOGISTIC_H_
@@ -0,0 +1,74 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_LU_H_
+#define INCLUDE_ML_LU_H_
+
+#include <vector>
+
+#include "ml/linear_algebra.h"
+
+// LU factorization with partial pivoting, P A = L U, of a square matrix
+// of doubles or floats. The factorization is blocked and right-looking:
+// each panel of columns is factored directly, and the trailing matrix
+// is updated through GEMM, which splits it across ThreadPool::global().
+//
+// A singular matrix still factors; solve() and inverse() then throw
+// std::runtime_error and determinant() is zero.
+template <class T>
+class BasicLu {
+ public:
+    // Pass an rvalue to factor a matrix in place of its storage.
+    explicit BasicLu(BasicMatrix<T> a);
+
+    int dims() const { return factors_.rows(); }
+    // Some pivot is exactly zero.
+    bool singular() const { return singular_; }
+    // L below the diagonal, its unit diagonal implied, and U on and
+    // above it.
+    const BasicMatrix<T>& factors() const { return factors_; }
+    // Row i was exchanged with row pivots()[i] >= i, for i in order.
+    const std::vector<int>& pivots() const { return pivots_; }
+
+    T determinant() const;
+    // x with A x = b; columns of a matrix b are separate systems.
+    BasicVector<T> solve(const BasicVector<T>& b) const;
+    BasicMatrix<T> solve(const BasicMatrix<T>& b) const;
+    // Overwrite b with the solution instead of allocating it.
+    void solveInPlace(BasicVector<T>* b) const;
+    void solveInPlace(BasicMatrix<T>* b) const;
+    BasicMatrix<T> inverse() const;
+
+ private:
+    void solveInPlace(T* b, int cols, int ldb) const;
+
+    BasicMatrix<T> factors_;
+    std::vector<int> pivots_;
+    bool singular_;
+};
+
+typedef BasicLu<double> Lu;
+typedef BasicLu<float> FloatLu;
+
+// One-off helpers that factor a on every call; keep a BasicLu to reuse
+// the factorization.
+template <class T>
+BasicVector<T> solve(const BasicMatrix<T>& a, const BasicVector<T>& b) {
+    return BasicLu<T>(a).solve(b);
+}
+
+template <class T>
+BasicMatrix<T> solve(const BasicMatrix<T>& a, const BasicMatrix<T>& b) {
+    return BasicLu<T>(a).solve(b);
+}
+
+template <class T>
+BasicMatrix<T> inverse(const BasicMatrix<T>& a) {
+    return BasicLu<T>(a).inverse();
+}
+
+template <class T>
+T determinant(const BasicMatrix<T>& a) {
+    return BasicLu<T>(a).determinant();
+}
+
+#endif  // INCLUDE_ML_LU_H_
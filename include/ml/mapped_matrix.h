@@ -0,0 +1,41 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_MAPPED_MATRIX_H_
+#define INCLUDE_ML_MAPPED_MATRIX_H_
+
+#include <string>
+
+#include "ml/linear_algebra.h"
+
+// Matrices backed by memory-mapped files. The file is a 64-byte header
+// (magic, version, element type, layout, byte order, rows, cols)
+// followed by the row-major payload at a 64-byte aligned offset.
+// Mapping takes constant time and pages are read on first touch, so
+// matrices larger than RAM work with every Matrix operation.
+//
+// Errors (missing file, foreign or truncated file, platform without
+// mmap) are reported with std::runtime_error.
+
+enum MapMode {
+    // Pages are shared with every process mapping the same file until
+    // they are written; writes stay private to this Matrix.
+    kMapCopyOnWrite,
+    // Writes go straight to the file.
+    kMapShared
+};
+
+// Writes mat to path in the mappable format (see ml/serialization.h),
+// without a checksum.
+void writeMatrixFile(const std::string& path, const Matrix& mat);
+
+// Maps a file written by writeMatrixFile(), createMatrixFile() or
+// writeMatrix(). kMapShared drops the checksum of a file that has one,
+// since writes through the mapping would not update it.
+Matrix mapMatrixFile(const std::string& path,
+                     MapMode mode = kMapCopyOnWrite);
+
+// Creates a zero-filled cols x rows matrix file without touching its
+// pages and maps it in kMapShared mode, so it can be filled in place.
+Matrix createMatrixFile(const std::string& path, int cols, int rows);
+
+#endif  // INCLUDE_ML_MAPPED_MATRIX_H_
@@ -0,0 +1,81 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_QR_H_
+#define INCLUDE_ML_QR_H_
+
+#include <vector>
+
+#include "ml/linear_algebra.h"
+
+// Householder QR factorization A = Q R of an m x n matrix of doubles or
+// floats with m >= n. Reflectors are accumulated 32 at a time in
+// compact WY form, I - V T V^T, so that applying them to the rest of
+// the matrix, or to right-hand sides, runs through GEMM and its thread
+// pool.
+//
+// A diagonal element of R below max(m, n) eps max |R(i, i)| makes the
+// matrix numerically rank deficient; least squares solves then throw
+// std::runtime_error.
+template <class T>
+class BasicQr {
+ public:
+    // Pass an rvalue to factor a matrix in place of its storage.
+    explicit BasicQr(BasicMatrix<T> a);
+
+    int rows() const { return factors_.rows(); }
+    int cols() const { return factors_.cols(); }
+    bool rankDeficient() const;
+    // R on and above the diagonal, the Householder vectors below it,
+    // their leading ones implied.
+    const BasicMatrix<T>& factors() const { return factors_; }
+    const std::vector<T>& tau() const { return tau_; }
+    // The n x n R and the m x n Q of the thin factorization.
+    BasicMatrix<T> r() const;
+    BasicMatrix<T> q() const;
+
+    // b = Q^T b and b = Q b for m x k right-hand sides; Q is the full
+    // m x m orthogonal matrix here.
+    void applyQtInPlace(BasicMatrix<T>* b) const;
+    void applyQInPlace(BasicMatrix<T>* b) const;
+
+    // The x minimizing |A x - b|; columns of a matrix b are separate
+    // problems.
+    BasicVector<T> solve(const BasicVector<T>& b) const;
+    BasicMatrix<T> solve(const BasicMatrix<T>& b) const;
+
+ private:
+    void apply(BasicMatrix<T>* b, bool transposed) const;
+
+    BasicMatrix<T> factors_;
+    std::vector<T> tau_;
+    // The triangular T of each block of reflectors, side by side.
+    BasicMatrix<T> blockFactors_;
+};
+
+typedef BasicQr<double> Qr;
+typedef BasicQr<float> FloatQr;
+
+enum LstsqMethod {
+    // TSQR for matrices at least kTsqrAspect times taller than wide,
+    // Householder QR otherwise.
+    kLstsqAuto,
+    kLstsqHouseholder,
+    // Communication-avoiding TSQR: every thread reduces its own band of
+    // rows, a few hundred at a time, to an R factor, and the R factors
+    // are reduced once more. A and b are only read, in one pass, and Q
+    // is never formed.
+    kLstsqTsqr
+};
+
+const int kTsqrAspect = 64;
+
+// The x minimizing |A x - b| for A with at least as many rows as
+// columns.
+template <class T>
+BasicVector<T> lstsq(const BasicMatrix<T>& a, const BasicVector<T>& b,
+                     LstsqMethod method = kLstsqAuto);
+template <class T>
+BasicMatrix<T> lstsq(const BasicMatrix<T>& a, const BasicMatrix<T>& b,
+                     LstsqMethod method = kLstsqAuto);
+
+#endif  // INCLUDE_ML_QR_H_
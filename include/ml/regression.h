@@ -0,0 +1,102 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_REGRESSION_H_
+#define INCLUDE_ML_REGRESSION_H_
+
+#include "ml/linear_algebra.h"
+
+// Linear model y = w . x + b over samples x of dims features, of
+// doubles or floats. Samples are the rows of a matrix.
+template <class T>
+class BasicLinearRegression {
+ public:
+    // All-zero model.
+    explicit BasicLinearRegression(int dims);
+    BasicLinearRegression(BasicVector<T> weights, T intercept);
+
+    int dims() const { return weights_.dims(); }
+    const BasicVector<T>& weights() const { return weights_; }
+    T intercept() const { return intercept_; }
+
+    T predict(const BasicVector<T>& x) const;
+    // One prediction per row of x, through GEMV, into a y of x.rows()
+    // elements.
+    void predict(const BasicMatrix<T>& x, BasicVector<T>* y) const;
+    BasicVector<T> predict(const BasicMatrix<T>& x) const;
+
+ private:
+    BasicVector<T> weights_;
+    T intercept_;
+};
+
+typedef BasicLinearRegression<double> LinearRegression;
+typedef BasicLinearRegression<float> FloatLinearRegression;
+
+// Minimizes the ridge loss |X w + b - y|^2 / (2 n) + l2 |w|^2 / 2 over
+// the n rows of X exactly; the intercept b is zero without intercept
+// and never penalized. Features and targets are centered first. With
+// l2 > 0 the normal equations (Xc^T Xc + n l2 I) w = Xc^T yc are
+// formed by GEMM and solved by Cholesky; with l2 = 0 the centered
+// least squares problem goes through lstsq(), which keeps the accuracy
+// of QR and throws std::runtime_error for collinear features. Fewer
+// samples than features need l2 > 0.
+template <class T>
+BasicLinearRegression<T> fitLinearRegression(const BasicMatrix<T>& x,
+                                             const BasicVector<T>& y,
+                                             T l2 = 0, bool intercept = true);
+
+struct SgdOptions {
+    SgdOptions()
+        : batchSize(64), learningRate(0.01), decay(0), l2(0), shards(0),
+          intercept(true) {}
+
+    // Samples per gradient step.
+    int batchSize;
+    // Step t (counted in mini-batches) has length
+    // learningRate / (1 + decay t).
+    double learningRate;
+    double decay;
+    // Ridge penalty, as in fitLinearRegression().
+    double l2;
+    // Copies of the model trained side by side on interleaved
+    // mini-batches and averaged after each chunk. Zero means one per
+    // thread of ThreadPool::global(); fix it for results that do not
+    // depend on the number of threads.
+    int shards;
+    bool intercept;
+};
+
+// Mini-batch stochastic gradient descent on the loss of
+// fitLinearRegression(), for data streamed in chunks of rows that need
+// not fit in memory together. Every chunk is cut into mini-batches
+// dealt round-robin to the shards; each shard runs SGD from the
+// current model over its own mini-batches, in parallel, and the shard
+// models are averaged into the next one. Residuals and gradients of a
+// mini-batch are two GEMV calls over its rows. With one shard this is
+// plain sequential SGD.
+template <class T>
+class BasicSgdRegression {
+ public:
+    explicit BasicSgdRegression(int dims,
+                                const SgdOptions& options = SgdOptions());
+
+    // One pass over a chunk of samples, in order.
+    void partialFit(const BasicMatrix<T>& x, const BasicVector<T>& y);
+    // epochs passes over all of x.
+    void fit(const BasicMatrix<T>& x, const BasicVector<T>& y, int epochs);
+
+    const BasicLinearRegression<T>& model() const { return model_; }
+    const SgdOptions& options() const { return options_; }
+    // Mini-batch steps taken by each shard so far.
+    int64_t steps() const { return steps_; }
+
+ private:
+    BasicLinearRegression<T> model_;
+    SgdOptions options_;
+    int64_t steps_;
+};
+
+typedef BasicSgdRegression<double> SgdRegression;
+typedef BasicSgdRegression<float> FloatSgdRegression;
+
+#endif  // INCLUDE_ML_REGRESSION_H_
@@ -0,0 +1,95 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_SCALAR_H_
+#define INCLUDE_ML_SCALAR_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// Element types of vectors and matrices: double (the default), float,
+// int8_t and BFloat16.
+//
+// Arithmetic on an element type is carried out in its Accumulator type
+// and rounded back once: float for BFloat16, int32_t for int8_t. int8_t
+// results saturate to [-128, 127] instead of wrapping, and reductions
+// (dot products) return the accumulator type.
+
+// Brain floating point: the upper half of an IEEE float, with the same
+// range and an 8-bit significand. Conversions from float round to
+// nearest even; arithmetic goes through float.
+class BFloat16 {
+ public:
+    BFloat16() : bits_(0) {}
+    BFloat16(float value)  // NOLINT(runtime/explicit)
+        : bits_(roundBits(value)) {}
+
+    operator float() const {
+        uint32_t bits = static_cast<uint32_t>(bits_) << 16;
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint16_t bits() const { return bits_; }
+    static BFloat16 fromBits(uint16_t bits) {
+        BFloat16 value;
+        value.bits_ = bits;
+        return value;
+    }
+
+ private:
+    static uint16_t roundBits(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        if ((bits & 0x7FFFFFFF) > 0x7F800000) {
+            // Keep NaNs NaN (and quiet) whatever their payload.
+            return static_cast<uint16_t>((bits >> 16) | 0x0040);
+        }
+        bits += 0x7FFF + ((bits >> 16) & 1);
+        return static_cast<uint16_t>(bits >> 16);
+    }
+
+    uint16_t bits_;
+};
+
+template <class T>
+struct ScalarTraits {
+    typedef T Accumulator;
+    // Rounds an accumulated value back to the element type.
+    static T narrow(Accumulator value) { return value; }
+    // Converts any arithmetic value to the element type.
+    template <class U>
+    static T cast(U value) { return static_cast<T>(value); }
+};
+
+template <>
+struct ScalarTraits<int8_t> {
+    typedef int32_t Accumulator;
+    static int8_t narrow(Accumulator value) {
+        return static_cast<int8_t>(value < -128 ? -128 :
+                                   value > 127 ? 127 : value);
+    }
+    // Rounds to nearest and saturates; NaN becomes 0.
+    template <class U>
+    static int8_t cast(U value) {
+        double rounded = floor(static_cast<double>(value) + 0.5);
+        if (rounded != rounded) {
+            return 0;
+        }
+        return static_cast<int8_t>(rounded < -128.0 ? -128.0 :
+                                   rounded > 127.0 ? 127.0 : rounded);
+    }
+};
+
+template <>
+struct ScalarTraits<BFloat16> {
+    typedef float Accumulator;
+    static BFloat16 narrow(Accumulator value) { return BFloat16(value); }
+    template <class U>
+    static BFloat16 cast(U value) {
+        return BFloat16(static_cast<float>(value));
+    }
+};
+
+#endif  // INCLUDE_ML_SCALAR_H_
@@ -0,0 +1,92 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_SERIALIZATION_H_
+#define INCLUDE_ML_SERIALIZATION_H_
+
+#include <iostream>
+
+#include "ml/linear_algebra.h"
+
+// Binary format for Vector and Matrix, the same one mapMatrixFile()
+// reads: a 64-byte header (magic, version, element type, layout, byte
+// order, shape, flags), the raw row-major elements at a 64-byte aligned
+// offset and, optionally, a 64-bit checksum of the elements. A Vector
+// is stored as a single-row matrix.
+//
+// Files are written in host byte order and converted on read when they
+// come from a machine with the other one. Malformed input, checksum
+// mismatches and stream failures throw std::runtime_error.
+
+// Streams a cols x rows matrix out in chunks of whole rows, so a large
+// matrix never has to be in memory at once.
+class MatrixWriter {
+ public:
+    MatrixWriter(std::ostream* out, int cols, int rows,
+                 bool checksum = true);
+    ~MatrixWriter();
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int rowsWritten() const { return rowsWritten_; }
+
+    // Appends rows.rows() rows; rows.cols() must equal cols().
+    void writeRows(ConstMatrixView rows);
+    // Appends count rows stored contiguously at data.
+    void writeRows(const double* data, int count);
+    // Writes the checksum and flushes; call it once every row is out.
+    void finish();
+
+ private:
+    MatrixWriter(const MatrixWriter&);
+    MatrixWriter& operator =(const MatrixWriter&);
+
+    struct State;
+
+    std::ostream* out_;
+    State* state_;
+    int cols_;
+    int rows_;
+    int rowsWritten_;
+};
+
+// Reads a matrix written by MatrixWriter back in chunks of whole rows.
+class MatrixReader {
+ public:
+    // Reads and validates the header.
+    explicit MatrixReader(std::istream* in);
+    ~MatrixReader();
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int rowsLeft() const { return rows_ - rowsRead_; }
+    bool checksummed() const;
+
+    // Fills rows (rows.cols() must equal cols()) with the next
+    // rows.rows() rows. The checksum is verified with the last row.
+    void readRows(MatrixView rows);
+    // Reads the next count rows contiguously into data.
+    void readRows(double* data, int count);
+
+ private:
+    MatrixReader(const MatrixReader&);
+    MatrixReader& operator =(const MatrixReader&);
+
+    struct State;
+
+    void readPayload(double* data, size_t n);
+    void verify();
+
+    std::istream* in_;
+    State* state_;
+    int cols_;
+    int rows_;
+    int rowsRead_;
+};
+
+void writeMatrix(std::ostream* out, const Matrix& mat, bool checksum = true);
+Matrix readMatrix(std::istream* in);
+
+void writeVector(std::ostream* out, const Vector& vec, bool checksum = true);
+Vector readVector(std::istream* in);
+
+#endif  // INCLUDE_ML_SERIALIZATION_H_
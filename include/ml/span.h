@@ -0,0 +1,36 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_SPAN_H_
+#define INCLUDE_ML_SPAN_H_
+
+#include <assert.h>
+#include <stddef.h>
+
+// Non-owning view of a contiguous array: a pointer and a length. It is
+// only valid while the owner of the memory is alive and not resized.
+template <class T>
+class Span {
+ public:
+    Span() : data_(NULL), size_(0) {}
+    Span(T* data, size_t size) : data_(data), size_(size) {}
+    // Span<T> converts to Span<const T>.
+    template <class U>
+    Span(const Span<U>& other)  // NOLINT(runtime/explicit)
+        : data_(other.data()), size_(other.size()) {}
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+    T& operator[](size_t i) const {
+        assert(i < size_);
+        return data_[i];
+    }
+
+ private:
+    T* data_;
+    size_t size_;
+};
+
+#endif  // INCLUDE_ML_SPAN_H_
@@ -0,0 +1,150 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_SPARSE_H_
+#define INCLUDE_ML_SPARSE_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "ml/linear_algebra.h"
+
+// Sparse matrices store only their non-zero elements. Like Matrix they
+// are built as (cols, rows) and indexed as (row, col).
+//
+// - BasicCooMatrix: unordered (row, col, value) triplets, cheap to
+//   append to; the format to build a matrix in.
+// - BasicCsrMatrix: compressed rows. The values of row i are
+//   values()[rowStart()[i] .. rowStart()[i+1]), their columns sorted
+//   ascending in colIndex(). The format for products with dense
+//   operands, which run in parallel over rows.
+// - BasicCscMatrix: compressed columns, the CSR layout of the
+//   transpose. Cheap column access and A^T x products.
+//
+// Conversions between the three and to and from BasicMatrix sum
+// duplicate entries and drop nothing else; converting from a dense
+// matrix keeps its non-zero elements only. Element types are double
+// and float.
+
+template <class T>
+class BasicCooMatrix {
+ public:
+    BasicCooMatrix(int cols, int rows);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    size_t nonZeros() const { return values_.size(); }
+
+    // Appends an entry; entries at the same position add up.
+    void add(int i, int j, T value);
+    void reserve(size_t nonZeros);
+
+    const std::vector<int>& rowIndex() const { return rowIndex_; }
+    const std::vector<int>& colIndex() const { return colIndex_; }
+    const std::vector<T>& values() const { return values_; }
+
+    BasicMatrix<T> toDense() const;
+
+ private:
+    std::vector<int> rowIndex_;
+    std::vector<int> colIndex_;
+    std::vector<T> values_;
+    int cols_;
+    int rows_;
+};
+
+template <class T>
+class BasicCscMatrix;
+
+template <class T>
+class BasicCsrMatrix {
+ public:
+    BasicCsrMatrix(int cols, int rows);
+    // Takes the arrays of a valid CSR matrix (see above) as they are.
+    BasicCsrMatrix(int cols, int rows, std::vector<int64_t> rowStart,
+                   std::vector<int> colIndex, std::vector<T> values);
+    explicit BasicCsrMatrix(const BasicCooMatrix<T>& coo);
+    explicit BasicCsrMatrix(const BasicCscMatrix<T>& csc);
+    explicit BasicCsrMatrix(const BasicMatrix<T>& dense);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    size_t nonZeros() const { return values_.size(); }
+    // Element (i, j), zero when it is not stored; O(log(row length)).
+    T at(int i, int j) const;
+
+    const std::vector<int64_t>& rowStart() const { return rowStart_; }
+    const std::vector<int>& colIndex() const { return colIndex_; }
+    const std::vector<T>& values() const { return values_; }
+    // Values can be changed in place; the pattern cannot.
+    T* valuesPtr() { return values_.data(); }
+
+    BasicMatrix<T> toDense() const;
+    // The transpose, as a CSC matrix of the same arrays.
+    BasicCscMatrix<T> transposed() const;
+
+ private:
+    std::vector<int64_t> rowStart_;
+    std::vector<int> colIndex_;
+    std::vector<T> values_;
+    int cols_;
+    int rows_;
+};
+
+template <class T>
+class BasicCscMatrix {
+ public:
+    BasicCscMatrix(int cols, int rows);
+    BasicCscMatrix(int cols, int rows, std::vector<int64_t> colStart,
+                   std::vector<int> rowIndex, std::vector<T> values);
+    explicit BasicCscMatrix(const BasicCooMatrix<T>& coo);
+    explicit BasicCscMatrix(const BasicCsrMatrix<T>& csr);
+    explicit BasicCscMatrix(const BasicMatrix<T>& dense);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    size_t nonZeros() const { return values_.size(); }
+    T at(int i, int j) const;
+
+    const std::vector<int64_t>& colStart() const { return colStart_; }
+    const std::vector<int>& rowIndex() const { return rowIndex_; }
+    const std::vector<T>& values() const { return values_; }
+    T* valuesPtr() { return values_.data(); }
+
+    BasicMatrix<T> toDense() const;
+    BasicCsrMatrix<T> transposed() const;
+
+ private:
+    std::vector<int64_t> colStart_;
+    std::vector<int> rowIndex_;
+    std::vector<T> values_;
+    int cols_;
+    int rows_;
+};
+
+typedef BasicCooMatrix<double> CooMatrix;
+typedef BasicCsrMatrix<double> CsrMatrix;
+typedef BasicCscMatrix<double> CscMatrix;
+
+// Sparse x dense products. CSR products split the rows among the
+// threads of ThreadPool::global() by their number of non-zeros; CSC
+// products split the columns of the dense operand (SpMM) or reduce
+// per-thread partial results (SpMV). Each dense row update of SpMM runs
+// through the SIMD axpy kernel.
+template <class T>
+BasicVector<T> operator *(const BasicCsrMatrix<T>& a,
+                          const BasicVector<T>& x);
+template <class T>
+BasicMatrix<T> operator *(const BasicCsrMatrix<T>& a,
+                          const BasicMatrix<T>& b);
+template <class T>
+BasicVector<T> operator *(const BasicCscMatrix<T>& a,
+                          const BasicVector<T>& x);
+template <class T>
+BasicMatrix<T> operator *(const BasicCscMatrix<T>& a,
+                          const BasicMatrix<T>& b);
+template <class T>
+BasicVector<T> operator *(const BasicCooMatrix<T>& a,
+                          const BasicVector<T>& x);
+
+#endif  // INCLUDE_ML_SPARSE_H_
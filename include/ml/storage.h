@@ -0,0 +1,61 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_STORAGE_H_
+#define INCLUDE_ML_STORAGE_H_
+
+#include <stddef.h>
+
+#include <memory>
+
+class Allocator;
+
+// Element buffer behind vectors and matrices. It either owns heap
+// memory or refers to external memory (for example a memory-mapped
+// file) kept alive by a shared owner object.
+//
+// Copies are always deep and land on the heap. Assignment and resize()
+// write into the existing buffer when it is big enough, whoever owns
+// it; external memory is only left behind when it is too small. Move
+// assignment steals heap buffers but copies into external memory, so
+// `mapped = a + b` still writes through to the file.
+//
+// Heap buffers come from defaultAllocator() (see ml/allocator.h), are
+// 64-byte aligned and go back to the allocator that produced them.
+template <class T>
+class BasicStorage {
+ public:
+    BasicStorage();
+    explicit BasicStorage(size_t size, T value = T());
+    // Wraps external memory; owner is released with the last storage
+    // referring to it.
+    BasicStorage(T* data, size_t size, std::shared_ptr<void> owner);
+    BasicStorage(const BasicStorage& storage);
+    BasicStorage(BasicStorage&& storage) noexcept;  // NOLINT(build/c++11)
+    ~BasicStorage();
+
+    BasicStorage& operator =(const BasicStorage& storage);
+    BasicStorage& operator =(BasicStorage&& storage) noexcept;  // NOLINT
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    bool external() const { return owner_ != NULL; }
+
+    // Keeps the first min(size, size()) elements; new ones are zero.
+    void resize(size_t size);
+
+ private:
+    void release();
+
+    T* data_;
+    size_t size_;
+    size_t capacity_;
+    Allocator* allocator_;
+    std::shared_ptr<void> owner_;
+};
+
+typedef BasicStorage<double> Storage;
+
+#endif  // INCLUDE_ML_STORAGE_H_
@@ -0,0 +1,70 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_SVD_H_
+#define INCLUDE_ML_SVD_H_
+
+#include "ml/linear_algebra.h"
+#include "ml/sparse.h"
+
+enum SvdVectors {
+    // Singular values only.
+    kSvdNone,
+    // U (m x p) and V (n x p), p = min(m, n).
+    kSvdThin,
+    // Square U (m x m) and V (n x n).
+    kSvdFull
+};
+
+// Singular value decomposition A = U diag(s) V^T of an m x n matrix of
+// doubles or floats, singular values in descending order.
+//
+// The wide side is first reduced away by a Householder QR, of A or of
+// A^T, and the square R is diagonalized by one-sided Jacobi rotations,
+// which find even tiny singular values to high relative accuracy. Each
+// Jacobi round rotates a disjoint set of row pairs in parallel, in
+// round-robin order, until all rows are orthogonal. Singular vectors
+// of zero singular values complete an orthonormal basis.
+//
+// A matrix with non-finite elements, or Jacobi sweeps that do not
+// converge, throw std::runtime_error.
+template <class T>
+class BasicSvd {
+ public:
+    explicit BasicSvd(const BasicMatrix<T>& a, SvdVectors vectors = kSvdThin);
+    // Takes the factors as they are; randomizedSvd() returns these.
+    BasicSvd(BasicMatrix<T> u, BasicVector<T> singularValues,
+             BasicMatrix<T> v);
+
+    const BasicVector<T>& singularValues() const { return singularValues_; }
+    // The singular vectors in columns; empty with kSvdNone.
+    const BasicMatrix<T>& u() const { return u_; }
+    const BasicMatrix<T>& v() const { return v_; }
+
+ private:
+    BasicMatrix<T> u_;
+    BasicVector<T> singularValues_;
+    BasicMatrix<T> v_;
+};
+
+typedef BasicSvd<double> Svd;
+typedef BasicSvd<float> FloatSvd;
+
+// The k largest singular triplets of A, approximately, for k much
+// smaller than its dimensions (Halko, Martinsson and Tropp). A is
+// multiplied by a Gaussian n x (k + oversampling) matrix and its range
+// refined by powerIterations rounds of multiplication by A^T and A,
+// orthonormalized by QR in between; the SVD of the projection of A
+// onto that range gives the triplets. A is only ever multiplied, through
+// GEMM or SpMM on the thread pool: a dense A is never transposed or
+// copied, a sparse one is laid out once more as CSC for the products
+// with A^T. Results depend on seed only.
+template <class T>
+BasicSvd<T> randomizedSvd(const BasicMatrix<T>& a, int k,
+                          int oversampling = 10, int powerIterations = 2,
+                          unsigned seed = 0);
+template <class T>
+BasicSvd<T> randomizedSvd(const BasicCsrMatrix<T>& a, int k,
+                          int oversampling = 10, int powerIterations = 2,
+                          unsigned seed = 0);
+
+#endif  // INCLUDE_ML_SVD_H_
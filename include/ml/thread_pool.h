@@ -0,0 +1,57 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_THREAD_POOL_H_
+#define INCLUDE_ML_THREAD_POOL_H_
+
+#include <functional>
+
+// Persistent pool of worker threads. Every worker owns a task deque:
+// it pops its own tasks from the back and steals from the front of
+// the others' deques when it runs dry. The thread that calls
+// parallelFor() works on the same deques until its loop is done, so
+// nested parallel loops cannot deadlock.
+class ThreadPool {
+ public:
+    typedef std::function<void(int begin, int end)> Body;
+
+    // threads counts the calling thread too, so ThreadPool(1) runs
+    // everything inline. Zero means one thread per CPU the process may
+    // run on. When there are no more threads than such CPUs, workers
+    // are pinned to CPUs of their own, on separate cores first.
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    int threads() const;
+
+    // Calls body on consecutive [begin, end) chunks of [0, count) of
+    // at least grain elements each and waits for all of them. When a
+    // chunk throws, the chunks not yet started are skipped and the
+    // first exception is rethrown once the others have finished.
+    void parallelFor(int count, const Body& body, int grain = 1);
+
+    // Library-wide pool used by the parallel kernels. Its size comes
+    // from ML_LIB_NUM_THREADS or the number of CPUs the process may run
+    // on.
+    static ThreadPool& global();
+    // Replaces the global pool; must not race with running kernels.
+    static void setGlobalThreads(int threads);
+
+ private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator =(const ThreadPool&);
+
+    struct Loop;
+    struct Task;
+    struct Worker;
+    struct State;
+
+    bool popTask(int worker, Task* task);
+    bool stealTask(int thief, Task* task);
+    void runTask(const Task& task);
+    void workerLoop(int worker);
+
+    State* state_;
+    int threads_;
+};
+
+#endif  // INCLUDE_ML_THREAD_POOL_H_
@@ -0,0 +1,201 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef INCLUDE_ML_VIEW_H_
+#define INCLUDE_ML_VIEW_H_
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+
+#include <type_traits>  // NOLINT(build/c++11)
+
+#include "ml/expression.h"
+#include "ml/scalar.h"
+
+// Views alias the storage of a Matrix (or of another view) and never
+// allocate. Copying a view copies the reference; assigning to a view
+// writes elements through it. T is the element type for writable
+// views and its const version for read-only ones. A view is valid as
+// long as the matrix it came from is alive and not resized.
+//
+// Like any destination, a view may appear in the expression assigned
+// to it, but only at the same positions: m.row(0) = m.row(0) + x is
+// fine, m.transposed() = m is not.
+
+// Dot product of two strided arrays of n elements, accumulated in the
+// accumulator type of T.
+template <class T>
+typename ScalarTraits<T>::Accumulator dot(const T* a, int strideA,
+                                          const T* b, int strideB, int n);
+
+template <class T>
+class BasicVectorView : public VectorExpression<BasicVectorView<T> > {
+ public:
+    typedef typename std::remove_const<T>::type Scalar;
+
+    BasicVectorView(T* data, int dims, int stride = 1)
+        : data_(data), dims_(dims), stride_(stride) {}
+    // Writable views convert to read-only ones.
+    template <class U>
+    BasicVectorView(const BasicVectorView<U>& view)  // NOLINT
+        : data_(view.ptr()), dims_(view.dims()), stride_(view.stride()) {}
+
+    int dims() const { return dims_; }
+    int stride() const { return stride_; }
+    T* ptr() const { return data_; }
+    T& at(int i) const { return data_[static_cast<ptrdiff_t>(i)*stride_]; }
+    double length() const {
+        return sqrt(static_cast<double>(
+            dot<Scalar>(data_, stride_, data_, stride_, dims_)));
+    }
+
+    BasicVectorView& operator =(const BasicVectorView& view) {
+        assign(view);
+        return *this;
+    }
+    template <class E>
+    BasicVectorView& operator =(const VectorExpression<E>& expr) {
+        assign(expr.self());
+        return *this;
+    }
+    template <class E>
+    BasicVectorView& operator +=(const VectorExpression<E>& expr) {
+        assign(*this + expr);
+        return *this;
+    }
+    template <class E>
+    BasicVectorView& operator -=(const VectorExpression<E>& expr) {
+        assign(*this - expr);
+        return *this;
+    }
+    template <class E>
+    BasicVectorView& operator *=(const VectorExpression<E>& expr) {
+        assign(*this * expr);
+        return *this;
+    }
+    BasicVectorView& operator *=(Scalar a) {
+        assign(a * *this);
+        return *this;
+    }
+
+ private:
+    template <class E>
+    void assign(const E& expr) {
+        assert(expr.dims() == dims_);
+        for (int i = 0; i < dims_; i++) {
+            data_[static_cast<ptrdiff_t>(i)*stride_] = expr.at(i);
+        }
+    }
+
+    T* data_;
+    int dims_;
+    int stride_;
+};
+
+typedef BasicVectorView<double> VectorView;
+typedef BasicVectorView<const double> ConstVectorView;
+
+template <class T, class U>
+typename ScalarTraits<typename BasicVectorView<T>::Scalar>::Accumulator
+dot(const BasicVectorView<T>& lhs, const BasicVectorView<U>& rhs) {
+    assert(lhs.dims() == rhs.dims());
+    return dot<typename BasicVectorView<T>::Scalar>(
+        lhs.ptr(), lhs.stride(), rhs.ptr(), rhs.stride(), lhs.dims());
+}
+
+template <class T>
+class BasicMatrixView : public MatrixExpression<BasicMatrixView<T> > {
+ public:
+    typedef typename std::remove_const<T>::type Scalar;
+
+    // Element (i, j) lives at data[i*rowStride + j*colStride].
+    BasicMatrixView(T* data, int rows, int cols, int rowStride,
+                    int colStride = 1)
+        : data_(data), rows_(rows), cols_(cols),
+          rowStride_(rowStride), colStride_(colStride) {}
+    template <class U>
+    BasicMatrixView(const BasicMatrixView<U>& view)  // NOLINT
+        : data_(view.ptr()), rows_(view.rows()), cols_(view.cols()),
+          rowStride_(view.rowStride()), colStride_(view.colStride()) {}
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int rowStride() const { return rowStride_; }
+    int colStride() const { return colStride_; }
+    T* ptr() const { return data_; }
+    T& at(int i, int j) const {
+        return data_[offset(i, j)];
+    }
+
+    BasicVectorView<T> row(int i) const {
+        assert(0 <= i && i < rows_);
+        return BasicVectorView<T>(data_ + offset(i, 0), cols_, colStride_);
+    }
+    BasicVectorView<T> col(int j) const {
+        assert(0 <= j && j < cols_);
+        return BasicVectorView<T>(data_ + offset(0, j), rows_, rowStride_);
+    }
+    // rows x cols sub-matrix whose top-left element is (i, j).
+    BasicMatrixView block(int i, int j, int rows, int cols) const {
+        assert(0 <= i && 0 <= j && i + rows <= rows_ && j + cols <= cols_);
+        return BasicMatrixView(data_ + offset(i, j),
+                               rows, cols, rowStride_, colStride_);
+    }
+    BasicMatrixView transposed() const {
+        return BasicMatrixView(data_, cols_, rows_, colStride_, rowStride_);
+    }
+
+    BasicMatrixView& operator =(const BasicMatrixView& view) {
+        assign(view);
+        return *this;
+    }
+    template <class E>
+    BasicMatrixView& operator =(const MatrixExpression<E>& expr) {
+        assign(expr.self());
+        return *this;
+    }
+    template <class E>
+    BasicMatrixView& operator +=(const MatrixExpression<E>& expr) {
+        assign(*this + expr);
+        return *this;
+    }
+    template <class E>
+    BasicMatrixView& operator -=(const MatrixExpression<E>& expr) {
+        assign(*this - expr);
+        return *this;
+    }
+    BasicMatrixView& operator *=(Scalar a) {
+        assign(a * *this);
+        return *this;
+    }
+
+ private:
+    // In ptrdiff_t: views of large matrices span more than 2^31
+    // elements.
+    ptrdiff_t offset(int i, int j) const {
+        return static_cast<ptrdiff_t>(i)*rowStride_ +
+               static_cast<ptrdiff_t>(j)*colStride_;
+    }
+
+    template <class E>
+    void assign(const E& expr) {
+        assert(expr.rows() == rows_ && expr.cols() == cols_);
+        for (int i = 0; i < rows_; i++) {
+            T* row = data_ + offset(i, 0);
+            for (int j = 0; j < cols_; j++) {
+                row[static_cast<ptrdiff_t>(j)*colStride_] = expr.at(i, j);
+            }
+        }
+    }
+
+    T* data_;
+    int rows_;
+    int cols_;
+    int rowStride_;
+    int colStride_;
+};
+
+typedef BasicMatrixView<double> MatrixView;
+typedef BasicMatrixView<const double> ConstMatrixView;
+
+#endif  // INCLUDE_ML_VIEW_H_
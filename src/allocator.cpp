@@ -0,0 +1,213 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/allocator.h"
+
+#include <stdlib.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include <atomic>  // NOLINT(build/c++11)
+#include <new>
+
+namespace {
+
+// Size classes: 64, 128, 192 and 256 bytes, then four evenly spaced
+// classes in every (2^e, 2^(e+1)] up to kMaxPooledBytes.
+const int kSmallClasses = 4;
+const int kSmallShift = 6;
+const int kFirstExponent = 8;
+// PooledAllocator::kMaxPooledBytes is 2^kLastExponent.
+const int kLastExponent = 26;
+const int kClasses = kSmallClasses + 4 * (kLastExponent - kFirstExponent);
+
+int floorLog2(size_t value) {
+    int log = 0;
+    while (value >>= 1) {
+        log++;
+    }
+    return log;
+}
+
+int sizeClass(size_t bytes) {
+    if (bytes <= kSmallClasses << kSmallShift) {
+        return static_cast<int>((bytes - 1) >> kSmallShift);
+    }
+    int e = floorLog2(bytes - 1);
+    size_t step = static_cast<size_t>(1) << (e - 2);
+    int k = static_cast<int>((bytes - (static_cast<size_t>(1) << e) +
+                              step - 1) / step);
+    return kSmallClasses + 4 * (e - kFirstExponent) + k - 1;
+}
+
+size_t classBytes(int sizeClass) {
+    if (sizeClass < kSmallClasses) {
+        return static_cast<size_t>(sizeClass + 1) << kSmallShift;
+    }
+    int e = kFirstExponent + (sizeClass - kSmallClasses) / 4;
+    int k = (sizeClass - kSmallClasses) % 4 + 1;
+    return (static_cast<size_t>(1) << e) +
+           (static_cast<size_t>(k) << (e - 2));
+}
+
+AlignedAllocator systemAllocator;
+PooledAllocator builtinPool;
+std::atomic<Allocator*> currentDefault(&builtinPool);
+thread_local Allocator* scopedDefault = NULL;
+
+// Free buffers are chained through their first word.
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Plain thread_local flags stay readable after the cache of the thread
+// is destroyed, unlike the cache itself; buffers freed that late (by
+// static matrices, say) go straight back to the system.
+thread_local bool cacheDestroyed = false;
+
+struct ThreadCache {
+    FreeBlock* lists[kClasses];
+    size_t cached;
+
+    ThreadCache() : cached(0) {
+        for (int c = 0; c < kClasses; c++) {
+            lists[c] = NULL;
+        }
+    }
+
+    ~ThreadCache() {
+        release();
+        cacheDestroyed = true;
+    }
+
+    void release() {
+        for (int c = 0; c < kClasses; c++) {
+            while (lists[c] != NULL) {
+                FreeBlock* block = lists[c];
+                lists[c] = block->next;
+                systemAllocator.deallocate(block, classBytes(c));
+            }
+        }
+        cached = 0;
+    }
+};
+
+ThreadCache* threadCache() {
+    if (cacheDestroyed) {
+        return NULL;
+    }
+    static thread_local ThreadCache cache;
+    return &cache;
+}
+
+}  // namespace
+
+const size_t Allocator::kAlignment;
+const size_t AlignedAllocator::kHugePageBytes;
+const size_t PooledAllocator::kMaxPooledBytes;
+const size_t PooledAllocator::kMaxCachedBytes;
+
+void* AlignedAllocator::allocate(size_t bytes) {
+    bool huge = bytes >= kHugePageBytes;
+    size_t alignment = huge ? kHugePageBytes : kAlignment;
+#if defined(_WIN32)
+    void* p = _aligned_malloc(bytes, alignment);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+#else
+    void* p = NULL;
+    if (posix_memalign(&p, alignment, bytes) != 0) {
+        throw std::bad_alloc();
+    }
+#if defined(MADV_HUGEPAGE)
+    // Only a hint: the buffer works the same without huge pages.
+    if (huge) {
+        madvise(p, bytes, MADV_HUGEPAGE);
+    }
+#endif
+#endif
+    return p;
+}
+
+void AlignedAllocator::deallocate(void* p, size_t /* bytes */) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+void* PooledAllocator::allocate(size_t bytes) {
+    if (bytes > kMaxPooledBytes) {
+        return systemAllocator.allocate(bytes);
+    }
+
+    // Always a whole class: whichever thread frees the buffer may put
+    // it on its free list.
+    int c = sizeClass(bytes);
+    ThreadCache* cache = threadCache();
+    FreeBlock* block = cache == NULL ? NULL : cache->lists[c];
+    if (block != NULL) {
+        cache->lists[c] = block->next;
+        cache->cached -= classBytes(c);
+        return block;
+    }
+
+    return systemAllocator.allocate(classBytes(c));
+}
+
+void PooledAllocator::deallocate(void* p, size_t bytes) {
+    ThreadCache* cache = threadCache();
+    if (bytes > kMaxPooledBytes) {
+        systemAllocator.deallocate(p, bytes);
+        return;
+    }
+
+    int c = sizeClass(bytes);
+    size_t size = classBytes(c);
+    if (cache == NULL || cache->cached + size > kMaxCachedBytes) {
+        systemAllocator.deallocate(p, size);
+        return;
+    }
+
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+    block->next = cache->lists[c];
+    cache->lists[c] = block;
+    cache->cached += size;
+}
+
+size_t PooledAllocator::cachedBytes() {
+    ThreadCache* cache = threadCache();
+    return cache == NULL ? 0 : cache->cached;
+}
+
+void PooledAllocator::trim() {
+    ThreadCache* cache = threadCache();
+    if (cache != NULL) {
+        cache->release();
+    }
+}
+
+Allocator* defaultAllocator() {
+    if (scopedDefault != NULL) {
+        return scopedDefault;
+    }
+    return currentDefault.load(std::memory_order_acquire);
+}
+
+void setDefaultAllocator(Allocator* allocator) {
+    currentDefault.store(allocator == NULL ? &builtinPool : allocator,
+                         std::memory_order_release);
+}
+
+AllocatorScope::AllocatorScope(Allocator* allocator)
+    : previous_(scopedDefault) {
+    scopedDefault = allocator;
+}
+
+AllocatorScope::~AllocatorScope() {
+    scopedDefault = previous_;
+}
@@ -0,0 +1,98 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/arena.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+size_t roundUp(size_t value, size_t step) {
+    return (value + step - 1) / step * step;
+}
+
+}  // namespace
+
+const size_t Arena::kDefaultChunkBytes;
+
+Arena::Arena(size_t chunkBytes)
+    : chunkBytes_(roundUp(std::max<size_t>(chunkBytes, 1), kAlignment)),
+      current_(0), offset_(0), spilled_(0), live_(0) {
+}
+
+Arena::~Arena() {
+    assert(live_ == 0);
+    releaseChunks();
+}
+
+void* Arena::allocate(size_t bytes) {
+    size_t size = roundUp(bytes, kAlignment);
+    while (current_ < chunks_.size() &&
+           offset_ + size > chunks_[current_].size) {
+        // The tail of a skipped chunk is lost until reset().
+        spilled_ += offset_;
+        current_++;
+        offset_ = 0;
+    }
+    if (current_ == chunks_.size()) {
+        addChunk(std::max(size, chunkBytes_));
+    }
+
+    char* p = chunks_[current_].data + offset_;
+    offset_ += size;
+    live_++;
+    return p;
+}
+
+void Arena::deallocate(void* p, size_t bytes) {
+    assert(live_ > 0);
+    live_--;
+
+    // Buffers freed in reverse order of allocation, as temporaries of
+    // nested expressions are, are reused right away.
+    size_t size = roundUp(bytes, kAlignment);
+    if (current_ < chunks_.size() && size <= offset_ &&
+        chunks_[current_].data + offset_ - size == p) {
+        offset_ -= size;
+    }
+}
+
+void Arena::reset() {
+    assert(live_ == 0);
+    if (chunks_.size() > 1) {
+        size_t total = reservedBytes();
+        releaseChunks();
+        addChunk(total);
+    }
+    current_ = 0;
+    offset_ = 0;
+    spilled_ = 0;
+}
+
+size_t Arena::usedBytes() const {
+    return spilled_ + offset_;
+}
+
+size_t Arena::reservedBytes() const {
+    size_t total = 0;
+    for (size_t i = 0; i < chunks_.size(); i++) {
+        total += chunks_[i].size;
+    }
+    return total;
+}
+
+void Arena::addChunk(size_t size) {
+    Chunk chunk;
+    chunk.data = static_cast<char*>(system_.allocate(size));
+    chunk.size = size;
+    chunks_.push_back(chunk);
+}
+
+void Arena::releaseChunks() {
+    for (size_t i = 0; i < chunks_.size(); i++) {
+        system_.deallocate(chunks_[i].data, chunks_[i].size);
+    }
+    chunks_.clear();
+}
@@ -0,0 +1,415 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/batch.h"
+
+#include <assert.h>
+#include <math.h>
+
+#include <algorithm>
+
+#include "ml/thread_pool.h"
+#include "src/simd.h"
+
+using std::max;
+
+namespace {
+
+// Groups of fewer multiply-adds than this are handed to one thread
+// together.
+const size_t kParallelWork = 16 * 1024;
+
+// Output columns of a product kept in registers across the inner
+// dimension.
+const int kBlockCols = 4;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ML_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ML_ALWAYS_INLINE inline
+#endif
+
+// The kernels below work on one group, so every inner loop runs over
+// the kLanes matrices of the group, a compile-time count of contiguous
+// elements that the compiler turns into whole vector registers. They
+// are inlined into one wrapper per instruction set.
+
+// kCols columns of row i of c = a b, from column j; a is m x k, b k x n.
+template <class T, int kCols>
+ML_ALWAYS_INLINE void multiplyColumns(int i, int j, int k, int n,
+                                      const T* a, const T* b, T* c) {
+    const int kLanes = BasicMatrixBatch<T>::kLanes;
+    T sum[kCols][kLanes] = {};
+    for (int p = 0; p < k; p++) {
+        const T* ap = a + (static_cast<size_t>(i) * k + p) * kLanes;
+        const T* bp = b + (static_cast<size_t>(p) * n + j) * kLanes;
+        for (int col = 0; col < kCols; col++) {
+            for (int l = 0; l < kLanes; l++) {
+                sum[col][l] += ap[l] * bp[col * kLanes + l];
+            }
+        }
+    }
+    T* ci = c + (static_cast<size_t>(i) * n + j) * kLanes;
+    for (int col = 0; col < kCols; col++) {
+        for (int l = 0; l < kLanes; l++) {
+            ci[col * kLanes + l] = sum[col][l];
+        }
+    }
+}
+
+template <class T>
+ML_ALWAYS_INLINE void multiplyGroup(int m, int k, int n, const T* a,
+                                    const T* b, T* c) {
+    for (int i = 0; i < m; i++) {
+        int j = 0;
+        for (; j + kBlockCols <= n; j += kBlockCols) {
+            multiplyColumns<T, kBlockCols>(i, j, k, n, a, b, c);
+        }
+        for (; j < n; j++) {
+            multiplyColumns<T, 1>(i, j, k, n, a, b, c);
+        }
+    }
+}
+
+// Exchanges columns [begin, end) of rows top and row in the lanes
+// whose pivotRow is i.
+template <class T>
+ML_ALWAYS_INLINE void swapRows(int i, const T* pivotRow, int begin, int end,
+                               T* top, T* row) {
+    const int kLanes = BasicMatrixBatch<T>::kLanes;
+    for (int c = begin; c < end; c++) {
+        T* topc = top + c * kLanes;
+        T* rowc = row + c * kLanes;
+        for (int l = 0; l < kLanes; l++) {
+            bool swap = pivotRow[l] == T(i);
+            T value = topc[l];
+            topc[l] = swap ? rowc[l] : value;
+            rowc[l] = swap ? value : rowc[l];
+        }
+    }
+}
+
+// Solves a x = b for the n x n a and n x nrhs x, which holds b on
+// entry, by Gaussian elimination with partial pivoting; a is
+// overwritten. Each lane pivots on its own rows: the exchanges are
+// blends, done only for the rows some lane picked. zeroPivot[l] is set
+// to 1 for the lanes that meet an exact zero pivot, which divide by 1
+// instead so the other lanes never see a NaN.
+template <class T>
+ML_ALWAYS_INLINE void solveGroup(int n, int nrhs, T* a, T* x, T* zeroPivot) {
+    const int kLanes = BasicMatrixBatch<T>::kLanes;
+    T pivotRow[kLanes];
+    T largest[kLanes];
+    T inverse[kLanes];
+    for (int l = 0; l < kLanes; l++) {
+        zeroPivot[l] = 0;
+    }
+    for (int j = 0; j < n; j++) {
+        T* aj = a + static_cast<size_t>(j) * n * kLanes;
+        T* xj = x + static_cast<size_t>(j) * nrhs * kLanes;
+        for (int l = 0; l < kLanes; l++) {
+            pivotRow[l] = T(j);
+            largest[l] = fabs(aj[j * kLanes + l]);
+        }
+        for (int i = j + 1; i < n; i++) {
+            const T* aij = a + (static_cast<size_t>(i) * n + j) * kLanes;
+            for (int l = 0; l < kLanes; l++) {
+                T value = fabs(aij[l]);
+                bool larger = value > largest[l];
+                largest[l] = larger ? value : largest[l];
+                pivotRow[l] = larger ? T(i) : pivotRow[l];
+            }
+        }
+        for (int i = j + 1; i < n; i++) {
+            bool picked = false;
+            for (int l = 0; l < kLanes; l++) {
+                picked |= pivotRow[l] == T(i);
+            }
+            if (!picked) {
+                continue;
+            }
+            T* ai = a + static_cast<size_t>(i) * n * kLanes;
+            T* xi = x + static_cast<size_t>(i) * nrhs * kLanes;
+            swapRows(i, pivotRow, j, n, aj, ai);
+            swapRows(i, pivotRow, 0, nrhs, xj, xi);
+        }
+        for (int l = 0; l < kLanes; l++) {
+            bool zero = largest[l] == 0;
+            zeroPivot[l] = zero ? T(1) : zeroPivot[l];
+            inverse[l] = T(1) / (zero ? T(1) : aj[j * kLanes + l]);
+            aj[j * kLanes + l] = inverse[l];
+        }
+        for (int i = j + 1; i < n; i++) {
+            T* ai = a + static_cast<size_t>(i) * n * kLanes;
+            T* xi = x + static_cast<size_t>(i) * nrhs * kLanes;
+            T factor[kLanes];
+            for (int l = 0; l < kLanes; l++) {
+                factor[l] = ai[j * kLanes + l] * inverse[l];
+            }
+            for (int c = j + 1; c < n; c++) {
+                for (int l = 0; l < kLanes; l++) {
+                    ai[c * kLanes + l] -= factor[l] * aj[c * kLanes + l];
+                }
+            }
+            for (int c = 0; c < nrhs; c++) {
+                for (int l = 0; l < kLanes; l++) {
+                    xi[c * kLanes + l] -= factor[l] * xj[c * kLanes + l];
+                }
+            }
+        }
+    }
+    // Back substitution; the diagonal of a holds the pivot reciprocals.
+    for (int i = n - 1; i >= 0; i--) {
+        const T* ai = a + static_cast<size_t>(i) * n * kLanes;
+        T* xi = x + static_cast<size_t>(i) * nrhs * kLanes;
+        for (int p = i + 1; p < n; p++) {
+            const T* xp = x + static_cast<size_t>(p) * nrhs * kLanes;
+            for (int c = 0; c < nrhs; c++) {
+                for (int l = 0; l < kLanes; l++) {
+                    xi[c * kLanes + l] -= ai[p * kLanes + l] *
+                                          xp[c * kLanes + l];
+                }
+            }
+        }
+        for (int c = 0; c < nrhs; c++) {
+            for (int l = 0; l < kLanes; l++) {
+                xi[c * kLanes + l] *= ai[i * kLanes + l];
+            }
+        }
+    }
+}
+
+template <class T>
+struct BatchKernels {
+    typedef void (*Multiply)(int m, int k, int n, const T* a, const T* b,
+                             T* c);
+    typedef void (*Solve)(int n, int nrhs, T* a, T* x, T* zeroPivot);
+
+    Multiply multiply;
+    Solve solve;
+};
+
+#define ML_BATCH_KERNELS(suffix, target)                                    \
+    template <class T>                                                      \
+    target void multiply##suffix(int m, int k, int n, const T* a,           \
+                                 const T* b, T* c) {                        \
+        multiplyGroup(m, k, n, a, b, c);                                    \
+    }                                                                       \
+    template <class T>                                                      \
+    target void solve##suffix(int n, int nrhs, T* a, T* x, T* zeroPivot) {  \
+        solveGroup(n, nrhs, a, x, zeroPivot);                               \
+    }
+
+ML_BATCH_KERNELS(Generic, )
+#if defined(ML_SIMD_X86)
+ML_BATCH_KERNELS(Avx2, ML_TARGET_AVX2)
+#if defined(ML_SIMD_AVX512)
+ML_BATCH_KERNELS(Avx512, ML_TARGET_AVX512)
+#endif
+#endif
+
+template <class T>
+BatchKernels<T> selectBatchKernels() {
+    BatchKernels<T> table = { multiplyGeneric<T>, solveGeneric<T> };
+#if defined(ML_SIMD_X86)
+    if (kernels::activeIsa() >= kernels::kIsaAvx2) {
+        table.multiply = multiplyAvx2<T>;
+        table.solve = solveAvx2<T>;
+    }
+#if defined(ML_SIMD_AVX512)
+    if (kernels::activeIsa() == kernels::kIsaAvx512) {
+        table.multiply = multiplyAvx512<T>;
+        table.solve = solveAvx512<T>;
+    }
+#endif
+#endif
+    return table;
+}
+
+template <class T>
+const BatchKernels<T>& batchKernels() {
+    static const BatchKernels<T> table = selectBatchKernels<T>();
+    return table;
+}
+
+// Groups per parallel task for groups of work multiply-adds each.
+int groupGrain(size_t work) {
+    return static_cast<int>(max<size_t>(1, kParallelWork / max<size_t>(1,
+                                                                  work)));
+}
+
+template <class T>
+bool sameShape(const BasicMatrixBatch<T>& a, const BasicMatrixBatch<T>& b) {
+    return a.count() == b.count() && a.rows() == b.rows() &&
+           a.cols() == b.cols();
+}
+
+// Solves every a(k) x(k) = b(k), b being the identity when NULL.
+template <class T>
+int solveGroups(const BasicMatrixBatch<T>& a, const BasicMatrixBatch<T>* b,
+                BasicMatrixBatch<T>* x, bool* singular) {
+    const int kLanes = BasicMatrixBatch<T>::kLanes;
+    int n = a.rows();
+    int nrhs = x->cols();
+    int count = a.count();
+    size_t matrixSize = static_cast<size_t>(n) * n * kLanes;
+    size_t rhsSize = static_cast<size_t>(n) * nrhs * kLanes;
+    BasicStorage<T> zeroPivot(static_cast<size_t>(a.groups()) * kLanes);
+    T* flags = zeroPivot.data();
+    typename BatchKernels<T>::Solve solve = batchKernels<T>().solve;
+    ThreadPool::global().parallelFor(a.groups(),
+        [&a, b, x, n, nrhs, matrixSize, rhsSize, flags, solve](int begin,
+                                                               int end) {
+            BasicStorage<T> work(matrixSize);
+            for (int g = begin; g < end; g++) {
+                const T* ag = a.group(g);
+                std::copy(ag, ag + matrixSize, work.data());
+                T* xg = x->group(g);
+                if (b == NULL) {
+                    std::fill(xg, xg + rhsSize, T(0));
+                    for (int i = 0; i < n; i++) {
+                        std::fill_n(xg + (static_cast<size_t>(i) * n + i) *
+                                    kLanes, kLanes, T(1));
+                    }
+                } else if (b != x) {
+                    const T* bg = b->group(g);
+                    std::copy(bg, bg + rhsSize, xg);
+                }
+                solve(n, nrhs, work.data(), xg, flags + g * kLanes);
+            }
+        }, groupGrain(static_cast<size_t>(n) * n * (n + nrhs)));
+
+    int failures = 0;
+    for (int i = 0; i < count; i++) {
+        failures += flags[i] != 0;
+        if (singular != NULL) {
+            singular[i] = flags[i] != 0;
+        }
+    }
+    return failures;
+}
+
+}  // namespace
+
+template <class T>
+BasicMatrixBatch<T>::BasicMatrixBatch(int count, int cols, int rows)
+    : storage_(static_cast<size_t>((count + kLanes - 1) / kLanes) * kLanes *
+               rows * cols),
+      count_(count),
+      cols_(cols),
+      rows_(rows) {
+    assert(count >= 0 && cols >= 0 && rows >= 0);
+}
+
+template <class T>
+BasicMatrixBatch<T>::BasicMatrixBatch(int count, int cols, int rows,
+                                      const T* matrices)
+    : BasicMatrixBatch(count, cols, rows) {
+    size_t matrixSize = static_cast<size_t>(rows) * cols;
+    for (int index = 0; index < count; index++) {
+        const T* source = matrices + index * matrixSize;
+        T* target = &at(index, 0, 0);
+        for (size_t e = 0; e < matrixSize; e++) {
+            target[e * kLanes] = source[e];
+        }
+    }
+}
+
+template <class T>
+BasicMatrix<T> BasicMatrixBatch<T>::get(int index) const {
+    assert(index >= 0 && index < count_);
+    BasicMatrix<T> mat(cols_, rows_);
+    const T* source = &at(index, 0, 0);
+    T* target = mat.ptr();
+    for (size_t e = 0; e < mat.size(); e++) {
+        target[e] = source[e * kLanes];
+    }
+    return mat;
+}
+
+template <class T>
+void BasicMatrixBatch<T>::set(int index, const BasicMatrix<T>& mat) {
+    assert(index >= 0 && index < count_);
+    assert(mat.rows() == rows_ && mat.cols() == cols_);
+    for (int i = 0; i < rows_; i++) {
+        for (int j = 0; j < cols_; j++) {
+            at(index, i, j) = mat.at(i, j);
+        }
+    }
+}
+
+template <class T>
+void BasicMatrixBatch<T>::copyTo(T* matrices) const {
+    size_t matrixSize = static_cast<size_t>(rows_) * cols_;
+    for (int index = 0; index < count_; index++) {
+        const T* source = &at(index, 0, 0);
+        T* target = matrices + index * matrixSize;
+        for (size_t e = 0; e < matrixSize; e++) {
+            target[e] = source[e * kLanes];
+        }
+    }
+}
+
+template <class T>
+const int BasicMatrixBatch<T>::kLanes;
+
+template <class T>
+void multiplyBatch(const BasicMatrixBatch<T>& a, const BasicMatrixBatch<T>& b,
+                   BasicMatrixBatch<T>* c) {
+    assert(a.count() == b.count() && a.cols() == b.rows());
+    assert(c->count() == a.count() && c->rows() == a.rows() &&
+           c->cols() == b.cols());
+    int m = a.rows();
+    int k = a.cols();
+    int n = b.cols();
+    typename BatchKernels<T>::Multiply multiply = batchKernels<T>().multiply;
+    ThreadPool::global().parallelFor(a.groups(),
+        [&a, &b, c, m, k, n, multiply](int begin, int end) {
+            for (int g = begin; g < end; g++) {
+                multiply(m, k, n, a.group(g), b.group(g), c->group(g));
+            }
+        }, groupGrain(static_cast<size_t>(m) * k * n));
+}
+
+template <class T>
+void addBatch(const BasicMatrixBatch<T>& a, const BasicMatrixBatch<T>& b,
+              BasicMatrixBatch<T>* c) {
+    assert(sameShape(a, b) && sameShape(a, *c));
+    size_t groupSize = static_cast<size_t>(a.rows()) * a.cols() *
+                       BasicMatrixBatch<T>::kLanes;
+    ThreadPool::global().parallelFor(a.groups(),
+        [&a, &b, c, groupSize](int begin, int end) {
+            kernels::add(a.group(begin), b.group(begin), c->group(begin),
+                         (end - begin) * groupSize);
+        }, groupGrain(groupSize));
+}
+
+template <class T>
+int solveBatch(const BasicMatrixBatch<T>& a, const BasicMatrixBatch<T>& b,
+               BasicMatrixBatch<T>* x, bool* singular) {
+    assert(a.rows() == a.cols() && b.rows() == a.rows());
+    assert(b.count() == a.count() && sameShape(b, *x));
+    return solveGroups(a, &b, x, singular);
+}
+
+template <class T>
+int inverseBatch(const BasicMatrixBatch<T>& a, BasicMatrixBatch<T>* inverse,
+                 bool* singular) {
+    assert(a.rows() == a.cols() && sameShape(a, *inverse));
+    return solveGroups<T>(a, NULL, inverse, singular);
+}
+
+template class BasicMatrixBatch<double>;
+template class BasicMatrixBatch<float>;
+template void multiplyBatch(const MatrixBatch&, const MatrixBatch&,
+                            MatrixBatch*);
+template void multiplyBatch(const FloatMatrixBatch&, const FloatMatrixBatch&,
+                            FloatMatrixBatch*);
+template void addBatch(const MatrixBatch&, const MatrixBatch&, MatrixBatch*);
+template void addBatch(const FloatMatrixBatch&, const FloatMatrixBatch&,
+                       FloatMatrixBatch*);
+template int solveBatch(const MatrixBatch&, const MatrixBatch&, MatrixBatch*,
+                        bool*);
+template int solveBatch(const FloatMatrixBatch&, const FloatMatrixBatch&,
+                        FloatMatrixBatch*, bool*);
+template int inverseBatch(const MatrixBatch&, MatrixBatch*, bool*);
+template int inverseBatch(const FloatMatrixBatch&, FloatMatrixBatch*, bool*);
@@ -0,0 +1,360 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/cholesky.h"
+
+#include <assert.h>
+#include <math.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ml/thread_pool.h"
+#include "src/gemm.h"
+#include "src/simd.h"
+#include "src/transpose.h"
+#include "src/triangular.h"
+
+using std::min;
+using std::vector;
+
+namespace {
+
+// Columns per block. Blocks of the diagonal are factored directly; the
+// trailing matrix is updated a block at a time through GEMM.
+const int kBlock = 64;
+
+// Rows of the trailing matrix per GEMM call of its update, which only
+// reaches the diagonal of each band rather than the whole width.
+const int kUpdateRows = 256;
+
+// Rows below the diagonal block solved by one task.
+const int kRowsPerTask = 32;
+
+// Factors the n x n block at a in place, reading its lower triangle,
+// one column at a time. Returns false if a pivot is not positive.
+template <class T>
+bool factorBlock(int n, T* a, int lda) {
+    for (int j = 0; j < n; j++) {
+        T* aj = a + static_cast<size_t>(j) * lda;
+        T pivot = aj[j] - kernels::dot(aj, aj, j);
+        // Also false for NaN.
+        if (!(pivot > T(0))) {
+            return false;
+        }
+        aj[j] = sqrt(pivot);
+        for (int i = j + 1; i < n; i++) {
+            T* ai = a + static_cast<size_t>(i) * lda;
+            ai[j] = (ai[j] - kernels::dot(ai, aj, j)) / aj[j];
+        }
+    }
+    return true;
+}
+
+// Rows [begin, end) of L21 = A21 L11^-T: each row is a forward
+// substitution against L11 (kb x kb at l11).
+template <class T>
+void solveRows(int kb, const T* l11, int lda, T* a21, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        T* ai = a21 + static_cast<size_t>(i) * lda;
+        for (int j = 0; j < kb; j++) {
+            const T* lj = l11 + static_cast<size_t>(j) * lda;
+            ai[j] = (ai[j] - kernels::dot(ai, lj, j)) / lj[j];
+        }
+    }
+}
+
+template <class T>
+bool factorBlocked(int n, T* a, int lda) {
+    vector<T> panelT;
+    for (int k = 0; k < n; k += kBlock) {
+        int kb = min(kBlock, n - k);
+        T* akk = a + static_cast<size_t>(k) * lda + k;
+        if (!factorBlock(kb, akk, lda)) {
+            return false;
+        }
+
+        int rest = n - k - kb;
+        if (rest == 0) {
+            break;
+        }
+        T* a21 = akk + static_cast<size_t>(kb) * lda;
+        int tasks = (rest + kRowsPerTask - 1) / kRowsPerTask;
+        ThreadPool::global().parallelFor(tasks,
+            [kb, akk, lda, a21, rest](int begin, int end) {
+                solveRows(kb, akk, lda, a21, begin * kRowsPerTask,
+                          min(end * kRowsPerTask, rest));
+            });
+
+        // A22 -= L21 L21^T, lower triangle only, band by band.
+        panelT.resize(static_cast<size_t>(kb) * rest);
+        kernels::transpose(rest, kb, a21, lda, panelT.data(), rest);
+        for (int r = 0; r < rest; r += kUpdateRows) {
+            int rows = min(kUpdateRows, rest - r);
+            kernels::gemm(rows, r + rows, kb, T(-1),
+                          a21 + static_cast<size_t>(r) * lda, lda,
+                          panelT.data(), rest, T(1),
+                          a21 + static_cast<size_t>(r) * lda + kb, lda);
+        }
+    }
+    return true;
+}
+
+template <class T>
+void clearUpper(int n, T* a, int lda) {
+    for (int i = 0; i < n; i++) {
+        T* ai = a + static_cast<size_t>(i) * lda;
+        std::fill(ai + i + 1, ai + n, T(0));
+    }
+}
+
+// Plain loops for the small systems of a batch, where calls into the
+// dispatched SIMD kernels would cost more than the arithmetic.
+template <class T>
+inline T dotSmall(const T* a, const T* b, int n) {
+    T sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+template <class T>
+bool factorSmall(int n, T* a) {
+    for (int j = 0; j < n; j++) {
+        T* aj = a + j * n;
+        T pivot = aj[j] - dotSmall(aj, aj, j);
+        if (!(pivot > T(0))) {
+            return false;
+        }
+        aj[j] = sqrt(pivot);
+        T inverse = T(1) / aj[j];
+        for (int i = j + 1; i < n; i++) {
+            T* ai = a + i * n;
+            ai[j] = (ai[j] - dotSmall(ai, aj, j)) * inverse;
+        }
+    }
+    return true;
+}
+
+// L L^T X = B for the n x nrhs B, one column at a time.
+template <class T>
+void solveSmall(int n, int nrhs, const T* l, T* b) {
+    for (int c = 0; c < nrhs; c++) {
+        for (int i = 0; i < n; i++) {
+            const T* li = l + i * n;
+            T sum = b[i * nrhs + c];
+            for (int p = 0; p < i; p++) {
+                sum -= li[p] * b[p * nrhs + c];
+            }
+            b[i * nrhs + c] = sum / li[i];
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            T sum = b[i * nrhs + c];
+            for (int p = i + 1; p < n; p++) {
+                sum -= l[p * n + i] * b[p * nrhs + c];
+            }
+            b[i * nrhs + c] = sum / l[i * n + i];
+        }
+    }
+}
+
+void throwIndefinite() {
+    throw std::runtime_error("cholesky: matrix is not positive definite");
+}
+
+}  // namespace
+
+template <class T>
+BasicCholesky<T>::BasicCholesky(BasicMatrix<T> a)
+    : factor_(std::move(a)), positiveDefinite_(false) {
+    assert(factor_.rows() == factor_.cols());
+    int n = dims();
+    positiveDefinite_ = factorBlocked(n, factor_.ptr(), n);
+    clearUpper(n, factor_.ptr(), n);
+}
+
+template <class T>
+void BasicCholesky<T>::check() const {
+    if (!positiveDefinite_) {
+        throwIndefinite();
+    }
+}
+
+template <class T>
+T BasicCholesky<T>::determinant() const {
+    check();
+    T det = 1;
+    for (int i = 0; i < dims(); i++) {
+        det *= factor_.at(i, i) * factor_.at(i, i);
+    }
+    return det;
+}
+
+template <class T>
+T BasicCholesky<T>::logDeterminant() const {
+    check();
+    T sum = 0;
+    for (int i = 0; i < dims(); i++) {
+        sum += log(factor_.at(i, i));
+    }
+    return 2 * sum;
+}
+
+template <class T>
+void BasicCholesky<T>::solveLowerInPlace(BasicMatrix<T>* b) const {
+    check();
+    assert(b->rows() == dims());
+    kernels::solveTriangular(kernels::kLower, kernels::kNonUnitDiagonal,
+                             dims(), b->cols(), factor_.ptr(), dims(),
+                             b->ptr(), b->cols());
+}
+
+template <class T>
+void BasicCholesky<T>::solveUpperInPlace(BasicMatrix<T>* b) const {
+    check();
+    assert(b->rows() == dims());
+    kernels::solveTriangularTransposed(kernels::kLower,
+                                       kernels::kNonUnitDiagonal, dims(),
+                                       b->cols(), factor_.ptr(), dims(),
+                                       b->ptr(), b->cols());
+}
+
+template <class T>
+void BasicCholesky<T>::solveInPlace(BasicMatrix<T>* b) const {
+    solveLowerInPlace(b);
+    solveUpperInPlace(b);
+}
+
+template <class T>
+void BasicCholesky<T>::solveInPlace(BasicVector<T>* b) const {
+    check();
+    assert(b->dims() == dims());
+    int n = dims();
+    kernels::solveTriangular(kernels::kLower, kernels::kNonUnitDiagonal, n,
+                             1, factor_.ptr(), n, b->ptr(), 1);
+    kernels::solveTriangularTransposed(kernels::kLower,
+                                       kernels::kNonUnitDiagonal, n, 1,
+                                       factor_.ptr(), n, b->ptr(), 1);
+}
+
+template <class T>
+BasicVector<T> BasicCholesky<T>::solve(const BasicVector<T>& b) const {
+    BasicVector<T> x = b;
+    solveInPlace(&x);
+    return x;
+}
+
+template <class T>
+BasicMatrix<T> BasicCholesky<T>::solve(const BasicMatrix<T>& b) const {
+    BasicMatrix<T> x = b;
+    solveInPlace(&x);
+    return x;
+}
+
+template <class T>
+BasicMatrix<T> BasicCholesky<T>::inverse() const {
+    BasicMatrix<T> x = BasicMatrix<T>::identity(dims());
+    solveInPlace(&x);
+    return x;
+}
+
+// Row-oriented update: row i of L meets the rotation of every earlier
+// column, already known from the rows above, then defines its own.
+// x holds the k update vectors as rows, n elements each.
+template <class T>
+bool BasicCholesky<T>::modify(const T* x, int k, T sign) {
+    check();
+    int n = dims();
+    BasicMatrix<T> updated = factor_;
+    vector<T> work(x, x + static_cast<size_t>(k) * n);
+    vector<T> cosines(static_cast<size_t>(k) * n);
+    vector<T> sines(static_cast<size_t>(k) * n);
+    for (int i = 0; i < n; i++) {
+        T* li = updated.ptr() + static_cast<size_t>(i) * n;
+        for (int v = 0; v < k; v++) {
+            T* xv = &work[static_cast<size_t>(v) * n];
+            const T* c = &cosines[static_cast<size_t>(v) * n];
+            const T* s = &sines[static_cast<size_t>(v) * n];
+            T xi = xv[i];
+            for (int j = 0; j < i; j++) {
+                li[j] = (li[j] + sign * s[j] * xi) / c[j];
+                xi = c[j] * xi - s[j] * li[j];
+            }
+            xv[i] = xi;
+
+            T squared = li[i] * li[i] + sign * xi * xi;
+            if (!(squared > T(0))) {
+                return false;
+            }
+            T r = sqrt(squared);
+            cosines[static_cast<size_t>(v) * n + i] = r / li[i];
+            sines[static_cast<size_t>(v) * n + i] = xi / li[i];
+            li[i] = r;
+        }
+    }
+    factor_ = std::move(updated);
+    return true;
+}
+
+template <class T>
+void BasicCholesky<T>::update(const BasicVector<T>& x) {
+    assert(x.dims() == dims());
+    modify(x.ptr(), 1, T(1));
+}
+
+template <class T>
+void BasicCholesky<T>::update(const BasicMatrix<T>& x) {
+    assert(x.rows() == dims());
+    BasicMatrix<T> columns = x.transposed();
+    modify(columns.ptr(), x.cols(), T(1));
+}
+
+template <class T>
+bool BasicCholesky<T>::downdate(const BasicVector<T>& x) {
+    assert(x.dims() == dims());
+    return modify(x.ptr(), 1, T(-1));
+}
+
+template <class T>
+bool BasicCholesky<T>::downdate(const BasicMatrix<T>& x) {
+    assert(x.rows() == dims());
+    BasicMatrix<T> columns = x.transposed();
+    return modify(columns.ptr(), x.cols(), T(-1));
+}
+
+template <class T>
+int choleskySolveBatch(int count, int n, int nrhs, T* a, T* b,
+                       bool* positiveDefinite) {
+    size_t matrixSize = static_cast<size_t>(n) * n;
+    size_t rhsSize = static_cast<size_t>(n) * nrhs;
+    vector<char> failed(count, 0);
+    ThreadPool::global().parallelFor(count,
+        [n, nrhs, a, b, matrixSize, rhsSize, &failed](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                T* ai = a + i * matrixSize;
+                T* bi = b + i * rhsSize;
+                if (!factorSmall(n, ai)) {
+                    failed[i] = 1;
+                    continue;
+                }
+                clearUpper(n, ai, n);
+                solveSmall(n, nrhs, ai, bi);
+            }
+        }, 16);
+
+    int failures = 0;
+    for (int i = 0; i < count; i++) {
+        failures += failed[i];
+        if (positiveDefinite != NULL) {
+            positiveDefinite[i] = !failed[i];
+        }
+    }
+    return failures;
+}
+
+template class BasicCholesky<double>;
+template class BasicCholesky<float>;
+template int choleskySolveBatch(int, int, int, double*, double*, bool*);
+template int choleskySolveBatch(int, int, int, float*, float*, bool*);
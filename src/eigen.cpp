@@ -0,0 +1,614 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/eigen.h"
+
+#include <assert.h>
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ml/thread_pool.h"
+#include "src/gemm.h"
+#include "src/gemv.h"
+#include "src/householder.h"
+#include "src/simd.h"
+#include "src/transpose.h"
+
+using std::min;
+using std::vector;
+
+namespace {
+
+// Reflectors per panel of the tridiagonal reduction and per block of
+// the back-transformation.
+const int kPanel = 32;
+
+// Tridiagonal problems up to this size are solved by QL iterations
+// instead of being split further.
+const int kDirectSize = 32;
+
+// Problems from this size up solve their two halves in parallel.
+const int kParallelSize = 128;
+
+// QL sweeps allowed per eigenvalue.
+const int kMaxSweeps = 30;
+
+// Iterations allowed per root of a secular equation. Bisection alone
+// would need fewer than this to reach rounding.
+const int kMaxSecularIterations = 100;
+
+// Reduces the symmetric n x n matrix a, both triangles stored, to
+// tridiagonal T = Q^T A Q, Q = H(0) ... H(n - 2). d gets the diagonal
+// of T and e its subdiagonal, e[i] coupling i and i + 1. Reflector i
+// acts on rows i + 1 and below; it is left in row i of a right of
+// a(i, i + 1), its leading one implied.
+//
+// The reflectors of a panel are applied lazily as A - V W^T - W V^T:
+// each one reads the trailing matrix once through GEMV, and the
+// trailing matrix is updated once per panel through GEMM.
+template <class T>
+void tridiagonalize(int n, T* a, T* d, T* e, T* tau) {
+    vector<T> vt(static_cast<size_t>(kPanel) * n);
+    vector<T> wt(static_cast<size_t>(kPanel) * n);
+    vector<T> v, w;
+    for (int k = 0; k < n - 1; k += kPanel) {
+        int nb = min(kPanel, n - 1 - k);
+        for (int j = 0; j < nb; j++) {
+            int i = k + j;
+            T* ai = a + static_cast<size_t>(i) * n;
+            for (int p = 0; p < j; p++) {
+                const T* vp = &vt[static_cast<size_t>(p) * n];
+                const T* wp = &wt[static_cast<size_t>(p) * n];
+                kernels::axpy(-wp[i], vp + i, ai + i, ai + i, n - i);
+                kernels::axpy(-vp[i], wp + i, ai + i, ai + i, n - i);
+            }
+            d[i] = ai[i];
+
+            // H(i) = I - tau v v^T maps x = a(i, i + 1:) to (beta, 0, ...).
+            T* x = ai + i + 1;
+            int count = n - i - 1;
+            T alpha = x[0];
+            T norm2 = T(kernels::sumSquares(x + 1, count - 1));
+            T* vj = &vt[static_cast<size_t>(j) * n];
+            T* wj = &wt[static_cast<size_t>(j) * n];
+            std::fill(vj, vj + n, T(0));
+            std::fill(wj, wj + n, T(0));
+            if (norm2 == T(0)) {
+                tau[i] = 0;
+                e[i] = alpha;
+                continue;
+            }
+            T beta = -copysign(sqrt(alpha * alpha + norm2), alpha);
+            tau[i] = (beta - alpha) / beta;
+            kernels::scale(T(1) / (alpha - beta), x + 1, x + 1, count - 1);
+            x[0] = beta;
+            e[i] = beta;
+            vj[i + 1] = 1;
+            std::copy(x + 1, x + count, vj + i + 2);
+
+            // w = tau (A v - V W^T v - W V^T v) - tau / 2 (w^T v) v, with
+            // A the trailing matrix as of the start of the panel.
+            T* vi = vj + i + 1;
+            T* wi = wj + i + 1;
+            const T* trailing = ai + n + i + 1;
+            kernels::gemv(count, count, T(1), trailing, n, vi, T(0), wi);
+            for (int p = 0; p < j; p++) {
+                const T* vp = &vt[static_cast<size_t>(p) * n] + i + 1;
+                const T* wp = &wt[static_cast<size_t>(p) * n] + i + 1;
+                T wv = T(kernels::dot(wp, vi, count));
+                T vv = T(kernels::dot(vp, vi, count));
+                kernels::axpy(-wv, vp, wi, wi, count);
+                kernels::axpy(-vv, wp, wi, wi, count);
+            }
+            kernels::scale(tau[i], wi, wi, count);
+            T gamma = -tau[i] / 2 * T(kernels::dot(wi, vi, count));
+            kernels::axpy(gamma, vi, wi, wi, count);
+        }
+
+        int o = k + nb;
+        int rows = n - o;
+        v.resize(static_cast<size_t>(rows) * nb);
+        w.resize(static_cast<size_t>(rows) * nb);
+        kernels::transpose(nb, rows, &vt[o], n, v.data(), nb);
+        kernels::transpose(nb, rows, &wt[o], n, w.data(), nb);
+        T* ao = a + static_cast<size_t>(o) * n + o;
+        kernels::gemm(rows, rows, nb, T(-1), v.data(), nb, &wt[o], n, T(1),
+                      ao, n);
+        kernels::gemm(rows, rows, nb, T(-1), w.data(), nb, &vt[o], n, T(1),
+                      ao, n);
+    }
+    d[n - 1] = a[static_cast<size_t>(n - 1) * n + n - 1];
+}
+
+// Z := Q Z for the n x n matrix z and the Q left in a by
+// tridiagonalize(), a block of reflectors at a time, last to first.
+template <class T>
+void applyReflectors(int n, const T* a, const T* tau, T* z) {
+    int count = n - 1;
+    vector<T> v, vt, work;
+    vector<T> t(kPanel * kPanel);
+    for (int k = (count - 1) / kPanel * kPanel; k >= 0; k -= kPanel) {
+        int kb = min(kPanel, count - k);
+        int rows = n - k - 1;
+        vt.assign(static_cast<size_t>(kb) * rows, T(0));
+        for (int j = 0; j < kb; j++) {
+            const T* aj = a + static_cast<size_t>(k + j) * n + k + 1;
+            T* vtj = &vt[static_cast<size_t>(j) * rows];
+            vtj[j] = 1;
+            std::copy(aj + j + 1, aj + rows, vtj + j + 1);
+        }
+        v.resize(vt.size());
+        kernels::transpose(kb, rows, vt.data(), rows, v.data(), kb);
+        kernels::blockReflectorFactor(rows, kb, v.data(), vt.data(), tau + k,
+                                      t.data(), kb);
+        kernels::applyBlockReflector(false, rows, n, kb, v.data(), vt.data(),
+                                     t.data(), kb,
+                                     z + static_cast<size_t>(k + 1) * n, n,
+                                     &work);
+    }
+}
+
+void throwNoConvergence() {
+    throw std::runtime_error("eigen: QL iterations did not converge");
+}
+
+// Reorders d ascending, and the columns of the n rows of z along with
+// it when z is not NULL.
+template <class T>
+void sortAscending(int n, T* d, T* z, int ldz) {
+    vector<int> order(n);
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [d](int i, int j) { return d[i] < d[j]; });
+    vector<T> values(d, d + n);
+    for (int i = 0; i < n; i++) {
+        d[i] = values[order[i]];
+    }
+    if (z == NULL) {
+        return;
+    }
+    for (int r = 0; r < n; r++) {
+        T* zr = z + static_cast<size_t>(r) * ldz;
+        values.assign(zr, zr + n);
+        for (int i = 0; i < n; i++) {
+            zr[i] = values[order[i]];
+        }
+    }
+}
+
+// Eigenvalues of the symmetric tridiagonal matrix (d, e) into d,
+// ascending, by implicit QL iterations with Wilkinson shifts; e[n - 1]
+// must be zero and e is destroyed. When z is not NULL, the rotations
+// are applied to the columns of its n rows.
+template <class T>
+void tridiagonalQl(int n, T* d, T* e, T* z, int ldz) {
+    const T eps = std::numeric_limits<T>::epsilon();
+    T shift = 0;
+    T norm = 0;
+    for (int l = 0; l < n; l++) {
+        norm = std::max<T>(norm, fabs(d[l]) + fabs(e[l]));
+        int m = l;
+        while (m < n - 1 && fabs(e[m]) > eps * norm) {
+            m++;
+        }
+        int sweeps = 0;
+        while (m > l && fabs(e[l]) > eps * norm) {
+            if (++sweeps > kMaxSweeps) {
+                throwNoConvergence();
+            }
+            T g = d[l];
+            T p = (d[l + 1] - g) / (2 * e[l]);
+            T r = copysign(hypot(p, T(1)), p);
+            d[l] = e[l] / (p + r);
+            d[l + 1] = e[l] * (p + r);
+            T dl1 = d[l + 1];
+            T h = g - d[l];
+            for (int i = l + 2; i < n; i++) {
+                d[i] -= h;
+            }
+            shift += h;
+
+            p = d[m];
+            T c = 1, c2 = 1, c3 = 1;
+            T s = 0, s2 = 0;
+            T el1 = e[l + 1];
+            for (int i = m - 1; i >= l; i--) {
+                c3 = c2;
+                c2 = c;
+                s2 = s;
+                g = c * e[i];
+                h = c * p;
+                r = hypot(p, e[i]);
+                e[i + 1] = s * r;
+                s = e[i] / r;
+                c = p / r;
+                p = c * d[i] - s * g;
+                d[i + 1] = h + s * (c * g + s * d[i]);
+                if (z != NULL) {
+                    for (int k = 0; k < n; k++) {
+                        T* zk = z + static_cast<size_t>(k) * ldz;
+                        T zi = zk[i];
+                        zk[i] = c * zi - s * zk[i + 1];
+                        zk[i + 1] = s * zi + c * zk[i + 1];
+                    }
+                }
+            }
+            p = -s * s2 * c3 * el1 * e[l] / dl1;
+            e[l] = s * p;
+            d[l] = c * p;
+        }
+        d[l] += shift;
+        e[l] = 0;
+    }
+    sortAscending(n, d, z, ldz);
+}
+
+// Root i of the secular equation 1 / rho + sum_j z_j^2 / (d_j - x) = 0,
+// for k ascending d and rho > 0, which lies in (d_i, d_i+1), or in
+// (d_k-1, d_k-1 + rho |z|^2) for the last. delta gets d_j - x.
+//
+// The root is sought as an offset from the nearer pole, so that delta
+// keeps its relative accuracy however close the root is to it. Each
+// step fits the two poles around the root to the value and slope of
+// the equation and takes the root of that model, falling back to
+// bisection when it leaves the bracket.
+template <class T>
+T secularRoot(int k, const T* d, const T* z, T rho, int i, T* delta) {
+    const T eps = std::numeric_limits<T>::epsilon();
+    if (k == 1) {
+        T step = rho * z[0] * z[0];
+        delta[0] = -step;
+        return d[0] + step;
+    }
+    bool last = i == k - 1;
+    int origin = i;
+    T lo = 0;
+    T hi;
+    if (last) {
+        T norm2 = 0;
+        for (int j = 0; j < k; j++) {
+            norm2 += z[j] * z[j];
+        }
+        hi = rho * norm2;
+    } else {
+        T mid = (d[i + 1] - d[i]) / 2;
+        T f = 1 / rho;
+        for (int j = 0; j < k; j++) {
+            f += z[j] * z[j] / ((d[j] - d[i]) - mid);
+        }
+        hi = mid;
+        if (f < 0) {
+            origin = i + 1;
+            lo = -mid;
+            hi = 0;
+        }
+    }
+
+    // delta holds d_j - d_origin until the root is found.
+    for (int j = 0; j < k; j++) {
+        delta[j] = d[j] - d[origin];
+    }
+    T mu = (lo + hi) / 2;
+    for (int iteration = 0; iteration < kMaxSecularIterations;
+         iteration++) {
+        T psi = 0, dpsi = 0, phi = 0, dphi = 0;
+        for (int j = 0; j <= i; j++) {
+            T t = z[j] / (delta[j] - mu);
+            psi += z[j] * t;
+            dpsi += t * t;
+        }
+        for (int j = i + 1; j < k; j++) {
+            T t = z[j] / (delta[j] - mu);
+            phi += z[j] * t;
+            dphi += t * t;
+        }
+        T f = 1 / rho + psi + phi;
+        if (fabs(f) <= 8 * eps * (1 / rho + phi - psi)) {
+            break;
+        }
+        if (f < 0) {
+            lo = mu;
+        } else {
+            hi = mu;
+        }
+        if (hi - lo <= 2 * eps * std::max(fabs(lo), fabs(hi))) {
+            break;
+        }
+
+        // f(mu + eta) ~ c + a / (da - eta) + b / (db - eta).
+        T da = delta[i] - mu;
+        T a = dpsi * da * da;
+        T eta;
+        if (last) {
+            T c = f - dpsi * da;
+            eta = da + a / c;
+        } else {
+            T db = delta[i + 1] - mu;
+            T b = dphi * db * db;
+            T c = f - dpsi * da - dphi * db;
+            T qb = c * (da + db) + a + b;
+            T qc = c * da * db + a * db + b * da;
+            T disc = sqrt(std::max(T(0), qb * qb - 4 * c * qc));
+            T q = (qb + copysign(disc, qb)) / 2;
+            eta = qc / q;
+            if (!(eta > da && eta < db) && c != T(0)) {
+                eta = q / c;
+            }
+        }
+        T next = mu + eta;
+        mu = next > lo && next < hi ? next : (lo + hi) / 2;
+    }
+    for (int j = 0; j < k; j++) {
+        delta[j] -= mu;
+    }
+    return d[origin] + mu;
+}
+
+// Merges the eigenpairs of the two halves of a divide-and-conquer step.
+// On entry d[0:m) and d[m:n) hold the eigenvalues of the halves and q
+// their eigenvectors in its two diagonal blocks; the whole matrix is
+// diag(Q1, Q2) (diag(d) + rho z z^T) diag(Q1, Q2)^T with z made of the
+// last row of Q1 and sign times the first row of Q2.
+//
+// Eigenvalues whose z is negligible, or that nearly coincide with
+// another after a rotation, keep their vector (deflation). The others
+// are the roots of the secular equation; their vectors follow from z
+// recomputed for the roots found (Gu and Eisenstat), which keeps them
+// orthogonal, and are multiplied by Q through GEMM.
+template <class T>
+void merge(int n, int m, T* d, T* q, int ldq, T rho, T sign) {
+    const T eps = std::numeric_limits<T>::epsilon();
+    vector<T> z(n);
+    std::copy(q + static_cast<size_t>(m - 1) * ldq,
+              q + static_cast<size_t>(m - 1) * ldq + m, z.begin());
+    for (int j = m; j < n; j++) {
+        z[j] = sign * q[static_cast<size_t>(m) * ldq + j];
+    }
+    // |z|^2 = 2.
+    for (int j = 0; j < n; j++) {
+        z[j] *= sqrt(T(0.5));
+    }
+    rho *= 2;
+
+    vector<int> column(n);
+    for (int j = 0; j < n; j++) {
+        column[j] = j;
+    }
+    std::stable_sort(column.begin(), column.end(),
+                     [d](int i, int j) { return d[i] < d[j]; });
+    vector<T> ds(n), zs(n);
+    T largest = 0;
+    for (int j = 0; j < n; j++) {
+        ds[j] = d[column[j]];
+        zs[j] = z[column[j]];
+        largest = std::max<T>(largest, std::max(fabs(ds[j]), fabs(zs[j])));
+    }
+    T tolerance = 8 * eps * largest;
+
+    vector<int> kept, deflated;
+    int previous = -1;
+    for (int j = 0; j < n; j++) {
+        if (rho * fabs(zs[j]) <= tolerance) {
+            deflated.push_back(j);
+            continue;
+        }
+        if (previous >= 0) {
+            // A rotation of the two vectors that zeroes z of previous
+            // deflates it if it barely moves the eigenvalues.
+            T norm = hypot(zs[j], zs[previous]);
+            T c = zs[j] / norm;
+            T s = -zs[previous] / norm;
+            if (fabs((ds[j] - ds[previous]) * c * s) <= tolerance) {
+                zs[j] = norm;
+                zs[previous] = 0;
+                T* x = q + column[previous];
+                T* y = q + column[j];
+                for (int r = 0; r < n; r++) {
+                    size_t at = static_cast<size_t>(r) * ldq;
+                    T xr = x[at];
+                    x[at] = c * xr + s * y[at];
+                    y[at] = c * y[at] - s * xr;
+                }
+                T dp = ds[previous];
+                ds[previous] = dp * c * c + ds[j] * s * s;
+                ds[j] = dp * s * s + ds[j] * c * c;
+                deflated.push_back(previous);
+                previous = j;
+                continue;
+            }
+            kept.push_back(previous);
+        }
+        previous = j;
+    }
+    if (previous >= 0) {
+        kept.push_back(previous);
+    }
+
+    int k = static_cast<int>(kept.size());
+    vector<T> dk(k), zk(k), lambda(k);
+    vector<T> delta(static_cast<size_t>(k) * k);
+    for (int j = 0; j < k; j++) {
+        dk[j] = ds[kept[j]];
+        zk[j] = zs[kept[j]];
+    }
+    ThreadPool& pool = ThreadPool::global();
+    pool.parallelFor(k, [k, &dk, &zk, rho, &lambda, &delta](int begin,
+                                                          int end) {
+            for (int i = begin; i < end; i++) {
+                T* di = delta.data() + static_cast<size_t>(i) * k;
+                lambda[i] = secularRoot(k, dk.data(), zk.data(), rho, i, di);
+            }
+        }, 8);
+
+    // z_j^2 = (lambda_j - d_j) / rho prod_i!=j (lambda_i - d_j) / (d_i - d_j).
+    vector<T> zhat(k);
+    for (int j = 0; j < k; j++) {
+        T product = -delta[static_cast<size_t>(j) * k + j] / rho;
+        for (int i = 0; i < k; i++) {
+            if (i != j) {
+                product *= -delta[static_cast<size_t>(i) * k + j] /
+                           (dk[i] - dk[j]);
+            }
+        }
+        zhat[j] = copysign(sqrt(std::max(T(0), product)), zk[j]);
+    }
+
+    // Vector i of the rank-one problem is zhat_j / (d_j - lambda_i).
+    vector<T> ut(static_cast<size_t>(k) * k);
+    pool.parallelFor(k, [k, &zhat, &delta, &ut](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                T* ui = ut.data() + static_cast<size_t>(i) * k;
+                const T* di = delta.data() + static_cast<size_t>(i) * k;
+                for (int j = 0; j < k; j++) {
+                    ui[j] = zhat[j] / di[j];
+                }
+                T norm = sqrt(T(kernels::sumSquares(ui, k)));
+                kernels::scale(T(1) / norm, ui, ui, k);
+            }
+        }, 16);
+    vector<T> u(ut.size());
+    kernels::transpose(k, k, ut.data(), k, u.data(), k);
+    vector<T> gathered(static_cast<size_t>(n) * k);
+    for (int r = 0; r < n; r++) {
+        const T* qr = q + static_cast<size_t>(r) * ldq;
+        T* gr = gathered.data() + static_cast<size_t>(r) * k;
+        for (int j = 0; j < k; j++) {
+            gr[j] = qr[column[kept[j]]];
+        }
+    }
+    vector<T> product(gathered.size());
+    kernels::gemm(n, k, k, T(1), gathered.data(), k, u.data(), k, T(0),
+                  product.data(), k);
+
+    // Pairs in ascending order: roots i < k, deflated k + j.
+    vector<std::pair<T, int> > pairs;
+    pairs.reserve(n);
+    for (int i = 0; i < k; i++) {
+        pairs.push_back(std::make_pair(lambda[i], i));
+    }
+    for (int j = 0; j < static_cast<int>(deflated.size()); j++) {
+        pairs.push_back(std::make_pair(ds[deflated[j]], k + j));
+    }
+    std::stable_sort(pairs.begin(), pairs.end());
+    vector<int> source(n);
+    for (int i = 0; i < n; i++) {
+        d[i] = pairs[i].first;
+        int p = pairs[i].second;
+        source[i] = p < k ? p : -1 - column[deflated[p - k]];
+    }
+    vector<T> row(n);
+    for (int r = 0; r < n; r++) {
+        T* qr = q + static_cast<size_t>(r) * ldq;
+        const T* pr = product.data() + static_cast<size_t>(r) * k;
+        for (int i = 0; i < n; i++) {
+            row[i] = source[i] >= 0 ? pr[source[i]] : qr[-1 - source[i]];
+        }
+        std::copy(row.begin(), row.end(), qr);
+    }
+}
+
+// Eigenvalues of the symmetric tridiagonal matrix (d, e), ascending,
+// into d and their eigenvectors into the columns of the n x n block at
+// q. The matrix is split at e[m - 1] into two halves, each modified by
+// |e[m - 1]| at its corner, which are solved recursively and merged.
+template <class T>
+void divideAndConquer(int n, T* d, const T* e, T* q, int ldq) {
+    for (int r = 0; r < n; r++) {
+        T* qr = q + static_cast<size_t>(r) * ldq;
+        std::fill(qr, qr + n, T(0));
+    }
+    if (n <= kDirectSize) {
+        vector<T> sub(e, e + n - 1);
+        sub.push_back(0);
+        for (int r = 0; r < n; r++) {
+            q[static_cast<size_t>(r) * ldq + r] = 1;
+        }
+        tridiagonalQl(n, d, sub.data(), q, ldq);
+        return;
+    }
+
+    int m = n / 2;
+    T coupling = e[m - 1];
+    T rho = fabs(coupling);
+    d[m - 1] -= rho;
+    d[m] -= rho;
+    T* q2 = q + static_cast<size_t>(m) * ldq + m;
+    if (n >= kParallelSize) {
+        ThreadPool::global().parallelFor(2,
+            [n, m, d, e, q, q2, ldq](int begin, int end) {
+                for (int half = begin; half < end; half++) {
+                    if (half == 0) {
+                        divideAndConquer(m, d, e, q, ldq);
+                    } else {
+                        divideAndConquer(n - m, d + m, e + m, q2, ldq);
+                    }
+                }
+            });
+    } else {
+        divideAndConquer(m, d, e, q, ldq);
+        divideAndConquer(n - m, d + m, e + m, q2, ldq);
+    }
+    merge(n, m, d, q, ldq, rho, coupling < 0 ? T(-1) : T(1));
+}
+
+}  // namespace
+
+template <class T>
+BasicSymmetricEigen<T>::BasicSymmetricEigen(BasicMatrix<T> a, bool vectors)
+    : values_(a.rows()), vectors_(0, 0) {
+    assert(a.rows() == a.cols());
+    int n = a.rows();
+    if (n == 0) {
+        return;
+    }
+    T* p = a.ptr();
+    T largest = 0;
+    bool finite = true;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j <= i; j++) {
+            T x = p[static_cast<size_t>(i) * n + j];
+            p[static_cast<size_t>(j) * n + i] = x;
+            largest = std::max<T>(largest, fabs(x));
+            finite = finite && isfinite(x);
+        }
+    }
+    // A NaN slips past the largest element, and an infinite one would
+    // scale the rest to NaN: the iterations would converge on garbage.
+    if (!finite) {
+        throw std::runtime_error("eigen: matrix has non-finite elements");
+    }
+    if (vectors) {
+        vectors_ = BasicMatrix<T>(n, n);
+    }
+    if (largest == T(0)) {
+        for (int i = 0; vectors && i < n; i++) {
+            vectors_.at(i, i) = 1;
+        }
+        return;
+    }
+
+    // Scaled to unit largest element, so that the tolerances of the
+    // tridiagonal solvers need no norm of their own.
+    kernels::scale(T(1) / largest, p, p, static_cast<size_t>(n) * n);
+    vector<T> d(n), e(n), tau(n);
+    tridiagonalize(n, p, d.data(), e.data(), tau.data());
+    e[n - 1] = 0;
+    if (vectors) {
+        divideAndConquer(n, d.data(), e.data(), vectors_.ptr(), n);
+        applyReflectors(n, p, tau.data(), vectors_.ptr());
+    } else {
+        tridiagonalQl(n, d.data(), e.data(), static_cast<T*>(NULL), 0);
+    }
+    for (int i = 0; i < n; i++) {
+        values_.at(i) = d[i] * largest;
+    }
+}
+
+template class BasicSymmetricEigen<double>;
+template class BasicSymmetricEigen<float>;
@@ -0,0 +1,502 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "src/gemm.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "ml/thread_pool.h"
+#include "src/simd.h"
+
+using std::min;
+using std::vector;
+
+namespace kernels {
+
+namespace {
+
+// Register tile computed by one micro-kernel call: kMr rows of kNr
+// elements, kNr being two AVX2 or one AVX-512 register wide.
+template <class T>
+struct Tile;
+
+template <>
+struct Tile<double> {
+    enum { kMr = 6, kNr = 8 };
+};
+
+template <>
+struct Tile<float> {
+    enum { kMr = 6, kNr = 16 };
+};
+
+// Cache blocking: a kMc x kKc block of A stays in L2, a kKc x kNc
+// panel of B stays in L3 and a kKc x kNr sliver of it in L1.
+const int kMc = 96;
+const int kKc = 256;
+const int kNc = 4096;
+
+// Products with fewer multiply-adds than this are not worth packing.
+const double kSmallGemm = 32.0 * 32.0 * 32.0;
+
+// Products with fewer multiply-adds than this stay on one thread.
+const double kParallelGemm = 128.0 * 128.0 * 128.0;
+
+// Parallel tiles are never split narrower than this many columns.
+const int kMinTileCols = 128;
+
+int roundUp(int value, int step) {
+    return (value + step - 1) / step * step;
+}
+
+template <class T>
+void scaleTile(int m, int n, T beta, T* c, int ldc) {
+    for (int i = 0; i < m; i++) {
+        T* ci = c + static_cast<size_t>(i) * ldc;
+        for (int j = 0; j < n; j++) {
+            ci[j] = beta == 0 ? 0 : beta * ci[j];
+        }
+    }
+}
+
+// Packs an mc x kc block of A into panels of kMr rows, each panel
+// stored column after column. The last panel is padded with zeros.
+template <class T>
+void packA(int mc, int kc, const T* a, int lda, T* buf) {
+    const int kMr = Tile<T>::kMr;
+    for (int i = 0; i < mc; i += kMr) {
+        int mr = min(kMr, mc - i);
+        for (int p = 0; p < kc; p++) {
+            for (int r = 0; r < mr; r++) {
+                buf[r] = a[static_cast<size_t>(i + r) * lda + p];
+            }
+            for (int r = mr; r < kMr; r++) {
+                buf[r] = 0;
+            }
+            buf += kMr;
+        }
+    }
+}
+
+// Packs a kc x nc panel of B into slivers of kNr columns, each sliver
+// stored row after row. The last sliver is padded with zeros.
+template <class T>
+void packB(int kc, int nc, const T* b, int ldb, T* buf) {
+    const int kNr = Tile<T>::kNr;
+    for (int j = 0; j < nc; j += kNr) {
+        int nr = min(kNr, nc - j);
+        for (int p = 0; p < kc; p++) {
+            const T* bp = b + static_cast<size_t>(p) * ldb + j;
+            for (int c = 0; c < nr; c++) {
+                buf[c] = bp[c];
+            }
+            for (int c = nr; c < kNr; c++) {
+                buf[c] = 0;
+            }
+            buf += kNr;
+        }
+    }
+}
+
+// ab = A panel * B sliver, both packed; ab is a kMr x kNr tile.
+template <class T>
+void microKernelGeneric(int kc, const T* a, const T* b, T* ab) {
+    const int kMr = Tile<T>::kMr;
+    const int kNr = Tile<T>::kNr;
+    T acc[kMr * kNr] = { 0 };
+
+    for (int p = 0; p < kc; p++) {
+        for (int i = 0; i < kMr; i++) {
+            T ai = a[i];
+            for (int j = 0; j < kNr; j++) {
+                acc[i * kNr + j] += ai * b[j];
+            }
+        }
+        a += kMr;
+        b += kNr;
+    }
+
+    for (int i = 0; i < kMr * kNr; i++) {
+        ab[i] = acc[i];
+    }
+}
+
+#if defined(ML_SIMD_X86)
+// Twelve ymm accumulators: each row of the tile is two registers.
+ML_TARGET_AVX2
+void microKernelAvx2(int kc, const double* a, const double* b, double* ab) {
+    const int kMr = Tile<double>::kMr;
+    const int kNr = Tile<double>::kNr;
+    __m256d acc[kMr][2];
+    for (int i = 0; i < kMr; i++) {
+        acc[i][0] = _mm256_setzero_pd();
+        acc[i][1] = _mm256_setzero_pd();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        __m256d b0 = _mm256_loadu_pd(b);
+        __m256d b1 = _mm256_loadu_pd(b + 4);
+        for (int i = 0; i < kMr; i++) {
+            __m256d ai = _mm256_broadcast_sd(a + i);
+            acc[i][0] = _mm256_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_pd(ai, b1, acc[i][1]);
+        }
+        a += kMr;
+        b += kNr;
+    }
+
+    for (int i = 0; i < kMr; i++) {
+        _mm256_storeu_pd(ab + i * kNr, acc[i][0]);
+        _mm256_storeu_pd(ab + i * kNr + 4, acc[i][1]);
+    }
+}
+
+ML_TARGET_AVX2
+void microKernelAvx2(int kc, const float* a, const float* b, float* ab) {
+    const int kMr = Tile<float>::kMr;
+    const int kNr = Tile<float>::kNr;
+    __m256 acc[kMr][2];
+    for (int i = 0; i < kMr; i++) {
+        acc[i][0] = _mm256_setzero_ps();
+        acc[i][1] = _mm256_setzero_ps();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        __m256 b0 = _mm256_loadu_ps(b);
+        __m256 b1 = _mm256_loadu_ps(b + 8);
+        for (int i = 0; i < kMr; i++) {
+            __m256 ai = _mm256_broadcast_ss(a + i);
+            acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += kMr;
+        b += kNr;
+    }
+
+    for (int i = 0; i < kMr; i++) {
+        _mm256_storeu_ps(ab + i * kNr, acc[i][0]);
+        _mm256_storeu_ps(ab + i * kNr + 8, acc[i][1]);
+    }
+}
+
+#if defined(ML_SIMD_AVX512)
+// One zmm accumulator per row of the tile.
+ML_TARGET_AVX512
+void microKernelAvx512(int kc, const double* a, const double* b,
+                       double* ab) {
+    const int kMr = Tile<double>::kMr;
+    const int kNr = Tile<double>::kNr;
+    __m512d acc[kMr];
+    for (int i = 0; i < kMr; i++) {
+        acc[i] = _mm512_setzero_pd();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        __m512d bp = _mm512_loadu_pd(b);
+        for (int i = 0; i < kMr; i++) {
+            acc[i] = _mm512_fmadd_pd(_mm512_set1_pd(a[i]), bp, acc[i]);
+        }
+        a += kMr;
+        b += kNr;
+    }
+
+    for (int i = 0; i < kMr; i++) {
+        _mm512_storeu_pd(ab + i * kNr, acc[i]);
+    }
+}
+
+ML_TARGET_AVX512
+void microKernelAvx512(int kc, const float* a, const float* b, float* ab) {
+    const int kMr = Tile<float>::kMr;
+    const int kNr = Tile<float>::kNr;
+    __m512 acc[kMr];
+    for (int i = 0; i < kMr; i++) {
+        acc[i] = _mm512_setzero_ps();
+    }
+
+    for (int p = 0; p < kc; p++) {
+        __m512 bp = _mm512_loadu_ps(b);
+        for (int i = 0; i < kMr; i++) {
+            acc[i] = _mm512_fmadd_ps(_mm512_set1_ps(a[i]), bp, acc[i]);
+        }
+        a += kMr;
+        b += kNr;
+    }
+
+    for (int i = 0; i < kMr; i++) {
+        _mm512_storeu_ps(ab + i * kNr, acc[i]);
+    }
+}
+#endif  // ML_SIMD_AVX512
+#endif  // ML_SIMD_X86
+
+template <class T>
+struct MicroKernel {
+    typedef void (*Type)(int kc, const T* a, const T* b, T* ab);
+};
+
+template <class T>
+typename MicroKernel<T>::Type selectMicroKernel() {
+    // The 6-row tile needs more than 16 xmm registers, so SSE2 hosts
+    // are better served by the compiler-vectorized generic kernel.
+#if defined(ML_SIMD_X86)
+    if (activeIsa() == kIsaAvx2) {
+        return microKernelAvx2;
+    }
+#if defined(ML_SIMD_AVX512)
+    if (activeIsa() == kIsaAvx512) {
+        return microKernelAvx512;
+    }
+#endif
+#endif
+    return microKernelGeneric<T>;
+}
+
+template <class T>
+typename MicroKernel<T>::Type microKernel() {
+    static const typename MicroKernel<T>::Type kernel =
+        selectMicroKernel<T>();
+    return kernel;
+}
+
+template <class T>
+void storeTile(int mr, int nr, T alpha, const T* ab, T beta, T* c,
+               int ldc) {
+    const int kNr = Tile<T>::kNr;
+    for (int i = 0; i < mr; i++) {
+        T* ci = c + static_cast<size_t>(i) * ldc;
+        const T* abi = ab + i * kNr;
+        if (beta == 0) {
+            for (int j = 0; j < nr; j++) {
+                ci[j] = alpha * abi[j];
+            }
+        } else {
+            for (int j = 0; j < nr; j++) {
+                ci[j] = alpha * abi[j] + beta * ci[j];
+            }
+        }
+    }
+}
+
+template <class T>
+void macroKernel(int mc, int nc, int kc, T alpha,
+                 const T* packedA, const T* packedB,
+                 T beta, T* c, int ldc) {
+    const int kMr = Tile<T>::kMr;
+    const int kNr = Tile<T>::kNr;
+    typename MicroKernel<T>::Type kernel = microKernel<T>();
+    T ab[kMr * kNr];
+
+    for (int j = 0; j < nc; j += kNr) {
+        int nr = min(kNr, nc - j);
+        for (int i = 0; i < mc; i += kMr) {
+            int mr = min(kMr, mc - i);
+            kernel(kc, packedA + i * kc, packedB + j * kc, ab);
+            storeTile(mr, nr, alpha, ab, beta,
+                      c + static_cast<size_t>(i) * ldc + j, ldc);
+        }
+    }
+}
+
+// Plain i-k-j loop: streams rows of B and C, no packing overhead.
+template <class T>
+void gemmSmall(int m, int n, int k, T alpha,
+               const T* a, int lda,
+               const T* b, int ldb,
+               T beta, T* c, int ldc) {
+    scaleTile(m, n, beta, c, ldc);
+
+    for (int i = 0; i < m; i++) {
+        T* ci = c + static_cast<size_t>(i) * ldc;
+        for (int p = 0; p < k; p++) {
+            T aip = alpha * a[static_cast<size_t>(i) * lda + p];
+            const T* bp = b + static_cast<size_t>(p) * ldb;
+            for (int j = 0; j < n; j++) {
+                ci[j] += aip * bp[j];
+            }
+        }
+    }
+}
+
+// Serial blocked product; all packing buffers are per thread and
+// reused across calls.
+template <class T>
+void gemmBlocked(int m, int n, int k, T alpha,
+                 const T* a, int lda,
+                 const T* b, int ldb,
+                 T beta, T* c, int ldc) {
+    static thread_local vector<T> packedA;
+    static thread_local vector<T> packedB;
+
+    size_t kcMax = min(k, kKc);
+    size_t sizeA = roundUp(min(m, kMc), Tile<T>::kMr) * kcMax;
+    size_t sizeB = roundUp(min(n, kNc), Tile<T>::kNr) * kcMax;
+    if (packedA.size() < sizeA) {
+        packedA.resize(sizeA);
+    }
+    if (packedB.size() < sizeB) {
+        packedB.resize(sizeB);
+    }
+
+    for (int jc = 0; jc < n; jc += kNc) {
+        int nc = min(kNc, n - jc);
+        for (int pc = 0; pc < k; pc += kKc) {
+            int kc = min(kKc, k - pc);
+            // The first k-block applies beta, the rest accumulate.
+            T betaBlock = pc == 0 ? beta : 1;
+            packB(kc, nc, b + static_cast<size_t>(pc) * ldb + jc, ldb,
+                  packedB.data());
+            for (int ic = 0; ic < m; ic += kMc) {
+                int mc = min(kMc, m - ic);
+                packA(mc, kc, a + static_cast<size_t>(ic) * lda + pc, lda,
+                      packedA.data());
+                macroKernel(mc, nc, kc, alpha, packedA.data(),
+                            packedB.data(), betaBlock,
+                            c + static_cast<size_t>(ic) * ldc + jc, ldc);
+            }
+        }
+    }
+}
+
+template <class T>
+void gemmPacked(int m, int n, int k, T alpha,
+                const T* a, int lda,
+                const T* b, int ldb,
+                T beta, T* c, int ldc) {
+    if (m <= 0 || n <= 0) {
+        return;
+    }
+
+    if (k <= 0 || alpha == 0) {
+        scaleTile(m, n, beta, c, ldc);
+        return;
+    }
+
+    double work = static_cast<double>(m) * n * k;
+    if (work <= kSmallGemm) {
+        gemmSmall(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::global();
+    if (pool.threads() == 1 || work < kParallelGemm) {
+        gemmBlocked(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        return;
+    }
+
+    // Output tiles are independent, so each task runs the whole serial
+    // algorithm on its own tile. Narrow the tiles until there are a few
+    // per thread to balance the load.
+    const int kNr = Tile<T>::kNr;
+    int tileRows = kMc;
+    int tileCols = roundUp(min(n, kNc), kNr);
+    int tilesM = (m + tileRows - 1) / tileRows;
+    while (tileCols > kMinTileCols &&
+           tilesM * ((n + tileCols - 1) / tileCols) < 4 * pool.threads()) {
+        tileCols = roundUp(tileCols / 2, kNr);
+    }
+    int tilesN = (n + tileCols - 1) / tileCols;
+
+    pool.parallelFor(tilesM * tilesN,
+        [m, n, k, alpha, a, lda, b, ldb, beta, c, ldc,
+         tileRows, tileCols, tilesN](int begin, int end) {
+            for (int t = begin; t < end; t++) {
+                int ic = t / tilesN * tileRows;
+                int jc = t % tilesN * tileCols;
+                size_t row = ic;
+                gemmBlocked(min(tileRows, m - ic), min(tileCols, n - jc), k,
+                            alpha, a + row * lda, lda, b + jc, ldb, beta,
+                            c + row * ldc + jc, ldc);
+            }
+        });
+}
+
+// Copies an m x n block with leading dimension ld into a dense float
+// buffer.
+template <class T>
+void widen(int m, int n, const T* src, int ld, vector<float>* dst) {
+    dst->resize(static_cast<size_t>(m) * n);
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            (*dst)[static_cast<size_t>(i) * n + j] =
+                src[static_cast<size_t>(i) * ld + j];
+        }
+    }
+}
+
+}  // namespace
+
+void gemm(int m, int n, int k, double alpha,
+          const double* a, int lda,
+          const double* b, int ldb,
+          double beta, double* c, int ldc) {
+    gemmPacked(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+void gemm(int m, int n, int k, float alpha,
+          const float* a, int lda,
+          const float* b, int ldb,
+          float beta, float* c, int ldc) {
+    gemmPacked(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+void gemm(int m, int n, int k, BFloat16 alpha,
+          const BFloat16* a, int lda,
+          const BFloat16* b, int ldb,
+          BFloat16 beta, BFloat16* c, int ldc) {
+    if (m <= 0 || n <= 0) {
+        return;
+    }
+
+    // Widening costs O(mk + kn + mn) next to the O(mnk) product.
+    vector<float> wideA, wideB, wideC;
+    widen(m, k, a, lda, &wideA);
+    widen(k, n, b, ldb, &wideB);
+    if (beta == 0) {
+        wideC.resize(static_cast<size_t>(m) * n);
+    } else {
+        widen(m, n, c, ldc, &wideC);
+    }
+
+    gemmPacked(m, n, k, static_cast<float>(alpha), wideA.data(), k,
+               wideB.data(), n, static_cast<float>(beta), wideC.data(), n);
+
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) {
+            c[static_cast<size_t>(i) * ldc + j] =
+                wideC[static_cast<size_t>(i) * n + j];
+        }
+    }
+}
+
+void gemm(int m, int n, int k, int8_t alpha,
+          const int8_t* a, int lda,
+          const int8_t* b, int ldb,
+          int8_t beta, int8_t* c, int ldc) {
+    // Rows are independent; each accumulates exactly in 32 bits with
+    // the i-k-j order, which the compiler vectorizes.
+    ThreadPool::global().parallelFor(m,
+        [n, k, alpha, a, lda, b, ldb, beta, c, ldc](int begin, int end) {
+            vector<int32_t> row(n);
+            for (int i = begin; i < end; i++) {
+                std::fill(row.begin(), row.end(), 0);
+                for (int p = 0; p < k; p++) {
+                    int32_t aip = a[static_cast<size_t>(i) * lda + p];
+                    const int8_t* bp = b + static_cast<size_t>(p) * ldb;
+                    for (int j = 0; j < n; j++) {
+                        row[j] += aip * bp[j];
+                    }
+                }
+
+                int8_t* ci = c + static_cast<size_t>(i) * ldc;
+                for (int j = 0; j < n; j++) {
+                    int64_t value = static_cast<int64_t>(alpha) * row[j] +
+                                    beta * ci[j];
+                    ci[j] = static_cast<int8_t>(
+                        value < -128 ? -128 : value > 127 ? 127 : value);
+                }
+            }
+        });
+}
+
+}  // namespace kernels
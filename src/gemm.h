@@ -0,0 +1,38 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef SRC_GEMM_H_
+#define SRC_GEMM_H_
+
+#include <stdint.h>
+
+#include "ml/scalar.h"
+
+namespace kernels {
+
+// C = alpha * A * B + beta * C for row-major A (m x k), B (k x n)
+// and C (m x n) with leading dimensions lda, ldb and ldc.
+// When beta is zero C is not read, so it may hold garbage.
+//
+// double and float run the packed, blocked kernels. BFloat16 is widened
+// to float and rounded once at the end; int8_t accumulates exactly in
+// 32 bits and saturates once at the end.
+void gemm(int m, int n, int k, double alpha,
+          const double* a, int lda,
+          const double* b, int ldb,
+          double beta, double* c, int ldc);
+void gemm(int m, int n, int k, float alpha,
+          const float* a, int lda,
+          const float* b, int ldb,
+          float beta, float* c, int ldc);
+void gemm(int m, int n, int k, BFloat16 alpha,
+          const BFloat16* a, int lda,
+          const BFloat16* b, int ldb,
+          BFloat16 beta, BFloat16* c, int ldc);
+void gemm(int m, int n, int k, int8_t alpha,
+          const int8_t* a, int lda,
+          const int8_t* b, int ldb,
+          int8_t beta, int8_t* c, int ldc);
+
+}  // namespace kernels
+
+#endif  // SRC_GEMM_H_
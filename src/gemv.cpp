@@ -0,0 +1,257 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "src/gemv.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <type_traits>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "ml/thread_pool.h"
+#include "src/simd.h"
+
+using std::min;
+using std::vector;
+
+namespace kernels {
+
+namespace {
+
+// Products with fewer elements than this stay on one thread.
+const double kParallelGemv = 128.0 * 1024.0;
+
+// Rows handled together by the row kernel, sharing the loads of x.
+const int kRows = 4;
+
+// Columns of y updated together by the transposed kernel: the slice of
+// y stays in L1 while all the rows stream past it.
+const int kSliceCols = 1024;
+
+template <class T>
+struct RowKernel {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    // out[r] = row r of A (at a + r*lda) . x, for r < kRows.
+    typedef void (*Type)(const T* a, int lda, const T* x, int n,
+                         Accumulator* out);
+};
+
+template <class T>
+void rowsGeneric(const T* a, int lda, const T* x, int n,
+                 typename ScalarTraits<T>::Accumulator* out) {
+    for (int r = 0; r < kRows; r++) {
+        out[r] = dot(a + r * lda, x, n);
+    }
+}
+
+#if defined(ML_SIMD_X86)
+// One accumulator per row; every load of x feeds four multiply-adds.
+#define ML_ROW_KERNEL(name, target, type, reg, width, load, setzero, fmadd, \
+                      store)                                               \
+    target void name(const type* a, int lda, const type* x, int n,         \
+                     type* out) {                                          \
+        enum { kWidth = (width) };                                         \
+        const type* row[kRows] = { a, a + lda, a + 2 * lda, a + 3 * lda }; \
+        reg s0 = setzero(), s1 = setzero(), s2 = setzero(), s3 = setzero(); \
+        int j = 0;                                                         \
+        for (; j + kWidth <= n; j += kWidth) {                             \
+            reg xj = load(x + j);                                          \
+            s0 = fmadd(load(row[0] + j), xj, s0);                          \
+            s1 = fmadd(load(row[1] + j), xj, s1);                          \
+            s2 = fmadd(load(row[2] + j), xj, s2);                          \
+            s3 = fmadd(load(row[3] + j), xj, s3);                          \
+        }                                                                  \
+        type lanes[kRows][kWidth];                                         \
+        store(lanes[0], s0);                                               \
+        store(lanes[1], s1);                                               \
+        store(lanes[2], s2);                                               \
+        store(lanes[3], s3);                                               \
+        for (int r = 0; r < kRows; r++) {                                  \
+            type sum = 0;                                                  \
+            for (int l = 0; l < kWidth; l++) {                             \
+                sum += lanes[r][l];                                        \
+            }                                                              \
+            for (int k = j; k < n; k++) {                                  \
+                sum += row[r][k] * x[k];                                   \
+            }                                                              \
+            out[r] = sum;                                                  \
+        }                                                                  \
+    }
+
+ML_ROW_KERNEL(rowsAvx2, ML_TARGET_AVX2, double, __m256d, 4,
+              _mm256_loadu_pd, _mm256_setzero_pd, _mm256_fmadd_pd,
+              _mm256_storeu_pd)
+ML_ROW_KERNEL(rowsAvx2, ML_TARGET_AVX2, float, __m256, 8,
+              _mm256_loadu_ps, _mm256_setzero_ps, _mm256_fmadd_ps,
+              _mm256_storeu_ps)
+
+#if defined(ML_SIMD_AVX512)
+ML_ROW_KERNEL(rowsAvx512, ML_TARGET_AVX512, double, __m512d, 8,
+              _mm512_loadu_pd, _mm512_setzero_pd, _mm512_fmadd_pd,
+              _mm512_storeu_pd)
+ML_ROW_KERNEL(rowsAvx512, ML_TARGET_AVX512, float, __m512, 16,
+              _mm512_loadu_ps, _mm512_setzero_ps, _mm512_fmadd_ps,
+              _mm512_storeu_ps)
+#endif  // ML_SIMD_AVX512
+#endif  // ML_SIMD_X86
+
+template <class T>
+typename RowKernel<T>::Type selectRowKernel() {
+    return rowsGeneric<T>;
+}
+
+#if defined(ML_SIMD_X86)
+template <>
+RowKernel<double>::Type selectRowKernel<double>() {
+#if defined(ML_SIMD_AVX512)
+    if (activeIsa() == kIsaAvx512) {
+        return rowsAvx512;
+    }
+#endif
+    if (activeIsa() >= kIsaAvx2) {
+        return rowsAvx2;
+    }
+    return rowsGeneric<double>;
+}
+
+template <>
+RowKernel<float>::Type selectRowKernel<float>() {
+#if defined(ML_SIMD_AVX512)
+    if (activeIsa() == kIsaAvx512) {
+        return rowsAvx512;
+    }
+#endif
+    if (activeIsa() >= kIsaAvx2) {
+        return rowsAvx2;
+    }
+    return rowsGeneric<float>;
+}
+#endif  // ML_SIMD_X86
+
+template <class T>
+typename RowKernel<T>::Type rowKernel() {
+    static const typename RowKernel<T>::Type kernel = selectRowKernel<T>();
+    return kernel;
+}
+
+template <class T>
+T combine(T alpha, typename ScalarTraits<T>::Accumulator acc, T beta,
+          const T& y) {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    Accumulator value = Accumulator(alpha) * acc;
+    if (beta != T(0)) {
+        value += Accumulator(beta) * Accumulator(y);
+    }
+    return ScalarTraits<T>::narrow(value);
+}
+
+template <class T>
+void gemvRows(int begin, int end, int n, T alpha, const T* a, int lda,
+              const T* x, T beta, T* y) {
+    typename ScalarTraits<T>::Accumulator acc[kRows];
+    typename RowKernel<T>::Type kernel = rowKernel<T>();
+    int i = begin;
+    for (; i + kRows <= end; i += kRows) {
+        kernel(a + static_cast<size_t>(i) * lda, lda, x, n, acc);
+        for (int r = 0; r < kRows; r++) {
+            y[i + r] = combine(alpha, acc[r], beta, y[i + r]);
+        }
+    }
+    for (; i < end; i++) {
+        y[i] = combine(alpha, dot(a + static_cast<size_t>(i) * lda, x, n),
+                       beta, y[i]);
+    }
+}
+
+// Columns [begin, end) of y. When T is its own accumulator the rows
+// are added straight into y with axpy; otherwise into a wider buffer
+// that is rounded once.
+template <class T>
+void gemvColumns(int begin, int end, int m, T alpha, const T* a, int lda,
+                 const T* x, T beta, T* y) {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    int width = end - begin;
+    if (std::is_same<Accumulator, T>::value) {
+        if (beta == T(0)) {
+            std::fill(y + begin, y + end, T(0));
+        } else if (beta != T(1)) {
+            scale(beta, y + begin, y + begin, width);
+        }
+        for (int i = 0; i < m; i++) {
+            T weight = alpha * x[i];
+            if (weight != T(0)) {
+                const T* ai = a + static_cast<size_t>(i) * lda + begin;
+                axpy(weight, ai, y + begin, y + begin, width);
+            }
+        }
+        return;
+    }
+
+    vector<Accumulator> acc(width, Accumulator(0));
+    for (int i = 0; i < m; i++) {
+        Accumulator xi = x[i];
+        const T* ai = a + static_cast<size_t>(i) * lda + begin;
+        for (int j = 0; j < width; j++) {
+            acc[j] += xi * Accumulator(ai[j]);
+        }
+    }
+    for (int j = 0; j < width; j++) {
+        y[begin + j] = combine(alpha, acc[j], beta, y[begin + j]);
+    }
+}
+
+bool runParallel(int m, int n) {
+    return ThreadPool::global().threads() > 1 &&
+           static_cast<double>(m) * n >= kParallelGemv;
+}
+
+}  // namespace
+
+template <class T>
+void gemv(int m, int n, T alpha, const T* a, int lda, const T* x,
+          T beta, T* y) {
+    if (!runParallel(m, n)) {
+        gemvRows(0, m, n, alpha, a, lda, x, beta, y);
+        return;
+    }
+
+    int blocks = (m + kRows - 1) / kRows;
+    ThreadPool::global().parallelFor(blocks,
+        [m, n, alpha, a, lda, x, beta, y](int begin, int end) {
+            gemvRows(begin * kRows, min(end * kRows, m), n, alpha, a, lda,
+                     x, beta, y);
+        }, 4);
+}
+
+template <class T>
+void gemvTransposed(int m, int n, T alpha, const T* a, int lda,
+                    const T* x, T beta, T* y) {
+    int slices = (n + kSliceCols - 1) / kSliceCols;
+    if (slices < 2 || !runParallel(m, n)) {
+        for (int s = 0; s < slices; s++) {
+            gemvColumns(s * kSliceCols, min((s + 1) * kSliceCols, n), m,
+                        alpha, a, lda, x, beta, y);
+        }
+        return;
+    }
+
+    ThreadPool::global().parallelFor(slices,
+        [m, n, alpha, a, lda, x, beta, y](int begin, int end) {
+            for (int s = begin; s < end; s++) {
+                gemvColumns(s * kSliceCols, min((s + 1) * kSliceCols, n), m,
+                            alpha, a, lda, x, beta, y);
+            }
+        });
+}
+
+#define ML_INSTANTIATE_GEMV(T)                                               \
+    template void gemv(int, int, T, const T*, int, const T*, T, T*);         \
+    template void gemvTransposed(int, int, T, const T*, int, const T*, T,    \
+                                 T*);
+
+ML_INSTANTIATE_GEMV(double)
+ML_INSTANTIATE_GEMV(float)
+ML_INSTANTIATE_GEMV(int8_t)
+ML_INSTANTIATE_GEMV(BFloat16)
+
+}  // namespace kernels
@@ -0,0 +1,27 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef SRC_GEMV_H_
+#define SRC_GEMV_H_
+
+#include "ml/scalar.h"
+
+namespace kernels {
+
+// y = alpha * A * x + beta * y for row-major A (m x n) with leading
+// dimension lda, x of n and y of m elements.
+template <class T>
+void gemv(int m, int n, T alpha, const T* a, int lda, const T* x,
+          T beta, T* y);
+
+// y = alpha * A^T * x + beta * y for the same A, x of m and y of n
+// elements.
+//
+// In both, each element of y is accumulated in ScalarTraits<T>::
+// Accumulator and rounded once, and y is not read when beta is zero.
+template <class T>
+void gemvTransposed(int m, int n, T alpha, const T* a, int lda,
+                    const T* x, T beta, T* y);
+
+}  // namespace kernels
+
+#endif  // SRC_GEMV_H_
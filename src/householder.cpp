@@ -0,0 +1,73 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "src/householder.h"
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "src/gemm.h"
+#include "src/simd.h"
+
+using std::vector;
+
+namespace kernels {
+
+// T(0:j, j) = -tau(j) T(0:j, 0:j) V^T v(j).
+template <class T>
+void blockReflectorFactor(int rows, int kb, const T* v, const T* vt,
+                          const T* tau, T* t, int ldt) {
+    vector<T> gram(static_cast<size_t>(kb) * kb);
+    gemm(kb, kb, rows, T(1), vt, rows, v, kb, T(0), gram.data(), kb);
+    for (int j = 0; j < kb; j++) {
+        for (int i = 0; i < j; i++) {
+            T sum = 0;
+            for (int p = i; p < j; p++) {
+                sum += t[i * ldt + p] * gram[p * kb + j];
+            }
+            t[i * ldt + j] = -tau[j] * sum;
+        }
+        t[j * ldt + j] = tau[j];
+        for (int i = j + 1; i < kb; i++) {
+            t[i * ldt + j] = 0;
+        }
+    }
+}
+
+template <class T>
+void applyBlockReflector(bool transposed, int rows, int nc, int kb,
+                         const T* v, const T* vt, const T* t, int ldt, T* c,
+                         int ldc, vector<T>* work) {
+    work->resize(static_cast<size_t>(kb) * nc);
+    T* w = work->data();
+    gemm(kb, nc, rows, T(1), vt, rows, c, ldc, T(0), w, nc);
+
+    // W := T^T W or T W, in place: each row only reads rows not yet
+    // overwritten.
+    for (int s = 0; s < kb; s++) {
+        int i = transposed ? kb - 1 - s : s;
+        T* wi = w + static_cast<size_t>(i) * nc;
+        scale(t[i * ldt + i], wi, wi, nc);
+        int first = transposed ? 0 : i + 1;
+        int last = transposed ? i : kb;
+        for (int p = first; p < last; p++) {
+            T factor = transposed ? t[p * ldt + i] : t[i * ldt + p];
+            if (factor != T(0)) {
+                axpy(factor, w + static_cast<size_t>(p) * nc, wi, wi, nc);
+            }
+        }
+    }
+    gemm(rows, nc, kb, T(-1), v, kb, w, nc, T(1), c, ldc);
+}
+
+#define ML_INSTANTIATE_HOUSEHOLDER(T)                                        \
+    template void blockReflectorFactor(int, int, const T*, const T*,         \
+                                       const T*, T*, int);                   \
+    template void applyBlockReflector(bool, int, int, int, const T*,         \
+                                      const T*, const T*, int, T*, int,      \
+                                      vector<T>*);
+
+ML_INSTANTIATE_HOUSEHOLDER(double)
+ML_INSTANTIATE_HOUSEHOLDER(float)
+
+}  // namespace kernels
@@ -0,0 +1,31 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef SRC_HOUSEHOLDER_H_
+#define SRC_HOUSEHOLDER_H_
+
+#include <vector>
+
+namespace kernels {
+
+// Blocks of Householder reflectors H(i) = I - tau(i) v(i) v(i)^T in
+// compact WY form, H(0) H(1) ... H(kb - 1) = I - V T V^T. V is rows x kb
+// and row-major, with v(i) in column i; vt holds its transpose. T is
+// upper triangular, row-major with leading dimension ldt. Elements are
+// double or float.
+
+// Builds T from V and tau through one GEMM for the Gram matrix V^T V.
+template <class T>
+void blockReflectorFactor(int rows, int kb, const T* v, const T* vt,
+                          const T* tau, T* t, int ldt);
+
+// C := (I - V T V^T)^T C, or without the transpose, for the row-major
+// rows x nc matrix c. Both products with V run through GEMM; work is
+// resized to kb x nc.
+template <class T>
+void applyBlockReflector(bool transposed, int rows, int nc, int kb,
+                         const T* v, const T* vt, const T* t, int ldt, T* c,
+                         int ldc, std::vector<T>* work);
+
+}  // namespace kernels
+
+#endif  // SRC_HOUSEHOLDER_H_
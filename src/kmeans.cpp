@@ -0,0 +1,528 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/kmeans.h"
+
+#include <assert.h>
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>  // NOLINT(build/c++11)
+#include <limits>
+#include <random>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "ml/thread_pool.h"
+#include "src/gemm.h"
+#include "src/gemv.h"
+#include "src/simd.h"
+
+using std::max;
+using std::min;
+using std::vector;
+
+namespace {
+
+// Samples per parallel task, and per GEMM when assigning them all.
+const int kBlockRows = 256;
+
+template <class T>
+const T* rowOf(const BasicMatrix<T>& mat, int i) {
+    return mat.ptr() + static_cast<size_t>(i) * mat.cols();
+}
+
+// Squared norms of the rows of x.
+template <class T>
+vector<T> rowNorms(const BasicMatrix<T>& x) {
+    vector<T> norms(x.rows());
+    ThreadPool::global().parallelFor(x.rows(),
+        [&x, &norms](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                norms[i] = T(kernels::sumSquares(rowOf(x, i), x.cols()));
+            }
+        }, kBlockRows);
+    return norms;
+}
+
+// |x - c| from the squared norms and the dot product.
+template <class T>
+T distance(T xNorm, T cNorm, const T* x, const T* c, int d) {
+    T dot = T(kernels::dot(x, c, d));
+    return sqrt(max(T(0), xNorm + cNorm - 2 * dot));
+}
+
+// Labels every row of x with its nearest center, by GEMM over blocks
+// of rows. Optionally stores the distance to it, to the second nearest
+// center (k > 1) and to all centers, row after row.
+template <class T>
+void assignAll(const BasicMatrix<T>& x, const vector<T>& xNorms,
+               const BasicMatrix<T>& centers, const vector<T>& cNorms,
+               int* labels, T* nearest, T* second, T* all) {
+    int n = x.rows();
+    int d = x.cols();
+    int k = centers.rows();
+    BasicMatrix<T> transposed = centers.transposed();
+    const T* ct = transposed.ptr();
+    int blocks = (n + kBlockRows - 1) / kBlockRows;
+    ThreadPool::global().parallelFor(blocks,
+        [&x, &xNorms, &cNorms, ct, n, d, k, labels, nearest, second,
+         all](int begin, int end) {
+            vector<T> scores(static_cast<size_t>(kBlockRows) * k);
+            for (int b = begin; b < end; b++) {
+                int first = b * kBlockRows;
+                int rows = min(kBlockRows, n - first);
+                kernels::gemm(rows, k, d, T(-2), rowOf(x, first), d, ct, k,
+                              T(0), scores.data(), k);
+                for (int r = 0; r < rows; r++) {
+                    int i = first + r;
+                    T* si = scores.data() + static_cast<size_t>(r) * k;
+                    T best = std::numeric_limits<T>::max();
+                    T next = best;
+                    int label = 0;
+                    for (int c = 0; c < k; c++) {
+                        si[c] = max(T(0), si[c] + xNorms[i] + cNorms[c]);
+                        if (si[c] < best) {
+                            next = best;
+                            best = si[c];
+                            label = c;
+                        } else if (si[c] < next) {
+                            next = si[c];
+                        }
+                    }
+                    labels[i] = label;
+                    if (nearest != NULL) {
+                        nearest[i] = sqrt(best);
+                    }
+                    if (second != NULL) {
+                        second[i] = k > 1 ? sqrt(next) : T(0);
+                    }
+                    if (all != NULL) {
+                        T* ai = all + static_cast<size_t>(i) * k;
+                        for (int c = 0; c < k; c++) {
+                            ai[c] = sqrt(si[c]);
+                        }
+                    }
+                }
+            }
+        });
+}
+
+// k-means++: each center is a sample drawn with probability
+// proportional to its squared distance to the centers so far.
+template <class T>
+BasicMatrix<T> seedCenters(const BasicMatrix<T>& x, const vector<T>& xNorms,
+                           int k, unsigned seed) {
+    int n = x.rows();
+    int d = x.cols();
+    std::mt19937 random(seed);
+    BasicMatrix<T> centers(d, k);
+    vector<T> closest(n, std::numeric_limits<T>::max());
+    vector<T> products(n);
+    int chosen = std::uniform_int_distribution<int>(0, n - 1)(random);
+    for (int c = 0; c < k; c++) {
+        if (c > 0) {
+            double total = 0;
+            for (int i = 0; i < n; i++) {
+                total += closest[i];
+            }
+            double target = std::uniform_real_distribution<double>(
+                0, total)(random);
+            chosen = std::uniform_int_distribution<int>(0, n - 1)(random);
+            double sum = 0;
+            for (int i = 0; i < n && total > 0; i++) {
+                sum += closest[i];
+                if (sum > target && closest[i] > 0) {
+                    chosen = i;
+                    break;
+                }
+            }
+        }
+        T* center = centers.ptr() + static_cast<size_t>(c) * d;
+        std::copy(rowOf(x, chosen), rowOf(x, chosen) + d, center);
+        kernels::gemv(n, d, T(-2), x.ptr(), d, center, T(0), products.data());
+        T norm = xNorms[chosen];
+        for (int i = 0; i < n; i++) {
+            closest[i] = min(closest[i],
+                             max(T(0), products[i] + xNorms[i] + norm));
+        }
+    }
+    return centers;
+}
+
+// Sample indices grouped by label, in sample order: the samples of
+// cluster c are order[offsets[c]] to order[offsets[c + 1] - 1].
+void groupByLabel(const vector<int>& labels, int k, vector<int>* offsets,
+                  vector<int>* order) {
+    offsets->assign(k + 1, 0);
+    for (size_t i = 0; i < labels.size(); i++) {
+        (*offsets)[labels[i] + 1]++;
+    }
+    for (int c = 0; c < k; c++) {
+        (*offsets)[c + 1] += (*offsets)[c];
+    }
+    vector<int> next(offsets->begin(), offsets->end() - 1);
+    order->resize(labels.size());
+    for (size_t i = 0; i < labels.size(); i++) {
+        (*order)[next[labels[i]]++] = static_cast<int>(i);
+    }
+}
+
+// Moves every center to the mean of its samples; movement gets the
+// distance each one moved.
+template <class T>
+void updateCenters(const BasicMatrix<T>& x, const vector<int>& labels,
+                   BasicMatrix<T>* centers, vector<T>* movement) {
+    int d = x.cols();
+    int k = centers->rows();
+    vector<int> offsets, order;
+    groupByLabel(labels, k, &offsets, &order);
+    ThreadPool::global().parallelFor(k,
+        [&x, &offsets, &order, centers, movement, d](int begin, int end) {
+            vector<T> sum(d);
+            for (int c = begin; c < end; c++) {
+                int count = offsets[c + 1] - offsets[c];
+                (*movement)[c] = 0;
+                if (count == 0) {
+                    continue;
+                }
+                std::fill(sum.begin(), sum.end(), T(0));
+                for (int p = offsets[c]; p < offsets[c + 1]; p++) {
+                    kernels::add(sum.data(), rowOf(x, order[p]), sum.data(),
+                                 d);
+                }
+                kernels::scale(T(1) / count, sum.data(), sum.data(), d);
+                T* center = centers->ptr() + static_cast<size_t>(c) * d;
+                kernels::sub(center, sum.data(), center, d);
+                (*movement)[c] = sqrt(T(kernels::sumSquares(center, d)));
+                std::copy(sum.begin(), sum.end(), center);
+            }
+        });
+}
+
+// Half the distance of every center to its nearest other center, and
+// all center-center distances if pairs is not NULL.
+template <class T>
+vector<T> centerSeparation(const BasicMatrix<T>& centers,
+                           const vector<T>& cNorms, vector<T>* pairs) {
+    int k = centers.rows();
+    int d = centers.cols();
+    BasicMatrix<T> transposed = centers.transposed();
+    vector<T> products(static_cast<size_t>(k) * k);
+    kernels::gemm(k, k, d, T(-2), centers.ptr(), d, transposed.ptr(), k,
+                  T(0), products.data(), k);
+    vector<T> half(k, std::numeric_limits<T>::max());
+    for (int a = 0; a < k; a++) {
+        for (int c = 0; c < k; c++) {
+            size_t e = static_cast<size_t>(a) * k + c;
+            products[e] = a == c ? T(0) :
+                sqrt(max(T(0), products[e] + cNorms[a] + cNorms[c]));
+            if (a != c) {
+                half[a] = min(half[a], products[e] / 2);
+            }
+        }
+    }
+    if (pairs != NULL) {
+        pairs->swap(products);
+    }
+    return half;
+}
+
+// Lloyd iterations from centers already assigned; keeps the bounds of
+// the chosen method for its assignment steps.
+template <class T>
+class Lloyd {
+ public:
+    Lloyd(const BasicMatrix<T>& x, const vector<T>& xNorms,
+          BasicMatrix<T>* centers, vector<int>* labels, KMeansBounds bounds)
+        : x_(x), xNorms_(xNorms), centers_(centers), labels_(*labels),
+          bounds_(bounds), k_(centers->rows()), cNorms_(rowNorms(*centers)),
+          upper_(x.rows()) {
+        if (bounds_ == kKMeansElkan) {
+            lower_.resize(static_cast<size_t>(x.rows()) * k_);
+        } else if (bounds_ == kKMeansHamerly) {
+            lower_.resize(x.rows());
+        }
+        assignAll(x_, xNorms_, *centers_, cNorms_, labels_.data(),
+                  upper_.data(),
+                  bounds_ == kKMeansHamerly ? lower_.data() : NULL,
+                  bounds_ == kKMeansElkan ? lower_.data() : NULL);
+    }
+
+    // One update and assignment; returns the number of samples that
+    // changed cluster and the summed squared movement of the centers.
+    int64_t iterate(double* shift) {
+        vector<T> movement(k_);
+        updateCenters(x_, labels_, centers_, &movement);
+        cNorms_ = rowNorms(*centers_);
+        *shift = 0;
+        for (int c = 0; c < k_; c++) {
+            *shift += static_cast<double>(movement[c]) * movement[c];
+        }
+        if (bounds_ == kKMeansLloyd) {
+            vector<int> previous = labels_;
+            assignAll(x_, xNorms_, *centers_, cNorms_, labels_.data(),
+                      static_cast<T*>(NULL), static_cast<T*>(NULL),
+                      static_cast<T*>(NULL));
+            int64_t changes = 0;
+            for (size_t i = 0; i < previous.size(); i++) {
+                changes += previous[i] != labels_[i];
+            }
+            return changes;
+        }
+        return bounds_ == kKMeansHamerly ? hamerly(movement)
+                                         : elkan(movement);
+    }
+
+ private:
+    T distanceTo(int i, int c) const {
+        return distance(xNorms_[i], cNorms_[c], rowOf(x_, i),
+                        rowOf(*centers_, c), x_.cols());
+    }
+
+    int64_t hamerly(const vector<T>& movement) {
+        // The lower bound drops by the largest movement of any other
+        // center: the largest, or the second largest for its center.
+        int farthest = static_cast<int>(
+            std::max_element(movement.begin(), movement.end()) -
+            movement.begin());
+        T largest = movement[farthest];
+        T runnerUp = 0;
+        for (int c = 0; c < k_; c++) {
+            if (c != farthest) {
+                runnerUp = max(runnerUp, movement[c]);
+            }
+        }
+        vector<T> half = centerSeparation(*centers_, cNorms_,
+                                          static_cast<vector<T>*>(NULL));
+        std::atomic<int64_t> changes(0);
+        ThreadPool::global().parallelFor(x_.rows(),
+            [this, &movement, &half, farthest, largest, runnerUp,
+             &changes](int begin, int end) {
+                int d = x_.cols();
+                vector<T> products(k_);
+                int64_t changed = 0;
+                for (int i = begin; i < end; i++) {
+                    int a = labels_[i];
+                    upper_[i] += movement[a];
+                    lower_[i] -= a == farthest ? runnerUp : largest;
+                    T bound = max(half[a], lower_[i]);
+                    if (upper_[i] <= bound) {
+                        continue;
+                    }
+                    upper_[i] = distanceTo(i, a);
+                    if (upper_[i] <= bound) {
+                        continue;
+                    }
+                    kernels::gemv(k_, d, T(-2), centers_->ptr(), d,
+                                  rowOf(x_, i), T(0), products.data());
+                    T best = std::numeric_limits<T>::max();
+                    T next = best;
+                    int label = a;
+                    for (int c = 0; c < k_; c++) {
+                        T squared = max(T(0), products[c] + xNorms_[i] +
+                                              cNorms_[c]);
+                        if (squared < best) {
+                            next = best;
+                            best = squared;
+                            label = c;
+                        } else if (squared < next) {
+                            next = squared;
+                        }
+                    }
+                    changed += label != a;
+                    labels_[i] = label;
+                    upper_[i] = sqrt(best);
+                    lower_[i] = sqrt(next);
+                }
+                changes += changed;
+            }, kBlockRows);
+        return changes;
+    }
+
+    int64_t elkan(const vector<T>& movement) {
+        vector<T> pairs;
+        vector<T> half = centerSeparation(*centers_, cNorms_, &pairs);
+        std::atomic<int64_t> changes(0);
+        ThreadPool::global().parallelFor(x_.rows(),
+            [this, &movement, &half, &pairs, &changes](int begin, int end) {
+                int64_t changed = 0;
+                for (int i = begin; i < end; i++) {
+                    T* lower = lower_.data() + static_cast<size_t>(i) * k_;
+                    for (int c = 0; c < k_; c++) {
+                        lower[c] = max(T(0), lower[c] - movement[c]);
+                    }
+                    int a = labels_[i];
+                    T upper = upper_[i] + movement[a];
+                    if (upper <= half[a]) {
+                        upper_[i] = upper;
+                        continue;
+                    }
+                    bool tight = false;
+                    int label = a;
+                    for (int c = 0; c < k_; c++) {
+                        const T* pair = pairs.data() +
+                                        static_cast<size_t>(label) * k_;
+                        if (c == label || upper <= lower[c] ||
+                            upper <= pair[c] / 2) {
+                            continue;
+                        }
+                        if (!tight) {
+                            upper = lower[label] = distanceTo(i, label);
+                            tight = true;
+                            if (upper <= lower[c] || upper <= pair[c] / 2) {
+                                continue;
+                            }
+                        }
+                        T candidate = lower[c] = distanceTo(i, c);
+                        if (candidate < upper) {
+                            upper = candidate;
+                            label = c;
+                        }
+                    }
+                    changed += label != a;
+                    labels_[i] = label;
+                    upper_[i] = upper;
+                }
+                changes += changed;
+            }, kBlockRows);
+        return changes;
+    }
+
+    const BasicMatrix<T>& x_;
+    const vector<T>& xNorms_;
+    BasicMatrix<T>* centers_;
+    vector<int>& labels_;
+    KMeansBounds bounds_;
+    int k_;
+    vector<T> cNorms_;
+    vector<T> upper_;
+    vector<T> lower_;
+};
+
+// Mean variance of the features of x.
+template <class T>
+double featureVariance(const BasicMatrix<T>& x, const vector<T>& xNorms) {
+    int n = x.rows();
+    int d = x.cols();
+    BasicVector<T> ones(n, T(1));
+    BasicVector<T> means(d);
+    kernels::gemvTransposed(n, d, T(1) / n, x.ptr(), d, ones.ptr(), T(0),
+                            means.ptr());
+    double squares = 0;
+    for (int i = 0; i < n; i++) {
+        squares += xNorms[i];
+    }
+    double meanNorm = kernels::sumSquares(means.ptr(), d);
+    return max(0.0, squares / n - meanNorm) / d;
+}
+
+}  // namespace
+
+template <class T>
+BasicKMeans<T>::BasicKMeans(const BasicMatrix<T>& x, int k,
+                            const KMeansOptions& options)
+    : centers_(0, 0), labels_(x.rows()), inertia_(0), iterations_(0),
+      converged_(false) {
+    assert(k >= 1 && k <= x.rows() && options.maxIterations >= 0);
+    vector<T> xNorms = rowNorms(x);
+    centers_ = seedCenters(x, xNorms, k, options.seed);
+    double threshold = options.tolerance * featureVariance(x, xNorms);
+
+    Lloyd<T> lloyd(x, xNorms, &centers_, &labels_, options.bounds);
+    while (iterations_ < options.maxIterations) {
+        iterations_++;
+        double shift;
+        int64_t changes = lloyd.iterate(&shift);
+        if (changes == 0 || shift <= threshold) {
+            converged_ = true;
+            break;
+        }
+    }
+
+    // Inertia from exact distances, summed over blocks in order.
+    vector<T> cNorms = rowNorms(centers_);
+    int blocks = (x.rows() + kBlockRows - 1) / kBlockRows;
+    vector<double> partial(blocks);
+    ThreadPool::global().parallelFor(blocks,
+        [this, &x, &xNorms, &cNorms, &partial](int begin, int end) {
+            for (int b = begin; b < end; b++) {
+                double sum = 0;
+                int last = min(x.rows(), (b + 1) * kBlockRows);
+                for (int i = b * kBlockRows; i < last; i++) {
+                    int c = labels_[i];
+                    T dist = distance(xNorms[i], cNorms[c], rowOf(x, i),
+                                      rowOf(centers_, c), x.cols());
+                    sum += static_cast<double>(dist) * dist;
+                }
+                partial[b] = sum;
+            }
+        });
+    for (int b = 0; b < blocks; b++) {
+        inertia_ += partial[b];
+    }
+}
+
+template <class T>
+vector<int> BasicKMeans<T>::predict(const BasicMatrix<T>& x) const {
+    assert(x.cols() == centers_.cols());
+    vector<int> labels(x.rows());
+    assignAll(x, rowNorms(x), centers_, rowNorms(centers_), labels.data(),
+              static_cast<T*>(NULL), static_cast<T*>(NULL),
+              static_cast<T*>(NULL));
+    return labels;
+}
+
+template <class T>
+BasicMiniBatchKMeans<T>::BasicMiniBatchKMeans(int k, int dims,
+                                              const KMeansOptions& options)
+    : centers_(dims, k), counts_(k), options_(options), initialized_(false) {
+    assert(k >= 1 && dims >= 1);
+}
+
+template <class T>
+void BasicMiniBatchKMeans<T>::partialFit(const BasicMatrix<T>& batch) {
+    assert(batch.cols() == centers_.cols());
+    int k = centers_.rows();
+    int d = centers_.cols();
+    vector<T> xNorms = rowNorms(batch);
+    if (!initialized_) {
+        assert(batch.rows() >= k);
+        centers_ = seedCenters(batch, xNorms, k, options_.seed);
+        initialized_ = true;
+    }
+    vector<int> labels(batch.rows());
+    assignAll(batch, xNorms, centers_, rowNorms(centers_), labels.data(),
+              static_cast<T*>(NULL), static_cast<T*>(NULL),
+              static_cast<T*>(NULL));
+
+    vector<int> offsets, order;
+    groupByLabel(labels, k, &offsets, &order);
+    T* centers = centers_.ptr();
+    int64_t* counts = counts_.data();
+    ThreadPool::global().parallelFor(k,
+        [&batch, &offsets, &order, centers, counts, d](int begin, int end) {
+            for (int c = begin; c < end; c++) {
+                T* center = centers + static_cast<size_t>(c) * d;
+                for (int p = offsets[c]; p < offsets[c + 1]; p++) {
+                    T rate = T(1.0 / ++counts[c]);
+                    kernels::scale(1 - rate, center, center, d);
+                    kernels::axpy(rate, rowOf(batch, order[p]), center,
+                                  center, d);
+                }
+            }
+        });
+}
+
+template <class T>
+vector<int> BasicMiniBatchKMeans<T>::predict(const BasicMatrix<T>& x) const {
+    assert(initialized_ && x.cols() == centers_.cols());
+    vector<int> labels(x.rows());
+    assignAll(x, rowNorms(x), centers_, rowNorms(centers_), labels.data(),
+              static_cast<T*>(NULL), static_cast<T*>(NULL),
+              static_cast<T*>(NULL));
+    return labels;
+}
+
+template class BasicKMeans<double>;
+template class BasicKMeans<float>;
+template class BasicMiniBatchKMeans<double>;
+template class BasicMiniBatchKMeans<float>;
@@ -0,0 +1,123 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/lbfgs.h"
+
+#include <assert.h>
+#include <math.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using std::max;
+using std::min;
+using std::vector;
+
+namespace {
+
+// Sufficient decrease of the Armijo condition.
+const double kArmijo = 1e-4;
+
+// Backtracking halvings before the line search gives up.
+const int kMaxBacktracks = 40;
+
+template <class T>
+T dotProduct(const BasicVector<T>& a, const BasicVector<T>& b) {
+    return T(dot(a, b));
+}
+
+}  // namespace
+
+template <class T>
+BasicLbfgs<T>::BasicLbfgs(const LbfgsOptions& options)
+    : options_(options), converged_(false), iterations_(0), evaluations_(0) {
+    assert(options.history > 0 && options.maxIterations >= 0);
+}
+
+template <class T>
+T BasicLbfgs<T>::minimize(const Objective& f, BasicVector<T>* x) {
+    int n = x->dims();
+    converged_ = false;
+    iterations_ = 0;
+    BasicVector<T> gradient(n);
+    T value = f(*x, &gradient);
+    evaluations_ = 1;
+
+    // Correction pairs s = x' - x, y = g' - g, oldest first.
+    vector<BasicVector<T> > steps, changes;
+    vector<T> rho;
+    vector<T> alpha(options_.history);
+    BasicVector<T> direction(n), next(n), nextGradient(n);
+    for (; iterations_ < options_.maxIterations; iterations_++) {
+        double gradientNorm = gradient.length();
+        if (gradientNorm <= options_.tolerance * max(1.0, x->length())) {
+            converged_ = true;
+            break;
+        }
+
+        // Two-loop recursion: direction = -H g.
+        direction = gradient;
+        int pairs = static_cast<int>(steps.size());
+        for (int i = pairs - 1; i >= 0; i--) {
+            alpha[i] = rho[i] * dotProduct(steps[i], direction);
+            direction -= alpha[i] * changes[i];
+        }
+        if (pairs > 0) {
+            const BasicVector<T>& y = changes[pairs - 1];
+            direction *= T(1) / (rho[pairs - 1] * dotProduct(y, y));
+        }
+        for (int i = 0; i < pairs; i++) {
+            T beta = rho[i] * dotProduct(changes[i], direction);
+            direction += (alpha[i] - beta) * steps[i];
+        }
+        direction *= T(-1);
+        T slope = dotProduct(gradient, direction);
+        if (!(slope < 0)) {
+            // Not a descent direction: forget the history.
+            steps.clear();
+            changes.clear();
+            rho.clear();
+            direction = T(-1) * gradient;
+            slope = -T(gradientNorm * gradientNorm);
+        }
+
+        // Without curvature information the first step has length one.
+        T step = steps.empty() ? T(min(1.0, 1.0 / gradientNorm)) : T(1);
+        T nextValue = 0;
+        bool decreased = false;
+        for (int tries = 0; tries < kMaxBacktracks; tries++) {
+            next = *x + step * direction;
+            nextValue = f(next, &nextGradient);
+            evaluations_++;
+            if (nextValue <= value + T(kArmijo) * step * slope) {
+                decreased = true;
+                break;
+            }
+            step *= T(0.5);
+        }
+        if (!decreased) {
+            break;
+        }
+
+        BasicVector<T> s = next - *x;
+        BasicVector<T> y = nextGradient - gradient;
+        T curvature = dotProduct(s, y);
+        if (curvature > 0) {
+            if (static_cast<int>(steps.size()) == options_.history) {
+                steps.erase(steps.begin());
+                changes.erase(changes.begin());
+                rho.erase(rho.begin());
+            }
+            steps.push_back(std::move(s));
+            changes.push_back(std::move(y));
+            rho.push_back(T(1) / curvature);
+        }
+        std::swap(*x, next);
+        std::swap(gradient, nextGradient);
+        value = nextValue;
+    }
+    return value;
+}
+
+template class BasicLbfgs<double>;
+template class BasicLbfgs<float>;
@@ -4,229 +4,299 @@
 
 #include <assert.h>
 #include <math.h>
+#include <stdint.h>
 
+#include <algorithm>
+#include <functional>
+#include <utility>
 #include <vector>
 #include <iostream>
 
+#include "src/gemm.h"
+#include "src/gemv.h"
+#include "src/simd.h"
+#include "src/transpose.h"
+
 using std::vector;
 using std::ostream;
 
-Vector::Vector(int dims, double defaultValue) {
-    dims_ = dims;
-    data_ = vector<double>(dims_, defaultValue);
-}
+namespace {
 
-Vector::Vector(const Vector& vec) {
-    dims_ = vec.dims_;
-    data_ = vector<double>(dims_);
+// Streams print int8_t as a character and do not know BFloat16.
+double printable(double value) { return value; }
+float printable(float value) { return value; }
+int printable(int8_t value) { return value; }
+float printable(BFloat16 value) { return value; }
 
-    for (int i = 0; i < dims_; i++) {
-        data_[i] = vec.data_[i];
-    }
-}
+}  // namespace
 
-double Vector::at(int i) const {
-    return data_[i];
+template <class T>
+void AddOp::kernel(const T* a, const T* b, T* out, size_t n) {
+    kernels::add(a, b, out, n);
 }
 
-double& Vector::at(int i) {
-    return data_[i];
+template <class T>
+void AddOp::scalarKernel(T a, const T* b, T* out, size_t n) {
+    kernels::addScalar(a, b, out, n);
 }
 
-Vector& Vector::operator =(const Vector& vec) {
-    dims_ = vec.dims_;
-    data_ = vector<double>(dims_);
-
-    for (int i = 0; i < dims_; i++) {
-        data_[i] = vec.data_[i];
-    }
+template <class T>
+void SubOp::kernel(const T* a, const T* b, T* out, size_t n) {
+    kernels::sub(a, b, out, n);
+}
 
-    return *this;
+template <class T>
+void MulOp::kernel(const T* a, const T* b, T* out, size_t n) {
+    kernels::mul(a, b, out, n);
 }
 
-Vector Vector::operator +(const Vector& vec) const {
-    Vector sumVec(vec.dims_);
+template <class T>
+void MulOp::scalarKernel(T a, const T* b, T* out, size_t n) {
+    kernels::scale(a, b, out, n);
+}
 
-    for (int i = 0; i < dims_; i++) {
-        sumVec.data_[i] = data_[i]+vec.data_[i];
-    }
+template <class T>
+BasicVector<T>::BasicVector(int dims, T defaultValue) {
+    dims_ = dims;
+    data_ = BasicStorage<T>(dims_, defaultValue);
+}
 
-    return sumVec;
+template <class T>
+BasicVector<T>::BasicVector(const BasicVector& vec)
+    : data_(vec.data_), dims_(vec.dims_) {
 }
 
-Vector Vector::operator -(const Vector& vec) const {
-    Vector diffVec(vec.dims_);
+template <class T>
+BasicVector<T>::BasicVector(BasicVector&& vec) noexcept  // NOLINT
+    : data_(std::move(vec.data_)), dims_(vec.dims_) {
+    vec.dims_ = 0;
+}
 
-    for (int i = 0; i < dims_; i++) {
-        diffVec.data_[i] = data_[i]-vec.data_[i];
-    }
+// Copies into the existing buffer whenever it is large enough.
+template <class T>
+BasicVector<T>& BasicVector<T>::operator =(const BasicVector& vec) {
+    dims_ = vec.dims_;
+    data_ = vec.data_;
 
-    return diffVec;
+    return *this;
 }
 
-Vector Vector::operator *(const Vector& vec) const {
-    Vector multiplyVec(vec.dims_);
-
-    for (int i = 0; i < dims_; i++) {
-        multiplyVec.data_[i] = data_[i]*vec.data_[i];
+template <class T>
+BasicVector<T>& BasicVector<T>::operator =(
+        BasicVector&& vec) noexcept {  // NOLINT(build/c++11)
+    if (this != &vec) {
+        dims_ = vec.dims_;
+        data_ = std::move(vec.data_);
+        vec.dims_ = 0;
     }
 
-    return multiplyVec;
+    return *this;
 }
 
-bool Vector::operator ==(const Vector& vec) const {
-    if (dims_ != vec.dims_) {
-        return false;
-    }
-
-    for (int i = 0; i < dims_; i++) {
-        if (data_[i] != vec.data_[i]) {
-            return false;
-        }
-    }
+template <class T>
+BasicVector<T>& BasicVector<T>::operator *=(T a) {
+    kernels::scale(a, ptr(), ptr(), dims_);
 
-    return true;
+    return *this;
 }
 
-bool Vector::operator !=(const Vector& vec) const {
-    return !(*this == vec);
+template <class T>
+void BasicVector<T>::assign(
+        const VectorBinary<AddOp, BasicVector,
+                           VectorScalar<MulOp, BasicVector> >& expr) {
+    const BasicVector& x = expr.rhs().expr();
+    dims_ = expr.dims();
+    data_.resize(dims_);
+    kernels::axpy(expr.rhs().scalar(), x.ptr(),
+                  expr.lhs().ptr(), ptr(), dims_);
 }
 
-std::vector<double> Vector::data() const {
-    return data_;
+template <class T>
+void BasicVector<T>::assign(
+        const VectorBinary<AddOp, VectorScalar<MulOp, BasicVector>,
+                           BasicVector>& expr) {
+    const BasicVector& x = expr.lhs().expr();
+    dims_ = expr.dims();
+    data_.resize(dims_);
+    kernels::axpy(expr.lhs().scalar(), x.ptr(),
+                  expr.rhs().ptr(), ptr(), dims_);
 }
 
-int Vector::dims() const {
-    return dims_;
+template <class T>
+std::vector<T> BasicVector<T>::data() const {
+    return vector<T>(ptr(), ptr() + size());
 }
 
-std::ostream& operator <<(std::ostream& os, const Vector& vec) {
+template <class T>
+std::ostream& operator <<(std::ostream& os, const BasicVector<T>& vec) {
     os << "(";
     for (int i = 0; i < vec.dims()-1; i++) {
-        os << vec.at(i) << ", ";
+        os << printable(vec.at(i)) << ", ";
     }
-    os << vec.at(vec.dims()-1) << ")" << std::endl;
+    os << printable(vec.at(vec.dims()-1)) << ")" << std::endl;
     return os;
 }
 
-Vector operator *(const double& a, const Vector& vec) {
-    Vector multVec(vec.dims());
-
-    for (int i = 0; i < vec.dims(); i++) {
-        multVec.at(i)*=a;
-    }
-
-    return multVec;
+template <class T>
+double BasicVector<T>::length() const {
+    return sqrt(static_cast<double>(kernels::sumSquares(ptr(), dims_)));
 }
 
-Vector operator +(const double& a, const Vector& vec) {
-    return Vector(vec.dims(), a) + vec;
-}
+template <class T>
+typename ScalarTraits<T>::Accumulator dot(const BasicVector<T>& vec1,
+                                          const BasicVector<T>& vec2) {
+    assert(vec1.dims() == vec2.dims());
 
-Vector operator +(const Vector& vec, const double& a) {
-    return Vector(vec.dims(), a) + vec;
+    return kernels::dot(vec1.ptr(), vec2.ptr(), vec1.dims());
 }
 
-double Vector::length() const {
-    double sum = 0;
-    for (int i = 0; i < dims(); i++) {
-        sum+=at(i)*at(i);
+template <class T>
+typename ScalarTraits<T>::Accumulator dot(const T* a, int strideA,
+                                          const T* b, int strideB, int n) {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    if (strideA == 1 && strideB == 1) {
+        return kernels::dot(a, b, n);
     }
 
-    return sqrt(sum);
-}
-double dot(const Vector &vec1, const Vector &vec2) {
-    int sum = 0;
-    for (int i = 0; i< vec1.dims(); i++) {
-        sum+=vec1.at(i)*vec2.at(i);
+    Accumulator sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += Accumulator(a[static_cast<ptrdiff_t>(i)*strideA]) *
+               Accumulator(b[static_cast<ptrdiff_t>(i)*strideB]);
     }
 
     return sum;
 }
 
-Matrix::Matrix(int cols, int rows, double defaultValue) {
+template <class T>
+BasicMatrix<T>::BasicMatrix(int cols, int rows, T defaultValue) {
     cols_ = cols;
     rows_ = rows;
-    data_ = vector<double>(cols_*rows_, defaultValue);
+    data_ = BasicStorage<T>(static_cast<size_t>(cols_)*rows_, defaultValue);
 }
 
-Matrix::Matrix(const Matrix &mat) {
-    cols_ = mat.cols_;
-    rows_ = mat.rows_;
-    data_ = vector<double>(cols_*rows_);
-
-    for (std::size_t i = 0; i < data_.size(); i++) {
-        data_[i] = mat.data_[i];
-    }
+template <class T>
+BasicMatrix<T>::BasicMatrix(int cols, int rows, BasicStorage<T> storage)
+    : data_(std::move(storage)), cols_(cols), rows_(rows) {
+    assert(data_.size() == static_cast<size_t>(cols_)*rows_);
 }
 
-double Matrix::at(int i, int j) const {
-    return data_[cols()*i+j];
+template <class T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix &mat)
+    : data_(mat.data_), cols_(mat.cols_), rows_(mat.rows_) {
 }
 
-double& Matrix::at(int i, int j) {
-    return data_[cols()*i+j];
+template <class T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix&& mat) noexcept  // NOLINT
+    : data_(std::move(mat.data_)), cols_(mat.cols_), rows_(mat.rows_) {
+    mat.cols_ = 0;
+    mat.rows_ = 0;
 }
 
-Matrix& Matrix::operator =(const Matrix& mat) {
+// Copies into the existing buffer whenever it is large enough.
+template <class T>
+BasicMatrix<T>& BasicMatrix<T>::operator =(const BasicMatrix& mat) {
     cols_ = mat.cols_;
     rows_ = mat.rows_;
-    data_ = vector<double>(cols_*rows_);
-
-    for (std::size_t i = 0; i < data_.size(); i++) {
-        data_[i] = mat.data_[i];
-    }
+    data_ = mat.data_;
 
     return *this;
 }
 
-Matrix Matrix::operator +(const Matrix& mat) const {
-    assert(cols_ == mat.cols_ && rows_ == mat.rows_);
-
-    Matrix sumMat(cols_, rows_);
-
-    for (size_t i = 0; i < sumMat.data_.size(); i++) {
-        sumMat.data_[i] = data_[i] + mat.data_[i];
+template <class T>
+BasicMatrix<T>& BasicMatrix<T>::operator =(
+        BasicMatrix&& mat) noexcept {  // NOLINT(build/c++11)
+    if (this != &mat) {
+        cols_ = mat.cols_;
+        rows_ = mat.rows_;
+        data_ = std::move(mat.data_);
+        mat.cols_ = 0;
+        mat.rows_ = 0;
     }
 
-    return sumMat;
+    return *this;
 }
 
-Matrix Matrix::operator -(const Matrix& mat) const {
-    assert(cols_ == mat.cols_ && rows_ == mat.rows_);
+template <class T>
+BasicMatrix<T>& BasicMatrix<T>::operator *=(T a) {
+    kernels::scale(a, ptr(), ptr(), size());
 
-    Matrix diffMat(cols_, rows_);
+    return *this;
+}
 
-    for (size_t i = 0; i < diffMat.data_.size(); i++) {
-        diffMat.data_[i] = data_[i] - mat.data_[i];
+template <class T>
+void BasicMatrix<T>::assign(
+        const MatrixBinary<AddOp, BasicMatrix,
+                           MatrixScalar<MulOp, BasicMatrix> >& expr) {
+    const BasicMatrix& x = expr.rhs().expr();
+    rows_ = expr.rows();
+    cols_ = expr.cols();
+    data_.resize(static_cast<size_t>(rows_)*cols_);
+    kernels::axpy(expr.rhs().scalar(), x.ptr(),
+                  expr.lhs().ptr(), ptr(), size());
+}
+
+template <class T>
+void BasicMatrix<T>::assign(
+        const MatrixBinary<AddOp, MatrixScalar<MulOp, BasicMatrix>,
+                           BasicMatrix>& expr) {
+    const BasicMatrix& x = expr.lhs().expr();
+    rows_ = expr.rows();
+    cols_ = expr.cols();
+    data_.resize(static_cast<size_t>(rows_)*cols_);
+    kernels::axpy(expr.lhs().scalar(), x.ptr(),
+                  expr.rhs().ptr(), ptr(), size());
+}
+
+// Rows and transposed views are copied by block, strided views element
+// by element. A view into this matrix is copied aside first unless it
+// is its transpose.
+template <class T>
+void BasicMatrix<T>::assign(const BasicMatrixView<const T>& view) {
+    std::less_equal<const T*> notAfter;
+    if (size() > 0 && notAfter(ptr(), view.ptr()) &&
+        !notAfter(ptr() + size(), view.ptr())) {
+        if (view.ptr() == ptr() && view.rowStride() == 1 &&
+            view.colStride() == cols_ && view.rows() == cols_ &&
+            view.cols() == rows_) {
+            transposeInPlace();
+        } else {
+            *this = BasicMatrix(view);
+        }
+        return;
     }
 
-    return diffMat;
-}
-
-bool Matrix::operator ==(const Matrix& mat) const {
-    if (cols_ != mat.cols_ || rows_ != mat.rows_) {
-        return false;
+    rows_ = view.rows();
+    cols_ = view.cols();
+    data_.resize(static_cast<size_t>(rows_)*cols_);
+    if (view.colStride() == 1) {
+        for (int i = 0; i < rows_; i++) {
+            const T* row = view.ptr() + static_cast<size_t>(i)*view.rowStride();
+            std::copy(row, row + cols_, ptr() + static_cast<size_t>(i)*cols_);
+        }
+    } else if (view.rowStride() == 1) {
+        kernels::transpose(cols_, rows_, view.ptr(), view.colStride(),
+                           ptr(), cols_);
     } else {
-        for (size_t i = 0; i < data_.size(); i++) {
-            if (data_[i] != mat.data_[i]) {
-                return false;
+        for (int i = 0; i < rows_; i++) {
+            for (int j = 0; j < cols_; j++) {
+                at(i, j) = view.at(i, j);
             }
         }
-
-        return true;
     }
 }
 
-bool Matrix::operator !=(const Matrix& mat) const {
-    return !(*this == mat);
+template <class T>
+void BasicMatrix<T>::transposeInPlace() {
+    kernels::transposeInPlace(rows_, cols_, ptr());
+    std::swap(rows_, cols_);
 }
 
-ostream& operator <<(ostream& os, const Matrix& mat) {
-    for (int i = 0; i < mat.cols(); i++) {
+template <class T>
+ostream& operator <<(ostream& os, const BasicMatrix<T>& mat) {
+    for (int i = 0; i < mat.rows(); i++) {
         os << "| ";
-        for (int j = 0; j < mat.rows(); j++) {
-            os << mat.at(i, j) << " ";
+        for (int j = 0; j < mat.cols(); j++) {
+            os << printable(mat.at(i, j)) << " ";
         }
         os << "|" << std::endl;
     }
@@ -234,59 +304,101 @@ ostream& operator <<(ostream& os, const Matrix& mat) {
     return os;
 }
 
-Matrix operator *(const double& a, const Matrix& mat) {
-    Matrix multiplyMat(mat.cols(), mat.rows());
-    for (int i = 0; i < mat.rows(); i++) {
-        for (int j = 0; j < mat.cols(); j++) {
-            multiplyMat.at(i, j) = a*mat.at(i, j);
-        }
-    }
+template <class T>
+BasicMatrix<T> BasicMatrix<T>::operator *(const BasicMatrix& mat) const {
+    assert(cols_ == mat.rows_);
+    BasicMatrix multiplyMat(mat.cols_, rows_);
+
+    kernels::gemm(rows_, mat.cols_, cols_, T(1),
+                  ptr(), cols_,
+                  mat.ptr(), mat.cols_,
+                  T(0), multiplyMat.ptr(), multiplyMat.cols_);
 
     return multiplyMat;
 }
 
-Matrix Matrix::operator *(const Matrix& mat) const {
-    assert(this->cols() == mat.rows());
-    Matrix multiplyMat(rows(), this->cols());
-
-    for (int i = 0; i < multiplyMat.cols(); i++) {
-        for (int j = 0; j < multiplyMat.rows(); j++) {
-            double sum = 0.0;
-            for (int k = 0; k < cols(); k++) {
-                sum+=this->at(i, k)*mat.at(k, j);
-            }
-            multiplyMat.at(i, j) = sum;
+template <class T>
+void multiply(const BasicMatrixView<const T>& a, const BasicVector<T>& x,
+              BasicVector<T>* y) {
+    assert(a.cols() == x.dims() && a.rows() == y->dims());
+    if (a.rows() == 0) {
+        return;
+    }
+    if (y->ptr() == x.ptr()) {
+        // The kernels write y while still reading x.
+        BasicVector<T> copy(x);
+        multiply(a, copy, y);
+        return;
+    }
+    if (a.cols() == 0) {
+        std::fill(y->ptr(), y->ptr() + y->dims(), T(0));
+    } else if (a.colStride() == 1) {
+        kernels::gemv(a.rows(), a.cols(), T(1), a.ptr(), a.rowStride(),
+                      x.ptr(), T(0), y->ptr());
+    } else if (a.rowStride() == 1) {
+        // The transpose of a row-major matrix.
+        kernels::gemvTransposed(a.cols(), a.rows(), T(1), a.ptr(),
+                                a.colStride(), x.ptr(), T(0), y->ptr());
+    } else {
+        for (int i = 0; i < a.rows(); i++) {
+            y->at(i) = ScalarTraits<T>::narrow(dot<T>(
+                a.ptr() + static_cast<ptrdiff_t>(i) * a.rowStride(),
+                a.colStride(), x.ptr(), 1, x.dims()));
         }
     }
-
-    return multiplyMat;
-}
-
-Matrix operator +(const double& a, const Matrix& mat) {
-    return Matrix(mat.cols(), mat.rows(), a) + mat;
-}
-
-Matrix operator +(const Matrix& mat, const double& a) {
-    return Matrix(mat.cols(), mat.rows(), a) + mat;
 }
 
-vector<double> Matrix::data() const {
-    return data_;
+template <class T>
+BasicVector<T> operator *(const BasicMatrix<T>& a, const BasicVector<T>& x) {
+    BasicVector<T> y(a.rows());
+    multiply(a.view(), x, &y);
+    return y;
 }
 
-int Matrix::cols() const {
-    return cols_;
+template <class T>
+BasicVector<T> operator *(const BasicVector<T>& x, const BasicMatrix<T>& a) {
+    BasicVector<T> y(a.cols());
+    multiply(a.transposed(), x, &y);
+    return y;
 }
 
-int Matrix::rows() const {
-    return rows_;
+template <class T>
+vector<T> BasicMatrix<T>::data() const {
+    return vector<T>(ptr(), ptr() + size());
 }
 
-Matrix Matrix::identity(int dims) {
-    Matrix mat(dims, dims, 0);
+template <class T>
+BasicMatrix<T> BasicMatrix<T>::identity(int dims) {
+    BasicMatrix mat(dims, dims);
     for (int i = 0; i < dims; i++) {
-        mat.at(i, i) = 1.0;
+        mat.at(i, i) = T(1);
     }
 
     return mat;
 }
+
+#define ML_INSTANTIATE_LINEAR_ALGEBRA(T)                                     \
+    template void AddOp::kernel(const T*, const T*, T*, size_t);             \
+    template void AddOp::scalarKernel(T, const T*, T*, size_t);              \
+    template void SubOp::kernel(const T*, const T*, T*, size_t);             \
+    template void MulOp::kernel(const T*, const T*, T*, size_t);             \
+    template void MulOp::scalarKernel(T, const T*, T*, size_t);              \
+    template class BasicVector<T>;                                           \
+    template class BasicMatrix<T>;                                           \
+    template std::ostream& operator <<(std::ostream&, const BasicVector<T>&); \
+    template std::ostream& operator <<(std::ostream&, const BasicMatrix<T>&); \
+    template ScalarTraits<T>::Accumulator dot(const BasicVector<T>&,         \
+                                              const BasicVector<T>&);        \
+    template ScalarTraits<T>::Accumulator dot(const T*, int, const T*, int,  \
+                                              int);                          \
+    template void multiply(const BasicMatrixView<const T>&,                  \
+                           const BasicVector<T>&, BasicVector<T>*);          \
+    template BasicVector<T> operator *(const BasicMatrix<T>&,                \
+                                       const BasicVector<T>&);               \
+    template BasicVector<T> operator *(const BasicVector<T>&,                \
+                                       const BasicMatrix<T>&);
+
+ML_INSTANTIATE_LINEAR_ALGEBRA(double)
+ML_INSTANTIATE_LINEAR_ALGEBRA(float)
+ML_INSTANTIATE_LINEAR_ALGEBRA(int8_t)
+ML_INSTANTIATE_LINEAR_ALGEBRA(BFloat16)
@@ -0,0 +1,269 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/logistic.h"
+
+#include <assert.h>
+#include <math.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "ml/thread_pool.h"
+#include "src/gemm.h"
+#include "src/gemv.h"
+#include "src/simd.h"
+#include "src/transpose.h"
+
+using std::max;
+using std::min;
+using std::vector;
+
+namespace {
+
+// Bytes of samples per block of a shard: the block is scored and its
+// gradient taken while it stays in L2.
+const int kBlockBytes = 128 * 1024;
+
+template <class T>
+T sigmoid(T z) {
+    if (z >= 0) {
+        return T(1) / (T(1) + exp(-z));
+    }
+    T e = exp(z);
+    return e / (T(1) + e);
+}
+
+// Turns the scores z of one sample into probabilities minus the one-hot
+// label, in place, and returns the cross-entropy; k = 1 is the sigmoid
+// of a single score of class 1.
+template <class T>
+double residuals(int k, int label, T* z) {
+    if (k == 1) {
+        T score = z[0];
+        z[0] = sigmoid(score) - T(label);
+        return max(score, T(0)) + log1p(exp(-fabs(score))) - label * score;
+    }
+    T largest = z[0];
+    for (int c = 1; c < k; c++) {
+        largest = max(largest, z[c]);
+    }
+    double loss = largest - z[label];
+    T sum = 0;
+    for (int c = 0; c < k; c++) {
+        z[c] = exp(z[c] - largest);
+        sum += z[c];
+    }
+    loss += log(sum);
+    for (int c = 0; c < k; c++) {
+        z[c] = z[c] / sum - T(c == label);
+    }
+    return loss;
+}
+
+// Cross-entropy of a model with k score rows and its gradient, summed
+// over a range of samples.
+template <class T>
+class ShardLoss {
+ public:
+    ShardLoss(const BasicMatrix<T>& x, const vector<int>& labels, int k)
+        : x_(x), labels_(labels), k_(k),
+          blockRows_(max(16, kBlockBytes /
+                             static_cast<int>(sizeof(T) * max(1, x.cols())))),
+          scores_(static_cast<size_t>(blockRows_) * k),
+          transposed_(static_cast<size_t>(blockRows_) * k) {}
+
+    // Rows [begin, end) for weights w (k x d, and transposed wt, d x k)
+    // and intercepts b; the gradient, k x d then k, is added to grad.
+    double evaluate(int begin, int end, const T* w, const T* wt, const T* b,
+                    T* grad) {
+        int d = x_.cols();
+        T* gradIntercepts = grad + static_cast<size_t>(k_) * d;
+        double loss = 0;
+        for (int start = begin; start < end; start += blockRows_) {
+            int rows = min(blockRows_, end - start);
+            const T* xb = x_.ptr() + static_cast<size_t>(start) * d;
+            T* z = scores_.data();
+            if (k_ == 1) {
+                kernels::gemv(rows, d, T(1), xb, d, w, T(0), z);
+            } else {
+                kernels::gemm(rows, k_, d, T(1), xb, d, wt, k_, T(0), z, k_);
+            }
+            for (int i = 0; i < rows; i++) {
+                T* zi = z + static_cast<size_t>(i) * k_;
+                kernels::add(zi, b, zi, k_);
+                loss += residuals(k_, labels_[start + i], zi);
+                kernels::add(gradIntercepts, zi, gradIntercepts, k_);
+            }
+            if (k_ == 1) {
+                kernels::gemvTransposed(rows, d, T(1), xb, d, z, T(1), grad);
+            } else {
+                kernels::transpose(rows, k_, z, k_, transposed_.data(), rows);
+                kernels::gemm(k_, d, rows, T(1), transposed_.data(), rows, xb,
+                              d, T(1), grad, d);
+            }
+        }
+        return loss;
+    }
+
+ private:
+    const BasicMatrix<T>& x_;
+    const vector<int>& labels_;
+    int k_;
+    int blockRows_;
+    vector<T> scores_;
+    vector<T> transposed_;
+};
+
+// Penalized mean cross-entropy of the parameters theta, the k x d
+// weights followed by the k intercepts.
+template <class T>
+T logisticLoss(const BasicMatrix<T>& x, const vector<int>& labels, int k,
+               const LogisticOptions& options, int shards,
+               const BasicVector<T>& theta, BasicVector<T>* gradient) {
+    int n = x.rows();
+    int d = x.cols();
+    size_t weightCount = static_cast<size_t>(k) * d;
+    const T* w = theta.ptr();
+    const T* b = w + weightCount;
+    vector<T> wt(weightCount);
+    if (k > 1) {
+        kernels::transpose(k, d, w, d, wt.data(), k);
+    }
+    const T* wtp = wt.data();
+
+    vector<double> losses(shards);
+    vector<BasicVector<T> > partial(shards, BasicVector<T>(theta.dims()));
+    ThreadPool::global().parallelFor(shards,
+        [&x, &labels, k, n, shards, w, wtp, b, &losses, &partial](int begin,
+                                                                 int end) {
+            ShardLoss<T> shard(x, labels, k);
+            for (int s = begin; s < end; s++) {
+                int first = static_cast<int>(static_cast<int64_t>(n) * s /
+                                             shards);
+                int last = static_cast<int>(static_cast<int64_t>(n) *
+                                            (s + 1) / shards);
+                losses[s] = shard.evaluate(first, last, w, wtp, b,
+                                           partial[s].ptr());
+            }
+        });
+
+    double loss = 0;
+    *gradient = partial[0];
+    for (int s = 0; s < shards; s++) {
+        loss += losses[s];
+        if (s > 0) {
+            *gradient += partial[s];
+        }
+    }
+    *gradient *= T(1) / n;
+    T* g = gradient->ptr();
+    T l2 = T(options.l2);
+    kernels::axpy(l2, w, g, g, weightCount);
+    if (!options.intercept) {
+        std::fill(g + weightCount, g + weightCount + k, T(0));
+    }
+    double penalty = kernels::sumSquares(w, weightCount);
+    return T(loss / n + 0.5 * options.l2 * penalty);
+}
+
+}  // namespace
+
+template <class T>
+BasicLogisticRegression<T>::BasicLogisticRegression(int classes,
+                                                    BasicMatrix<T> weights,
+                                                    BasicVector<T> intercepts)
+    : classes_(classes), weights_(std::move(weights)),
+      intercepts_(std::move(intercepts)) {
+    assert(classes >= 2);
+    assert(weights_.rows() == (classes == 2 ? 1 : classes));
+    assert(intercepts_.dims() == weights_.rows());
+}
+
+template <class T>
+BasicMatrix<T> BasicLogisticRegression<T>::predictProbabilities(
+        const BasicMatrix<T>& x) const {
+    assert(x.cols() == dims());
+    int n = x.rows();
+    int k = weights_.rows();
+    BasicMatrix<T> probabilities(classes_, n);
+    T* p = probabilities.ptr();
+    if (k == 1) {
+        vector<T> z(n);
+        kernels::gemv(n, dims(), T(1), x.ptr(), dims(), weights_.ptr(), T(0),
+                      z.data());
+        for (int i = 0; i < n; i++) {
+            T one = sigmoid(z[i] + intercepts_.at(0));
+            p[2 * i] = T(1) - one;
+            p[2 * i + 1] = one;
+        }
+        return probabilities;
+    }
+    BasicMatrix<T> wt = weights_.transposed();
+    kernels::gemm(n, k, dims(), T(1), x.ptr(), dims(), wt.ptr(), k, T(0), p,
+                  k);
+    for (int i = 0; i < n; i++) {
+        T* pi = p + static_cast<size_t>(i) * k;
+        kernels::add(pi, intercepts_.ptr(), pi, k);
+        T largest = *std::max_element(pi, pi + k);
+        T sum = 0;
+        for (int c = 0; c < k; c++) {
+            pi[c] = exp(pi[c] - largest);
+            sum += pi[c];
+        }
+        kernels::scale(T(1) / sum, pi, pi, k);
+    }
+    return probabilities;
+}
+
+template <class T>
+vector<int> BasicLogisticRegression<T>::predict(
+        const BasicMatrix<T>& x) const {
+    BasicMatrix<T> probabilities = predictProbabilities(x);
+    vector<int> labels(x.rows());
+    for (int i = 0; i < x.rows(); i++) {
+        const T* pi = probabilities.ptr() + static_cast<size_t>(i) * classes_;
+        labels[i] = static_cast<int>(std::max_element(pi, pi + classes_) -
+                                     pi);
+    }
+    return labels;
+}
+
+template <class T>
+BasicLogisticRegression<T> fitLogisticRegression(
+        const BasicMatrix<T>& x, const vector<int>& labels, int classes,
+        const LogisticOptions& options) {
+    assert(classes >= 2 && x.rows() > 0);
+    assert(static_cast<int>(labels.size()) == x.rows());
+    for (size_t i = 0; i < labels.size(); i++) {
+        assert(labels[i] >= 0 && labels[i] < classes);
+    }
+    int k = classes == 2 ? 1 : classes;
+    int d = x.cols();
+    int shards = options.shards > 0 ? options.shards
+                                    : ThreadPool::global().threads();
+    shards = min(shards, x.rows());
+    BasicVector<T> theta(k * d + k);
+    BasicLbfgs<T> lbfgs(options.lbfgs);
+    lbfgs.minimize(
+        [&x, &labels, k, &options, shards](const BasicVector<T>& params,
+                                           BasicVector<T>* gradient) {
+            return logisticLoss(x, labels, k, options, shards, params,
+                                gradient);
+        }, &theta);
+
+    BasicMatrix<T> weights(d, k);
+    std::copy(theta.ptr(), theta.ptr() + k * d, weights.ptr());
+    BasicVector<T> intercepts(k);
+    std::copy(theta.ptr() + k * d, theta.ptr() + k * d + k, intercepts.ptr());
+    return BasicLogisticRegression<T>(classes, std::move(weights),
+                                      std::move(intercepts));
+}
+
+template class BasicLogisticRegression<double>;
+template class BasicLogisticRegression<float>;
+template LogisticRegression fitLogisticRegression(const Matrix&,
+                                                  const vector<int>&, int,
+                                                  const LogisticOptions&);
+template FloatLogisticRegression fitLogisticRegression(
+    const FloatMatrix&, const vector<int>&, int, const LogisticOptions&);
@@ -0,0 +1,163 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/lu.h"
+
+#include <assert.h>
+#include <math.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "src/gemm.h"
+#include "src/simd.h"
+#include "src/triangular.h"
+
+using std::min;
+
+namespace {
+
+// Columns per panel. Panels are factored a column at a time; the
+// trailing matrix is updated a panel at a time through GEMM.
+const int kPanel = 64;
+
+// Factors columns [k, k + kb) of the n x n matrix a, rows k and below,
+// exchanging whole rows as it pivots. Returns false on a zero pivot.
+template <class T>
+bool factorPanel(int n, int k, int kb, T* a, int lda, int* pivots) {
+    bool regular = true;
+    for (int j = k; j < k + kb; j++) {
+        int pivot = j;
+        T largest = fabs(a[static_cast<size_t>(j) * lda + j]);
+        for (int i = j + 1; i < n; i++) {
+            T value = fabs(a[static_cast<size_t>(i) * lda + j]);
+            if (value > largest) {
+                largest = value;
+                pivot = i;
+            }
+        }
+        pivots[j] = pivot;
+        T* aj = a + static_cast<size_t>(j) * lda;
+        if (pivot != j) {
+            std::swap_ranges(aj, aj + n,
+                             a + static_cast<size_t>(pivot) * lda);
+        }
+        if (largest == T(0)) {
+            // The column is zero from here down: nothing to eliminate.
+            regular = false;
+            continue;
+        }
+
+        T diagonal = aj[j];
+        int width = k + kb - j - 1;
+        for (int i = j + 1; i < n; i++) {
+            T* ai = a + static_cast<size_t>(i) * lda;
+            ai[j] /= diagonal;
+            if (ai[j] != T(0) && width > 0) {
+                kernels::axpy(-ai[j], aj + j + 1, ai + j + 1, ai + j + 1,
+                              width);
+            }
+        }
+    }
+    return regular;
+}
+
+void throwSingular() {
+    throw std::runtime_error("lu: singular matrix");
+}
+
+}  // namespace
+
+template <class T>
+BasicLu<T>::BasicLu(BasicMatrix<T> a)
+    : factors_(std::move(a)), pivots_(factors_.rows()), singular_(false) {
+    assert(factors_.rows() == factors_.cols());
+    int n = factors_.rows();
+    T* data = factors_.ptr();
+    int lda = n;
+    for (int k = 0; k < n; k += kPanel) {
+        int kb = min(kPanel, n - k);
+        if (!factorPanel(n, k, kb, data, lda, pivots_.data())) {
+            singular_ = true;
+        }
+
+        int rest = n - k - kb;
+        if (rest == 0) {
+            break;
+        }
+        // U12 = L11^-1 A12, then A22 -= L21 U12.
+        T* akk = data + static_cast<size_t>(k) * lda + k;
+        kernels::solveTriangular(kernels::kLower, kernels::kUnitDiagonal,
+                                 kb, rest, akk, lda, akk + kb, lda);
+        T* a21 = akk + static_cast<size_t>(kb) * lda;
+        kernels::gemm(rest, rest, kb, T(-1), a21, lda, akk + kb, lda, T(1),
+                      a21 + kb, lda);
+    }
+}
+
+template <class T>
+T BasicLu<T>::determinant() const {
+    T det = 1;
+    for (int i = 0; i < dims(); i++) {
+        det *= factors_.at(i, i);
+        if (pivots_[i] != i) {
+            det = -det;
+        }
+    }
+    return det;
+}
+
+template <class T>
+void BasicLu<T>::solveInPlace(T* b, int cols, int ldb) const {
+    if (singular_) {
+        throwSingular();
+    }
+    int n = dims();
+    for (int i = 0; i < n; i++) {
+        if (pivots_[i] != i) {
+            T* bi = b + static_cast<size_t>(i) * ldb;
+            std::swap_ranges(bi, bi + cols,
+                             b + static_cast<size_t>(pivots_[i]) * ldb);
+        }
+    }
+    kernels::solveTriangular(kernels::kLower, kernels::kUnitDiagonal, n,
+                             cols, factors_.ptr(), n, b, ldb);
+    kernels::solveTriangular(kernels::kUpper, kernels::kNonUnitDiagonal, n,
+                             cols, factors_.ptr(), n, b, ldb);
+}
+
+template <class T>
+void BasicLu<T>::solveInPlace(BasicVector<T>* b) const {
+    assert(b->dims() == dims());
+    solveInPlace(b->ptr(), 1, 1);
+}
+
+template <class T>
+void BasicLu<T>::solveInPlace(BasicMatrix<T>* b) const {
+    assert(b->rows() == dims());
+    solveInPlace(b->ptr(), b->cols(), b->cols());
+}
+
+template <class T>
+BasicVector<T> BasicLu<T>::solve(const BasicVector<T>& b) const {
+    BasicVector<T> x = b;
+    solveInPlace(&x);
+    return x;
+}
+
+template <class T>
+BasicMatrix<T> BasicLu<T>::solve(const BasicMatrix<T>& b) const {
+    BasicMatrix<T> x = b;
+    solveInPlace(&x);
+    return x;
+}
+
+template <class T>
+BasicMatrix<T> BasicLu<T>::inverse() const {
+    BasicMatrix<T> x = BasicMatrix<T>::identity(dims());
+    solveInPlace(&x);
+    return x;
+}
+
+template class BasicLu<double>;
+template class BasicLu<float>;
@@ -0,0 +1,150 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/mapped_matrix.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ML_HAVE_MMAP 1
+#endif
+
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "ml/serialization.h"
+#include "src/matrix_file.h"
+
+namespace {
+
+void fail(const std::string& path, const std::string& what) {
+    throw std::runtime_error(path + ": " + what + ": " + strerror(errno));
+}
+
+#if defined(ML_HAVE_MMAP)
+
+// Owner of a mapping; the last Storage referring to it unmaps it.
+struct Mapping {
+    Mapping(void* base, size_t length) : base(base), length(length) {}
+    ~Mapping() { munmap(base, length); }
+
+    void* base;
+    size_t length;
+};
+
+Matrix mapOpenFile(int fd, const std::string& path, MapMode mode) {
+    matrixfile::Header header;
+    if (pread(fd, &header, sizeof(header), 0) !=
+        static_cast<ssize_t>(sizeof(header))) {
+        close(fd);
+        throw std::runtime_error(path + ": truncated header");
+    }
+    try {
+        matrixfile::decodeHeader(&header, path);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    // Mapped pages are used as they are, so they cannot be byte-swapped.
+    if (header.endianness != matrixfile::hostEndianness()) {
+        close(fd);
+        throw std::runtime_error(path + ": written with other byte order");
+    }
+
+    struct stat info;
+    uint64_t length = header.payloadOffset + matrixfile::payloadBytes(header);
+    if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < length) {
+        close(fd);
+        throw std::runtime_error(path + ": truncated payload");
+    }
+
+    // Writes through a shared mapping would leave the checksum stale.
+    if (mode == kMapShared && (header.flags & matrixfile::kFlagChecksum)) {
+        uint8_t flags = header.flags & ~matrixfile::kFlagChecksum;
+        if (pwrite(fd, &flags, 1, offsetof(matrixfile::Header, flags)) != 1) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            fail(path, "write");
+        }
+    }
+
+    int flags = mode == kMapShared ? MAP_SHARED : MAP_PRIVATE;
+    void* base = mmap(NULL, length, PROT_READ | PROT_WRITE, flags, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fail(path, "mmap");
+    }
+
+    std::shared_ptr<Mapping> mapping(new Mapping(base, length));
+    double* data = reinterpret_cast<double*>(
+        static_cast<char*>(base) + header.payloadOffset);
+    size_t size = static_cast<size_t>(header.rows * header.cols);
+
+    return Matrix(static_cast<int>(header.cols), static_cast<int>(header.rows),
+                  Storage(data, size, mapping));
+}
+
+#endif  // ML_HAVE_MMAP
+
+}  // namespace
+
+void writeMatrixFile(const std::string& path, const Matrix& mat) {
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out) {
+        fail(path, "open");
+    }
+
+    // No checksum: kMapShared writes would make it stale.
+    writeMatrix(&out, mat, false);
+}
+
+#if defined(ML_HAVE_MMAP)
+
+Matrix mapMatrixFile(const std::string& path, MapMode mode) {
+    int fd = open(path.c_str(), mode == kMapShared ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        fail(path, "open");
+    }
+
+    return mapOpenFile(fd, path, mode);
+}
+
+Matrix createMatrixFile(const std::string& path, int cols, int rows) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fail(path, "open");
+    }
+
+    matrixfile::Header header = matrixfile::makeHeader(rows, cols);
+    off_t length = header.payloadOffset + matrixfile::payloadBytes(header);
+    // ftruncate() leaves a sparse, zero-filled payload.
+    if (pwrite(fd, &header, sizeof(header), 0) !=
+            static_cast<ssize_t>(sizeof(header)) ||
+        ftruncate(fd, length) != 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        fail(path, "write");
+    }
+
+    return mapOpenFile(fd, path, kMapShared);
+}
+
+#else
+
+Matrix mapMatrixFile(const std::string& path, MapMode) {
+    throw std::runtime_error(path + ": memory mapping is not supported");
+}
+
+Matrix createMatrixFile(const std::string& path, int, int) {
+    throw std::runtime_error(path + ": memory mapping is not supported");
+}
+
+#endif  // ML_HAVE_MMAP
@@ -0,0 +1,159 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "src/matrix_file.h"
+
+#include <limits.h>
+#include <string.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace matrixfile {
+
+uint8_t hostEndianness() {
+    uint16_t probe = 1;
+    uint8_t firstByte;
+    memcpy(&firstByte, &probe, 1);
+    return firstByte == 1 ? kLittleEndian : kBigEndian;
+}
+
+Header makeHeader(uint64_t rows, uint64_t cols) {
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.dtype = kDtypeFloat64;
+    header.layout = kLayoutRowMajor;
+    header.endianness = hostEndianness();
+    header.rows = rows;
+    header.cols = cols;
+    header.payloadOffset = kAlignment;
+    return header;
+}
+
+namespace {
+
+const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+
+uint32_t swap32(uint32_t x) {
+    return (x >> 24) | ((x >> 8) & 0xFF00) | ((x << 8) & 0xFF0000) |
+           (x << 24);
+}
+
+uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+uint64_t mixWord(uint64_t lane, const double* element) {
+    uint64_t word;
+    memcpy(&word, element, sizeof(word));
+    return rotl(lane + word * kPrime2, 31) * kPrime1;
+}
+
+}  // namespace
+
+void decodeHeader(Header* raw, const std::string& source) {
+    if (memcmp(raw->magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error(source + ": not an ml-lib matrix file");
+    }
+    if (raw->endianness != kLittleEndian && raw->endianness != kBigEndian) {
+        throw std::runtime_error(source + ": bad byte order");
+    }
+    if (raw->endianness != hostEndianness()) {
+        raw->version = swap32(raw->version);
+        raw->rows = byteSwap(raw->rows);
+        raw->cols = byteSwap(raw->cols);
+        raw->payloadOffset = byteSwap(raw->payloadOffset);
+    }
+
+    const Header& header = *raw;
+    if (header.version != kVersion) {
+        throw std::runtime_error(source + ": unsupported format version");
+    }
+    if (header.dtype != kDtypeFloat64) {
+        throw std::runtime_error(source + ": unsupported element type");
+    }
+    if (header.layout != kLayoutRowMajor) {
+        throw std::runtime_error(source + ": unsupported layout");
+    }
+    if (header.rows > INT_MAX || header.cols > INT_MAX) {
+        throw std::runtime_error(source + ": matrix is too large");
+    }
+    if (header.payloadOffset < sizeof(Header) ||
+        header.payloadOffset % kAlignment != 0) {
+        throw std::runtime_error(source + ": bad payload offset");
+    }
+    // rows * cols < 2^62 cannot wrap, but its bytes can. Offset, payload
+    // and checksum must fit in a file offset, and the payload in the
+    // size_t that BasicMatrix indexes with.
+    const uint64_t kMaxBytes = std::min<uint64_t>(SIZE_MAX, INT64_MAX);
+    uint64_t elements = header.rows * header.cols;
+    if (elements > (kMaxBytes - sizeof(uint64_t)) / sizeof(double) ||
+        header.payloadOffset > kMaxBytes - sizeof(uint64_t) -
+                               elements * sizeof(double)) {
+        throw std::runtime_error(source + ": matrix is too large");
+    }
+}
+
+uint64_t payloadBytes(const Header& header) {
+    return header.rows * header.cols * sizeof(double);
+}
+
+uint64_t byteSwap(uint64_t x) {
+    return (static_cast<uint64_t>(swap32(static_cast<uint32_t>(x))) << 32) |
+           swap32(static_cast<uint32_t>(x >> 32));
+}
+
+void byteSwap(double* data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t bits;
+        memcpy(&bits, data + i, sizeof(bits));
+        bits = byteSwap(bits);
+        memcpy(data + i, &bits, sizeof(bits));
+    }
+}
+
+Checksum::Checksum() : count_(0) {
+    lanes_[0] = kPrime1 + kPrime2;
+    lanes_[1] = kPrime2;
+    lanes_[2] = 0;
+    lanes_[3] = 0 - kPrime1;
+}
+
+void Checksum::update(const double* data, size_t n) {
+    size_t i = 0;
+    // Chunks may end mid-round; finish the round one word at a time,
+    // then run whole rounds with the four lanes in registers.
+    for (; i < n && (count_ & 3) != 0; i++, count_++) {
+        lanes_[count_ & 3] = mixWord(lanes_[count_ & 3], data + i);
+    }
+    uint64_t lane0 = lanes_[0], lane1 = lanes_[1];
+    uint64_t lane2 = lanes_[2], lane3 = lanes_[3];
+    for (; i + 4 <= n; i += 4, count_ += 4) {
+        lane0 = mixWord(lane0, data + i);
+        lane1 = mixWord(lane1, data + i + 1);
+        lane2 = mixWord(lane2, data + i + 2);
+        lane3 = mixWord(lane3, data + i + 3);
+    }
+    lanes_[0] = lane0;
+    lanes_[1] = lane1;
+    lanes_[2] = lane2;
+    lanes_[3] = lane3;
+    for (; i < n; i++, count_++) {
+        lanes_[count_ & 3] = mixWord(lanes_[count_ & 3], data + i);
+    }
+}
+
+uint64_t Checksum::value() const {
+    uint64_t hash = rotl(lanes_[0], 1) + rotl(lanes_[1], 7) +
+                    rotl(lanes_[2], 12) + rotl(lanes_[3], 18);
+    hash ^= count_ * kPrime1;
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+}  // namespace matrixfile
@@ -0,0 +1,74 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef SRC_MATRIX_FILE_H_
+#define SRC_MATRIX_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace matrixfile {
+
+// On-disk layout shared by every binary matrix file: a 64-byte header
+// followed by the payload, which starts at a 64-byte aligned offset.
+// With kFlagChecksum the payload is followed by the 8-byte Checksum of
+// its bytes as written. Multi-byte fields use the writer's byte order,
+// recorded in `endianness`.
+const char kMagic[8] = { 'M', 'L', 'L', 'I', 'B', 'M', 'A', 'T' };
+const uint32_t kVersion = 1;
+const uint64_t kAlignment = 64;
+
+const uint8_t kDtypeFloat64 = 1;
+const uint8_t kLayoutRowMajor = 0;
+const uint8_t kLittleEndian = 0;
+const uint8_t kBigEndian = 1;
+
+const uint8_t kFlagChecksum = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint8_t dtype;
+    uint8_t layout;
+    uint8_t endianness;
+    uint8_t flags;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t payloadOffset;
+    uint8_t reserved[24];
+};
+
+static_assert(sizeof(Header) == kAlignment, "header must be 64 bytes");
+
+uint8_t hostEndianness();
+
+// Header of a row-major float64 rows x cols matrix in host byte order.
+Header makeHeader(uint64_t rows, uint64_t cols);
+
+// Converts a header as read from disk to host byte order. Throws
+// std::runtime_error naming source if it is not one of ours.
+void decodeHeader(Header* header, const std::string& source);
+
+uint64_t payloadBytes(const Header& header);
+
+uint64_t byteSwap(uint64_t x);
+void byteSwap(double* data, size_t n);
+
+// Running 64-bit hash of a payload, fed in chunks of whole elements. It
+// keeps four independent multiply-rotate lanes so it runs at memory
+// speed rather than at byte-at-a-time speed.
+class Checksum {
+ public:
+    Checksum();
+    void update(const double* data, size_t n);
+    uint64_t value() const;
+
+ private:
+    uint64_t lanes_[4];
+    uint64_t count_;
+};
+
+}  // namespace matrixfile
+
+#endif  // SRC_MATRIX_FILE_H_
@@ -0,0 +1,373 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/qr.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ml/thread_pool.h"
+#include "src/householder.h"
+#include "src/simd.h"
+#include "src/transpose.h"
+#include "src/triangular.h"
+
+using std::min;
+using std::vector;
+
+namespace {
+
+// Reflectors per block of the compact WY form.
+const int kPanel = 32;
+
+// TSQR reduces at least this many rows of a band at a time, and at
+// least four times as many as the matrix has columns.
+const int kTsqrChunkRows = 256;
+
+// Scratch reused across the blocks of a factorization.
+template <class T>
+struct Workspace {
+    vector<T> v;
+    vector<T> vt;
+    vector<T> w;
+};
+
+// Factors columns [k, k + kb) of the m x n matrix a, rows k and below,
+// one reflector at a time, applying each to the rest of the panel.
+template <class T>
+void factorPanel(int m, int k, int kb, T* a, int lda, T* tau, T* w) {
+    for (int j = k; j < k + kb; j++) {
+        T* aj = a + static_cast<size_t>(j) * lda;
+        T alpha = aj[j];
+        T norm2 = 0;
+        for (int i = j + 1; i < m; i++) {
+            T x = a[static_cast<size_t>(i) * lda + j];
+            norm2 += x * x;
+        }
+        if (norm2 == T(0)) {
+            tau[j] = 0;
+            continue;
+        }
+
+        // H = I - tau v v^T maps column j to (beta, 0, ...), v(0) = 1.
+        T beta = -copysign(sqrt(alpha * alpha + norm2), alpha);
+        tau[j] = (beta - alpha) / beta;
+        T scale = T(1) / (alpha - beta);
+        for (int i = j + 1; i < m; i++) {
+            a[static_cast<size_t>(i) * lda + j] *= scale;
+        }
+        aj[j] = beta;
+
+        // A := H A on the panel columns right of j: w = A^T v, then
+        // A -= tau v w^T.
+        int width = k + kb - j - 1;
+        if (width == 0) {
+            continue;
+        }
+        std::copy(aj + j + 1, aj + j + 1 + width, w);
+        for (int i = j + 1; i < m; i++) {
+            T* ai = a + static_cast<size_t>(i) * lda;
+            if (ai[j] != T(0)) {
+                kernels::axpy(ai[j], ai + j + 1, w, w, width);
+            }
+        }
+        kernels::axpy(-tau[j], w, aj + j + 1, aj + j + 1, width);
+        for (int i = j + 1; i < m; i++) {
+            T* ai = a + static_cast<size_t>(i) * lda;
+            if (ai[j] != T(0)) {
+                kernels::axpy(-tau[j] * ai[j], w, ai + j + 1, ai + j + 1,
+                              width);
+            }
+        }
+    }
+}
+
+// Copies the rows x kb reflectors below the diagonal of a into v,
+// with their unit diagonal and the zeros above it.
+template <class T>
+void copyReflectors(int rows, int kb, const T* a, int lda, T* v) {
+    for (int i = 0; i < rows; i++) {
+        const T* ai = a + static_cast<size_t>(i) * lda;
+        T* vi = v + static_cast<size_t>(i) * kb;
+        for (int j = 0; j < kb; j++) {
+            vi[j] = j < i ? ai[j] : (j == i ? T(1) : T(0));
+        }
+    }
+}
+
+// Blocked QR of the m x n matrix a. The triangular factor of the block
+// starting at column k goes to columns [k, k + kb) of t (kPanel x n).
+template <class T>
+void factorQr(int m, int n, T* a, int lda, T* tau, T* t, Workspace<T>* ws) {
+    int steps = min(m, n);
+    ws->w.resize(kPanel);
+    for (int k = 0; k < steps; k += kPanel) {
+        int kb = min(kPanel, steps - k);
+        factorPanel(m, k, kb, a, lda, tau, ws->w.data());
+
+        int rows = m - k;
+        T* akk = a + static_cast<size_t>(k) * lda + k;
+        ws->v.resize(static_cast<size_t>(rows) * kb);
+        ws->vt.resize(static_cast<size_t>(rows) * kb);
+        copyReflectors(rows, kb, akk, lda, ws->v.data());
+        kernels::transpose(rows, kb, ws->v.data(), kb, ws->vt.data(), rows);
+        kernels::blockReflectorFactor(rows, kb, ws->v.data(),
+                                      ws->vt.data(), tau + k, t + k, n);
+        int nc = n - k - kb;
+        if (nc > 0) {
+            vector<T> work;
+            kernels::applyBlockReflector(true, rows, nc, kb, ws->v.data(),
+                                         ws->vt.data(), t + k, n, akk + kb,
+                                         lda, &work);
+        }
+    }
+}
+
+template <class T>
+void clearBelowDiagonal(int rows, int cols, T* a, int lda) {
+    for (int i = 1; i < rows; i++) {
+        T* ai = a + static_cast<size_t>(i) * lda;
+        std::fill(ai, ai + min(i, cols), T(0));
+    }
+}
+
+// R is numerically rank deficient when a diagonal element is below
+// max(m, n) eps max |R(i, i)|.
+template <class T>
+bool rankDeficient(const T* r, int ldr, int n, int m) {
+    size_t stride = static_cast<size_t>(ldr) + 1;
+    T largest = 0;
+    for (int i = 0; i < n; i++) {
+        largest = std::max<T>(largest, fabs(r[i * stride]));
+    }
+    T tolerance = std::max(m, n) * std::numeric_limits<T>::epsilon() *
+                  largest;
+    for (int i = 0; i < n; i++) {
+        if (!(fabs(r[i * stride]) > tolerance)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void throwRankDeficient() {
+    throw std::runtime_error("qr: rank deficient matrix");
+}
+
+// x = R^-1 c for the leading n x n block of the upper triangular r,
+// c being its n x k block to the right, as TSQR leaves them.
+template <class T>
+BasicMatrix<T> solveAugmented(const BasicMatrix<T>& r, int m, int n, int k) {
+    if (rankDeficient(r.ptr(), r.cols(), n, m)) {
+        throwRankDeficient();
+    }
+    BasicMatrix<T> x = r.block(0, n, n, k);
+    kernels::solveTriangular(kernels::kUpper, kernels::kNonUnitDiagonal, n,
+                             k, r.ptr(), r.cols(), x.ptr(), k);
+    return x;
+}
+
+// The R factor, rows x c with rows <= c, of the rows of [A B] in
+// [begin, end), reduced a chunk at a time: each chunk is stacked under
+// the R of the rows before it and factored again.
+template <class T>
+void reduceBand(const BasicMatrix<T>& a, const BasicMatrix<T>& b,
+                int begin, int end, vector<T>* r, int* rows) {
+    int n = a.cols();
+    int c = n + b.cols();
+    int chunk = std::max(kTsqrChunkRows, 4 * c);
+    vector<T> stack(static_cast<size_t>(c + chunk) * c);
+    vector<T> tau(c);
+    vector<T> t(static_cast<size_t>(kPanel) * c);
+    Workspace<T> ws;
+    int held = 0;
+    for (int start = begin; start < end; start += chunk) {
+        int count = min(chunk, end - start);
+        for (int i = 0; i < count; i++) {
+            T* si = &stack[static_cast<size_t>(held + i) * c];
+            const T* ai = a.ptr() + static_cast<size_t>(start + i) * n;
+            const T* bi = b.ptr() + static_cast<size_t>(start + i) * b.cols();
+            std::copy(ai, ai + n, si);
+            std::copy(bi, bi + b.cols(), si + n);
+        }
+        int total = held + count;
+        factorQr(total, c, stack.data(), c, tau.data(), t.data(), &ws);
+        held = min(total, c);
+        clearBelowDiagonal(held, c, stack.data(), c);
+    }
+    r->assign(stack.begin(), stack.begin() + static_cast<size_t>(held) * c);
+    *rows = held;
+}
+
+// R of [A B] by TSQR; its leading n columns are the R of A and the
+// rest Q^T B.
+template <class T>
+BasicMatrix<T> tsqr(const BasicMatrix<T>& a, const BasicMatrix<T>& b) {
+    int m = a.rows();
+    int c = a.cols() + b.cols();
+    int bands = std::max(1, min(ThreadPool::global().threads(),
+                                m / std::max(kTsqrChunkRows, 4 * c)));
+    vector<vector<T> > factors(bands);
+    vector<int> rows(bands);
+    ThreadPool::global().parallelFor(bands,
+        [&a, &b, m, bands, &factors, &rows](int begin, int end) {
+            for (int p = begin; p < end; p++) {
+                int first = static_cast<int>(static_cast<int64_t>(m) * p /
+                                             bands);
+                int last = static_cast<int>(static_cast<int64_t>(m) *
+                                            (p + 1) / bands);
+                reduceBand(a, b, first, last, &factors[p], &rows[p]);
+            }
+        });
+
+    vector<T> stack;
+    for (int p = 0; p < bands; p++) {
+        stack.insert(stack.end(), factors[p].begin(), factors[p].end());
+    }
+    int total = static_cast<int>(stack.size() / c);
+    vector<T> tau(c);
+    vector<T> t(static_cast<size_t>(kPanel) * c);
+    Workspace<T> ws;
+    factorQr(total, c, stack.data(), c, tau.data(), t.data(), &ws);
+    int held = min(total, c);
+    clearBelowDiagonal(held, c, stack.data(), c);
+
+    BasicMatrix<T> r(c, c);
+    std::copy(stack.begin(), stack.begin() + static_cast<size_t>(held) * c,
+              r.ptr());
+    return r;
+}
+
+}  // namespace
+
+template <class T>
+BasicQr<T>::BasicQr(BasicMatrix<T> a)
+    : factors_(std::move(a)), tau_(factors_.cols()),
+      blockFactors_(factors_.cols(), kPanel) {
+    assert(factors_.rows() >= factors_.cols());
+    Workspace<T> ws;
+    factorQr(rows(), cols(), factors_.ptr(), cols(), tau_.data(),
+             blockFactors_.ptr(), &ws);
+}
+
+template <class T>
+bool BasicQr<T>::rankDeficient() const {
+    return ::rankDeficient(factors_.ptr(), cols(), cols(), rows());
+}
+
+template <class T>
+BasicMatrix<T> BasicQr<T>::r() const {
+    BasicMatrix<T> r = factors_.block(0, 0, cols(), cols());
+    clearBelowDiagonal(cols(), cols(), r.ptr(), cols());
+    return r;
+}
+
+template <class T>
+BasicMatrix<T> BasicQr<T>::q() const {
+    BasicMatrix<T> q(cols(), rows());
+    for (int i = 0; i < cols(); i++) {
+        q.at(i, i) = 1;
+    }
+    applyQInPlace(&q);
+    return q;
+}
+
+// Q^T = H(n-1) ... H(0) applies the blocks first to last, Q last to
+// first.
+template <class T>
+void BasicQr<T>::apply(BasicMatrix<T>* b, bool transposed) const {
+    assert(b->rows() == rows());
+    int n = cols();
+    int blocks = (n + kPanel - 1) / kPanel;
+    vector<T> v, vt, work;
+    for (int s = 0; s < blocks; s++) {
+        int k = (transposed ? s : blocks - 1 - s) * kPanel;
+        int kb = min(kPanel, n - k);
+        int count = rows() - k;
+        v.resize(static_cast<size_t>(count) * kb);
+        vt.resize(static_cast<size_t>(count) * kb);
+        copyReflectors(count, kb, factors_.ptr() + static_cast<size_t>(k) *
+                       n + k, n, v.data());
+        kernels::transpose(count, kb, v.data(), kb, vt.data(), count);
+        T* bk = b->ptr() + static_cast<size_t>(k) * b->cols();
+        kernels::applyBlockReflector(transposed, count, b->cols(), kb,
+                                     v.data(), vt.data(),
+                                     blockFactors_.ptr() + k, n, bk,
+                                     b->cols(), &work);
+    }
+}
+
+template <class T>
+void BasicQr<T>::applyQtInPlace(BasicMatrix<T>* b) const {
+    apply(b, true);
+}
+
+template <class T>
+void BasicQr<T>::applyQInPlace(BasicMatrix<T>* b) const {
+    apply(b, false);
+}
+
+template <class T>
+BasicMatrix<T> BasicQr<T>::solve(const BasicMatrix<T>& b) const {
+    if (rankDeficient()) {
+        throwRankDeficient();
+    }
+    BasicMatrix<T> c = b;
+    applyQtInPlace(&c);
+    BasicMatrix<T> x = c.block(0, 0, cols(), b.cols());
+    kernels::solveTriangular(kernels::kUpper, kernels::kNonUnitDiagonal,
+                             cols(), b.cols(), factors_.ptr(), cols(),
+                             x.ptr(), b.cols());
+    return x;
+}
+
+template <class T>
+BasicVector<T> BasicQr<T>::solve(const BasicVector<T>& b) const {
+    BasicMatrix<T> column(1, b.dims());
+    std::copy(b.ptr(), b.ptr() + b.dims(), column.ptr());
+    BasicMatrix<T> x = solve(column);
+    BasicVector<T> result(cols());
+    std::copy(x.ptr(), x.ptr() + cols(), result.ptr());
+    return result;
+}
+
+template <class T>
+BasicMatrix<T> lstsq(const BasicMatrix<T>& a, const BasicMatrix<T>& b,
+                     LstsqMethod method) {
+    assert(a.rows() == b.rows() && a.rows() >= a.cols());
+    if (method == kLstsqAuto) {
+        bool tall = a.rows() >= static_cast<int64_t>(kTsqrAspect) * a.cols();
+        method = tall ? kLstsqTsqr : kLstsqHouseholder;
+    }
+    if (method == kLstsqHouseholder) {
+        return BasicQr<T>(a).solve(b);
+    }
+    return solveAugmented(tsqr(a, b), a.rows(), a.cols(), b.cols());
+}
+
+template <class T>
+BasicVector<T> lstsq(const BasicMatrix<T>& a, const BasicVector<T>& b,
+                     LstsqMethod method) {
+    BasicMatrix<T> column(1, b.dims());
+    std::copy(b.ptr(), b.ptr() + b.dims(), column.ptr());
+    BasicMatrix<T> x = lstsq(a, column, method);
+    BasicVector<T> result(a.cols());
+    std::copy(x.ptr(), x.ptr() + a.cols(), result.ptr());
+    return result;
+}
+
+#define ML_INSTANTIATE_QR(T)                                                 \
+    template class BasicQr<T>;                                               \
+    template BasicMatrix<T> lstsq(const BasicMatrix<T>&,                     \
+                                  const BasicMatrix<T>&, LstsqMethod);       \
+    template BasicVector<T> lstsq(const BasicMatrix<T>&,                     \
+                                  const BasicVector<T>&, LstsqMethod);
+
+ML_INSTANTIATE_QR(double)
+ML_INSTANTIATE_QR(float)
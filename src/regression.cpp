@@ -0,0 +1,222 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/regression.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ml/cholesky.h"
+#include "ml/qr.h"
+#include "ml/thread_pool.h"
+#include "src/gemv.h"
+#include "src/simd.h"
+
+using std::min;
+using std::vector;
+
+namespace {
+
+// Rows per task when centering.
+const int kCenterRows = 256;
+
+// Column means of x.
+template <class T>
+BasicVector<T> columnMeans(const BasicMatrix<T>& x) {
+    BasicVector<T> ones(x.rows(), T(1));
+    BasicVector<T> means(x.cols());
+    kernels::gemvTransposed(x.rows(), x.cols(), T(1) / x.rows(), x.ptr(),
+                            x.cols(), ones.ptr(), T(0), means.ptr());
+    return means;
+}
+
+// Subtracts means from every row of x.
+template <class T>
+void centerRows(const BasicVector<T>& means, BasicMatrix<T>* x) {
+    int cols = x->cols();
+    T* data = x->ptr();
+    const T* center = means.ptr();
+    ThreadPool::global().parallelFor(x->rows(),
+        [cols, data, center](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                T* row = data + static_cast<size_t>(i) * cols;
+                kernels::sub(row, center, row, cols);
+            }
+        }, kCenterRows);
+}
+
+// The ridge weights for X and y, centered unless the model has no
+// intercept.
+template <class T>
+BasicVector<T> solveCentered(const BasicMatrix<T>& x, const BasicVector<T>& y,
+                             T l2) {
+    int n = x.rows();
+    int d = x.cols();
+    if (l2 == 0) {
+        if (n < d) {
+            throw std::runtime_error(
+                "regression: fewer samples than features need l2 > 0");
+        }
+        return lstsq(x, y);
+    }
+    BasicMatrix<T> gram = BasicMatrix<T>(x.transposed()) * x;
+    for (int i = 0; i < d; i++) {
+        gram.at(i, i) += n * l2;
+    }
+    BasicVector<T> rhs(d);
+    kernels::gemvTransposed(n, d, T(1), x.ptr(), d, y.ptr(), T(0),
+                            rhs.ptr());
+    BasicCholesky<T> cholesky(std::move(gram));
+    cholesky.solveInPlace(&rhs);
+    return rhs;
+}
+
+// SGD over mini-batches first, first + stride, ... of the chunk
+// (x, y), starting at step; updates weights and intercept.
+template <class T>
+void runShard(const BasicMatrix<T>& x, const BasicVector<T>& y,
+              const SgdOptions& options, int first, int stride,
+              int64_t step, T* weights, T* intercept) {
+    int n = x.rows();
+    int d = x.cols();
+    int batchSize = options.batchSize;
+    vector<T> residual(batchSize);
+    vector<T> gradient(d);
+    for (int start = first * batchSize; start < n;
+         start += stride * batchSize, step++) {
+        int rows = min(batchSize, n - start);
+        const T* xb = x.ptr() + static_cast<size_t>(start) * d;
+        T rate = T(options.learningRate / (1 + options.decay * step));
+        kernels::gemv(rows, d, T(1), xb, d, weights, T(0), residual.data());
+        T mean = 0;
+        for (int i = 0; i < rows; i++) {
+            residual[i] += *intercept - y.at(start + i);
+            mean += residual[i];
+        }
+        kernels::gemvTransposed(rows, d, T(1) / rows, xb, d, residual.data(),
+                                T(0), gradient.data());
+        kernels::scale(T(1 - rate * options.l2), weights, weights, d);
+        kernels::axpy(-rate, gradient.data(), weights, weights, d);
+        if (options.intercept) {
+            *intercept -= rate * mean / rows;
+        }
+    }
+}
+
+}  // namespace
+
+template <class T>
+BasicLinearRegression<T>::BasicLinearRegression(int dims)
+    : weights_(dims), intercept_(0) {}
+
+template <class T>
+BasicLinearRegression<T>::BasicLinearRegression(BasicVector<T> weights,
+                                                T intercept)
+    : weights_(std::move(weights)), intercept_(intercept) {}
+
+template <class T>
+T BasicLinearRegression<T>::predict(const BasicVector<T>& x) const {
+    assert(x.dims() == dims());
+    return T(dot(weights_, x)) + intercept_;
+}
+
+template <class T>
+void BasicLinearRegression<T>::predict(const BasicMatrix<T>& x,
+                                       BasicVector<T>* y) const {
+    assert(x.cols() == dims() && y->dims() == x.rows());
+    kernels::gemv(x.rows(), x.cols(), T(1), x.ptr(), x.cols(),
+                  weights_.ptr(), T(0), y->ptr());
+    kernels::addScalar(intercept_, y->ptr(), y->ptr(), y->dims());
+}
+
+template <class T>
+BasicVector<T> BasicLinearRegression<T>::predict(
+        const BasicMatrix<T>& x) const {
+    BasicVector<T> y(x.rows());
+    predict(x, &y);
+    return y;
+}
+
+template <class T>
+BasicLinearRegression<T> fitLinearRegression(const BasicMatrix<T>& x,
+                                             const BasicVector<T>& y,
+                                             T l2, bool intercept) {
+    assert(x.rows() == y.dims() && x.rows() > 0 && l2 >= 0);
+    if (!intercept) {
+        return BasicLinearRegression<T>(solveCentered(x, y, l2), T(0));
+    }
+    BasicVector<T> means = columnMeans(x);
+    double sum = 0;
+    for (int i = 0; i < y.dims(); i++) {
+        sum += y.at(i);
+    }
+    T targetMean = T(sum / y.dims());
+    BasicMatrix<T> centered = x;
+    centerRows(means, &centered);
+    BasicVector<T> weights = solveCentered(
+        centered, BasicVector<T>(y + (-targetMean)), l2);
+    T offset = targetMean - T(dot(weights, means));
+    return BasicLinearRegression<T>(std::move(weights), offset);
+}
+
+template <class T>
+BasicSgdRegression<T>::BasicSgdRegression(int dims, const SgdOptions& options)
+    : model_(dims), options_(options), steps_(0) {
+    assert(options.batchSize > 0 && options.shards >= 0);
+}
+
+template <class T>
+void BasicSgdRegression<T>::partialFit(const BasicMatrix<T>& x,
+                                       const BasicVector<T>& y) {
+    assert(x.cols() == model_.dims() && x.rows() == y.dims());
+    int batches = (x.rows() + options_.batchSize - 1) / options_.batchSize;
+    int shards = options_.shards > 0 ? options_.shards
+                                     : ThreadPool::global().threads();
+    shards = min(shards, batches);
+    if (shards == 0) {
+        return;
+    }
+    vector<BasicVector<T> > weights(shards, model_.weights());
+    vector<T> intercepts(shards, model_.intercept());
+    const SgdOptions& options = options_;
+    int64_t step = steps_;
+    ThreadPool::global().parallelFor(shards,
+        [&x, &y, &options, shards, step, &weights, &intercepts](int begin,
+                                                               int end) {
+            for (int s = begin; s < end; s++) {
+                runShard(x, y, options, s, shards, step, weights[s].ptr(),
+                         &intercepts[s]);
+            }
+        });
+
+    BasicVector<T> average = weights[0];
+    T intercept = intercepts[0];
+    for (int s = 1; s < shards; s++) {
+        average += weights[s];
+        intercept += intercepts[s];
+    }
+    average *= T(1) / shards;
+    model_ = BasicLinearRegression<T>(std::move(average), intercept / shards);
+    steps_ += (batches + shards - 1) / shards;
+}
+
+template <class T>
+void BasicSgdRegression<T>::fit(const BasicMatrix<T>& x,
+                                const BasicVector<T>& y, int epochs) {
+    for (int epoch = 0; epoch < epochs; epoch++) {
+        partialFit(x, y);
+    }
+}
+
+template class BasicLinearRegression<double>;
+template class BasicLinearRegression<float>;
+template class BasicSgdRegression<double>;
+template class BasicSgdRegression<float>;
+template LinearRegression fitLinearRegression(const Matrix&, const Vector&,
+                                              double, bool);
+template FloatLinearRegression fitLinearRegression(const FloatMatrix&,
+                                                   const FloatVector&, float,
+                                                   bool);
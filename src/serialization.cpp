@@ -0,0 +1,273 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/serialization.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/matrix_file.h"
+
+namespace {
+
+const char kSource[] = "matrix stream";
+
+// readMatrix() reads its first chunk of rows into this many elements
+// and doubles the chunk from there.
+const size_t kFirstChunk = 1 << 16;
+
+void checkStream(const std::ios& stream, const char* what) {
+    if (!stream.good()) {
+        throw std::runtime_error(std::string(kSource) + ": " + what);
+    }
+}
+
+// A seekable stream must still hold bytes bytes, so that a corrupt
+// header fails here instead of sizing a huge allocation. Pipes and
+// other streams without positions pass.
+void checkRemaining(std::istream* in, uint64_t bytes) {
+    std::streampos here = in->tellg();
+    if (here == std::streampos(-1)) {
+        return;
+    }
+    in->seekg(0, std::ios::end);
+    std::streampos end = in->tellg();
+    in->clear();
+    in->seekg(here);
+    checkStream(*in, "truncated header");
+    if (end != std::streampos(-1) && end >= here &&
+        static_cast<uint64_t>(end - here) < bytes) {
+        throw std::runtime_error(std::string(kSource) + ": truncated payload");
+    }
+}
+
+}  // namespace
+
+struct MatrixWriter::State {
+    matrixfile::Header header;
+    matrixfile::Checksum checksum;
+};
+
+MatrixWriter::MatrixWriter(std::ostream* out, int cols, int rows,
+                           bool checksum)
+    : out_(out), state_(new State), cols_(cols), rows_(rows),
+      rowsWritten_(0) {
+    assert(cols >= 0 && rows >= 0);
+    try {
+        state_->header = matrixfile::makeHeader(rows, cols);
+        if (checksum) {
+            state_->header.flags |= matrixfile::kFlagChecksum;
+        }
+
+        // makeHeader() puts the payload right after the header.
+        out_->write(reinterpret_cast<const char*>(&state_->header),
+                    sizeof(state_->header));
+        checkStream(*out_, "write failed");
+    } catch (...) {
+        delete state_;
+        throw;
+    }
+}
+
+MatrixWriter::~MatrixWriter() {
+    delete state_;
+}
+
+void MatrixWriter::writeRows(ConstMatrixView rows) {
+    assert(rows.cols() == cols_);
+    if (rows.colStride() == 1 && rows.rowStride() == cols_) {
+        writeRows(rows.ptr(), rows.rows());
+        return;
+    }
+    if (rows.colStride() == 1) {
+        for (int i = 0; i < rows.rows(); i++) {
+            writeRows(rows.row(i).ptr(), 1);
+        }
+        return;
+    }
+
+    std::vector<double> row(cols_);
+    for (int i = 0; i < rows.rows(); i++) {
+        for (int j = 0; j < cols_; j++) {
+            row[j] = rows.at(i, j);
+        }
+        writeRows(row.data(), 1);
+    }
+}
+
+void MatrixWriter::writeRows(const double* data, int count) {
+    assert(count >= 0 && rowsWritten_ + count <= rows_);
+    size_t n = static_cast<size_t>(count) * cols_;
+    if (state_->header.flags & matrixfile::kFlagChecksum) {
+        state_->checksum.update(data, n);
+    }
+    out_->write(reinterpret_cast<const char*>(data), n * sizeof(double));
+    checkStream(*out_, "write failed");
+    rowsWritten_ += count;
+}
+
+void MatrixWriter::finish() {
+    assert(rowsWritten_ == rows_);
+    if (state_->header.flags & matrixfile::kFlagChecksum) {
+        uint64_t value = state_->checksum.value();
+        out_->write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    out_->flush();
+    checkStream(*out_, "write failed");
+}
+
+struct MatrixReader::State {
+    matrixfile::Header header;
+    matrixfile::Checksum checksum;
+    bool swap;
+};
+
+MatrixReader::MatrixReader(std::istream* in)
+    : in_(in), state_(new State), cols_(0), rows_(0), rowsRead_(0) {
+    matrixfile::Header& header = state_->header;
+    in_->read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (in_->gcount() != static_cast<std::streamsize>(sizeof(header))) {
+        delete state_;
+        throw std::runtime_error(std::string(kSource) + ": truncated header");
+    }
+    try {
+        state_->swap = header.endianness != matrixfile::hostEndianness();
+        matrixfile::decodeHeader(&header, kSource);
+        in_->ignore(header.payloadOffset - sizeof(header));
+        checkStream(*in_, "truncated header");
+
+        cols_ = static_cast<int>(header.cols);
+        rows_ = static_cast<int>(header.rows);
+        checkRemaining(in_, header.rows * header.cols * sizeof(double));
+        if (rows_ == 0) {
+            verify();
+        }
+    } catch (...) {
+        delete state_;
+        throw;
+    }
+}
+
+MatrixReader::~MatrixReader() {
+    delete state_;
+}
+
+bool MatrixReader::checksummed() const {
+    return (state_->header.flags & matrixfile::kFlagChecksum) != 0;
+}
+
+void MatrixReader::readRows(MatrixView rows) {
+    assert(rows.cols() == cols_);
+    if (rows.colStride() == 1 && rows.rowStride() == cols_) {
+        readRows(rows.ptr(), rows.rows());
+        return;
+    }
+    if (rows.colStride() == 1) {
+        for (int i = 0; i < rows.rows(); i++) {
+            readRows(rows.row(i).ptr(), 1);
+        }
+        return;
+    }
+
+    std::vector<double> row(cols_);
+    for (int i = 0; i < rows.rows(); i++) {
+        readRows(row.data(), 1);
+        for (int j = 0; j < cols_; j++) {
+            rows.at(i, j) = row[j];
+        }
+    }
+}
+
+void MatrixReader::readRows(double* data, int count) {
+    assert(count >= 0 && count <= rowsLeft());
+    readPayload(data, static_cast<size_t>(count) * cols_);
+    rowsRead_ += count;
+    if (rowsRead_ == rows_ && count > 0) {
+        verify();
+    }
+}
+
+void MatrixReader::readPayload(double* data, size_t n) {
+    std::streamsize bytes = n * sizeof(double);
+    in_->read(reinterpret_cast<char*>(data), bytes);
+    if (in_->gcount() != bytes) {
+        throw std::runtime_error(std::string(kSource) + ": truncated payload");
+    }
+
+    // The checksum covers the bytes as they were written.
+    if (checksummed()) {
+        state_->checksum.update(data, n);
+    }
+    if (state_->swap) {
+        matrixfile::byteSwap(data, n);
+    }
+}
+
+void MatrixReader::verify() {
+    if (!checksummed()) {
+        return;
+    }
+
+    uint64_t expected;
+    in_->read(reinterpret_cast<char*>(&expected), sizeof(expected));
+    if (in_->gcount() != static_cast<std::streamsize>(sizeof(expected))) {
+        throw std::runtime_error(std::string(kSource) +
+                                 ": truncated checksum");
+    }
+    if (state_->swap) {
+        expected = matrixfile::byteSwap(expected);
+    }
+    if (expected != state_->checksum.value()) {
+        throw std::runtime_error(std::string(kSource) +
+                                 ": checksum mismatch");
+    }
+}
+
+void writeMatrix(std::ostream* out, const Matrix& mat, bool checksum) {
+    MatrixWriter writer(out, mat.cols(), mat.rows(), checksum);
+    writer.writeRows(mat.ptr(), mat.rows());
+    writer.finish();
+}
+
+// Grows the matrix with the rows that actually arrive, in chunks that
+// double, so that the header of a non-seekable stream cannot make it
+// allocate more than twice the payload received.
+Matrix readMatrix(std::istream* in) {
+    MatrixReader reader(in);
+    int cols = reader.cols();
+    Storage storage;
+    while (reader.rowsLeft() > 0) {
+        size_t chunk = std::max(kFirstChunk, storage.size());
+        int count = reader.rowsLeft();
+        if (cols > 0) {
+            count = static_cast<int>(std::min<size_t>(
+                count, std::max<size_t>(chunk / cols, 1)));
+        }
+        size_t done = storage.size();
+        storage.resize(done + static_cast<size_t>(count) * cols);
+        reader.readRows(storage.data() + done, count);
+    }
+    return Matrix(cols, reader.rows(), std::move(storage));
+}
+
+void writeVector(std::ostream* out, const Vector& vec, bool checksum) {
+    MatrixWriter writer(out, vec.dims(), 1, checksum);
+    writer.writeRows(vec.ptr(), 1);
+    writer.finish();
+}
+
+Vector readVector(std::istream* in) {
+    MatrixReader reader(in);
+    if (reader.rows() != 1) {
+        throw std::runtime_error(std::string(kSource) +
+                                 ": not a single-row matrix");
+    }
+    Vector vec(reader.cols());
+    reader.readRows(vec.ptr(), 1);
+    return vec;
+}
@@ -0,0 +1,128 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "src/simd.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/simd_kernels.h"
+
+namespace kernels {
+
+namespace {
+
+Isa detectIsa() {
+    Isa isa = kIsaGeneric;
+#if defined(ML_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        isa = kIsaSse2;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        isa = kIsaAvx2;
+    }
+#if defined(ML_SIMD_AVX512)
+    if (__builtin_cpu_supports("avx512f")) {
+        isa = kIsaAvx512;
+    }
+#endif
+#endif
+
+    const char* requested = getenv("ML_LIB_ISA");
+    if (requested != NULL) {
+        for (int i = kIsaGeneric; i < isa; i++) {
+            if (strcmp(requested, isaName(static_cast<Isa>(i))) == 0) {
+                return static_cast<Isa>(i);
+            }
+        }
+    }
+
+    return isa;
+}
+
+template <class T>
+const KernelTable<T>& kernelTable() {
+    static const KernelTable<T> table = selectKernels<T>(activeIsa());
+    return table;
+}
+
+}  // namespace
+
+Isa activeIsa() {
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+    case kIsaSse2:
+        return "sse2";
+    case kIsaAvx2:
+        return "avx2";
+    case kIsaAvx512:
+        return "avx512";
+    default:
+        return "generic";
+    }
+}
+
+template <class T>
+void add(const T* a, const T* b, T* out, size_t n) {
+    kernelTable<T>().add(a, b, out, n);
+}
+
+template <class T>
+void sub(const T* a, const T* b, T* out, size_t n) {
+    kernelTable<T>().sub(a, b, out, n);
+}
+
+template <class T>
+void mul(const T* a, const T* b, T* out, size_t n) {
+    kernelTable<T>().mul(a, b, out, n);
+}
+
+template <class T>
+void scale(T alpha, const T* a, T* out, size_t n) {
+    kernelTable<T>().scale(alpha, a, out, n);
+}
+
+template <class T>
+void addScalar(T alpha, const T* a, T* out, size_t n) {
+    kernelTable<T>().addScalar(alpha, a, out, n);
+}
+
+template <class T>
+void axpy(T alpha, const T* x, const T* y, T* out, size_t n) {
+    kernelTable<T>().axpy(alpha, x, y, out, n);
+}
+
+template <class T>
+typename ScalarTraits<T>::Accumulator dot(const T* a, const T* b, size_t n) {
+    return kernelTable<T>().dot(a, b, n);
+}
+
+template <class T>
+typename ScalarTraits<T>::Accumulator sumSquares(const T* a, size_t n) {
+    return kernelTable<T>().sumSquares(a, n);
+}
+
+#define ML_INSTANTIATE_KERNELS(T)                                           \
+    template void add<T>(const T*, const T*, T*, size_t);                   \
+    template void sub<T>(const T*, const T*, T*, size_t);                   \
+    template void mul<T>(const T*, const T*, T*, size_t);                   \
+    template void scale<T>(T, const T*, T*, size_t);                        \
+    template void addScalar<T>(T, const T*, T*, size_t);                    \
+    template void axpy<T>(T, const T*, const T*, T*, size_t);               \
+    template ScalarTraits<T>::Accumulator dot<T>(const T*, const T*,        \
+                                                 size_t);                   \
+    template ScalarTraits<T>::Accumulator sumSquares<T>(const T*, size_t);
+
+ML_INSTANTIATE_KERNELS(double)
+ML_INSTANTIATE_KERNELS(float)
+ML_INSTANTIATE_KERNELS(int8_t)
+ML_INSTANTIATE_KERNELS(BFloat16)
+
+#undef ML_INSTANTIATE_KERNELS
+
+}  // namespace kernels
@@ -0,0 +1,67 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef SRC_SIMD_H_
+#define SRC_SIMD_H_
+
+#include <stddef.h>
+
+#include "ml/scalar.h"
+
+// x86 kernels are compiled per function with target attributes, so
+// the library itself needs no -m flags and runs on any x86 host.
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define ML_SIMD_X86 1
+#define ML_TARGET_SSE2 __attribute__((target("sse2")))
+#define ML_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#if defined(__clang__) || __GNUC__ >= 5
+#define ML_SIMD_AVX512 1
+#define ML_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+#endif
+
+#if defined(ML_SIMD_X86)
+#include <immintrin.h>
+#endif
+
+namespace kernels {
+
+enum Isa {
+    kIsaGeneric,
+    kIsaSse2,
+    kIsaAvx2,
+    kIsaAvx512
+};
+
+// Widest instruction set supported by both the CPU and the build.
+// The ML_LIB_ISA environment variable (generic, sse2, avx2, avx512)
+// can lower it, which is handy for testing the narrower paths.
+Isa activeIsa();
+const char* isaName(Isa isa);
+
+// Element-wise kernels over contiguous arrays of n elements of type T
+// (double, float, int8_t or BFloat16), with the rounding and saturation
+// rules of ml/scalar.h. Output may alias an input.
+template <class T>
+void add(const T* a, const T* b, T* out, size_t n);
+template <class T>
+void sub(const T* a, const T* b, T* out, size_t n);
+template <class T>
+void mul(const T* a, const T* b, T* out, size_t n);
+template <class T>
+void scale(T alpha, const T* a, T* out, size_t n);
+template <class T>
+void addScalar(T alpha, const T* a, T* out, size_t n);
+// out = alpha * x + y
+template <class T>
+void axpy(T alpha, const T* x, const T* y, T* out, size_t n);
+
+// Reductions, accumulated in ScalarTraits<T>::Accumulator.
+template <class T>
+typename ScalarTraits<T>::Accumulator dot(const T* a, const T* b, size_t n);
+template <class T>
+typename ScalarTraits<T>::Accumulator sumSquares(const T* a, size_t n);
+
+}  // namespace kernels
+
+#endif  // SRC_SIMD_H_
@@ -0,0 +1,226 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "src/simd_kernels.h"
+
+// BFloat16 kernels widen to float in registers (a bfloat16 is the top
+// half of a float), compute in float and round back to nearest even
+// exactly like BFloat16(float), so results match the scalar path.
+
+namespace kernels {
+
+namespace {
+
+#if defined(ML_SIMD_X86)
+
+//
+// SSE2
+//
+ML_TARGET_SSE2
+inline __m128 loadSse2(const BFloat16* p) {
+    __m128i raw = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(), raw));
+}
+
+ML_TARGET_SSE2
+inline void storeSse2(BFloat16* p, __m128 x) {
+    __m128i bits = _mm_castps_si128(x);
+    __m128i lsb = _mm_and_si128(_mm_srli_epi32(bits, 16),
+                                _mm_set1_epi32(1));
+    __m128i rounded = _mm_srli_epi32(
+        _mm_add_epi32(_mm_add_epi32(bits, _mm_set1_epi32(0x7FFF)), lsb), 16);
+    __m128i nan = _mm_or_si128(_mm_srli_epi32(bits, 16),
+                               _mm_set1_epi32(0x40));
+    __m128i isNan = _mm_castps_si128(_mm_cmpunord_ps(x, x));
+    rounded = _mm_or_si128(_mm_and_si128(isNan, nan),
+                           _mm_andnot_si128(isNan, rounded));
+    // Sign-extend so the signed pack keeps all 16 bits.
+    rounded = _mm_srai_epi32(_mm_slli_epi32(rounded, 16), 16);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p),
+                     _mm_packs_epi32(rounded, rounded));
+}
+
+ML_TARGET_SSE2
+inline __m128 set1Sse2(BFloat16 alpha) {
+    return _mm_set1_ps(alpha);
+}
+
+ML_TARGET_SSE2
+inline __m128 mulAddSse2(__m128 a, __m128 b, __m128 c) {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+ML_BINARY_KERNEL(addSse2, ML_TARGET_SSE2, BFloat16, __m128, 4,
+                 loadSse2, storeSse2, _mm_add_ps, generic::add)
+ML_BINARY_KERNEL(subSse2, ML_TARGET_SSE2, BFloat16, __m128, 4,
+                 loadSse2, storeSse2, _mm_sub_ps, generic::sub)
+ML_BINARY_KERNEL(mulSse2, ML_TARGET_SSE2, BFloat16, __m128, 4,
+                 loadSse2, storeSse2, _mm_mul_ps, generic::mul)
+ML_SCALAR_KERNEL(scaleSse2, ML_TARGET_SSE2, BFloat16, __m128, 4,
+                 loadSse2, storeSse2, set1Sse2, _mm_mul_ps, generic::scale)
+ML_SCALAR_KERNEL(addScalarSse2, ML_TARGET_SSE2, BFloat16, __m128, 4,
+                 loadSse2, storeSse2, set1Sse2, _mm_add_ps,
+                 generic::addScalar)
+ML_AXPY_KERNEL(axpySse2, ML_TARGET_SSE2, BFloat16, __m128, 4,
+               loadSse2, storeSse2, set1Sse2, mulAddSse2, generic::axpy)
+ML_DOT_KERNEL(dotSse2, ML_TARGET_SSE2, BFloat16, float, __m128, 4,
+              loadSse2, _mm_setzero_ps, mulAddSse2, _mm_storeu_ps,
+              generic::dot)
+
+ML_TARGET_SSE2
+float sumSquaresSse2(const BFloat16* a, size_t n) {
+    return dotSse2(a, a, n);
+}
+
+//
+// AVX2 + FMA
+//
+ML_TARGET_AVX2
+inline __m256 loadAvx2(const BFloat16* p) {
+    __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    return _mm256_castsi256_ps(
+        _mm256_slli_epi32(_mm256_cvtepu16_epi32(raw), 16));
+}
+
+ML_TARGET_AVX2
+inline void storeAvx2(BFloat16* p, __m256 x) {
+    __m256i bits = _mm256_castps_si256(x);
+    __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16),
+                                   _mm256_set1_epi32(1));
+    __m256i rounded = _mm256_srli_epi32(
+        _mm256_add_epi32(_mm256_add_epi32(bits, _mm256_set1_epi32(0x7FFF)),
+                         lsb), 16);
+    __m256i nan = _mm256_or_si256(_mm256_srli_epi32(bits, 16),
+                                  _mm256_set1_epi32(0x40));
+    __m256 isNan = _mm256_cmp_ps(x, x, _CMP_UNORD_Q);
+    rounded = _mm256_blendv_epi8(rounded, nan, _mm256_castps_si256(isNan));
+    // packus works within 128-bit lanes; the permute gathers the halves.
+    __m256i packed = _mm256_permute4x64_epi64(
+        _mm256_packus_epi32(rounded, rounded), 0xD8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                     _mm256_castsi256_si128(packed));
+}
+
+ML_TARGET_AVX2
+inline __m256 set1Avx2(BFloat16 alpha) {
+    return _mm256_set1_ps(alpha);
+}
+
+ML_BINARY_KERNEL(addAvx2, ML_TARGET_AVX2, BFloat16, __m256, 8,
+                 loadAvx2, storeAvx2, _mm256_add_ps, generic::add)
+ML_BINARY_KERNEL(subAvx2, ML_TARGET_AVX2, BFloat16, __m256, 8,
+                 loadAvx2, storeAvx2, _mm256_sub_ps, generic::sub)
+ML_BINARY_KERNEL(mulAvx2, ML_TARGET_AVX2, BFloat16, __m256, 8,
+                 loadAvx2, storeAvx2, _mm256_mul_ps, generic::mul)
+ML_SCALAR_KERNEL(scaleAvx2, ML_TARGET_AVX2, BFloat16, __m256, 8,
+                 loadAvx2, storeAvx2, set1Avx2, _mm256_mul_ps,
+                 generic::scale)
+ML_SCALAR_KERNEL(addScalarAvx2, ML_TARGET_AVX2, BFloat16, __m256, 8,
+                 loadAvx2, storeAvx2, set1Avx2, _mm256_add_ps,
+                 generic::addScalar)
+ML_AXPY_KERNEL(axpyAvx2, ML_TARGET_AVX2, BFloat16, __m256, 8,
+               loadAvx2, storeAvx2, set1Avx2, _mm256_fmadd_ps,
+               generic::axpy)
+ML_DOT_KERNEL(dotAvx2, ML_TARGET_AVX2, BFloat16, float, __m256, 8,
+              loadAvx2, _mm256_setzero_ps, _mm256_fmadd_ps,
+              _mm256_storeu_ps, generic::dot)
+
+ML_TARGET_AVX2
+float sumSquaresAvx2(const BFloat16* a, size_t n) {
+    return dotAvx2(a, a, n);
+}
+
+#if defined(ML_SIMD_AVX512)
+//
+// AVX-512
+//
+// The unmasked shifts and conversions start from an undefined register
+// that GCC 12 reports as maybe-uninitialized; the all-lanes masked
+// forms compile to the same instructions.
+const __mmask16 kAllLanes = 0xFFFF;
+
+ML_TARGET_AVX512
+inline __m512 loadAvx512(const BFloat16* p) {
+    __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m512i wide = _mm512_maskz_cvtepu16_epi32(kAllLanes, raw);
+    return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(kAllLanes, wide, 16));
+}
+
+ML_TARGET_AVX512
+inline void storeAvx512(BFloat16* p, __m512 x) {
+    __m512i bits = _mm512_castps_si512(x);
+    __m512i high = _mm512_maskz_srli_epi32(kAllLanes, bits, 16);
+    __m512i lsb = _mm512_and_si512(high, _mm512_set1_epi32(1));
+    __m512i rounded = _mm512_maskz_srli_epi32(kAllLanes,
+        _mm512_add_epi32(_mm512_add_epi32(bits, _mm512_set1_epi32(0x7FFF)),
+                         lsb), 16);
+    __m512i nan = _mm512_or_si512(high, _mm512_set1_epi32(0x40));
+    __mmask16 isNan = _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q);
+    rounded = _mm512_mask_blend_epi32(isNan, rounded, nan);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p),
+                        _mm512_maskz_cvtepi32_epi16(kAllLanes, rounded));
+}
+
+ML_TARGET_AVX512
+inline __m512 set1Avx512(BFloat16 alpha) {
+    return _mm512_set1_ps(alpha);
+}
+
+ML_BINARY_KERNEL(addAvx512, ML_TARGET_AVX512, BFloat16, __m512, 16,
+                 loadAvx512, storeAvx512, _mm512_add_ps, generic::add)
+ML_BINARY_KERNEL(subAvx512, ML_TARGET_AVX512, BFloat16, __m512, 16,
+                 loadAvx512, storeAvx512, _mm512_sub_ps, generic::sub)
+ML_BINARY_KERNEL(mulAvx512, ML_TARGET_AVX512, BFloat16, __m512, 16,
+                 loadAvx512, storeAvx512, _mm512_mul_ps, generic::mul)
+ML_SCALAR_KERNEL(scaleAvx512, ML_TARGET_AVX512, BFloat16, __m512, 16,
+                 loadAvx512, storeAvx512, set1Avx512, _mm512_mul_ps,
+                 generic::scale)
+ML_SCALAR_KERNEL(addScalarAvx512, ML_TARGET_AVX512, BFloat16, __m512, 16,
+                 loadAvx512, storeAvx512, set1Avx512, _mm512_add_ps,
+                 generic::addScalar)
+ML_AXPY_KERNEL(axpyAvx512, ML_TARGET_AVX512, BFloat16, __m512, 16,
+               loadAvx512, storeAvx512, set1Avx512, _mm512_fmadd_ps,
+               generic::axpy)
+ML_DOT_KERNEL(dotAvx512, ML_TARGET_AVX512, BFloat16, float, __m512, 16,
+              loadAvx512, _mm512_setzero_ps, _mm512_fmadd_ps,
+              _mm512_storeu_ps, generic::dot)
+
+ML_TARGET_AVX512
+float sumSquaresAvx512(const BFloat16* a, size_t n) {
+    return dotAvx512(a, a, n);
+}
+#endif  // ML_SIMD_AVX512
+
+#endif  // ML_SIMD_X86
+
+}  // namespace
+
+template <>
+KernelTable<BFloat16> selectKernels<BFloat16>(Isa isa) {
+    KernelTable<BFloat16> table = generic::table<BFloat16>();
+#if defined(ML_SIMD_X86)
+    if (isa == kIsaSse2) {
+        KernelTable<BFloat16> sse2 = { addSse2, subSse2, mulSse2, scaleSse2,
+                                       addScalarSse2, axpySse2, dotSse2,
+                                       sumSquaresSse2 };
+        table = sse2;
+    }
+    if (isa == kIsaAvx2) {
+        KernelTable<BFloat16> avx2 = { addAvx2, subAvx2, mulAvx2, scaleAvx2,
+                                       addScalarAvx2, axpyAvx2, dotAvx2,
+                                       sumSquaresAvx2 };
+        table = avx2;
+    }
+#if defined(ML_SIMD_AVX512)
+    if (isa == kIsaAvx512) {
+        KernelTable<BFloat16> avx512 = { addAvx512, subAvx512, mulAvx512,
+                                         scaleAvx512, addScalarAvx512,
+                                         axpyAvx512, dotAvx512,
+                                         sumSquaresAvx512 };
+        table = avx512;
+    }
+#endif
+#endif
+    return table;
+}
+
+}  // namespace kernels
@@ -0,0 +1,140 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "src/simd_kernels.h"
+
+namespace kernels {
+
+namespace {
+
+#if defined(ML_SIMD_X86)
+
+//
+// SSE2
+//
+ML_BINARY_KERNEL(addSse2, ML_TARGET_SSE2, double, __m128d, 2,
+                 _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, generic::add)
+ML_BINARY_KERNEL(subSse2, ML_TARGET_SSE2, double, __m128d, 2,
+                 _mm_loadu_pd, _mm_storeu_pd, _mm_sub_pd, generic::sub)
+ML_BINARY_KERNEL(mulSse2, ML_TARGET_SSE2, double, __m128d, 2,
+                 _mm_loadu_pd, _mm_storeu_pd, _mm_mul_pd, generic::mul)
+ML_SCALAR_KERNEL(scaleSse2, ML_TARGET_SSE2, double, __m128d, 2,
+                 _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_mul_pd,
+                 generic::scale)
+ML_SCALAR_KERNEL(addScalarSse2, ML_TARGET_SSE2, double, __m128d, 2,
+                 _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_add_pd,
+                 generic::addScalar)
+
+// SSE2 has no fused multiply-add.
+ML_TARGET_SSE2
+inline __m128d mulAddSse2(__m128d a, __m128d b, __m128d c) {
+    return _mm_add_pd(_mm_mul_pd(a, b), c);
+}
+
+ML_AXPY_KERNEL(axpySse2, ML_TARGET_SSE2, double, __m128d, 2,
+               _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, mulAddSse2,
+               generic::axpy)
+ML_DOT_KERNEL(dotSse2, ML_TARGET_SSE2, double, double, __m128d, 2,
+              _mm_loadu_pd, _mm_setzero_pd, mulAddSse2, _mm_storeu_pd,
+              generic::dot)
+
+ML_TARGET_SSE2
+double sumSquaresSse2(const double* a, size_t n) {
+    return dotSse2(a, a, n);
+}
+
+//
+// AVX2 + FMA
+//
+ML_BINARY_KERNEL(addAvx2, ML_TARGET_AVX2, double, __m256d, 4,
+                 _mm256_loadu_pd, _mm256_storeu_pd, _mm256_add_pd,
+                 generic::add)
+ML_BINARY_KERNEL(subAvx2, ML_TARGET_AVX2, double, __m256d, 4,
+                 _mm256_loadu_pd, _mm256_storeu_pd, _mm256_sub_pd,
+                 generic::sub)
+ML_BINARY_KERNEL(mulAvx2, ML_TARGET_AVX2, double, __m256d, 4,
+                 _mm256_loadu_pd, _mm256_storeu_pd, _mm256_mul_pd,
+                 generic::mul)
+ML_SCALAR_KERNEL(scaleAvx2, ML_TARGET_AVX2, double, __m256d, 4,
+                 _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd,
+                 _mm256_mul_pd, generic::scale)
+ML_SCALAR_KERNEL(addScalarAvx2, ML_TARGET_AVX2, double, __m256d, 4,
+                 _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd,
+                 _mm256_add_pd, generic::addScalar)
+ML_AXPY_KERNEL(axpyAvx2, ML_TARGET_AVX2, double, __m256d, 4,
+               _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd,
+               _mm256_fmadd_pd, generic::axpy)
+ML_DOT_KERNEL(dotAvx2, ML_TARGET_AVX2, double, double, __m256d, 4,
+              _mm256_loadu_pd, _mm256_setzero_pd, _mm256_fmadd_pd,
+              _mm256_storeu_pd, generic::dot)
+
+ML_TARGET_AVX2
+double sumSquaresAvx2(const double* a, size_t n) {
+    return dotAvx2(a, a, n);
+}
+
+#if defined(ML_SIMD_AVX512)
+//
+// AVX-512
+//
+ML_BINARY_KERNEL(addAvx512, ML_TARGET_AVX512, double, __m512d, 8,
+                 _mm512_loadu_pd, _mm512_storeu_pd, _mm512_add_pd,
+                 generic::add)
+ML_BINARY_KERNEL(subAvx512, ML_TARGET_AVX512, double, __m512d, 8,
+                 _mm512_loadu_pd, _mm512_storeu_pd, _mm512_sub_pd,
+                 generic::sub)
+ML_BINARY_KERNEL(mulAvx512, ML_TARGET_AVX512, double, __m512d, 8,
+                 _mm512_loadu_pd, _mm512_storeu_pd, _mm512_mul_pd,
+                 generic::mul)
+ML_SCALAR_KERNEL(scaleAvx512, ML_TARGET_AVX512, double, __m512d, 8,
+                 _mm512_loadu_pd, _mm512_storeu_pd, _mm512_set1_pd,
+                 _mm512_mul_pd, generic::scale)
+ML_SCALAR_KERNEL(addScalarAvx512, ML_TARGET_AVX512, double, __m512d, 8,
+                 _mm512_loadu_pd, _mm512_storeu_pd, _mm512_set1_pd,
+                 _mm512_add_pd, generic::addScalar)
+ML_AXPY_KERNEL(axpyAvx512, ML_TARGET_AVX512, double, __m512d, 8,
+               _mm512_loadu_pd, _mm512_storeu_pd, _mm512_set1_pd,
+               _mm512_fmadd_pd, generic::axpy)
+ML_DOT_KERNEL(dotAvx512, ML_TARGET_AVX512, double, double, __m512d, 8,
+              _mm512_loadu_pd, _mm512_setzero_pd, _mm512_fmadd_pd,
+              _mm512_storeu_pd, generic::dot)
+
+ML_TARGET_AVX512
+double sumSquaresAvx512(const double* a, size_t n) {
+    return dotAvx512(a, a, n);
+}
+#endif  // ML_SIMD_AVX512
+
+#endif  // ML_SIMD_X86
+
+}  // namespace
+
+template <>
+KernelTable<double> selectKernels<double>(Isa isa) {
+    KernelTable<double> table = generic::table<double>();
+#if defined(ML_SIMD_X86)
+    if (isa == kIsaSse2) {
+        KernelTable<double> sse2 = { addSse2, subSse2, mulSse2, scaleSse2,
+                                     addScalarSse2, axpySse2, dotSse2,
+                                     sumSquaresSse2 };
+        table = sse2;
+    }
+    if (isa == kIsaAvx2) {
+        KernelTable<double> avx2 = { addAvx2, subAvx2, mulAvx2, scaleAvx2,
+                                     addScalarAvx2, axpyAvx2, dotAvx2,
+                                     sumSquaresAvx2 };
+        table = avx2;
+    }
+#if defined(ML_SIMD_AVX512)
+    if (isa == kIsaAvx512) {
+        KernelTable<double> avx512 = { addAvx512, subAvx512, mulAvx512,
+                                       scaleAvx512, addScalarAvx512,
+                                       axpyAvx512, dotAvx512,
+                                       sumSquaresAvx512 };
+        table = avx512;
+    }
+#endif
+#endif
+    return table;
+}
+
+}  // namespace kernels
@@ -0,0 +1,140 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "src/simd_kernels.h"
+
+namespace kernels {
+
+namespace {
+
+#if defined(ML_SIMD_X86)
+
+//
+// SSE2
+//
+ML_BINARY_KERNEL(addSse2, ML_TARGET_SSE2, float, __m128, 4,
+                 _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, generic::add)
+ML_BINARY_KERNEL(subSse2, ML_TARGET_SSE2, float, __m128, 4,
+                 _mm_loadu_ps, _mm_storeu_ps, _mm_sub_ps, generic::sub)
+ML_BINARY_KERNEL(mulSse2, ML_TARGET_SSE2, float, __m128, 4,
+                 _mm_loadu_ps, _mm_storeu_ps, _mm_mul_ps, generic::mul)
+ML_SCALAR_KERNEL(scaleSse2, ML_TARGET_SSE2, float, __m128, 4,
+                 _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, _mm_mul_ps,
+                 generic::scale)
+ML_SCALAR_KERNEL(addScalarSse2, ML_TARGET_SSE2, float, __m128, 4,
+                 _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, _mm_add_ps,
+                 generic::addScalar)
+
+// SSE2 has no fused multiply-add.
+ML_TARGET_SSE2
+inline __m128 mulAddSse2(__m128 a, __m128 b, __m128 c) {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+ML_AXPY_KERNEL(axpySse2, ML_TARGET_SSE2, float, __m128, 4,
+               _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps, mulAddSse2,
+               generic::axpy)
+ML_DOT_KERNEL(dotSse2, ML_TARGET_SSE2, float, float, __m128, 4,
+              _mm_loadu_ps, _mm_setzero_ps, mulAddSse2, _mm_storeu_ps,
+              generic::dot)
+
+ML_TARGET_SSE2
+float sumSquaresSse2(const float* a, size_t n) {
+    return dotSse2(a, a, n);
+}
+
+//
+// AVX2 + FMA
+//
+ML_BINARY_KERNEL(addAvx2, ML_TARGET_AVX2, float, __m256, 8,
+                 _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps,
+                 generic::add)
+ML_BINARY_KERNEL(subAvx2, ML_TARGET_AVX2, float, __m256, 8,
+                 _mm256_loadu_ps, _mm256_storeu_ps, _mm256_sub_ps,
+                 generic::sub)
+ML_BINARY_KERNEL(mulAvx2, ML_TARGET_AVX2, float, __m256, 8,
+                 _mm256_loadu_ps, _mm256_storeu_ps, _mm256_mul_ps,
+                 generic::mul)
+ML_SCALAR_KERNEL(scaleAvx2, ML_TARGET_AVX2, float, __m256, 8,
+                 _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps,
+                 _mm256_mul_ps, generic::scale)
+ML_SCALAR_KERNEL(addScalarAvx2, ML_TARGET_AVX2, float, __m256, 8,
+                 _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps,
+                 _mm256_add_ps, generic::addScalar)
+ML_AXPY_KERNEL(axpyAvx2, ML_TARGET_AVX2, float, __m256, 8,
+               _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps,
+               _mm256_fmadd_ps, generic::axpy)
+ML_DOT_KERNEL(dotAvx2, ML_TARGET_AVX2, float, float, __m256, 8,
+              _mm256_loadu_ps, _mm256_setzero_ps, _mm256_fmadd_ps,
+              _mm256_storeu_ps, generic::dot)
+
+ML_TARGET_AVX2
+float sumSquaresAvx2(const float* a, size_t n) {
+    return dotAvx2(a, a, n);
+}
+
+#if defined(ML_SIMD_AVX512)
+//
+// AVX-512
+//
+ML_BINARY_KERNEL(addAvx512, ML_TARGET_AVX512, float, __m512, 16,
+                 _mm512_loadu_ps, _mm512_storeu_ps, _mm512_add_ps,
+                 generic::add)
+ML_BINARY_KERNEL(subAvx512, ML_TARGET_AVX512, float, __m512, 16,
+                 _mm512_loadu_ps, _mm512_storeu_ps, _mm512_sub_ps,
+                 generic::sub)
+ML_BINARY_KERNEL(mulAvx512, ML_TARGET_AVX512, float, __m512, 16,
+                 _mm512_loadu_ps, _mm512_storeu_ps, _mm512_mul_ps,
+                 generic::mul)
+ML_SCALAR_KERNEL(scaleAvx512, ML_TARGET_AVX512, float, __m512, 16,
+                 _mm512_loadu_ps, _mm512_storeu_ps, _mm512_set1_ps,
+                 _mm512_mul_ps, generic::scale)
+ML_SCALAR_KERNEL(addScalarAvx512, ML_TARGET_AVX512, float, __m512, 16,
+                 _mm512_loadu_ps, _mm512_storeu_ps, _mm512_set1_ps,
+                 _mm512_add_ps, generic::addScalar)
+ML_AXPY_KERNEL(axpyAvx512, ML_TARGET_AVX512, float, __m512, 16,
+               _mm512_loadu_ps, _mm512_storeu_ps, _mm512_set1_ps,
+               _mm512_fmadd_ps, generic::axpy)
+ML_DOT_KERNEL(dotAvx512, ML_TARGET_AVX512, float, float, __m512, 16,
+              _mm512_loadu_ps, _mm512_setzero_ps, _mm512_fmadd_ps,
+              _mm512_storeu_ps, generic::dot)
+
+ML_TARGET_AVX512
+float sumSquaresAvx512(const float* a, size_t n) {
+    return dotAvx512(a, a, n);
+}
+#endif  // ML_SIMD_AVX512
+
+#endif  // ML_SIMD_X86
+
+}  // namespace
+
+template <>
+KernelTable<float> selectKernels<float>(Isa isa) {
+    KernelTable<float> table = generic::table<float>();
+#if defined(ML_SIMD_X86)
+    if (isa == kIsaSse2) {
+        KernelTable<float> sse2 = { addSse2, subSse2, mulSse2, scaleSse2,
+                                     addScalarSse2, axpySse2, dotSse2,
+                                     sumSquaresSse2 };
+        table = sse2;
+    }
+    if (isa == kIsaAvx2) {
+        KernelTable<float> avx2 = { addAvx2, subAvx2, mulAvx2, scaleAvx2,
+                                     addScalarAvx2, axpyAvx2, dotAvx2,
+                                     sumSquaresAvx2 };
+        table = avx2;
+    }
+#if defined(ML_SIMD_AVX512)
+    if (isa == kIsaAvx512) {
+        KernelTable<float> avx512 = { addAvx512, subAvx512, mulAvx512,
+                                       scaleAvx512, addScalarAvx512,
+                                       axpyAvx512, dotAvx512,
+                                       sumSquaresAvx512 };
+        table = avx512;
+    }
+#endif
+#endif
+    return table;
+}
+
+}  // namespace kernels
@@ -0,0 +1,222 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "src/simd_kernels.h"
+
+// int8_t kernels saturate like ScalarTraits<int8_t>::narrow(). Sums and
+// differences use the saturating byte instructions directly; products
+// are formed exactly in 16-bit lanes and packed back with saturation;
+// dot products accumulate pairs of 16-bit products into 32-bit lanes.
+// 512-bit byte arithmetic needs AVX-512BW, so AVX-512 hosts run the
+// AVX2 kernels.
+
+namespace kernels {
+
+namespace {
+
+#if defined(ML_SIMD_X86)
+
+//
+// SSE2
+//
+ML_TARGET_SSE2
+inline __m128i loadSse2(const int8_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+ML_TARGET_SSE2
+inline void storeSse2(int8_t* p, __m128i x) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), x);
+}
+
+ML_TARGET_SSE2
+inline __m128i set1Sse2(int8_t alpha) {
+    return _mm_set1_epi8(alpha);
+}
+
+// Sign-extends the low or the high eight bytes to 16 bits.
+ML_TARGET_SSE2
+inline __m128i widenLoSse2(__m128i x) {
+    return _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+}
+
+ML_TARGET_SSE2
+inline __m128i widenHiSse2(__m128i x) {
+    return _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+}
+
+ML_TARGET_SSE2
+inline __m128i mulSse2(__m128i a, __m128i b) {
+    __m128i lo = _mm_mullo_epi16(widenLoSse2(a), widenLoSse2(b));
+    __m128i hi = _mm_mullo_epi16(widenHiSse2(a), widenHiSse2(b));
+    return _mm_packs_epi16(lo, hi);
+}
+
+// |alpha * x| <= 2^14, so alpha * x + y cannot overflow 16 bits.
+ML_TARGET_SSE2
+inline __m128i mulAddSse2(__m128i alpha, __m128i x, __m128i y) {
+    __m128i lo = _mm_add_epi16(
+        _mm_mullo_epi16(widenLoSse2(alpha), widenLoSse2(x)), widenLoSse2(y));
+    __m128i hi = _mm_add_epi16(
+        _mm_mullo_epi16(widenHiSse2(alpha), widenHiSse2(x)), widenHiSse2(y));
+    return _mm_packs_epi16(lo, hi);
+}
+
+ML_BINARY_KERNEL(addSse2, ML_TARGET_SSE2, int8_t, __m128i, 16,
+                 loadSse2, storeSse2, _mm_adds_epi8, generic::add)
+ML_BINARY_KERNEL(subSse2, ML_TARGET_SSE2, int8_t, __m128i, 16,
+                 loadSse2, storeSse2, _mm_subs_epi8, generic::sub)
+ML_BINARY_KERNEL(mulSaturateSse2, ML_TARGET_SSE2, int8_t, __m128i, 16,
+                 loadSse2, storeSse2, mulSse2, generic::mul)
+ML_SCALAR_KERNEL(scaleSse2, ML_TARGET_SSE2, int8_t, __m128i, 16,
+                 loadSse2, storeSse2, set1Sse2, mulSse2, generic::scale)
+ML_SCALAR_KERNEL(addScalarSse2, ML_TARGET_SSE2, int8_t, __m128i, 16,
+                 loadSse2, storeSse2, set1Sse2, _mm_adds_epi8,
+                 generic::addScalar)
+ML_AXPY_KERNEL(axpySse2, ML_TARGET_SSE2, int8_t, __m128i, 16,
+               loadSse2, storeSse2, set1Sse2, mulAddSse2, generic::axpy)
+
+ML_TARGET_SSE2
+int32_t dotSse2(const int8_t* a, const int8_t* b, size_t n) {
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = loadSse2(a + i);
+        __m128i y = loadSse2(b + i);
+        acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(widenLoSse2(x),
+                                                  widenLoSse2(y)));
+        acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(widenHiSse2(x),
+                                                  widenHiSse2(y)));
+    }
+
+    int32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes),
+                     _mm_add_epi32(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+           generic::dot(a + i, b + i, n - i);
+}
+
+ML_TARGET_SSE2
+int32_t sumSquaresSse2(const int8_t* a, size_t n) {
+    return dotSse2(a, a, n);
+}
+
+//
+// AVX2
+//
+ML_TARGET_AVX2
+inline __m256i loadAvx2(const int8_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+ML_TARGET_AVX2
+inline void storeAvx2(int8_t* p, __m256i x) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x);
+}
+
+ML_TARGET_AVX2
+inline __m256i set1Avx2(int8_t alpha) {
+    return _mm256_set1_epi8(alpha);
+}
+
+ML_TARGET_AVX2
+inline __m256i widenLoAvx2(__m256i x) {
+    return _mm256_cvtepi8_epi16(_mm256_castsi256_si128(x));
+}
+
+ML_TARGET_AVX2
+inline __m256i widenHiAvx2(__m256i x) {
+    return _mm256_cvtepi8_epi16(_mm256_extracti128_si256(x, 1));
+}
+
+// packs works within 128-bit lanes; the permute restores the order.
+ML_TARGET_AVX2
+inline __m256i narrowAvx2(__m256i lo, __m256i hi) {
+    return _mm256_permute4x64_epi64(_mm256_packs_epi16(lo, hi), 0xD8);
+}
+
+ML_TARGET_AVX2
+inline __m256i mulAvx2(__m256i a, __m256i b) {
+    return narrowAvx2(_mm256_mullo_epi16(widenLoAvx2(a), widenLoAvx2(b)),
+                      _mm256_mullo_epi16(widenHiAvx2(a), widenHiAvx2(b)));
+}
+
+ML_TARGET_AVX2
+inline __m256i mulAddAvx2(__m256i alpha, __m256i x, __m256i y) {
+    return narrowAvx2(
+        _mm256_add_epi16(_mm256_mullo_epi16(widenLoAvx2(alpha),
+                                            widenLoAvx2(x)),
+                         widenLoAvx2(y)),
+        _mm256_add_epi16(_mm256_mullo_epi16(widenHiAvx2(alpha),
+                                            widenHiAvx2(x)),
+                         widenHiAvx2(y)));
+}
+
+ML_BINARY_KERNEL(addAvx2, ML_TARGET_AVX2, int8_t, __m256i, 32,
+                 loadAvx2, storeAvx2, _mm256_adds_epi8, generic::add)
+ML_BINARY_KERNEL(subAvx2, ML_TARGET_AVX2, int8_t, __m256i, 32,
+                 loadAvx2, storeAvx2, _mm256_subs_epi8, generic::sub)
+ML_BINARY_KERNEL(mulSaturateAvx2, ML_TARGET_AVX2, int8_t, __m256i, 32,
+                 loadAvx2, storeAvx2, mulAvx2, generic::mul)
+ML_SCALAR_KERNEL(scaleAvx2, ML_TARGET_AVX2, int8_t, __m256i, 32,
+                 loadAvx2, storeAvx2, set1Avx2, mulAvx2, generic::scale)
+ML_SCALAR_KERNEL(addScalarAvx2, ML_TARGET_AVX2, int8_t, __m256i, 32,
+                 loadAvx2, storeAvx2, set1Avx2, _mm256_adds_epi8,
+                 generic::addScalar)
+ML_AXPY_KERNEL(axpyAvx2, ML_TARGET_AVX2, int8_t, __m256i, 32,
+               loadAvx2, storeAvx2, set1Avx2, mulAddAvx2, generic::axpy)
+
+ML_TARGET_AVX2
+int32_t dotAvx2(const int8_t* a, const int8_t* b, size_t n) {
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = loadAvx2(a + i);
+        __m256i y = loadAvx2(b + i);
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(widenLoAvx2(x),
+                                                        widenLoAvx2(y)));
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(widenHiAvx2(x),
+                                                        widenHiAvx2(y)));
+    }
+
+    int32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes),
+                        _mm256_add_epi32(acc0, acc1));
+    int32_t sum = 0;
+    for (int l = 0; l < 8; l++) {
+        sum += lanes[l];
+    }
+    return sum + generic::dot(a + i, b + i, n - i);
+}
+
+ML_TARGET_AVX2
+int32_t sumSquaresAvx2(const int8_t* a, size_t n) {
+    return dotAvx2(a, a, n);
+}
+
+#endif  // ML_SIMD_X86
+
+}  // namespace
+
+template <>
+KernelTable<int8_t> selectKernels<int8_t>(Isa isa) {
+    KernelTable<int8_t> table = generic::table<int8_t>();
+#if defined(ML_SIMD_X86)
+    if (isa == kIsaSse2) {
+        KernelTable<int8_t> sse2 = { addSse2, subSse2, mulSaturateSse2,
+                                     scaleSse2, addScalarSse2, axpySse2,
+                                     dotSse2, sumSquaresSse2 };
+        table = sse2;
+    }
+    if (isa >= kIsaAvx2) {
+        KernelTable<int8_t> avx2 = { addAvx2, subAvx2, mulSaturateAvx2,
+                                     scaleAvx2, addScalarAvx2, axpyAvx2,
+                                     dotAvx2, sumSquaresAvx2 };
+        table = avx2;
+    }
+#endif
+    return table;
+}
+
+}  // namespace kernels
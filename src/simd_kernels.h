@@ -0,0 +1,220 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef SRC_SIMD_KERNELS_H_
+#define SRC_SIMD_KERNELS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ml/scalar.h"
+#include "src/simd.h"
+
+// Internals shared by the per-type kernel files (simd_double.cpp,
+// simd_float.cpp, simd_int8.cpp, simd_bfloat16.cpp): the dispatch
+// table, the portable fallbacks and the macros stamping out the
+// vector loops.
+
+namespace kernels {
+
+template <class T>
+struct KernelTable {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    typedef void (*Binary)(const T*, const T*, T*, size_t);
+    typedef void (*Scalar)(T, const T*, T*, size_t);
+    typedef void (*Axpy)(T, const T*, const T*, T*, size_t);
+    typedef Accumulator (*Dot)(const T*, const T*, size_t);
+    typedef Accumulator (*Norm)(const T*, size_t);
+
+    Binary add;
+    Binary sub;
+    Binary mul;
+    Scalar scale;
+    Scalar addScalar;
+    Axpy axpy;
+    Dot dot;
+    Norm sumSquares;
+};
+
+// Kernels for isa, defined next to the kernels of each element type.
+template <class T>
+KernelTable<T> selectKernels(Isa isa);
+
+template <>
+KernelTable<double> selectKernels<double>(Isa isa);
+template <>
+KernelTable<float> selectKernels<float>(Isa isa);
+template <>
+KernelTable<int8_t> selectKernels<int8_t>(Isa isa);
+template <>
+KernelTable<BFloat16> selectKernels<BFloat16>(Isa isa);
+
+// Portable fallbacks; the vector kernels also use them for the tails
+// that do not fill a register.
+namespace generic {
+
+template <class T>
+void add(const T* a, const T* b, T* out, size_t n) {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ScalarTraits<T>::narrow(Accumulator(a[i]) +
+                                         Accumulator(b[i]));
+    }
+}
+
+template <class T>
+void sub(const T* a, const T* b, T* out, size_t n) {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ScalarTraits<T>::narrow(Accumulator(a[i]) -
+                                         Accumulator(b[i]));
+    }
+}
+
+template <class T>
+void mul(const T* a, const T* b, T* out, size_t n) {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ScalarTraits<T>::narrow(Accumulator(a[i]) *
+                                         Accumulator(b[i]));
+    }
+}
+
+template <class T>
+void scale(T alpha, const T* a, T* out, size_t n) {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    Accumulator scalar = alpha;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ScalarTraits<T>::narrow(scalar * Accumulator(a[i]));
+    }
+}
+
+template <class T>
+void addScalar(T alpha, const T* a, T* out, size_t n) {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    Accumulator scalar = alpha;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ScalarTraits<T>::narrow(scalar + Accumulator(a[i]));
+    }
+}
+
+template <class T>
+void axpy(T alpha, const T* x, const T* y, T* out, size_t n) {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    Accumulator scalar = alpha;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ScalarTraits<T>::narrow(scalar * Accumulator(x[i]) +
+                                         Accumulator(y[i]));
+    }
+}
+
+template <class T>
+typename ScalarTraits<T>::Accumulator dot(const T* a, const T* b,
+                                          size_t n) {
+    typedef typename ScalarTraits<T>::Accumulator Accumulator;
+    Accumulator sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += Accumulator(a[i]) * Accumulator(b[i]);
+    }
+    return sum;
+}
+
+template <class T>
+typename ScalarTraits<T>::Accumulator sumSquares(const T* a, size_t n) {
+    return dot(a, a, n);
+}
+
+template <class T>
+KernelTable<T> table() {
+    KernelTable<T> kernels = { add<T>, sub<T>, mul<T>, scale<T>,
+                               addScalar<T>, axpy<T>, dot<T>,
+                               sumSquares<T> };
+    return kernels;
+}
+
+}  // namespace generic
+
+}  // namespace kernels
+
+#if defined(ML_SIMD_X86)
+
+// Element-wise loops are memory bound: two registers per iteration
+// are enough to keep the load ports busy. load() and store() convert
+// between type and the register type when they differ.
+#define ML_BINARY_KERNEL(name, target, type, reg, width, load, store, vop, \
+                         tail)                                             \
+    target void name(const type* a, const type* b, type* out, size_t n) { \
+        size_t i = 0;                                                      \
+        for (; i + 2 * (width) <= n; i += 2 * (width)) {                   \
+            reg x0 = vop(load(a + i), load(b + i));                        \
+            reg x1 = vop(load(a + i + (width)), load(b + i + (width)));    \
+            store(out + i, x0);                                            \
+            store(out + i + (width), x1);                                  \
+        }                                                                  \
+        tail(a + i, b + i, out + i, n - i);                                \
+    }
+
+#define ML_SCALAR_KERNEL(name, target, type, reg, width, load, store, set1, \
+                         vop, tail)                                         \
+    target void name(type alpha, const type* a, type* out, size_t n) {     \
+        reg va = set1(alpha);                                               \
+        size_t i = 0;                                                       \
+        for (; i + 2 * (width) <= n; i += 2 * (width)) {                    \
+            reg x0 = vop(va, load(a + i));                                  \
+            reg x1 = vop(va, load(a + i + (width)));                        \
+            store(out + i, x0);                                             \
+            store(out + i + (width), x1);                                   \
+        }                                                                   \
+        tail(alpha, a + i, out + i, n - i);                                 \
+    }
+
+#define ML_AXPY_KERNEL(name, target, type, reg, width, load, store, set1,  \
+                       fmadd, tail)                                        \
+    target void name(type alpha, const type* x, const type* y, type* out,  \
+                     size_t n) {                                           \
+        reg va = set1(alpha);                                              \
+        size_t i = 0;                                                      \
+        for (; i + 2 * (width) <= n; i += 2 * (width)) {                   \
+            reg r0 = fmadd(va, load(x + i), load(y + i));                  \
+            reg r1 = fmadd(va, load(x + i + (width)),                      \
+                           load(y + i + (width)));                         \
+            store(out + i, r0);                                            \
+            store(out + i + (width), r1);                                  \
+        }                                                                  \
+        tail(alpha, x + i, y + i, out + i, n - i);                         \
+    }
+
+// Four independent accumulators hide the latency of the multiply-add.
+#define ML_DOT_KERNEL(name, target, type, acc, reg, width, load, setzero,  \
+                      fmadd, storeAcc, tail)                               \
+    target acc name(const type* a, const type* b, size_t n) {              \
+        reg acc0 = setzero();                                              \
+        reg acc1 = setzero();                                              \
+        reg acc2 = setzero();                                              \
+        reg acc3 = setzero();                                              \
+        size_t i = 0;                                                      \
+        for (; i + 4 * (width) <= n; i += 4 * (width)) {                   \
+            acc0 = fmadd(load(a + i), load(b + i), acc0);                  \
+            acc1 = fmadd(load(a + i + (width)), load(b + i + (width)),     \
+                         acc1);                                            \
+            acc2 = fmadd(load(a + i + 2 * (width)),                        \
+                         load(b + i + 2 * (width)), acc2);                 \
+            acc3 = fmadd(load(a + i + 3 * (width)),                        \
+                         load(b + i + 3 * (width)), acc3);                 \
+        }                                                                  \
+        enum { kLanes = 4 * (width) };                                     \
+        acc lanes[kLanes];                                                 \
+        storeAcc(lanes, acc0);                                             \
+        storeAcc(lanes + (width), acc1);                                   \
+        storeAcc(lanes + 2 * (width), acc2);                               \
+        storeAcc(lanes + 3 * (width), acc3);                               \
+        acc sum = 0;                                                       \
+        for (int l = 0; l < (width); l++) {                                \
+            sum += (lanes[l] + lanes[l + (width)]) +                       \
+                   (lanes[l + 2 * (width)] + lanes[l + 3 * (width)]);      \
+        }                                                                  \
+        return sum + tail(a + i, b + i, n - i);                            \
+    }
+
+#endif  // ML_SIMD_X86
+
+#endif  // SRC_SIMD_KERNELS_H_
@@ -0,0 +1,533 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/sparse.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "ml/thread_pool.h"
+#include "src/simd.h"
+
+using std::vector;
+
+namespace {
+
+// Products touching fewer elements than this stay on one thread.
+const int64_t kParallelWork = 1 << 16;
+
+// Parallel SpMM tiles of the dense operand are at least this wide.
+const int kMinTileCols = 64;
+
+bool runParallel(int64_t work) {
+    return ThreadPool::global().threads() > 1 && work >= kParallelWork;
+}
+
+// Sorts (major, minor, value) entries into compressed form: the entries
+// of major m end up in [start[m], start[m+1]) ordered by minor index,
+// with duplicates summed. Counting sort by major, then a sort of every
+// segment that is not in order already.
+template <class T>
+void compress(int majors, size_t count, const int* major, const int* minor,
+              const T* value, vector<int64_t>* start, vector<int>* index,
+              vector<T>* values) {
+    vector<int64_t> offset(majors + 1, 0);
+    for (size_t k = 0; k < count; k++) {
+        assert(0 <= major[k] && major[k] < majors);
+        offset[major[k] + 1]++;
+    }
+    for (int m = 0; m < majors; m++) {
+        offset[m + 1] += offset[m];
+    }
+
+    vector<int> sortedIndex(count);
+    vector<T> sortedValues(count);
+    vector<int64_t> next(offset.begin(), offset.end() - 1);
+    for (size_t k = 0; k < count; k++) {
+        int64_t to = next[major[k]]++;
+        sortedIndex[to] = minor[k];
+        sortedValues[to] = value[k];
+    }
+
+    start->assign(majors + 1, 0);
+    vector<std::pair<int, T> > segment;
+    int64_t written = 0;
+    for (int m = 0; m < majors; m++) {
+        int64_t begin = offset[m];
+        int64_t end = offset[m + 1];
+        if (!std::is_sorted(sortedIndex.begin() + begin,
+                            sortedIndex.begin() + end)) {
+            segment.clear();
+            for (int64_t k = begin; k < end; k++) {
+                segment.push_back(std::make_pair(sortedIndex[k],
+                                                 sortedValues[k]));
+            }
+            std::stable_sort(segment.begin(), segment.end(),
+                             [](const std::pair<int, T>& a,
+                                const std::pair<int, T>& b) {
+                                 return a.first < b.first;
+                             });
+            for (int64_t k = begin; k < end; k++) {
+                sortedIndex[k] = segment[k - begin].first;
+                sortedValues[k] = segment[k - begin].second;
+            }
+        }
+
+        int64_t first = written;
+        for (int64_t k = begin; k < end; k++) {
+            if (written > first && sortedIndex[written - 1] == sortedIndex[k]) {
+                sortedValues[written - 1] += sortedValues[k];
+            } else {
+                sortedIndex[written] = sortedIndex[k];
+                sortedValues[written] = sortedValues[k];
+                written++;
+            }
+        }
+        (*start)[m + 1] = written;
+    }
+
+    sortedIndex.resize(written);
+    sortedValues.resize(written);
+    index->swap(sortedIndex);
+    values->swap(sortedValues);
+}
+
+// Major index of every entry of a compressed matrix.
+vector<int> expand(const vector<int64_t>& start) {
+    vector<int> major(start.back());
+    for (size_t m = 0; m + 1 < start.size(); m++) {
+        std::fill(major.begin() + start[m], major.begin() + start[m + 1],
+                  static_cast<int>(m));
+    }
+    return major;
+}
+
+template <class T>
+void fromDense(const BasicMatrix<T>& dense, bool byRows,
+               vector<int64_t>* start, vector<int>* index,
+               vector<T>* values) {
+    int majors = byRows ? dense.rows() : dense.cols();
+    int minors = byRows ? dense.cols() : dense.rows();
+    start->assign(majors + 1, 0);
+    index->clear();
+    values->clear();
+    for (int m = 0; m < majors; m++) {
+        for (int n = 0; n < minors; n++) {
+            T value = byRows ? dense.at(m, n) : dense.at(n, m);
+            if (value != T(0)) {
+                index->push_back(n);
+                values->push_back(value);
+            }
+        }
+        (*start)[m + 1] = values->size();
+    }
+}
+
+template <class T>
+T find(const vector<int64_t>& start, const vector<int>& index,
+       const vector<T>& values, int major, int minor) {
+    vector<int>::const_iterator begin = index.begin() + start[major];
+    vector<int>::const_iterator end = index.begin() + start[major + 1];
+    vector<int>::const_iterator it = std::lower_bound(begin, end, minor);
+    if (it == end || *it != minor) {
+        return T(0);
+    }
+    return values[it - index.begin()];
+}
+
+// Splits [0, majors) into parts ranges holding about the same number
+// of non-zeros; returns the parts + 1 boundaries.
+vector<int> balancedRanges(const vector<int64_t>& start, int parts) {
+    int majors = static_cast<int>(start.size()) - 1;
+    int64_t total = start.back();
+    vector<int> bounds(parts + 1, majors);
+    bounds[0] = 0;
+    for (int t = 1; t < parts; t++) {
+        int64_t target = total * t / parts;
+        int m = static_cast<int>(
+            std::lower_bound(start.begin(), start.end(), target) -
+            start.begin());
+        bounds[t] = std::max(bounds[t - 1], std::min(m, majors));
+    }
+    return bounds;
+}
+
+template <class T>
+void csrRowsTimesVector(const BasicCsrMatrix<T>& a, const T* x, T* y,
+                        int begin, int end) {
+    const int64_t* start = a.rowStart().data();
+    const int* col = a.colIndex().data();
+    const T* value = a.values().data();
+    for (int i = begin; i < end; i++) {
+        // Four partial sums keep the gathers independent.
+        T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        int64_t k = start[i];
+        for (; k + 4 <= start[i + 1]; k += 4) {
+            s0 += value[k] * x[col[k]];
+            s1 += value[k + 1] * x[col[k + 1]];
+            s2 += value[k + 2] * x[col[k + 2]];
+            s3 += value[k + 3] * x[col[k + 3]];
+        }
+        for (; k < start[i + 1]; k++) {
+            s0 += value[k] * x[col[k]];
+        }
+        y[i] = (s0 + s1) + (s2 + s3);
+    }
+}
+
+template <class T>
+void csrRowsTimesMatrix(const BasicCsrMatrix<T>& a, const T* b, T* c,
+                        int n, int begin, int end) {
+    const int64_t* start = a.rowStart().data();
+    const int* col = a.colIndex().data();
+    const T* value = a.values().data();
+    for (int i = begin; i < end; i++) {
+        T* ci = c + static_cast<size_t>(i) * n;
+        for (int64_t k = start[i]; k < start[i + 1]; k++) {
+            kernels::axpy(value[k], b + static_cast<size_t>(col[k]) * n,
+                          ci, ci, n);
+        }
+    }
+}
+
+template <class T>
+void cscColsTimesVector(const BasicCscMatrix<T>& a, const T* x, T* y,
+                        int begin, int end) {
+    const int64_t* start = a.colStart().data();
+    const int* row = a.rowIndex().data();
+    const T* value = a.values().data();
+    for (int j = begin; j < end; j++) {
+        T xj = x[j];
+        for (int64_t k = start[j]; k < start[j + 1]; k++) {
+            y[row[k]] += value[k] * xj;
+        }
+    }
+}
+
+template <class T>
+void cscTimesMatrixCols(const BasicCscMatrix<T>& a, const T* b, T* c,
+                        int n, int begin, int end) {
+    const int64_t* start = a.colStart().data();
+    const int* row = a.rowIndex().data();
+    const T* value = a.values().data();
+    int width = end - begin;
+    for (int j = 0; j < a.cols(); j++) {
+        const T* bj = b + static_cast<size_t>(j) * n + begin;
+        for (int64_t k = start[j]; k < start[j + 1]; k++) {
+            T* ci = c + static_cast<size_t>(row[k]) * n + begin;
+            kernels::axpy(value[k], bj, ci, ci, width);
+        }
+    }
+}
+
+}  // namespace
+
+//
+// COO
+//
+template <class T>
+BasicCooMatrix<T>::BasicCooMatrix(int cols, int rows)
+    : cols_(cols), rows_(rows) {
+}
+
+template <class T>
+void BasicCooMatrix<T>::add(int i, int j, T value) {
+    assert(0 <= i && i < rows_ && 0 <= j && j < cols_);
+    rowIndex_.push_back(i);
+    colIndex_.push_back(j);
+    values_.push_back(value);
+}
+
+template <class T>
+void BasicCooMatrix<T>::reserve(size_t nonZeros) {
+    rowIndex_.reserve(nonZeros);
+    colIndex_.reserve(nonZeros);
+    values_.reserve(nonZeros);
+}
+
+template <class T>
+BasicMatrix<T> BasicCooMatrix<T>::toDense() const {
+    BasicMatrix<T> dense(cols_, rows_);
+    for (size_t k = 0; k < values_.size(); k++) {
+        dense.at(rowIndex_[k], colIndex_[k]) += values_[k];
+    }
+    return dense;
+}
+
+//
+// CSR
+//
+template <class T>
+BasicCsrMatrix<T>::BasicCsrMatrix(int cols, int rows)
+    : rowStart_(rows + 1, 0), cols_(cols), rows_(rows) {
+}
+
+template <class T>
+BasicCsrMatrix<T>::BasicCsrMatrix(int cols, int rows,
+                                  vector<int64_t> rowStart,
+                                  vector<int> colIndex, vector<T> values)
+    : rowStart_(std::move(rowStart)), colIndex_(std::move(colIndex)),
+      values_(std::move(values)), cols_(cols), rows_(rows) {
+    assert(rowStart_.size() == static_cast<size_t>(rows_) + 1);
+    assert(rowStart_.front() == 0);
+    assert(rowStart_.back() == static_cast<int64_t>(values_.size()));
+    assert(colIndex_.size() == values_.size());
+}
+
+template <class T>
+BasicCsrMatrix<T>::BasicCsrMatrix(const BasicCooMatrix<T>& coo)
+    : cols_(coo.cols()), rows_(coo.rows()) {
+    compress(rows_, coo.nonZeros(), coo.rowIndex().data(),
+             coo.colIndex().data(), coo.values().data(),
+             &rowStart_, &colIndex_, &values_);
+}
+
+template <class T>
+BasicCsrMatrix<T>::BasicCsrMatrix(const BasicCscMatrix<T>& csc)
+    : cols_(csc.cols()), rows_(csc.rows()) {
+    vector<int> col = expand(csc.colStart());
+    compress(rows_, csc.nonZeros(), csc.rowIndex().data(), col.data(),
+             csc.values().data(), &rowStart_, &colIndex_, &values_);
+}
+
+template <class T>
+BasicCsrMatrix<T>::BasicCsrMatrix(const BasicMatrix<T>& dense)
+    : cols_(dense.cols()), rows_(dense.rows()) {
+    fromDense(dense, true, &rowStart_, &colIndex_, &values_);
+}
+
+template <class T>
+T BasicCsrMatrix<T>::at(int i, int j) const {
+    assert(0 <= i && i < rows_ && 0 <= j && j < cols_);
+    return find(rowStart_, colIndex_, values_, i, j);
+}
+
+template <class T>
+BasicMatrix<T> BasicCsrMatrix<T>::toDense() const {
+    BasicMatrix<T> dense(cols_, rows_);
+    for (int i = 0; i < rows_; i++) {
+        for (int64_t k = rowStart_[i]; k < rowStart_[i + 1]; k++) {
+            dense.at(i, colIndex_[k]) = values_[k];
+        }
+    }
+    return dense;
+}
+
+template <class T>
+BasicCscMatrix<T> BasicCsrMatrix<T>::transposed() const {
+    return BasicCscMatrix<T>(rows_, cols_, rowStart_, colIndex_, values_);
+}
+
+//
+// CSC
+//
+template <class T>
+BasicCscMatrix<T>::BasicCscMatrix(int cols, int rows)
+    : colStart_(cols + 1, 0), cols_(cols), rows_(rows) {
+}
+
+template <class T>
+BasicCscMatrix<T>::BasicCscMatrix(int cols, int rows,
+                                  vector<int64_t> colStart,
+                                  vector<int> rowIndex, vector<T> values)
+    : colStart_(std::move(colStart)), rowIndex_(std::move(rowIndex)),
+      values_(std::move(values)), cols_(cols), rows_(rows) {
+    assert(colStart_.size() == static_cast<size_t>(cols_) + 1);
+    assert(colStart_.front() == 0);
+    assert(colStart_.back() == static_cast<int64_t>(values_.size()));
+    assert(rowIndex_.size() == values_.size());
+}
+
+template <class T>
+BasicCscMatrix<T>::BasicCscMatrix(const BasicCooMatrix<T>& coo)
+    : cols_(coo.cols()), rows_(coo.rows()) {
+    compress(cols_, coo.nonZeros(), coo.colIndex().data(),
+             coo.rowIndex().data(), coo.values().data(),
+             &colStart_, &rowIndex_, &values_);
+}
+
+template <class T>
+BasicCscMatrix<T>::BasicCscMatrix(const BasicCsrMatrix<T>& csr)
+    : cols_(csr.cols()), rows_(csr.rows()) {
+    vector<int> row = expand(csr.rowStart());
+    compress(cols_, csr.nonZeros(), csr.colIndex().data(), row.data(),
+             csr.values().data(), &colStart_, &rowIndex_, &values_);
+}
+
+template <class T>
+BasicCscMatrix<T>::BasicCscMatrix(const BasicMatrix<T>& dense)
+    : cols_(dense.cols()), rows_(dense.rows()) {
+    fromDense(dense, false, &colStart_, &rowIndex_, &values_);
+}
+
+template <class T>
+T BasicCscMatrix<T>::at(int i, int j) const {
+    assert(0 <= i && i < rows_ && 0 <= j && j < cols_);
+    return find(colStart_, rowIndex_, values_, j, i);
+}
+
+template <class T>
+BasicMatrix<T> BasicCscMatrix<T>::toDense() const {
+    BasicMatrix<T> dense(cols_, rows_);
+    for (int j = 0; j < cols_; j++) {
+        for (int64_t k = colStart_[j]; k < colStart_[j + 1]; k++) {
+            dense.at(rowIndex_[k], j) = values_[k];
+        }
+    }
+    return dense;
+}
+
+template <class T>
+BasicCsrMatrix<T> BasicCscMatrix<T>::transposed() const {
+    return BasicCsrMatrix<T>(rows_, cols_, colStart_, rowIndex_, values_);
+}
+
+//
+// Products
+//
+template <class T>
+BasicVector<T> operator *(const BasicCsrMatrix<T>& a,
+                          const BasicVector<T>& x) {
+    assert(a.cols() == x.dims());
+    BasicVector<T> y(a.rows());
+    const T* xp = x.ptr();
+    T* yp = y.ptr();
+
+    if (!runParallel(static_cast<int64_t>(a.nonZeros()) + a.rows())) {
+        csrRowsTimesVector(a, xp, yp, 0, a.rows());
+        return y;
+    }
+
+    int parts = 4 * ThreadPool::global().threads();
+    vector<int> bounds = balancedRanges(a.rowStart(), parts);
+    ThreadPool::global().parallelFor(parts,
+        [&a, xp, yp, &bounds](int begin, int end) {
+            for (int t = begin; t < end; t++) {
+                csrRowsTimesVector(a, xp, yp, bounds[t], bounds[t + 1]);
+            }
+        });
+    return y;
+}
+
+template <class T>
+BasicMatrix<T> operator *(const BasicCsrMatrix<T>& a,
+                          const BasicMatrix<T>& b) {
+    assert(a.cols() == b.rows());
+    int n = b.cols();
+    BasicMatrix<T> c(n, a.rows());
+    const T* bp = b.ptr();
+    T* cp = c.ptr();
+
+    if (!runParallel(static_cast<int64_t>(a.nonZeros()) * n)) {
+        csrRowsTimesMatrix(a, bp, cp, n, 0, a.rows());
+        return c;
+    }
+
+    int parts = 4 * ThreadPool::global().threads();
+    vector<int> bounds = balancedRanges(a.rowStart(), parts);
+    ThreadPool::global().parallelFor(parts,
+        [&a, bp, cp, n, &bounds](int begin, int end) {
+            for (int t = begin; t < end; t++) {
+                csrRowsTimesMatrix(a, bp, cp, n, bounds[t], bounds[t + 1]);
+            }
+        });
+    return c;
+}
+
+template <class T>
+BasicVector<T> operator *(const BasicCscMatrix<T>& a,
+                          const BasicVector<T>& x) {
+    assert(a.cols() == x.dims());
+    BasicVector<T> y(a.rows());
+    const T* xp = x.ptr();
+
+    if (!runParallel(static_cast<int64_t>(a.nonZeros()) + a.cols())) {
+        cscColsTimesVector(a, xp, y.ptr(), 0, a.cols());
+        return y;
+    }
+
+    // Columns scatter into all of y: every part sums into its own
+    // vector, and the partial vectors are added up at the end.
+    int parts = ThreadPool::global().threads();
+    vector<int> bounds = balancedRanges(a.colStart(), parts);
+    vector<BasicVector<T> > partial(parts - 1, BasicVector<T>(a.rows()));
+    T* yp = y.ptr();
+    ThreadPool::global().parallelFor(parts,
+        [&a, xp, yp, &bounds, &partial](int begin, int end) {
+            for (int t = begin; t < end; t++) {
+                T* out = t == 0 ? yp : partial[t - 1].ptr();
+                cscColsTimesVector(a, xp, out, bounds[t], bounds[t + 1]);
+            }
+        });
+    for (size_t t = 0; t < partial.size(); t++) {
+        kernels::add(yp, partial[t].ptr(), yp, a.rows());
+    }
+    return y;
+}
+
+template <class T>
+BasicMatrix<T> operator *(const BasicCscMatrix<T>& a,
+                          const BasicMatrix<T>& b) {
+    assert(a.cols() == b.rows());
+    int n = b.cols();
+    BasicMatrix<T> c(n, a.rows());
+    const T* bp = b.ptr();
+    T* cp = c.ptr();
+
+    // Columns of a scatter into all rows of c, so the parallel split is
+    // over the columns of b and c instead.
+    int tiles = std::min(4 * ThreadPool::global().threads(),
+                         n / kMinTileCols);
+    if (tiles < 2 || !runParallel(static_cast<int64_t>(a.nonZeros()) * n)) {
+        cscTimesMatrixCols(a, bp, cp, n, 0, n);
+        return c;
+    }
+
+    ThreadPool::global().parallelFor(tiles,
+        [&a, bp, cp, n, tiles](int begin, int end) {
+            for (int t = begin; t < end; t++) {
+                cscTimesMatrixCols(a, bp, cp, n,
+                                   static_cast<int>(
+                                       static_cast<int64_t>(n) * t / tiles),
+                                   static_cast<int>(
+                                       static_cast<int64_t>(n) * (t + 1) /
+                                       tiles));
+            }
+        });
+    return c;
+}
+
+template <class T>
+BasicVector<T> operator *(const BasicCooMatrix<T>& a,
+                          const BasicVector<T>& x) {
+    assert(a.cols() == x.dims());
+    BasicVector<T> y(a.rows());
+    const int* row = a.rowIndex().data();
+    const int* col = a.colIndex().data();
+    const T* value = a.values().data();
+    for (size_t k = 0; k < a.nonZeros(); k++) {
+        y.at(row[k]) += value[k] * x.at(col[k]);
+    }
+    return y;
+}
+
+#define ML_INSTANTIATE_SPARSE(T)                                             \
+    template class BasicCooMatrix<T>;                                        \
+    template class BasicCsrMatrix<T>;                                        \
+    template class BasicCscMatrix<T>;                                        \
+    template BasicVector<T> operator *(const BasicCsrMatrix<T>&,             \
+                                       const BasicVector<T>&);               \
+    template BasicMatrix<T> operator *(const BasicCsrMatrix<T>&,             \
+                                       const BasicMatrix<T>&);               \
+    template BasicVector<T> operator *(const BasicCscMatrix<T>&,             \
+                                       const BasicVector<T>&);               \
+    template BasicMatrix<T> operator *(const BasicCscMatrix<T>&,             \
+                                       const BasicMatrix<T>&);               \
+    template BasicVector<T> operator *(const BasicCooMatrix<T>&,             \
+                                       const BasicVector<T>&);
+
+ML_INSTANTIATE_SPARSE(double)
+ML_INSTANTIATE_SPARSE(float)
@@ -0,0 +1,145 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/storage.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+#include <utility>
+
+#include "ml/allocator.h"
+#include "ml/scalar.h"
+
+namespace {
+
+template <class T>
+T* allocateBuffer(Allocator* allocator, size_t size) {
+    return static_cast<T*>(allocator->allocate(size * sizeof(T)));
+}
+
+}  // namespace
+
+template <class T>
+BasicStorage<T>::BasicStorage()
+    : data_(NULL), size_(0), capacity_(0), allocator_(NULL) {
+}
+
+template <class T>
+BasicStorage<T>::BasicStorage(size_t size, T value)
+    : data_(NULL), size_(size), capacity_(size), allocator_(NULL) {
+    if (size_ > 0) {
+        allocator_ = defaultAllocator();
+        data_ = allocateBuffer<T>(allocator_, size_);
+        std::uninitialized_fill(data_, data_ + size_, value);
+    }
+}
+
+template <class T>
+BasicStorage<T>::BasicStorage(T* data, size_t size,
+                              std::shared_ptr<void> owner)
+    : data_(data), size_(size), capacity_(size), allocator_(NULL),
+      owner_(owner) {
+}
+
+template <class T>
+BasicStorage<T>::BasicStorage(const BasicStorage& storage)
+    : data_(NULL), size_(storage.size_), capacity_(storage.size_),
+      allocator_(NULL) {
+    if (size_ > 0) {
+        allocator_ = defaultAllocator();
+        data_ = allocateBuffer<T>(allocator_, size_);
+        memcpy(data_, storage.data_, size_ * sizeof(T));
+    }
+}
+
+template <class T>
+BasicStorage<T>::BasicStorage(BasicStorage&& storage) noexcept  // NOLINT
+    : data_(storage.data_), size_(storage.size_),
+      capacity_(storage.capacity_), allocator_(storage.allocator_),
+      owner_(std::move(storage.owner_)) {
+    storage.data_ = NULL;
+    storage.size_ = 0;
+    storage.capacity_ = 0;
+    storage.allocator_ = NULL;
+}
+
+template <class T>
+BasicStorage<T>::~BasicStorage() {
+    release();
+}
+
+template <class T>
+BasicStorage<T>& BasicStorage<T>::operator =(const BasicStorage& storage) {
+    if (this != &storage) {
+        resize(storage.size_);
+        if (size_ > 0) {
+            memcpy(data_, storage.data_, size_ * sizeof(T));
+        }
+    }
+
+    return *this;
+}
+
+template <class T>
+BasicStorage<T>& BasicStorage<T>::operator =(
+        BasicStorage&& storage) noexcept {  // NOLINT(build/c++11)
+    if (external() && storage.size_ <= capacity_) {
+        return *this = static_cast<const BasicStorage&>(storage);
+    }
+    if (this != &storage) {
+        release();
+        data_ = storage.data_;
+        size_ = storage.size_;
+        capacity_ = storage.capacity_;
+        allocator_ = storage.allocator_;
+        owner_ = std::move(storage.owner_);
+        storage.data_ = NULL;
+        storage.size_ = 0;
+        storage.capacity_ = 0;
+        storage.allocator_ = NULL;
+    }
+
+    return *this;
+}
+
+template <class T>
+void BasicStorage<T>::resize(size_t size) {
+    if (size <= capacity_) {
+        if (size > size_) {
+            std::uninitialized_fill(data_ + size_, data_ + size, T());
+        }
+        size_ = size;
+        return;
+    }
+
+    Allocator* allocator = defaultAllocator();
+    T* data = allocateBuffer<T>(allocator, size);
+    if (size_ > 0) {
+        memcpy(data, data_, size_ * sizeof(T));
+    }
+    std::uninitialized_fill(data + size_, data + size, T());
+
+    release();
+    data_ = data;
+    size_ = size;
+    capacity_ = size;
+    allocator_ = allocator;
+}
+
+template <class T>
+void BasicStorage<T>::release() {
+    if (owner_ == NULL && data_ != NULL) {
+        allocator_->deallocate(data_, capacity_ * sizeof(T));
+    }
+    owner_.reset();
+    data_ = NULL;
+    size_ = 0;
+    capacity_ = 0;
+    allocator_ = NULL;
+}
+
+template class BasicStorage<double>;
+template class BasicStorage<float>;
+template class BasicStorage<int8_t>;
+template class BasicStorage<BFloat16>;
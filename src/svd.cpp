@@ -0,0 +1,350 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/svd.h"
+
+#include <assert.h>
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ml/eigen.h"
+#include "ml/qr.h"
+#include "ml/thread_pool.h"
+#include "src/simd.h"
+#include "src/transpose.h"
+
+using std::min;
+using std::vector;
+
+namespace {
+
+// Jacobi sweeps allowed; they usually number fewer than ten.
+const int kMaxSweeps = 60;
+
+// Row pairs rotated by one task.
+const int kPairsPerTask = 4;
+
+// x := c x - s y, y := s x + c y for rows x and y of n elements.
+template <class T>
+void rotate(int n, T c, T s, T* x, T* y) {
+    for (int i = 0; i < n; i++) {
+        T a = x[i];
+        x[i] = c * a - s * y[i];
+        y[i] = s * a + c * y[i];
+    }
+}
+
+// Makes the n rows of the n x n matrix x orthogonal by one-sided
+// Jacobi rotations, applying them to the rows of wt too when it is not
+// NULL. Every round of a sweep pairs each row with another by the
+// round-robin schedule of a tournament and rotates the pairs in
+// parallel; a sweep that rotates no pair ends the iteration. Squared
+// row lengths are computed once per sweep and updated by each
+// rotation, unless it shrinks a row enough to lose their accuracy.
+template <class T>
+void orthogonalizeRows(int n, T* x, T* wt) {
+    const T tolerance = sqrt(T(n)) * std::numeric_limits<T>::epsilon();
+    int players = n + n % 2;
+    int pairs = players / 2;
+    vector<int> rotated(pairs);
+    vector<T> norms(n);
+    for (int sweep = 0; sweep < kMaxSweeps; sweep++) {
+        for (int i = 0; i < n; i++) {
+            norms[i] = T(kernels::sumSquares(x + static_cast<size_t>(i) * n,
+                                             n));
+        }
+        bool converged = true;
+        for (int round = 0; round < players - 1; round++) {
+            ThreadPool::global().parallelFor(pairs,
+                [n, x, wt, tolerance, players, round, &rotated,
+                 &norms](int begin, int end) {
+                    for (int slot = begin; slot < end; slot++) {
+                        int p = round;
+                        int q = players - 1;
+                        if (slot > 0) {
+                            p = (round + slot) % (players - 1);
+                            q = (round - slot + players - 1) % (players - 1);
+                        }
+                        rotated[slot] = 0;
+                        if (p >= n || q >= n) {
+                            continue;
+                        }
+                        T* xp = x + static_cast<size_t>(p) * n;
+                        T* xq = x + static_cast<size_t>(q) * n;
+                        T alpha = norms[p];
+                        T beta = norms[q];
+                        T gamma = T(kernels::dot(xp, xq, n));
+                        if (!(fabs(gamma) > tolerance * sqrt(alpha) *
+                                            sqrt(beta))) {
+                            continue;
+                        }
+
+                        // The rotation that makes the pair orthogonal,
+                        // by its smaller angle.
+                        T zeta = (beta - alpha) / (2 * gamma);
+                        T t = copysign(T(1), zeta) /
+                              (fabs(zeta) + hypot(T(1), zeta));
+                        T c = 1 / sqrt(1 + t * t);
+                        T s = c * t;
+                        rotate(n, c, s, xp, xq);
+                        if (wt != NULL) {
+                            rotate(n, c, s, wt + static_cast<size_t>(p) * n,
+                                   wt + static_cast<size_t>(q) * n);
+                        }
+                        norms[p] = alpha - t * gamma;
+                        norms[q] = beta + t * gamma;
+                        if (norms[p] < alpha / 16) {
+                            norms[p] = T(kernels::sumSquares(xp, n));
+                        }
+                        if (norms[q] < beta / 16) {
+                            norms[q] = T(kernels::sumSquares(xq, n));
+                        }
+                        rotated[slot] = 1;
+                    }
+                }, kPairsPerTask);
+            for (int slot = 0; slot < pairs; slot++) {
+                converged = converged && !rotated[slot];
+            }
+        }
+        if (converged) {
+            return;
+        }
+    }
+    throw std::runtime_error("svd: Jacobi sweeps did not converge");
+}
+
+// Fills the zero rows of the n x n matrix x, whose other rows are
+// orthonormal, with unit vectors orthogonal to all of them: the unit
+// coordinate vectors, orthogonalized twice against the rows so far,
+// that keep the most of their length.
+template <class T>
+void completeBasis(int n, T* x) {
+    vector<int> missing;
+    for (int i = 0; i < n; i++) {
+        const T* xi = x + static_cast<size_t>(i) * n;
+        if (kernels::sumSquares(xi, n) == 0) {
+            missing.push_back(i);
+        }
+    }
+    int candidate = 0;
+    for (size_t s = 0; s < missing.size(); s++) {
+        T* xm = x + static_cast<size_t>(missing[s]) * n;
+        for (; candidate < n; candidate++) {
+            std::fill(xm, xm + n, T(0));
+            xm[candidate] = 1;
+            for (int pass = 0; pass < 2; pass++) {
+                for (int i = 0; i < n; i++) {
+                    const T* xi = x + static_cast<size_t>(i) * n;
+                    if (xi != xm) {
+                        T projection = T(kernels::dot(xi, xm, n));
+                        kernels::axpy(-projection, xi, xm, xm, n);
+                    }
+                }
+            }
+            T norm = sqrt(T(kernels::sumSquares(xm, n)));
+            if (norm > T(0.5)) {
+                kernels::scale(1 / norm, xm, xm, n);
+                candidate++;
+                break;
+            }
+        }
+    }
+}
+
+// The SVD of the m x n matrix a, m >= n. With A = Q R, the columns of
+// R W are made orthogonal, R W = U_R diag(s), so that A = (Q U_R)
+// diag(s) W^T. W starts as the eigenvectors of R^T R, which leaves the
+// columns orthogonal up to rounding magnified by the condition of R;
+// the Jacobi rotations that follow correct that in a sweep or two and
+// recover the small singular values to high relative accuracy.
+template <class T>
+void decompose(const BasicMatrix<T>& a, SvdVectors vectors,
+               BasicMatrix<T>* u, BasicVector<T>* s, BasicMatrix<T>* v) {
+    int m = a.rows();
+    int n = a.cols();
+    BasicQr<T> qr(a);
+    BasicMatrix<T> r = qr.r();
+    BasicMatrix<T> rt = r.transposed();
+    BasicSymmetricEigen<T> gram(rt * r);
+
+    // Rows of W^T by descending eigenvalue, and X = W^T R^T, whose rows
+    // are the columns of R W.
+    BasicMatrix<T> wt(n, n);
+    kernels::transpose(n, n, gram.vectors().ptr(), n, wt.ptr(), n);
+    for (int i = 0; i < n / 2; i++) {
+        std::swap_ranges(&wt.at(i, 0), &wt.at(i, 0) + n,
+                         &wt.at(n - 1 - i, 0));
+    }
+    BasicMatrix<T> x = wt * rt;
+    orthogonalizeRows(n, x.ptr(), vectors == kSvdNone ? NULL : wt.ptr());
+
+    vector<T> lengths(n);
+    vector<int> order(n);
+    for (int i = 0; i < n; i++) {
+        lengths[i] = sqrt(T(kernels::sumSquares(&x.at(i, 0), n)));
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&lengths](int i, int j) {
+                         return lengths[i] > lengths[j];
+                     });
+    *s = BasicVector<T>(n);
+    for (int i = 0; i < n; i++) {
+        s->at(i) = lengths[order[i]];
+    }
+    if (vectors == kSvdNone) {
+        return;
+    }
+
+    // U_R^T and W^T in descending order.
+    BasicMatrix<T> urt(n, n);
+    BasicMatrix<T> sorted(n, n);
+    for (int i = 0; i < n; i++) {
+        if (lengths[order[i]] > 0) {
+            kernels::scale(1 / lengths[order[i]], &x.at(order[i], 0),
+                           &urt.at(i, 0), n);
+        }
+        const T* wi = &wt.at(order[i], 0);
+        std::copy(wi, wi + n, &sorted.at(i, 0));
+    }
+    completeBasis(n, urt.ptr());
+    *v = BasicMatrix<T>(n, n);
+    kernels::transpose(n, n, sorted.ptr(), n, v->ptr(), n);
+
+    int cols = vectors == kSvdFull ? m : n;
+    *u = BasicMatrix<T>(cols, m);
+    kernels::transpose(n, n, urt.ptr(), n, u->ptr(), cols);
+    for (int i = n; i < cols; i++) {
+        u->at(i, i) = 1;
+    }
+    qr.applyQInPlace(u);
+}
+
+// Products of the randomized SVD with a dense A.
+template <class T>
+class DenseProducts {
+ public:
+    explicit DenseProducts(const BasicMatrix<T>& a) : a_(a) {}
+
+    int rows() const { return a_.rows(); }
+    int cols() const { return a_.cols(); }
+    // A X and Y^T A.
+    BasicMatrix<T> times(const BasicMatrix<T>& x) const { return a_ * x; }
+    BasicMatrix<T> leftTimes(const BasicMatrix<T>& y) const {
+        return BasicMatrix<T>(y.transposed()) * a_;
+    }
+
+ private:
+    const BasicMatrix<T>& a_;
+};
+
+// The same with a CSR A, and A^T as CSC for Y^T A = (A^T Y)^T.
+template <class T>
+class SparseProducts {
+ public:
+    explicit SparseProducts(const BasicCsrMatrix<T>& a)
+        : a_(a), at_(a.transposed()) {}
+
+    int rows() const { return a_.rows(); }
+    int cols() const { return a_.cols(); }
+    BasicMatrix<T> times(const BasicMatrix<T>& x) const { return a_ * x; }
+    BasicMatrix<T> leftTimes(const BasicMatrix<T>& y) const {
+        return BasicMatrix<T>((at_ * y).transposed());
+    }
+
+ private:
+    const BasicCsrMatrix<T>& a_;
+    BasicCscMatrix<T> at_;
+};
+
+template <class T>
+BasicMatrix<T> orthonormalBasis(const BasicMatrix<T>& y) {
+    return BasicQr<T>(y).q();
+}
+
+template <class T, class Products>
+BasicSvd<T> randomized(const Products& a, int k, int oversampling,
+                       int powerIterations, unsigned seed) {
+    int m = a.rows();
+    int n = a.cols();
+    assert(k > 0 && k <= min(m, n) && oversampling >= 0);
+    int l = min(k + oversampling, min(m, n));
+
+    BasicMatrix<T> omega(l, n);
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> normal;
+    for (size_t i = 0; i < omega.size(); i++) {
+        omega.ptr()[i] = T(normal(generator));
+    }
+    BasicMatrix<T> q = orthonormalBasis(a.times(omega));
+    for (int iteration = 0; iteration < powerIterations; iteration++) {
+        BasicMatrix<T> z = orthonormalBasis(
+            BasicMatrix<T>(a.leftTimes(q).transposed()));
+        q = orthonormalBasis(a.times(z));
+    }
+
+    // Q^T A = Ub S V^T, so A ~ (Q Ub) S V^T.
+    BasicSvd<T> small(a.leftTimes(q));
+    BasicMatrix<T> u = q * BasicMatrix<T>(small.u().block(0, 0, l, k));
+    BasicVector<T> s(k);
+    std::copy(small.singularValues().ptr(),
+              small.singularValues().ptr() + k, s.ptr());
+    BasicMatrix<T> v = small.v().block(0, 0, n, k);
+    return BasicSvd<T>(std::move(u), std::move(s), std::move(v));
+}
+
+}  // namespace
+
+template <class T>
+BasicSvd<T>::BasicSvd(const BasicMatrix<T>& a, SvdVectors vectors)
+    : u_(0, 0), singularValues_(0), v_(0, 0) {
+    // NaN would pass through the QR and the rotations unnoticed.
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!isfinite(a.ptr()[i])) {
+            throw std::runtime_error("svd: matrix has non-finite elements");
+        }
+    }
+    if (a.rows() >= a.cols()) {
+        decompose(a, vectors, &u_, &singularValues_, &v_);
+    } else {
+        decompose(BasicMatrix<T>(a.transposed()), vectors, &v_,
+                  &singularValues_, &u_);
+    }
+}
+
+template <class T>
+BasicSvd<T>::BasicSvd(BasicMatrix<T> u, BasicVector<T> singularValues,
+                      BasicMatrix<T> v)
+    : u_(std::move(u)), singularValues_(std::move(singularValues)),
+      v_(std::move(v)) {
+}
+
+template <class T>
+BasicSvd<T> randomizedSvd(const BasicMatrix<T>& a, int k, int oversampling,
+                          int powerIterations, unsigned seed) {
+    return randomized<T>(DenseProducts<T>(a), k, oversampling,
+                         powerIterations, seed);
+}
+
+template <class T>
+BasicSvd<T> randomizedSvd(const BasicCsrMatrix<T>& a, int k,
+                          int oversampling, int powerIterations,
+                          unsigned seed) {
+    return randomized<T>(SparseProducts<T>(a), k, oversampling,
+                         powerIterations, seed);
+}
+
+#define ML_INSTANTIATE_SVD(T)                                                \
+    template class BasicSvd<T>;                                              \
+    template BasicSvd<T> randomizedSvd(const BasicMatrix<T>&, int, int, int, \
+                                       unsigned);                            \
+    template BasicSvd<T> randomizedSvd(const BasicCsrMatrix<T>&, int, int,   \
+                                       int, unsigned);
+
+ML_INSTANTIATE_SVD(double)
+ML_INSTANTIATE_SVD(float)
@@ -0,0 +1,328 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "ml/thread_pool.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <exception>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+// Shared by the chunks of one parallelFor().
+struct ThreadPool::Loop {
+    const Body* body;
+    std::atomic<int> remaining;
+    // Set once a chunk throws; chunks not yet started are skipped.
+    std::atomic<bool> failed;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+};
+
+struct ThreadPool::Task {
+    Loop* loop;
+    int begin;
+    int end;
+};
+
+struct ThreadPool::Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::thread thread;
+};
+
+struct ThreadPool::State {
+    std::vector<Worker*> workers;
+    // Queued tasks across all deques; idle workers sleep while it is 0.
+    std::atomic<int> queued;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    bool stop;
+};
+
+namespace {
+
+// CPUs this process may run on, which a cpuset or taskset can limit
+// to fewer than the machine has.
+int hardwareThreads() {
+#if defined(__linux__)
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+        return CPU_COUNT(&set);
+    }
+#endif
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    return threads > 0 ? threads : 1;
+}
+
+#if defined(__linux__)
+// Lowest-numbered SMT sibling of cpu, cpu itself when unknown.
+int firstSibling(int cpu) {
+    char path[96];
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+             cpu);
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return cpu;
+    }
+    int first = cpu;
+    if (fscanf(file, "%d", &first) != 1) {
+        first = cpu;
+    }
+    fclose(file);
+    return first;
+}
+#endif
+
+// The CPUs of hardwareThreads() to pin workers to: one per physical
+// core first, then the SMT siblings sharing a core with an earlier one.
+std::vector<int> pinnableCpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return cpus;
+    }
+    std::vector<int> siblings;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &set)) {
+            continue;
+        }
+        int first = firstSibling(cpu);
+        if (first < cpu && first >= 0 && first < CPU_SETSIZE &&
+            CPU_ISSET(first, &set)) {
+            siblings.push_back(cpu);
+        } else {
+            cpus.push_back(cpu);
+        }
+    }
+    cpus.insert(cpus.end(), siblings.begin(), siblings.end());
+#endif
+    return cpus;
+}
+
+int defaultThreads() {
+    const char* env = getenv("ML_LIB_NUM_THREADS");
+    if (env != NULL && atoi(env) > 0) {
+        return atoi(env);
+    }
+    return hardwareThreads();
+}
+
+void pinToCpu(std::thread* thread, int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(thread->native_handle(), sizeof(set), &set);
+#else
+    (void)thread;
+    (void)cpu;
+#endif
+}
+
+// Taken only to create or replace the global pool; global() reads the
+// pointer without it.
+std::mutex globalMutex;
+std::atomic<ThreadPool*> globalPool(NULL);
+
+// Joins the global pool's workers at exit.
+struct GlobalPoolCleanup {
+    ~GlobalPoolCleanup() {
+        delete globalPool.exchange(NULL);
+    }
+} globalPoolCleanup;
+
+}  // namespace
+
+ThreadPool::ThreadPool(int threads) {
+    threads_ = threads > 0 ? threads : hardwareThreads();
+    state_ = new State();
+    state_->queued = 0;
+    state_->stop = false;
+
+    // The calling thread is the extra participant, so one thread fewer.
+    for (int i = 0; i < threads_ - 1; i++) {
+        state_->workers.push_back(new Worker());
+    }
+
+    // Pin only when every thread can get a CPU of its own within the
+    // affinity mask; the caller keeps the first one.
+    std::vector<int> cpus = pinnableCpus();
+    bool pin = threads_ <= static_cast<int>(cpus.size());
+    for (size_t i = 0; i < state_->workers.size(); i++) {
+        Worker* worker = state_->workers[i];
+        worker->thread = std::thread(&ThreadPool::workerLoop, this,
+                                     static_cast<int>(i));
+        if (pin) {
+            pinToCpu(&worker->thread, cpus[i + 1]);
+        }
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_->sleepMutex);
+        state_->stop = true;
+    }
+    state_->wakeUp.notify_all();
+
+    for (size_t i = 0; i < state_->workers.size(); i++) {
+        state_->workers[i]->thread.join();
+        delete state_->workers[i];
+    }
+    delete state_;
+}
+
+int ThreadPool::threads() const {
+    return threads_;
+}
+
+void ThreadPool::parallelFor(int count, const Body& body, int grain) {
+    if (count <= 0) {
+        return;
+    }
+
+    grain = std::max(grain, 1);
+    int workers = static_cast<int>(state_->workers.size());
+    // A few chunks per thread let stealing even out uneven chunks.
+    int chunks = std::min((count + grain - 1) / grain, 4 * threads_);
+    if (workers == 0 || chunks <= 1) {
+        body(0, count);
+        return;
+    }
+
+    Loop loop;
+    loop.body = &body;
+    loop.remaining = chunks;
+    loop.failed = false;
+    for (int c = 0; c < chunks; c++) {
+        Task task;
+        task.loop = &loop;
+        task.begin = static_cast<int>(static_cast<int64_t>(count) * c /
+                                      chunks);
+        task.end = static_cast<int>(static_cast<int64_t>(count) * (c + 1) /
+                                    chunks);
+
+        // Count the task before it becomes visible, so queued never
+        // drops below the number of tasks sitting in the deques.
+        state_->queued++;
+        Worker* worker = state_->workers[c % workers];
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->tasks.push_back(task);
+    }
+    {
+        // Pairs with the predicate check in workerLoop(): a worker is
+        // either still checking queued or already waiting.
+        std::lock_guard<std::mutex> lock(state_->sleepMutex);
+    }
+    state_->wakeUp.notify_all();
+
+    // Help out instead of blocking: this also drains tasks of loops
+    // nested inside our own chunks.
+    while (loop.remaining.load(std::memory_order_acquire) > 0) {
+        Task task;
+        if (stealTask(-1, &task)) {
+            runTask(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    // No chunk refers to loop any more, so the first exception can
+    // leave.
+    if (loop.error) {
+        std::rethrow_exception(loop.error);
+    }
+}
+
+bool ThreadPool::popTask(int worker, Task* task) {
+    Worker* self = state_->workers[worker];
+    std::lock_guard<std::mutex> lock(self->mutex);
+    if (self->tasks.empty()) {
+        return false;
+    }
+    *task = self->tasks.back();
+    self->tasks.pop_back();
+    state_->queued--;
+    return true;
+}
+
+bool ThreadPool::stealTask(int thief, Task* task) {
+    int workers = static_cast<int>(state_->workers.size());
+    for (int i = 1; i <= workers; i++) {
+        int victim = (thief + i + workers) % workers;
+        Worker* other = state_->workers[victim];
+        std::lock_guard<std::mutex> lock(other->mutex);
+        if (!other->tasks.empty()) {
+            *task = other->tasks.front();
+            other->tasks.pop_front();
+            state_->queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runTask(const Task& task) {
+    Loop* loop = task.loop;
+    if (!loop->failed.load(std::memory_order_relaxed)) {
+        try {
+            (*loop->body)(task.begin, task.end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(loop->errorMutex);
+            if (!loop->error) {
+                loop->error = std::current_exception();
+            }
+            loop->failed = true;
+        }
+    }
+    loop->remaining.fetch_sub(1, std::memory_order_release);
+}
+
+void ThreadPool::workerLoop(int worker) {
+    while (true) {
+        Task task;
+        if (popTask(worker, &task) || stealTask(worker, &task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(state_->sleepMutex);
+        while (!state_->stop && state_->queued.load() == 0) {
+            state_->wakeUp.wait(lock);
+        }
+        if (state_->stop && state_->queued.load() == 0) {
+            return;
+        }
+    }
+}
+
+ThreadPool& ThreadPool::global() {
+    ThreadPool* pool = globalPool.load(std::memory_order_acquire);
+    if (pool != NULL) {
+        return *pool;
+    }
+    std::lock_guard<std::mutex> lock(globalMutex);
+    pool = globalPool.load(std::memory_order_relaxed);
+    if (pool == NULL) {
+        pool = new ThreadPool(defaultThreads());
+        globalPool.store(pool, std::memory_order_release);
+    }
+    return *pool;
+}
+
+void ThreadPool::setGlobalThreads(int threads) {
+    std::lock_guard<std::mutex> lock(globalMutex);
+    delete globalPool.exchange(new ThreadPool(threads));
+}
@@ -0,0 +1,286 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "src/transpose.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "ml/thread_pool.h"
+#include "src/simd.h"
+
+using std::min;
+using std::swap;
+using std::vector;
+
+namespace kernels {
+
+namespace {
+
+// Recursion stops at kTile x kTile blocks, two of which fit in L1.
+const int kTile = 32;
+
+// Transposes with fewer elements than this stay on one thread.
+const double kParallelTranspose = 256.0 * 256.0;
+
+template <class T>
+struct MicroKernel {
+    // Transposes the kSize x kSize block at a into b.
+    typedef void (*Type)(const T* a, int lda, T* b, int ldb);
+};
+
+template <class T>
+void scalarBlock(int rows, int cols, const T* a, int lda, T* b, int ldb) {
+    for (int i = 0; i < rows; i++) {
+        const T* ai = a + static_cast<size_t>(i) * lda;
+        for (int j = 0; j < cols; j++) {
+            b[static_cast<size_t>(j) * ldb + i] = ai[j];
+        }
+    }
+}
+
+#if defined(ML_SIMD_X86)
+// 4 x 4 doubles: pairs are interleaved within 128-bit lanes, then the
+// lanes are exchanged.
+ML_TARGET_AVX2
+void microAvx2(const double* a, int lda, double* b, int ldb) {
+    __m256d r0 = _mm256_loadu_pd(a);
+    __m256d r1 = _mm256_loadu_pd(a + lda);
+    __m256d r2 = _mm256_loadu_pd(a + 2 * lda);
+    __m256d r3 = _mm256_loadu_pd(a + 3 * lda);
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(b, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(b + ldb, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(b + 2 * ldb, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(b + 3 * ldb, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+
+// 8 x 8 floats: the same in three rounds, 32, 64 and 128 bits wide.
+ML_TARGET_AVX2
+void microAvx2(const float* a, int lda, float* b, int ldb) {
+    __m256 r[8];
+    for (int i = 0; i < 8; i++) {
+        r[i] = _mm256_loadu_ps(a + i * lda);
+    }
+    __m256 t[8];
+    for (int i = 0; i < 8; i += 2) {
+        t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+    }
+    __m256 s[8];
+    for (int i = 0; i < 8; i += 4) {
+        s[i] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+        s[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+        s[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3],
+                                     _MM_SHUFFLE(1, 0, 1, 0));
+        s[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3],
+                                     _MM_SHUFFLE(3, 2, 3, 2));
+    }
+    for (int i = 0; i < 4; i++) {
+        _mm256_storeu_ps(b + i * ldb,
+                         _mm256_permute2f128_ps(s[i], s[i + 4], 0x20));
+        _mm256_storeu_ps(b + (i + 4) * ldb,
+                         _mm256_permute2f128_ps(s[i], s[i + 4], 0x31));
+    }
+}
+#endif  // ML_SIMD_X86
+
+// Micro-kernel size per type; 0 means no micro-kernel.
+template <class T>
+int microSize() {
+    return 0;
+}
+
+template <class T>
+typename MicroKernel<T>::Type microKernel() {
+    return 0;
+}
+
+#if defined(ML_SIMD_X86)
+template <>
+int microSize<double>() {
+    static const int size = activeIsa() >= kIsaAvx2 ? 4 : 0;
+    return size;
+}
+
+template <>
+MicroKernel<double>::Type microKernel<double>() {
+    return microAvx2;
+}
+
+template <>
+int microSize<float>() {
+    static const int size = activeIsa() >= kIsaAvx2 ? 8 : 0;
+    return size;
+}
+
+template <>
+MicroKernel<float>::Type microKernel<float>() {
+    return microAvx2;
+}
+#endif  // ML_SIMD_X86
+
+// Transposes a block of at most kTile x kTile elements.
+template <class T>
+void transposeTile(int rows, int cols, const T* a, int lda, T* b, int ldb) {
+    int size = microSize<T>();
+    if (size == 0) {
+        scalarBlock(rows, cols, a, lda, b, ldb);
+        return;
+    }
+
+    typename MicroKernel<T>::Type micro = microKernel<T>();
+    int fullRows = rows - rows % size;
+    int fullCols = cols - cols % size;
+    for (int i = 0; i < fullRows; i += size) {
+        for (int j = 0; j < fullCols; j += size) {
+            micro(a + static_cast<size_t>(i) * lda + j, lda,
+                  b + static_cast<size_t>(j) * ldb + i, ldb);
+        }
+    }
+    scalarBlock(rows, cols - fullCols, a + fullCols, lda,
+                b + static_cast<size_t>(fullCols) * ldb, ldb);
+    scalarBlock(rows - fullRows, fullCols,
+                a + static_cast<size_t>(fullRows) * lda, lda,
+                b + fullRows, ldb);
+}
+
+// Halves the longer side until the blocks fit in L1, whatever its
+// size; split points stay multiples of kTile.
+template <class T>
+void transposeRecursive(int rows, int cols, const T* a, int lda, T* b,
+                        int ldb) {
+    if (rows <= kTile && cols <= kTile) {
+        transposeTile(rows, cols, a, lda, b, ldb);
+    } else if (rows >= cols) {
+        int half = (rows / 2 + kTile - 1) / kTile * kTile;
+        transposeRecursive(half, cols, a, lda, b, ldb);
+        transposeRecursive(rows - half, cols,
+                           a + static_cast<size_t>(half) * lda, lda,
+                           b + half, ldb);
+    } else {
+        int half = (cols / 2 + kTile - 1) / kTile * kTile;
+        transposeRecursive(rows, half, a, lda, b, ldb);
+        transposeRecursive(rows, cols - half, a + half, lda,
+                           b + static_cast<size_t>(half) * ldb, ldb);
+    }
+}
+
+bool runParallel(int rows, int cols) {
+    return ThreadPool::global().threads() > 1 &&
+           static_cast<double>(rows) * cols >= kParallelTranspose;
+}
+
+// Exchanges the kTile blocks (bi, bj) and (bj, bi) of a square matrix,
+// transposing both; a diagonal block is transposed on its own.
+template <class T>
+void swapTiles(int n, T* a, int lda, int bi, int bj) {
+    int i0 = bi * kTile;
+    int j0 = bj * kTile;
+    int rows = min(kTile, n - i0);
+    int cols = min(kTile, n - j0);
+    T* upper = a + static_cast<size_t>(i0) * lda + j0;
+    if (bi == bj) {
+        for (int i = 0; i < rows; i++) {
+            for (int j = i + 1; j < cols; j++) {
+                swap(upper[static_cast<size_t>(i) * lda + j],
+                     upper[static_cast<size_t>(j) * lda + i]);
+            }
+        }
+        return;
+    }
+
+    T* lower = a + static_cast<size_t>(j0) * lda + i0;
+    T buffer[kTile * kTile];
+    transposeTile(rows, cols, upper, lda, buffer, kTile);
+    transposeTile(cols, rows, lower, lda, upper, lda);
+    for (int j = 0; j < cols; j++) {
+        std::copy(buffer + j * kTile, buffer + j * kTile + rows,
+                  lower + static_cast<size_t>(j) * lda);
+    }
+}
+
+}  // namespace
+
+template <class T>
+void transpose(int rows, int cols, const T* a, int lda, T* b, int ldb) {
+    if (!runParallel(rows, cols)) {
+        transposeRecursive(rows, cols, a, lda, b, ldb);
+        return;
+    }
+
+    // Each task writes whole rows of B, a strip of columns of A.
+    int strips = (cols + kTile - 1) / kTile;
+    ThreadPool::global().parallelFor(strips,
+        [rows, cols, a, lda, b, ldb](int begin, int end) {
+            int j0 = begin * kTile;
+            int j1 = min(end * kTile, cols);
+            transposeRecursive(rows, j1 - j0, a + j0, lda,
+                               b + static_cast<size_t>(j0) * ldb, ldb);
+        });
+}
+
+template <class T>
+void transposeSquare(int n, T* a, int lda) {
+    int tiles = (n + kTile - 1) / kTile;
+    // Row of tiles bi owns the pairs (bi, bj) with bj >= bi.
+    auto rowOfTiles = [n, a, lda, tiles](int begin, int end) {
+        for (int bi = begin; bi < end; bi++) {
+            for (int bj = bi; bj < tiles; bj++) {
+                swapTiles(n, a, lda, bi, bj);
+            }
+        }
+    };
+    if (!runParallel(n, n)) {
+        rowOfTiles(0, tiles);
+        return;
+    }
+    ThreadPool::global().parallelFor(tiles, rowOfTiles);
+}
+
+template <class T>
+void transposeInPlace(int rows, int cols, T* a) {
+    if (rows == cols) {
+        transposeSquare(rows, a, cols);
+        return;
+    }
+    if (rows <= 1 || cols <= 1) {
+        return;
+    }
+
+    // Element p = i*cols + j moves to j*rows + i, that is p*rows modulo
+    // size-1; the first and last elements stay. This runs on one thread:
+    // a few long cycles usually hold most elements, and finding cycle
+    // leaders without the bitmap costs more than the moves themselves.
+    int64_t last = static_cast<int64_t>(rows) * cols - 1;
+    vector<bool> moved(last + 1, false);
+    for (int64_t start = 1; start < last; start++) {
+        if (moved[start]) {
+            continue;
+        }
+        T carried = a[start];
+        int64_t p = start;
+        do {
+            int64_t next = p * rows % last;
+            swap(carried, a[next]);
+            moved[next] = true;
+            p = next;
+        } while (p != start);
+    }
+}
+
+#define ML_INSTANTIATE_TRANSPOSE(T)                                          \
+    template void transpose(int, int, const T*, int, T*, int);               \
+    template void transposeSquare(int, T*, int);                             \
+    template void transposeInPlace(int, int, T*);
+
+ML_INSTANTIATE_TRANSPOSE(double)
+ML_INSTANTIATE_TRANSPOSE(float)
+ML_INSTANTIATE_TRANSPOSE(int8_t)
+ML_INSTANTIATE_TRANSPOSE(BFloat16)
+
+}  // namespace kernels
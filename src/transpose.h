@@ -0,0 +1,27 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef SRC_TRANSPOSE_H_
+#define SRC_TRANSPOSE_H_
+
+#include "ml/scalar.h"
+
+namespace kernels {
+
+// B = A^T for row-major A (rows x cols) with leading dimension lda and
+// B (cols x rows) with leading dimension ldb. A and B must not overlap.
+template <class T>
+void transpose(int rows, int cols, const T* a, int lda, T* b, int ldb);
+
+// Transposes the n x n matrix at a, leading dimension lda, in place.
+template <class T>
+void transposeSquare(int n, T* a, int lda);
+
+// Transposes the contiguous rows x cols matrix at a in place into a
+// contiguous cols x rows one, following the cycles of the permutation.
+// Needs one bit of scratch per element instead of a second buffer.
+template <class T>
+void transposeInPlace(int rows, int cols, T* a);
+
+}  // namespace kernels
+
+#endif  // SRC_TRANSPOSE_H_
@@ -0,0 +1,248 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include "src/triangular.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "ml/thread_pool.h"
+#include "src/gemm.h"
+#include "src/simd.h"
+#include "src/transpose.h"
+
+using std::min;
+using std::vector;
+
+namespace kernels {
+
+namespace {
+
+// Rows solved directly before the rest of B is updated through GEMM.
+const int kBlock = 64;
+
+// Right-hand sides solved by one task.
+const int kColumnSlice = 256;
+
+// Substitution on one right-hand side: every row of T is a dot
+// product with the solved part of x.
+template <class T>
+void solveVector(Triangle triangle, Diagonal diagonal, int n, const T* t,
+                 int ldt, T* x, int incx) {
+    if (triangle == kLower) {
+        for (int i = 0; i < n; i++) {
+            const T* ti = t + static_cast<size_t>(i) * ldt;
+            T sum = x[i * incx];
+            if (incx == 1) {
+                sum -= dot(ti, x, i);
+            } else {
+                for (int p = 0; p < i; p++) {
+                    sum -= ti[p] * x[p * incx];
+                }
+            }
+            x[i * incx] = diagonal == kUnitDiagonal ? sum : sum / ti[i];
+        }
+        return;
+    }
+
+    for (int i = n - 1; i >= 0; i--) {
+        const T* ti = t + static_cast<size_t>(i) * ldt;
+        T sum = x[i * incx];
+        if (incx == 1) {
+            sum -= dot(ti + i + 1, x + i + 1, n - i - 1);
+        } else {
+            for (int p = i + 1; p < n; p++) {
+                sum -= ti[p] * x[p * incx];
+            }
+        }
+        x[i * incx] = diagonal == kUnitDiagonal ? sum : sum / ti[i];
+    }
+}
+
+// Substitution on columns [begin, end) of B, a row at a time: each
+// solved row is subtracted from the rows that depend on it.
+template <class T>
+void solveColumns(Triangle triangle, Diagonal diagonal, int n, const T* t,
+                  int ldt, T* b, int ldb, int begin, int end) {
+    int width = end - begin;
+    for (int s = 0; s < n; s++) {
+        int i = triangle == kLower ? s : n - 1 - s;
+        const T* ti = t + static_cast<size_t>(i) * ldt;
+        T* bi = b + static_cast<size_t>(i) * ldb + begin;
+        int first = triangle == kLower ? 0 : i + 1;
+        int last = triangle == kLower ? i : n;
+        for (int p = first; p < last; p++) {
+            if (ti[p] != T(0)) {
+                const T* bp = b + static_cast<size_t>(p) * ldb + begin;
+                axpy(-ti[p], bp, bi, bi, width);
+            }
+        }
+        if (diagonal == kNonUnitDiagonal) {
+            scale(T(1) / ti[i], bi, bi, width);
+        }
+    }
+}
+
+// T^T X = B: row i of T is column i of T^T, so once row i of X is
+// solved it is subtracted, scaled by row i of T, from the rows still to
+// be solved. A lower T is solved bottom up, an upper one top down.
+template <class T>
+void solveTransposedColumns(Triangle triangle, Diagonal diagonal, int n,
+                            const T* t, int ldt, T* b, int ldb, int begin,
+                            int end) {
+    int width = end - begin;
+    for (int s = 0; s < n; s++) {
+        int i = triangle == kLower ? n - 1 - s : s;
+        const T* ti = t + static_cast<size_t>(i) * ldt;
+        T* bi = b + static_cast<size_t>(i) * ldb + begin;
+        if (diagonal == kNonUnitDiagonal) {
+            scale(T(1) / ti[i], bi, bi, width);
+        }
+        int first = triangle == kLower ? 0 : i + 1;
+        int last = triangle == kLower ? i : n;
+        for (int p = first; p < last; p++) {
+            if (ti[p] != T(0)) {
+                T* bp = b + static_cast<size_t>(p) * ldb + begin;
+                axpy(-ti[p], bi, bp, bp, width);
+            }
+        }
+    }
+}
+
+template <class T>
+void solveTransposedVector(Triangle triangle, Diagonal diagonal, int n,
+                           const T* t, int ldt, T* x, int incx) {
+    if (incx != 1) {
+        solveTransposedColumns(triangle, diagonal, n, t, ldt, x, incx, 0,
+                               1);
+        return;
+    }
+    for (int s = 0; s < n; s++) {
+        int i = triangle == kLower ? n - 1 - s : s;
+        const T* ti = t + static_cast<size_t>(i) * ldt;
+        if (diagonal == kNonUnitDiagonal) {
+            x[i] /= ti[i];
+        }
+        if (triangle == kLower) {
+            axpy(-x[i], ti, x, x, i);
+        } else {
+            axpy(-x[i], ti + i + 1, x + i + 1, x + i + 1, n - i - 1);
+        }
+    }
+}
+
+template <class T>
+void solveBlock(Triangle triangle, Diagonal diagonal, bool transposed,
+                int n, int m, const T* t, int ldt, T* b, int ldb) {
+    int slices = (m + kColumnSlice - 1) / kColumnSlice;
+    auto columns = [triangle, diagonal, transposed, n, m, t, ldt, b,
+                    ldb](int begin, int end) {
+        int first = begin * kColumnSlice;
+        int last = min(end * kColumnSlice, m);
+        if (transposed) {
+            solveTransposedColumns(triangle, diagonal, n, t, ldt, b, ldb,
+                                   first, last);
+        } else {
+            solveColumns(triangle, diagonal, n, t, ldt, b, ldb, first,
+                         last);
+        }
+    };
+    if (slices == 1 || ThreadPool::global().threads() == 1) {
+        columns(0, slices);
+        return;
+    }
+    ThreadPool::global().parallelFor(slices, columns);
+}
+
+}  // namespace
+
+template <class T>
+void solveTriangular(Triangle triangle, Diagonal diagonal, int n, int m,
+                     const T* t, int ldt, T* b, int ldb) {
+    if (n == 0 || m == 0) {
+        return;
+    }
+    if (m == 1) {
+        solveVector(triangle, diagonal, n, t, ldt, b, ldb);
+        return;
+    }
+
+    if (triangle == kLower) {
+        for (int k = 0; k < n; k += kBlock) {
+            int kb = min(kBlock, n - k);
+            const T* tkk = t + static_cast<size_t>(k) * ldt + k;
+            T* bk = b + static_cast<size_t>(k) * ldb;
+            solveBlock(kLower, diagonal, false, kb, m, tkk, ldt, bk, ldb);
+            int below = n - k - kb;
+            if (below > 0) {
+                gemm(below, m, kb, T(-1), tkk + static_cast<size_t>(kb) * ldt,
+                     ldt, bk, ldb, T(1), bk + static_cast<size_t>(kb) * ldb,
+                     ldb);
+            }
+        }
+        return;
+    }
+
+    for (int end = n; end > 0; end -= kBlock) {
+        int k = std::max(0, end - kBlock);
+        int kb = end - k;
+        const T* tkk = t + static_cast<size_t>(k) * ldt + k;
+        T* bk = b + static_cast<size_t>(k) * ldb;
+        solveBlock(kUpper, diagonal, false, kb, m, tkk, ldt, bk, ldb);
+        if (k > 0) {
+            gemm(k, m, kb, T(-1), t + k, ldt, bk, ldb, T(1), b, ldb);
+        }
+    }
+}
+
+template <class T>
+void solveTriangularTransposed(Triangle triangle, Diagonal diagonal, int n,
+                               int m, const T* t, int ldt, T* b, int ldb) {
+    if (n == 0 || m == 0) {
+        return;
+    }
+    if (m == 1) {
+        solveTransposedVector(triangle, diagonal, n, t, ldt, b, ldb);
+        return;
+    }
+
+    // The GEMM updates need the off-diagonal blocks of T transposed.
+    vector<T> block(static_cast<size_t>(n) * kBlock);
+    if (triangle == kUpper) {
+        for (int k = 0; k < n; k += kBlock) {
+            int kb = min(kBlock, n - k);
+            const T* tkk = t + static_cast<size_t>(k) * ldt + k;
+            T* bk = b + static_cast<size_t>(k) * ldb;
+            solveBlock(kUpper, diagonal, true, kb, m, tkk, ldt, bk, ldb);
+            int below = n - k - kb;
+            if (below > 0) {
+                transpose(kb, below, tkk + kb, ldt, block.data(), kb);
+                gemm(below, m, kb, T(-1), block.data(), kb, bk, ldb, T(1),
+                     bk + static_cast<size_t>(kb) * ldb, ldb);
+            }
+        }
+        return;
+    }
+
+    for (int end = n; end > 0; end -= kBlock) {
+        int k = std::max(0, end - kBlock);
+        int kb = end - k;
+        const T* tk = t + static_cast<size_t>(k) * ldt;
+        T* bk = b + static_cast<size_t>(k) * ldb;
+        solveBlock(kLower, diagonal, true, kb, m, tk + k, ldt, bk, ldb);
+        if (k > 0) {
+            transpose(kb, k, tk, ldt, block.data(), kb);
+            gemm(k, m, kb, T(-1), block.data(), kb, bk, ldb, T(1), b, ldb);
+        }
+    }
+}
+
+#define ML_INSTANTIATE_TRIANGULAR(T)                                         \
+    template void solveTriangular(Triangle, Diagonal, int, int, const T*,    \
+                                  int, T*, int);                             \
+    template void solveTriangularTransposed(Triangle, Diagonal, int, int,    \
+                                            const T*, int, T*, int);
+
+ML_INSTANTIATE_TRIANGULAR(double)
+ML_INSTANTIATE_TRIANGULAR(float)
+
+}  // namespace kernels
@@ -0,0 +1,35 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef SRC_TRIANGULAR_H_
+#define SRC_TRIANGULAR_H_
+
+namespace kernels {
+
+enum Triangle {
+    kLower,
+    kUpper
+};
+
+enum Diagonal {
+    kNonUnitDiagonal,
+    // The diagonal is taken to be all ones and is never read.
+    kUnitDiagonal
+};
+
+// Solves T X = B in place of the row-major B (n x m, leading dimension
+// ldb), T being the lower or upper triangle of the row-major n x n
+// matrix at t (leading dimension ldt); the other triangle is not read.
+// Blocks of kTriangularBlock rows are solved directly and the rest of
+// B is updated through GEMM. Elements are double or float.
+template <class T>
+void solveTriangular(Triangle triangle, Diagonal diagonal, int n, int m,
+                     const T* t, int ldt, T* b, int ldb);
+
+// The same for T^T X = B, with T stored as above.
+template <class T>
+void solveTriangularTransposed(Triangle triangle, Diagonal diagonal, int n,
+                               int m, const T* t, int ldt, T* b, int ldb);
+
+}  // namespace kernels
+
+#endif  // SRC_TRIANGULAR_H_
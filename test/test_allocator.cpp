@@ -0,0 +1,162 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/allocator.h"
+#include "ml/linear_algebra.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <thread>  // NOLINT(build/c++11)
+
+static bool isAligned(const void* p, size_t alignment) {
+    return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+namespace {
+
+class CountingAllocator : public Allocator {
+ public:
+    CountingAllocator() : live(0), allocations(0) {}
+
+    void* allocate(size_t bytes) {
+        live += bytes;
+        allocations++;
+        return system.allocate(bytes);
+    }
+    void deallocate(void* p, size_t bytes) {
+        live -= bytes;
+        system.deallocate(p, bytes);
+    }
+
+    size_t live;
+    int allocations;
+
+ private:
+    AlignedAllocator system;
+};
+
+}  // namespace
+
+TEST(ML_ALLOCATOR, Buffers_Are_Cache_Line_Aligned) {
+    // Arrange
+    Vector small(1);
+    Vector odd(37, 1.0);
+    FloatMatrix floats(5, 3);
+    Int8Vector bytes(3);
+
+    // Act
+    Matrix sum = Matrix(7, 3, 1.0) + Matrix(7, 3, 2.0);
+
+    // Assert
+    EXPECT_TRUE(isAligned(small.ptr(), Allocator::kAlignment));
+    EXPECT_TRUE(isAligned(odd.ptr(), Allocator::kAlignment));
+    EXPECT_TRUE(isAligned(floats.ptr(), Allocator::kAlignment));
+    EXPECT_TRUE(isAligned(bytes.ptr(), Allocator::kAlignment));
+    EXPECT_TRUE(isAligned(sum.ptr(), Allocator::kAlignment));
+}
+
+TEST(ML_ALLOCATOR, Pool_Reuses_Freed_Buffers) {
+    // Arrange
+    PooledAllocator::trim();
+    const double* first;
+    {
+        Matrix mat(40, 40);
+        first = mat.ptr();
+    }
+    size_t cached = PooledAllocator::cachedBytes();
+
+    // Act
+    Matrix sameClass(41, 40);
+
+    // Assert
+    EXPECT_GE(cached, 40 * 40 * sizeof(double));
+    EXPECT_EQ(first, sameClass.ptr());
+    EXPECT_EQ(0u, PooledAllocator::cachedBytes());
+}
+
+TEST(ML_ALLOCATOR, Trim_Releases_Cached_Buffers) {
+    // Arrange
+    {
+        Vector a(1000), b(3000), c(20000);
+    }
+    EXPECT_GT(PooledAllocator::cachedBytes(), 0u);
+
+    // Act
+    PooledAllocator::trim();
+
+    // Assert
+    EXPECT_EQ(0u, PooledAllocator::cachedBytes());
+}
+
+TEST(ML_ALLOCATOR, Can_Plug_In_Allocator) {
+    // Arrange
+    CountingAllocator counting;
+    setDefaultAllocator(&counting);
+
+    // Act
+    Matrix* mat = new Matrix(10, 10, 1.0);
+    Matrix product = *mat * *mat;
+    size_t live = counting.live;
+    setDefaultAllocator(NULL);
+    Matrix other(10, 10);
+    delete mat;
+
+    // Assert
+    EXPECT_EQ(2 * 100 * sizeof(double), live);
+    EXPECT_EQ(2, counting.allocations);
+    EXPECT_EQ(100 * sizeof(double), counting.live);
+    EXPECT_DOUBLE_EQ(10.0, product.at(3, 4));
+}
+
+TEST(ML_ALLOCATOR, Large_Buffers_Are_Huge_Page_Aligned) {
+    // Arrange
+    AlignedAllocator allocator;
+    size_t bytes = 2 * AlignedAllocator::kHugePageBytes + 64;
+
+    // Act
+    void* p = allocator.allocate(bytes);
+
+    // Assert
+    EXPECT_TRUE(isAligned(p, AlignedAllocator::kHugePageBytes));
+    allocator.deallocate(p, bytes);
+}
+
+namespace {
+
+// Allocates from the pool when its thread exits: it is created before
+// the thread cache of the pool, so it is destroyed after it.
+struct LateAllocation {
+    static const size_t kBytes = 100;
+
+    ~LateAllocation() {
+        PooledAllocator pool;
+        block = pool.allocate(kBytes);
+    }
+
+    static void* block;
+};
+
+void* LateAllocation::block = NULL;
+
+}  // namespace
+
+TEST(ML_ALLOCATOR, Buffers_Outlive_Thread_Cache) {
+    // Arrange
+    std::thread exiting([]() {
+        static thread_local LateAllocation late;
+        (void)late;
+        Vector touch(3);
+    });
+    exiting.join();
+    PooledAllocator pool;
+
+    // Act: the buffer goes to this thread's list for 65 to 128 bytes.
+    pool.deallocate(LateAllocation::block, LateAllocation::kBytes);
+    void* reused = pool.allocate(128);
+
+    // Assert
+    EXPECT_EQ(LateAllocation::block, reused);
+    memset(reused, 0, 128);
+    pool.deallocate(reused, 128);
+}
@@ -0,0 +1,106 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/arena.h"
+#include "ml/linear_algebra.h"
+
+#include <stdint.h>
+
+#include <thread>  // NOLINT(build/c++11)
+
+TEST(ML_ARENA, Scope_Routes_Temporaries_To_Arena) {
+    // Arrange
+    Arena arena;
+    Matrix a(16, 16, 1.0);
+    Matrix persistent(16, 16);
+
+    // Act
+    {
+        AllocatorScope scope(&arena);
+        Matrix sum = a + 2.0*a;
+        Matrix product = sum * a;
+        EXPECT_EQ(2u, arena.liveBuffers());
+        EXPECT_GE(arena.usedBytes(), 2 * 16 * 16 * sizeof(double));
+        persistent = product;
+    }
+    size_t used = arena.usedBytes();
+    arena.reset();
+
+    // Assert
+    EXPECT_EQ(0u, arena.liveBuffers());
+    EXPECT_EQ(0u, used);
+    EXPECT_EQ(0u, arena.usedBytes());
+    EXPECT_DOUBLE_EQ(48.0, persistent.at(2, 3));
+}
+
+TEST(ML_ARENA, Reuses_Last_Freed_Buffer) {
+    // Arrange
+    Arena arena;
+    AllocatorScope scope(&arena);
+    Vector first(100);
+    const double* firstPtr = first.ptr();
+    const double* secondPtr;
+
+    // Act
+    {
+        Vector second(100);
+        secondPtr = second.ptr();
+    }
+    Vector third(100);
+
+    // Assert
+    EXPECT_NE(firstPtr, secondPtr);
+    EXPECT_EQ(secondPtr, third.ptr());
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(third.ptr()) %
+                  Allocator::kAlignment);
+}
+
+TEST(ML_ARENA, Reset_Merges_Chunks) {
+    // Arrange
+    Arena arena(1024);
+    {
+        AllocatorScope scope(&arena);
+        Vector a(100), b(100), c(100);
+    }
+    size_t reserved = arena.reservedBytes();
+
+    // Act
+    arena.reset();
+    {
+        AllocatorScope scope(&arena);
+        Vector a(100), b(100), c(100);
+        EXPECT_EQ(3u * 832, arena.usedBytes());
+    }
+
+    // Assert
+    EXPECT_EQ(3u * 1024, reserved);
+    EXPECT_EQ(reserved, arena.reservedBytes());
+}
+
+TEST(ML_ARENA, Scopes_Nest_Per_Thread) {
+    // Arrange
+    Arena outer, inner;
+    Allocator* global = defaultAllocator();
+    Allocator* otherThread = NULL;
+
+    // Act
+    {
+        AllocatorScope outerScope(&outer);
+        EXPECT_EQ(&outer, defaultAllocator());
+        {
+            AllocatorScope innerScope(&inner);
+            EXPECT_EQ(&inner, defaultAllocator());
+            AllocatorScope escape(NULL);
+            EXPECT_EQ(global, defaultAllocator());
+        }
+        EXPECT_EQ(&outer, defaultAllocator());
+        std::thread thread([&otherThread] {
+            otherThread = defaultAllocator();
+        });
+        thread.join();
+    }
+
+    // Assert
+    EXPECT_EQ(global, defaultAllocator());
+    EXPECT_EQ(global, otherThread);
+}
@@ -0,0 +1,174 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/batch.h"
+#include "ml/lu.h"
+#include "ml/thread_pool.h"
+#include "test/test_helpers.h"
+
+#include <math.h>
+
+#include <vector>
+
+// Matrix index of a batch; square ones are diagonally dominant, with
+// off-diagonal elements large enough that each picks its own pivots.
+template <class T>
+static BasicMatrix<T> batchElement(int index, int cols, int rows) {
+    BasicMatrix<T> a(cols, rows);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            a.at(i, j) = T(sin(index * 0.7 + i * 1.3 + j * 2.1));
+        }
+    }
+    if (cols == rows) {
+        for (int i = 0; i < rows; i++) {
+            a.at(i, (i + index) % cols) += T(2);
+        }
+    }
+    return a;
+}
+
+template <class T>
+static BasicMatrixBatch<T> filledBatch(int count, int cols, int rows,
+                                       int seed) {
+    BasicMatrixBatch<T> batch(count, cols, rows);
+    for (int index = 0; index < count; index++) {
+        batch.set(index, batchElement<T>(index + seed, cols, rows));
+    }
+    return batch;
+}
+
+TEST(ML_BATCH, Packs_And_Unpacks_Matrices) {
+    // Arrange
+    const int kCount = 11;
+    std::vector<double> matrices(kCount * 2 * 3);
+    for (size_t e = 0; e < matrices.size(); e++) {
+        matrices[e] = e;
+    }
+
+    // Act
+    MatrixBatch batch(kCount, 3, 2, matrices.data());
+    std::vector<double> unpacked(matrices.size());
+    batch.copyTo(unpacked.data());
+
+    // Assert
+    EXPECT_EQ(2, batch.groups());
+    EXPECT_EQ(2, batch.rows());
+    EXPECT_EQ(3, batch.cols());
+    EXPECT_EQ(matrices, unpacked);
+    EXPECT_EQ(5.0 * 6 + 4, batch.at(5, 1, 1));
+    EXPECT_EQ(5.0 * 6 + 4, batch.get(5).at(1, 1));
+    EXPECT_EQ(batch.group(1) + 1, &batch.at(MatrixBatch::kLanes + 1, 0, 0));
+}
+
+TEST(ML_BATCH, Multiplies_And_Adds_Each_Matrix) {
+    const int kShapes[][3] = {{4, 4, 4}, {5, 3, 7}, {1, 6, 1}, {32, 32, 32}};
+    for (const int* shape : kShapes) {
+        // Arrange: 37 is not a whole number of groups.
+        const int kCount = 37;
+        int m = shape[0], k = shape[1], n = shape[2];
+        MatrixBatch a = filledBatch<double>(kCount, k, m, 0);
+        MatrixBatch b = filledBatch<double>(kCount, n, k, 100);
+        MatrixBatch c(kCount, n, m);
+        MatrixBatch sum(kCount, k, m);
+
+        // Act
+        multiplyBatch(a, b, &c);
+        addBatch(a, a, &sum);
+
+        // Assert
+        for (int index = 0; index < kCount; index++) {
+            Matrix expected = a.get(index) * b.get(index);
+            EXPECT_LT(maxDifference(expected, c.get(index)), 1e-12 * k)
+                << m << " " << index;
+            Matrix doubled = a.get(index);
+            doubled *= 2;
+            EXPECT_EQ(0.0, maxDifference(doubled, sum.get(index)));
+        }
+    }
+}
+
+TEST(ML_BATCH, Solves_And_Inverts_Each_Matrix) {
+    const int kSizes[] = {1, 4, 5, 16};
+    for (int n : kSizes) {
+        // Arrange
+        const int kCount = 21;
+        MatrixBatch a = filledBatch<double>(kCount, n, n, 0);
+        MatrixBatch b = filledBatch<double>(kCount, 3, n, 50);
+        MatrixBatch x(kCount, 3, n);
+        MatrixBatch inverse(kCount, n, n);
+        bool singular[kCount];
+
+        // Act
+        int failures = solveBatch(a, b, &x, singular);
+        int inverseFailures = inverseBatch(a, &inverse);
+
+        // Assert
+        EXPECT_EQ(0, failures);
+        EXPECT_EQ(0, inverseFailures);
+        for (int index = 0; index < kCount; index++) {
+            EXPECT_FALSE(singular[index]);
+            Lu lu(a.get(index));
+            EXPECT_LT(maxDifference(lu.solve(b.get(index)), x.get(index)),
+                      1e-12) << n << " " << index;
+            Matrix identity = a.get(index) * inverse.get(index);
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++) {
+                    EXPECT_NEAR(i == j ? 1.0 : 0.0, identity.at(i, j), 1e-12);
+                }
+            }
+        }
+    }
+}
+
+TEST(ML_BATCH, Flags_Singular_Matrices) {
+    // Arrange: every third matrix has a zero column.
+    const int kCount = 30;
+    const int kDims = 6;
+    MatrixBatch a = filledBatch<double>(kCount, kDims, kDims, 0);
+    for (int index = 0; index < kCount; index += 3) {
+        for (int i = 0; i < kDims; i++) {
+            a.at(index, i, 2) = 0;
+        }
+    }
+    MatrixBatch zero(kCount, kDims, kDims);
+    MatrixBatch inverse(kCount, kDims, kDims);
+    bool singular[kCount];
+
+    // Act
+    int failures = inverseBatch(a, &inverse, singular);
+    int zeroFailures = inverseBatch(zero, &inverse);
+
+    // Assert
+    EXPECT_EQ(kCount / 3, failures);
+    EXPECT_EQ(kCount, zeroFailures);
+    for (int index = 0; index < kCount; index++) {
+        EXPECT_EQ(index % 3 == 0, singular[index]) << index;
+    }
+}
+
+TEST(ML_BATCH, Float_And_Threads_Agree) {
+    // Arrange
+    const int kCount = 1000;
+    FloatMatrixBatch a = filledBatch<float>(kCount, 5, 5, 0);
+    FloatMatrixBatch b = filledBatch<float>(kCount, 5, 5, 7);
+    FloatMatrixBatch serial(kCount, 5, 5);
+    FloatMatrixBatch parallel(kCount, 5, 5);
+    FloatMatrixBatch solved(kCount, 5, 5);
+
+    // Act
+    ThreadPool::setGlobalThreads(1);
+    multiplyBatch(a, b, &serial);
+    ThreadPool::setGlobalThreads(4);
+    multiplyBatch(a, b, &parallel);
+    int failures = solveBatch(a, serial, &solved);
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    EXPECT_EQ(0, failures);
+    for (int index = 0; index < kCount; index++) {
+        EXPECT_EQ(0.0, maxDifference(serial.get(index),
+                                       parallel.get(index)));
+        EXPECT_LT(maxDifference(b.get(index), solved.get(index)), 1e-4);
+    }
+}
@@ -0,0 +1,138 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/cholesky.h"
+#include "ml/thread_pool.h"
+#include "test/test_helpers.h"
+
+#include <math.h>
+
+#include <stdexcept>
+#include <vector>
+
+TEST(ML_CHOLESKY, Factor_Reproduces_Matrix) {
+    const int kSizes[] = {1, 5, 64, 150, 300};
+    for (int n : kSizes) {
+        // Arrange
+        Matrix a = spdMatrix<double>(n);
+
+        // Act
+        Cholesky cholesky(a);
+
+        // Assert
+        ASSERT_TRUE(cholesky.positiveDefinite()) << n;
+        const Matrix& l = cholesky.factor();
+        EXPECT_EQ(0.0, n > 1 ? l.at(0, n - 1) : 0.0);
+        EXPECT_LT(maxDifference(Matrix(l * Matrix(l.transposed())), a),
+                  1e-9 * n) << n;
+    }
+}
+
+TEST(ML_CHOLESKY, Solves_Systems) {
+    // Arrange
+    const int kDims = 130;
+    Matrix a = spdMatrix<double>(kDims);
+    Matrix x(3, kDims);
+    Vector v(kDims);
+    for (int i = 0; i < kDims; i++) {
+        v.at(i) = i % 4 - 1.5;
+        for (int j = 0; j < 3; j++) {
+            x.at(i, j) = (i * j) % 5 - 2.0;
+        }
+    }
+    FloatMatrix floatA = spdMatrix<float>(kDims);
+
+    // Act
+    Cholesky cholesky(a);
+    Matrix solved = cholesky.solve(Matrix(a * x));
+    Vector solvedVector = cholesky.solve(Vector(a * v));
+    Matrix inv = cholesky.inverse();
+    FloatCholesky floatCholesky(floatA);
+
+    // Assert
+    EXPECT_LT(maxDifference(solved, x), 1e-10);
+    for (int i = 0; i < kDims; i++) {
+        EXPECT_NEAR(v.at(i), solvedVector.at(i), 1e-10);
+    }
+    EXPECT_LT(maxDifference(Matrix(a * inv), Matrix::identity(kDims)),
+              1e-10);
+    EXPECT_NEAR(cholesky.logDeterminant(), floatCholesky.logDeterminant(),
+                1e-3 * fabs(cholesky.logDeterminant()));
+}
+
+TEST(ML_CHOLESKY, Rejects_Indefinite_Matrix) {
+    // Arrange
+    Matrix a = spdMatrix<double>(80);
+    a.at(70, 70) = -1;
+
+    // Act
+    Cholesky cholesky(a);
+
+    // Assert
+    EXPECT_FALSE(cholesky.positiveDefinite());
+    EXPECT_THROW(cholesky.solve(Vector(80, 1.0)), std::runtime_error);
+}
+
+TEST(ML_CHOLESKY, Updates_And_Downdates) {
+    // Arrange
+    const int kDims = 40;
+    Matrix a = spdMatrix<double>(kDims);
+    Matrix x(2, kDims);
+    for (int i = 0; i < kDims; i++) {
+        x.at(i, 0) = i % 3 - 1.0;
+        x.at(i, 1) = (i % 5) * 0.5;
+    }
+    Matrix updated = a + x * Matrix(x.transposed());
+    Vector huge(kDims, 100.0);
+
+    // Act
+    Cholesky cholesky(a);
+    cholesky.update(x);
+    Matrix afterUpdate = cholesky.factor();
+    bool downdated = cholesky.downdate(x);
+    bool rejected = cholesky.downdate(huge);
+
+    // Assert
+    EXPECT_LT(maxDifference(afterUpdate, Cholesky(updated).factor()), 1e-10);
+    EXPECT_TRUE(downdated);
+    EXPECT_LT(maxDifference(cholesky.factor(), Cholesky(a).factor()), 1e-10);
+    EXPECT_FALSE(rejected);
+    EXPECT_LT(maxDifference(cholesky.factor(), Cholesky(a).factor()), 1e-10);
+}
+
+TEST(ML_CHOLESKY, Solves_Batches) {
+    // Arrange
+    const int kCount = 50;
+    const int kDims = 6;
+    const int kRhs = 2;
+    std::vector<double> a, b;
+    std::vector<Matrix> expected;
+    for (int m = 0; m < kCount; m++) {
+        Matrix am = spdMatrix<double>(kDims);
+        am.at(0, 0) += m;
+        if (m == 7) {
+            am.at(3, 3) = -am.at(3, 3);
+        }
+        Matrix bm(kRhs, kDims, m + 1.0);
+        expected.push_back(m == 7 ? bm : Cholesky(am).solve(bm));
+        a.insert(a.end(), am.ptr(), am.ptr() + am.size());
+        b.insert(b.end(), bm.ptr(), bm.ptr() + bm.size());
+    }
+    bool positiveDefinite[kCount];
+    ThreadPool::setGlobalThreads(4);
+
+    // Act
+    int failures = choleskySolveBatch(kCount, kDims, kRhs, a.data(),
+                                      b.data(), positiveDefinite);
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    EXPECT_EQ(1, failures);
+    for (int m = 0; m < kCount; m++) {
+        EXPECT_EQ(m != 7, positiveDefinite[m]);
+        for (int k = 0; k < kDims * kRhs; k++) {
+            EXPECT_NEAR(expected[m].ptr()[k], b[m * kDims * kRhs + k],
+                        1e-12);
+        }
+    }
+}
@@ -0,0 +1,182 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/eigen.h"
+#include "ml/thread_pool.h"
+
+#include <math.h>
+
+#include <stdexcept>
+
+// A fixed symmetric n x n matrix with spread-out eigenvalues.
+template <class T>
+static BasicMatrix<T> symmetricMatrix(int n) {
+    BasicMatrix<T> a(n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j <= i; j++) {
+            a.at(i, j) = a.at(j, i) = T(sin(i * 1.3 + j * 0.7) +
+                                        (i == j ? i % 7 : 0));
+        }
+    }
+    return a;
+}
+
+// |A V - V diag(w)| and |V^T V - I|, largest element.
+template <class T>
+static void decompositionErrors(const BasicMatrix<T>& a,
+                                const BasicSymmetricEigen<T>& eigen,
+                                double* residual, double* orthogonality) {
+    const BasicMatrix<T>& v = eigen.vectors();
+    BasicMatrix<T> av = a * v;
+    BasicMatrix<T> vtv = BasicMatrix<T>(v.transposed()) * v;
+    *residual = 0;
+    *orthogonality = 0;
+    for (int i = 0; i < a.rows(); i++) {
+        for (int j = 0; j < a.cols(); j++) {
+            double scaled = av.at(i, j) - v.at(i, j) * eigen.values().at(j);
+            *residual = fmax(*residual, fabs(scaled));
+            double identity = i == j ? 1 : 0;
+            *orthogonality = fmax(*orthogonality,
+                                  fabs(vtv.at(i, j) - identity));
+        }
+    }
+}
+
+TEST(ML_EIGEN, Decomposes_Symmetric_Matrices) {
+    const int kSizes[] = {1, 2, 5, 33, 100, 257};
+    for (int n : kSizes) {
+        // Arrange
+        Matrix a = symmetricMatrix<double>(n);
+
+        // Act
+        SymmetricEigen eigen(a);
+
+        // Assert
+        double residual, orthogonality;
+        decompositionErrors(a, eigen, &residual, &orthogonality);
+        EXPECT_LT(residual, 1e-12 * n) << n;
+        EXPECT_LT(orthogonality, 1e-13 * n) << n;
+        for (int i = 1; i < n; i++) {
+            EXPECT_LE(eigen.values().at(i - 1), eigen.values().at(i)) << n;
+        }
+    }
+}
+
+TEST(ML_EIGEN, Handles_Repeated_Eigenvalues) {
+    // Arrange: all ones has eigenvalues 0 (n - 1 times) and n; I + e e^T
+    // of a unit e, 1 (n - 1 times) and 2.
+    const int kDims = 150;
+    Matrix ones(kDims, kDims, 1.0);
+    Matrix rankOne(kDims, kDims);
+    for (int i = 0; i < kDims; i++) {
+        for (int j = 0; j < kDims; j++) {
+            rankOne.at(i, j) = (i == j ? 1.0 : 0.0) + 1.0 / kDims;
+        }
+    }
+
+    // Act
+    SymmetricEigen first(ones);
+    SymmetricEigen second(rankOne);
+
+    // Assert
+    double residual, orthogonality;
+    decompositionErrors(ones, first, &residual, &orthogonality);
+    EXPECT_LT(residual, 1e-11);
+    EXPECT_LT(orthogonality, 1e-12);
+    EXPECT_NEAR(0.0, first.values().at(0), 1e-12);
+    EXPECT_NEAR(kDims, first.values().at(kDims - 1), 1e-11);
+    decompositionErrors(rankOne, second, &residual, &orthogonality);
+    EXPECT_LT(residual, 1e-12);
+    EXPECT_LT(orthogonality, 1e-12);
+    EXPECT_NEAR(1.0, second.values().at(kDims - 2), 1e-12);
+    EXPECT_NEAR(2.0, second.values().at(kDims - 1), 1e-12);
+}
+
+TEST(ML_EIGEN, Handles_Diagonal_Matrices) {
+    // Arrange: no coupling, so every merge deflates all its eigenvalues.
+    const int kDims = 100;
+    Matrix diagonal(kDims, kDims);
+    for (int i = 0; i < kDims; i++) {
+        diagonal.at(i, i) = (i * 37) % kDims;
+    }
+
+    // Act
+    SymmetricEigen eigen(diagonal);
+
+    // Assert
+    double residual, orthogonality;
+    decompositionErrors(diagonal, eigen, &residual, &orthogonality);
+    EXPECT_LT(residual, 1e-12);
+    EXPECT_LT(orthogonality, 1e-14);
+    for (int i = 0; i < kDims; i++) {
+        EXPECT_NEAR(i, eigen.values().at(i), 1e-12);
+    }
+}
+
+TEST(ML_EIGEN, Values_Only_Match_And_Threads_Agree) {
+    // Arrange
+    const int kDims = 300;
+    Matrix a = symmetricMatrix<double>(kDims);
+    // Only the lower triangle is read.
+    Matrix lower = a;
+    for (int i = 0; i < kDims; i++) {
+        for (int j = i + 1; j < kDims; j++) {
+            lower.at(i, j) = 1e6;
+        }
+    }
+
+    // Act
+    ThreadPool::setGlobalThreads(4);
+    SymmetricEigen parallel(lower);
+    ThreadPool::setGlobalThreads(1);
+    SymmetricEigen serial(a);
+    SymmetricEigen valuesOnly(a, false);
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    EXPECT_EQ(0, valuesOnly.vectors().rows());
+    for (int i = 0; i < kDims; i++) {
+        EXPECT_NEAR(serial.values().at(i), parallel.values().at(i), 1e-11);
+        EXPECT_NEAR(serial.values().at(i), valuesOnly.values().at(i), 1e-11);
+    }
+    double residual, orthogonality;
+    decompositionErrors(a, parallel, &residual, &orthogonality);
+    EXPECT_LT(residual, 1e-10);
+    EXPECT_LT(orthogonality, 1e-12);
+}
+
+TEST(ML_EIGEN, Rejects_Non_Finite_Elements) {
+    // Arrange
+    Matrix withNan = symmetricMatrix<double>(6);
+    withNan.at(4, 1) = NAN;
+    FloatMatrix withInf = symmetricMatrix<float>(6);
+    withInf.at(5, 5) = -INFINITY;
+
+    // Act & Assert
+    EXPECT_THROW(SymmetricEigen eigen(withNan), std::runtime_error);
+    EXPECT_THROW(SymmetricEigen(withNan, false), std::runtime_error);
+    EXPECT_THROW(FloatSymmetricEigen eigen(withInf), std::runtime_error);
+}
+
+TEST(ML_EIGEN, Float_And_Diagonal) {
+    // Arrange
+    FloatMatrix a = symmetricMatrix<float>(80);
+    Matrix diagonal(4, 4);
+    diagonal.at(0, 0) = 3;
+    diagonal.at(1, 1) = -1;
+    diagonal.at(2, 2) = 3;
+
+    // Act
+    FloatSymmetricEigen eigen(a);
+    SymmetricEigen sorted(diagonal);
+
+    // Assert
+    double residual, orthogonality;
+    decompositionErrors(a, eigen, &residual, &orthogonality);
+    EXPECT_LT(residual, 1e-4);
+    EXPECT_LT(orthogonality, 1e-5);
+    EXPECT_EQ(-1.0, sorted.values().at(0));
+    EXPECT_EQ(0.0, sorted.values().at(1));
+    EXPECT_EQ(3.0, sorted.values().at(3));
+    EXPECT_EQ(1.0, fabs(sorted.vectors().at(1, 0)));
+}
@@ -0,0 +1,175 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/linear_algebra.h"
+
+#include <math.h>
+#include <stdint.h>
+
+// Odd sizes leave a tail after the vector loops of every ISA.
+const int kDims = 67;
+
+template <class T>
+static BasicVector<T> rampVector(int dims, double scale, double shift) {
+    BasicVector<T> vec(dims);
+    for (int i = 0; i < dims; i++) {
+        vec.at(i) = ScalarTraits<T>::cast(scale*i + shift);
+    }
+    return vec;
+}
+
+TEST(ML_ELEMENT_TYPES, Float_Vector_Matches_Scalar_Arithmetic) {
+    // Arrange
+    FloatVector a = rampVector<float>(kDims, 0.25, -3.0);
+    FloatVector b = rampVector<float>(kDims, -0.5, 7.0);
+
+    // Act
+    FloatVector sum = a + b;
+    FloatVector product = a * b;
+    FloatVector axpy = a + 1.5f*b;
+    float dotProduct = dot(a, b);
+
+    // Assert
+    float expectedDot = 0.0f;
+    for (int i = 0; i < kDims; i++) {
+        EXPECT_FLOAT_EQ(a.at(i) + b.at(i), sum.at(i));
+        EXPECT_FLOAT_EQ(a.at(i) * b.at(i), product.at(i));
+        EXPECT_FLOAT_EQ(a.at(i) + 1.5f*b.at(i), axpy.at(i));
+        expectedDot += a.at(i) * b.at(i);
+    }
+    EXPECT_NEAR(expectedDot, dotProduct, 1e-3);
+}
+
+TEST(ML_ELEMENT_TYPES, Int8_Arithmetic_Saturates) {
+    // Arrange
+    Int8Vector a = rampVector<int8_t>(kDims, 4.0, -128.0);
+    Int8Vector b = rampVector<int8_t>(kDims, -3.0, 100.0);
+
+    // Act
+    Int8Vector sum = a + b;
+    Int8Vector difference = a - b;
+    Int8Vector product = a * b;
+    Int8Vector scaled = static_cast<int8_t>(3) * a;
+    Int8Vector axpy = a + static_cast<int8_t>(-2) * b;
+    int32_t dotProduct = dot(a, b);
+
+    // Assert
+    int32_t expectedDot = 0;
+    for (int i = 0; i < kDims; i++) {
+        int32_t x = a.at(i);
+        int32_t y = b.at(i);
+        EXPECT_EQ(ScalarTraits<int8_t>::narrow(x + y), sum.at(i));
+        EXPECT_EQ(ScalarTraits<int8_t>::narrow(x - y), difference.at(i));
+        EXPECT_EQ(ScalarTraits<int8_t>::narrow(x * y), product.at(i));
+        EXPECT_EQ(ScalarTraits<int8_t>::narrow(3 * x), scaled.at(i));
+        EXPECT_EQ(ScalarTraits<int8_t>::narrow(x - 2 * y), axpy.at(i));
+        expectedDot += x * y;
+    }
+    EXPECT_EQ(127, difference.at(kDims - 1));
+    EXPECT_EQ(-128, difference.at(0));
+    EXPECT_EQ(expectedDot, dotProduct);
+}
+
+TEST(ML_ELEMENT_TYPES, BFloat16_Rounds_To_Nearest_Even) {
+    // Arrange
+    float ulp = ldexpf(1.0f, -7);
+    BFloat16Vector a = rampVector<BFloat16>(kDims, 0.3, 1.0);
+    BFloat16Vector b = rampVector<BFloat16>(kDims, -0.7, 2.0);
+
+    // Act
+    BFloat16Vector sum = a + b;
+    BFloat16Vector axpy = a + BFloat16(0.5f)*b;
+    float dotProduct = dot(a, b);
+
+    // Assert
+    EXPECT_EQ(1.0f, BFloat16(1.0f + ulp / 2));
+    EXPECT_EQ(1.0f + 2 * ulp, BFloat16(1.0f + 3 * ulp / 2));
+    EXPECT_EQ(1.0f + ulp, BFloat16(1.0f + 3 * ulp / 4));
+    EXPECT_TRUE(isnan(static_cast<float>(BFloat16(nanf("")))));
+    float expectedDot = 0.0f;
+    for (int i = 0; i < kDims; i++) {
+        float x = a.at(i);
+        float y = b.at(i);
+        EXPECT_EQ(BFloat16(x + y).bits(), sum.at(i).bits());
+        EXPECT_EQ(BFloat16(0.5f*y + x).bits(), axpy.at(i).bits());
+        expectedDot += x * y;
+    }
+    EXPECT_NEAR(expectedDot, dotProduct, 1e-2 * fabs(expectedDot));
+}
+
+TEST(ML_ELEMENT_TYPES, Float_Gemm_Matches_Double) {
+    // Arrange
+    Matrix a(90, 70);
+    Matrix b(50, 90);
+    for (int i = 0; i < a.rows(); i++) {
+        for (int j = 0; j < a.cols(); j++) {
+            a.at(i, j) = sin(0.1*i + 0.3*j);
+        }
+    }
+    for (int i = 0; i < b.rows(); i++) {
+        for (int j = 0; j < b.cols(); j++) {
+            b.at(i, j) = cos(0.2*i - 0.1*j);
+        }
+    }
+
+    // Act
+    Matrix expected = a * b;
+    FloatMatrix product = elementCast<float>(a) * elementCast<float>(b);
+    BFloat16Matrix roughProduct =
+        elementCast<BFloat16>(a) * elementCast<BFloat16>(b);
+
+    // Assert
+    ASSERT_EQ(expected.rows(), product.rows());
+    ASSERT_EQ(expected.cols(), product.cols());
+    for (int i = 0; i < expected.rows(); i++) {
+        for (int j = 0; j < expected.cols(); j++) {
+            EXPECT_NEAR(expected.at(i, j), product.at(i, j), 1e-4);
+            EXPECT_NEAR(expected.at(i, j), roughProduct.at(i, j), 0.5);
+        }
+    }
+}
+
+TEST(ML_ELEMENT_TYPES, Int8_Gemm_Saturates_Once) {
+    // Arrange
+    Int8Matrix a(40, 3, 100);
+    Int8Matrix b(2, 40, -1);
+    for (int p = 0; p < 40; p += 2) {
+        b.at(p, 0) = 1;
+    }
+
+    // Act
+    Int8Matrix product = a * b;
+    Int8Matrix same = Int8Matrix::identity(3) * a;
+
+    // Assert
+    // Partial sums reach +-100 and beyond, but only the total saturates.
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(0, product.at(i, 0));
+        EXPECT_EQ(-128, product.at(i, 1));
+    }
+    EXPECT_EQ(a, same);
+}
+
+TEST(ML_ELEMENT_TYPES, Element_Cast_Rounds_And_Saturates) {
+    // Arrange
+    Vector vec(5);
+    vec.at(0) = 1.4;
+    vec.at(1) = 1.5;
+    vec.at(2) = -2.5;
+    vec.at(3) = 300.0;
+    vec.at(4) = -1e9;
+
+    // Act
+    Int8Vector narrow = elementCast<int8_t>(vec);
+    FloatVector single = elementCast<float>(vec);
+    Vector back = elementCast<double>(narrow);
+
+    // Assert
+    EXPECT_EQ(1, narrow.at(0));
+    EXPECT_EQ(2, narrow.at(1));
+    EXPECT_EQ(-2, narrow.at(2));
+    EXPECT_EQ(127, narrow.at(3));
+    EXPECT_EQ(-128, narrow.at(4));
+    EXPECT_FLOAT_EQ(1.4f, single.at(0));
+    EXPECT_DOUBLE_EQ(-128.0, back.at(4));
+}
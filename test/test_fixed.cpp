@@ -0,0 +1,116 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/fixed.h"
+
+#include <math.h>
+
+#include <type_traits>  // NOLINT(build/c++11)
+
+template <class T, int Cols, int Rows>
+static BasicFixedMatrix<T, Cols, Rows> fixedMatrix(double shift) {
+    BasicFixedMatrix<T, Cols, Rows> mat;
+    for (int i = 0; i < Rows; i++) {
+        for (int j = 0; j < Cols; j++) {
+            mat.at(i, j) = T(sin(i * 1.7 + j * 0.3 + shift));
+        }
+    }
+    return mat;
+}
+
+TEST(ML_FIXED, Stores_Elements_Inline) {
+    // Arrange
+    FixedMatrix<3, 2> mat(1.5);
+    FixedVector<4> vec;
+
+    // Act
+    mat.at(1, 2) = 7;
+    vec.at(3) = -2;
+
+    // Assert
+    EXPECT_EQ(sizeof(double) * 6, sizeof(mat));
+    EXPECT_EQ(sizeof(float) * 5, sizeof(FloatFixedVector<5>));
+    typedef FixedMatrix<3, 2> Small;
+    EXPECT_TRUE(std::is_trivially_copyable<Small>::value);
+    EXPECT_EQ(2, mat.rows());
+    EXPECT_EQ(3, mat.cols());
+    EXPECT_EQ(7.0, mat.ptr()[5]);
+    EXPECT_EQ(1.5, mat.at(0, 0));
+    EXPECT_EQ(0.0, vec.at(0));
+    EXPECT_EQ(2.0, vec.length());
+}
+
+TEST(ML_FIXED, Products_Match_Dynamic_Matrices) {
+    // Arrange: 4 x 4 is unrolled in full, 20 x 20 is not.
+    FixedMatrix<3, 4> a = fixedMatrix<double, 3, 4>(0.0);
+    FixedMatrix<5, 3> b = fixedMatrix<double, 5, 3>(1.0);
+    FixedMatrix<20, 20> big = fixedMatrix<double, 20, 20>(2.0);
+    FixedVector<3> x(0.5);
+    x.at(1) = -1;
+
+    // Act
+    FixedMatrix<5, 4> c = a * b;
+    FixedVector<4> y = a * x;
+    FixedMatrix<20, 20> square = big * big.transposed();
+
+    // Assert
+    Matrix expected = a.toMatrix() * b.toMatrix();
+    Vector expectedY = a.toMatrix() * x.toVector();
+    Matrix expectedSquare = big.toMatrix() *
+                            Matrix(big.toMatrix().transposed());
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 5; j++) {
+            EXPECT_NEAR(expected.at(i, j), c.at(i, j), 1e-14);
+        }
+        EXPECT_NEAR(expectedY.at(i), y.at(i), 1e-14);
+    }
+    for (int i = 0; i < 20; i++) {
+        for (int j = 0; j < 20; j++) {
+            EXPECT_NEAR(expectedSquare.at(i, j), square.at(i, j), 1e-13);
+        }
+    }
+}
+
+TEST(ML_FIXED, Element_Wise_Arithmetic) {
+    // Arrange
+    FloatFixedMatrix<2, 2> a = FloatFixedMatrix<2, 2>::identity();
+    FloatFixedMatrix<2, 2> b(3.0f);
+    FixedVector<3> u(1.0), v(2.0);
+
+    // Act
+    FloatFixedMatrix<2, 2> sum = a + 2.0f * b;
+    FloatFixedMatrix<2, 2> difference = b - a;
+    FixedVector<3> w = u - 0.5 * v + v;
+
+    // Assert
+    EXPECT_EQ(7.0f, sum.at(0, 0));
+    EXPECT_EQ(6.0f, sum.at(0, 1));
+    EXPECT_EQ(2.0f, difference.at(1, 1));
+    EXPECT_EQ(3.0f, difference.at(1, 0));
+    EXPECT_EQ(2.0, w.at(2));
+    EXPECT_EQ(12.0, dot(w, v));
+}
+
+TEST(ML_FIXED, Converts_To_And_From_Dynamic_Classes) {
+    // Arrange
+    Matrix dynamic(3, 2);
+    dynamic.at(1, 2) = 4;
+    Vector vec(2, 1.0);
+
+    // Act
+    FixedMatrix<3, 2> fixed(dynamic);
+    fixed.at(0, 0) = 1;
+    FixedVector<2> fixedVec(vec);
+    Matrix back = fixed.view();
+    FixedMatrix<2, 3> transposed;
+    transposed.view() = dynamic.transposed();
+    Vector product = fixed.view().transposed() * fixedVec.toVector();
+
+    // Assert
+    EXPECT_EQ(4.0, fixed.at(1, 2));
+    EXPECT_EQ(1.0, back.at(0, 0));
+    EXPECT_EQ(4.0, back.at(1, 2));
+    EXPECT_EQ(4.0, transposed.at(2, 1));
+    EXPECT_EQ(3, product.dims());
+    EXPECT_EQ(4.0, product.at(2));
+}
@@ -0,0 +1,161 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/linear_algebra.h"
+#include "ml/thread_pool.h"
+#include "test/test_helpers.h"
+
+#include <math.h>
+
+template <class T>
+static BasicVector<T> filledVector(int dims) {
+    BasicVector<T> vec(dims);
+    for (int i = 0; i < dims; i++) {
+        vec.at(i) = T((i % 5 - 2) * 0.5);
+    }
+    return vec;
+}
+
+// The product through GEMM, with x as a one-column matrix.
+static Vector reference(const Matrix& a, const Vector& x) {
+    Matrix column(1, x.dims());
+    for (int i = 0; i < x.dims(); i++) {
+        column.at(i, 0) = x.at(i);
+    }
+    Matrix product = a * column;
+    Vector y(product.rows());
+    for (int i = 0; i < y.dims(); i++) {
+        y.at(i) = product.at(i, 0);
+    }
+    return y;
+}
+
+TEST(ML_GEMV, Matches_Matrix_Product) {
+    const int kSizes[] = {1, 3, 4, 7, 17, 64, 133};
+    for (int rows : kSizes) {
+        for (int cols : kSizes) {
+            // Arrange
+            Matrix a = patternMatrix<double>(cols, rows, 7, 3, 11, -5, 0.25);
+            Vector x = filledVector<double>(cols);
+            Vector r = filledVector<double>(rows);
+
+            // Act
+            Vector y = a * x;
+            Vector z = r * a;
+
+            // Assert
+            ASSERT_EQ(reference(a, x), y) << rows << "x" << cols;
+            ASSERT_EQ(reference(a.transposed(), r), z)
+                << rows << "x" << cols;
+        }
+    }
+}
+
+TEST(ML_GEMV, Works_On_Views_And_Expressions) {
+    // Arrange
+    Matrix a = patternMatrix<double>(9, 12, 7, 3, 11, -5, 0.25);
+    Vector x = filledVector<double>(4);
+    Vector r = filledVector<double>(12);
+    Vector w = filledVector<double>(9);
+    BasicMatrixView<const double> block = a.block(2, 3, 5, 4);
+    Matrix blockCopy = block;
+    Matrix strided(5, 8);
+    BasicMatrixView<double> everyOther(strided.ptr(), 4, 5, 10, 1);
+    everyOther = patternMatrix<double>(5, 4, 7, 3, 11, -5, 0.25);
+    BasicMatrixView<double> stridedBoth(strided.ptr(), 4, 3, 10, 2);
+
+    // Act
+    Vector fromBlock = block * x;
+    Vector fromTransposed = a.transposed() * r;
+    Vector fromStrided = stridedBoth * filledVector<double>(3);
+    Vector fromExpression = a * (w + w - 0.5 * w);
+
+    // Assert
+    EXPECT_EQ(blockCopy * x, fromBlock);
+    EXPECT_EQ(r * a, fromTransposed);
+    EXPECT_EQ(Matrix(stridedBoth) * filledVector<double>(3), fromStrided);
+    EXPECT_EQ(a * Vector(1.5 * w), fromExpression);
+}
+
+TEST(ML_GEMV, Reuses_Output_Vector) {
+    // Arrange
+    Matrix a = patternMatrix<double>(6, 5, 7, 3, 11, -5, 0.25);
+    Vector x = filledVector<double>(6);
+    Vector y(5, 100.0);
+    const double* buffer = y.ptr();
+
+    // Act
+    multiply(a.view(), x, &y);
+
+    // Assert
+    EXPECT_EQ(buffer, y.ptr());
+    EXPECT_EQ(a * x, y);
+}
+
+TEST(ML_GEMV, Output_May_Alias_Input) {
+    // Arrange
+    Matrix a = patternMatrix<double>(7, 7, 7, 3, 11, -5, 0.25);
+    Vector x = filledVector<double>(7);
+    Vector expected = reference(a, x);
+    Vector transposedExpected = x * a;
+
+    // Act
+    Vector y = x;
+    multiply(a.view(), y, &y);
+    Vector z = x;
+    multiply(a.transposed(), z, &z);
+
+    // Assert
+    for (int i = 0; i < 7; i++) {
+        EXPECT_NEAR(expected.at(i), y.at(i), 1e-12);
+    }
+    EXPECT_EQ(transposedExpected, z);
+}
+
+TEST(ML_GEMV, Accumulates_Narrow_Types_Once) {
+    // Arrange
+    Int8Matrix a(300, 2, 100);
+    Int8Vector x(300, 1);
+    Int8Vector r(2, 1);
+    a.at(1, 0) = -100;
+    FloatMatrix f = patternMatrix<float>(40, 30, 7, 3, 11, -5, 0.25);
+    FloatVector fx = filledVector<float>(40);
+    BFloat16Matrix b = elementCast<BFloat16>(f);
+    BFloat16Vector bx = elementCast<BFloat16>(fx);
+
+    // Act
+    Int8Vector y = a * x;
+    Int8Vector z = r * a;
+    BFloat16Vector by = b * bx;
+
+    // Assert
+    EXPECT_EQ(127, y.at(0));
+    EXPECT_EQ(127, y.at(1));
+    EXPECT_EQ(0, z.at(0));
+    EXPECT_EQ(127, z.at(1));
+    FloatVector fy = f * fx;
+    for (int i = 0; i < fy.dims(); i++) {
+        EXPECT_NEAR(fy.at(i), static_cast<float>(by.at(i)),
+                    0.01 * (1 + fabs(fy.at(i))));
+    }
+}
+
+TEST(ML_GEMV, Parallel_Matches_Serial) {
+    // Arrange
+    FloatMatrix a = patternMatrix<float>(3001, 517, 7, 3, 11, -5, 0.25);
+    FloatVector x = filledVector<float>(3001);
+    FloatVector r = filledVector<float>(517);
+    ThreadPool::setGlobalThreads(1);
+    FloatVector serial = a * x;
+    FloatVector serialTransposed = r * a;
+
+    // Act
+    ThreadPool::setGlobalThreads(4);
+    FloatVector parallel = a * x;
+    FloatVector parallelTransposed = r * a;
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    EXPECT_EQ(serial, parallel);
+    EXPECT_EQ(serialTransposed, parallelTransposed);
+}
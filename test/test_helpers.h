@@ -0,0 +1,82 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#ifndef TEST_TEST_HELPERS_H_
+#define TEST_TEST_HELPERS_H_
+
+#include <math.h>
+#include <stdint.h>
+
+#include "ml/linear_algebra.h"
+
+// Fixtures and error measures shared by the tests. Fixture entries are
+// fixed functions of their position, so every run sees the same data.
+
+// cols x rows matrix of ((rowStep i + colStep j) % modulus + offset)
+// * scale: small values in a pattern that only repeats every modulus
+// steps.
+template <class T>
+BasicMatrix<T> patternMatrix(int cols, int rows, int rowStep, int colStep,
+                             int modulus, double offset = 0,
+                             double scale = 1) {
+    BasicMatrix<T> a(cols, rows);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            int64_t step = static_cast<int64_t>(rowStep) * i +
+                           static_cast<int64_t>(colStep) * j;
+            a.at(i, j) = T((step % modulus + offset) * scale);
+        }
+    }
+    return a;
+}
+
+// cols x rows matrix of sin(0.37 i (j + 1) + j), within [-1, 1], plus
+// diagonal on the main diagonal.
+template <class T>
+BasicMatrix<T> waveMatrix(int cols, int rows, double diagonal = 0) {
+    BasicMatrix<T> a(cols, rows);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            a.at(i, j) = T(sin(i * (j + 1) * 0.37 + j) +
+                           (i == j ? diagonal : 0));
+        }
+    }
+    return a;
+}
+
+// Well-conditioned symmetric positive definite n x n matrix X^T X + n I.
+template <class T>
+BasicMatrix<T> spdMatrix(int n) {
+    BasicMatrix<T> x(n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            x.at(i, j) = T(((i * 7 + j * 13) % 17 - 8) / 8.0);
+        }
+    }
+    BasicMatrix<T> a = BasicMatrix<T>(x.transposed()) * x;
+    for (int i = 0; i < n; i++) {
+        a.at(i, i) += T(n);
+    }
+    return a;
+}
+
+// Largest |a_ij - b_ij|.
+template <class T>
+double maxDifference(const BasicMatrix<T>& a, const BasicMatrix<T>& b) {
+    double largest = 0;
+    for (int i = 0; i < a.rows(); i++) {
+        for (int j = 0; j < a.cols(); j++) {
+            largest = fmax(largest, fabs(a.at(i, j) - b.at(i, j)));
+        }
+    }
+    return largest;
+}
+
+// Largest element of |B^T B - I|: how far the columns of b are from
+// orthonormal.
+template <class T>
+double orthogonalityError(const BasicMatrix<T>& b) {
+    BasicMatrix<T> product = BasicMatrix<T>(b.transposed()) * b;
+    return maxDifference(product, BasicMatrix<T>::identity(b.cols()));
+}
+
+#endif  // TEST_TEST_HELPERS_H_
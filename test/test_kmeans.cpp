@@ -0,0 +1,145 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/kmeans.h"
+#include "ml/thread_pool.h"
+
+#include <math.h>
+
+#include <vector>
+
+// Coordinate j of the center of blob b: the blobs sit 10 apart.
+static double blobCenter(int b, int j) {
+    return 10.0 * ((b + j) % 3) + 5.0 * (b % 2 == j % 2) + b;
+}
+
+// rows samples of cols features around blobs centers; sample i belongs
+// to blob i % blobs, at most 0.5 away in every feature.
+template <class T>
+static BasicMatrix<T> blobSamples(int cols, int rows, int blobs) {
+    BasicMatrix<T> x(cols, rows);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            x.at(i, j) = T(blobCenter(i % blobs, j) +
+                           0.5 * sin(i * (j + 1) * 0.37 + j));
+        }
+    }
+    return x;
+}
+
+// Checks that every blob went to a cluster of its own, centered near
+// the blob.
+template <class T>
+static void expectBlobs(const BasicMatrix<T>& centers,
+                        const std::vector<int>& labels, int blobs,
+                        double tolerance) {
+    std::vector<int> clusterOf(blobs);
+    std::vector<bool> used(blobs, false);
+    for (int b = 0; b < blobs; b++) {
+        clusterOf[b] = labels[b];
+        EXPECT_FALSE(used[labels[b]]);
+        used[labels[b]] = true;
+        for (int j = 0; j < centers.cols(); j++) {
+            EXPECT_NEAR(blobCenter(b, j), centers.at(labels[b], j),
+                        tolerance);
+        }
+    }
+    for (size_t i = 0; i < labels.size(); i++) {
+        EXPECT_EQ(clusterOf[i % blobs], labels[i]);
+    }
+}
+
+TEST(ML_KMEANS, Finds_Separated_Blobs) {
+    // Arrange
+    Matrix x = blobSamples<double>(4, 2000, 5);
+
+    // Act
+    KMeans kmeans(x, 5);
+
+    // Assert
+    EXPECT_TRUE(kmeans.converged());
+    EXPECT_EQ(5, kmeans.centers().rows());
+    EXPECT_EQ(4, kmeans.centers().cols());
+    expectBlobs(kmeans.centers(), kmeans.labels(), 5, 0.1);
+    EXPECT_GT(kmeans.inertia(), 0.0);
+    EXPECT_LT(kmeans.inertia(), 2000 * 4 * 0.25);
+    EXPECT_EQ(kmeans.labels(), kmeans.predict(x));
+}
+
+TEST(ML_KMEANS, Bounds_Agree_With_Lloyd) {
+    // Arrange: overlapping blobs, so assignments keep changing.
+    Matrix x = blobSamples<double>(3, 3000, 7);
+    for (int i = 0; i < x.rows(); i++) {
+        x.at(i, 0) += 6 * sin(i * 1.3);
+    }
+    KMeansOptions options;
+    options.tolerance = 0;
+    options.seed = 3;
+
+    // Act
+    options.bounds = kKMeansLloyd;
+    KMeans lloyd(x, 12, options);
+    options.bounds = kKMeansHamerly;
+    KMeans hamerly(x, 12, options);
+    options.bounds = kKMeansElkan;
+    KMeans elkan(x, 12, options);
+
+    // Assert
+    EXPECT_EQ(lloyd.labels(), hamerly.labels());
+    EXPECT_EQ(lloyd.labels(), elkan.labels());
+    EXPECT_GT(lloyd.iterations(), 5);
+    EXPECT_EQ(lloyd.iterations(), hamerly.iterations());
+    EXPECT_EQ(lloyd.iterations(), elkan.iterations());
+    EXPECT_NEAR(lloyd.inertia(), hamerly.inertia(), 1e-9 * lloyd.inertia());
+    EXPECT_NEAR(lloyd.inertia(), elkan.inertia(), 1e-9 * lloyd.inertia());
+}
+
+TEST(ML_KMEANS, Float_And_Threads_Agree) {
+    // Arrange
+    FloatMatrix x = blobSamples<float>(6, 5000, 4);
+    KMeansOptions options;
+    options.bounds = kKMeansElkan;
+
+    // Act
+    ThreadPool::setGlobalThreads(1);
+    FloatKMeans serial(x, 4, options);
+    ThreadPool::setGlobalThreads(4);
+    FloatKMeans parallel(x, 4, options);
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    expectBlobs(serial.centers(), serial.labels(), 4, 0.1);
+    EXPECT_EQ(serial.labels(), parallel.labels());
+    EXPECT_EQ(serial.inertia(), parallel.inertia());
+    for (int c = 0; c < 4; c++) {
+        for (int j = 0; j < 6; j++) {
+            EXPECT_EQ(serial.centers().at(c, j), parallel.centers().at(c, j));
+        }
+    }
+}
+
+TEST(ML_KMEANS, Mini_Batches_Approach_Blobs) {
+    // Arrange
+    Matrix x = blobSamples<double>(4, 6000, 5);
+    MiniBatchKMeans kmeans(5, 4);
+
+    // Act
+    for (int start = 0; start < x.rows(); start += 200) {
+        Matrix batch(4, 200);
+        for (int i = 0; i < 200; i++) {
+            for (int j = 0; j < 4; j++) {
+                batch.at(i, j) = x.at(start + i, j);
+            }
+        }
+        kmeans.partialFit(batch);
+    }
+
+    // Assert
+    EXPECT_TRUE(kmeans.initialized());
+    int64_t seen = 0;
+    for (int c = 0; c < 5; c++) {
+        seen += kmeans.counts()[c];
+    }
+    EXPECT_EQ(6000, seen);
+    expectBlobs(kmeans.centers(), kmeans.predict(x), 5, 0.1);
+}
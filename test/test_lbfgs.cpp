@@ -0,0 +1,68 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/lbfgs.h"
+
+// Rosenbrock's function summed over consecutive pairs, minimal at all
+// ones.
+template <class T>
+static T rosenbrock(const BasicVector<T>& x, BasicVector<T>* gradient) {
+    T value = 0;
+    for (int i = 0; i < x.dims(); i++) {
+        gradient->at(i) = 0;
+    }
+    for (int i = 0; i + 1 < x.dims(); i += 2) {
+        T a = x.at(i + 1) - x.at(i) * x.at(i);
+        T b = 1 - x.at(i);
+        value += 100 * a * a + b * b;
+        gradient->at(i) = -400 * a * x.at(i) - 2 * b;
+        gradient->at(i + 1) = 200 * a;
+    }
+    return value;
+}
+
+TEST(ML_LBFGS, Minimizes_Rosenbrock) {
+    // Arrange
+    Vector x(10, -1.2);
+    LbfgsOptions options;
+    options.maxIterations = 500;
+    options.tolerance = 1e-8;
+    Lbfgs lbfgs(options);
+
+    // Act
+    double value = lbfgs.minimize(rosenbrock<double>, &x);
+
+    // Assert
+    EXPECT_TRUE(lbfgs.converged());
+    EXPECT_LT(value, 1e-14);
+    EXPECT_GT(lbfgs.evaluations(), lbfgs.iterations());
+    for (int i = 0; i < 10; i++) {
+        EXPECT_NEAR(1.0, x.at(i), 1e-6);
+    }
+}
+
+TEST(ML_LBFGS, Minimizes_Quadratic_In_Float) {
+    // Arrange: sum of (i + 1) (x_i - i)^2.
+    FloatVector x(50);
+    FloatLbfgs lbfgs;
+
+    // Act
+    float value = lbfgs.minimize(
+        [](const FloatVector& point, FloatVector* gradient) {
+            float sum = 0;
+            for (int i = 0; i < point.dims(); i++) {
+                float offset = point.at(i) - i;
+                sum += (i + 1) * offset * offset;
+                gradient->at(i) = 2 * (i + 1) * offset;
+            }
+            return sum;
+        }, &x);
+
+    // Assert
+    EXPECT_TRUE(lbfgs.converged());
+    EXPECT_LT(value, 1e-4);
+    EXPECT_LT(lbfgs.iterations(), 100);
+    for (int i = 0; i < 50; i++) {
+        EXPECT_NEAR(i, x.at(i), 1e-3);
+    }
+}
@@ -2,7 +2,11 @@
 
 #include <gtest/gtest.h>
 #include "ml/linear_algebra.h"
+#include "test/test_helpers.h"
 
+#include <math.h>
+
+#include <utility>
 #include <vector>
 #include <iostream>
 
@@ -45,7 +49,7 @@ TEST(ML_LINEAR_ALGEBRA, Can_Create_Identity_Matrix) {
 
     // Act
     Matrix mat = Matrix::identity(dims);
-    vector<double> data = mat.data();
+    Span<const double> data = mat.span();
 
     // Assert
     EXPECT_EQ(dims, mat.cols());
@@ -61,3 +65,255 @@ TEST(ML_LINEAR_ALGEBRA, Can_Create_Identity_Matrix) {
         }
     }
 }
+
+static Matrix naiveMultiply(const Matrix& a, const Matrix& b) {
+    Matrix c(b.cols(), a.rows());
+    for (int i = 0; i < a.rows(); i++) {
+        for (int j = 0; j < b.cols(); j++) {
+            double sum = 0.0;
+            for (int k = 0; k < a.cols(); k++) {
+                sum += a.at(i, k)*b.at(k, j);
+            }
+            c.at(i, j) = sum;
+        }
+    }
+    return c;
+}
+
+TEST(ML_LINEAR_ALGEBRA, Can_Multiply_Non_Square_Matrices) {
+    // Arrange
+    Matrix a = patternMatrix<double>(3, 2, 7, 13, 17, -8, 0.25);
+    Matrix b = patternMatrix<double>(4, 3, 7, 13, 17, -8, 0.25);
+
+    // Act
+    Matrix c = a*b;
+
+    // Assert
+    EXPECT_EQ(4, c.cols());
+    EXPECT_EQ(2, c.rows());
+    EXPECT_EQ(naiveMultiply(a, b), c);
+}
+
+TEST(ML_LINEAR_ALGEBRA, Can_Multiply_Matrices_Across_Cache_Blocks) {
+    // Arrange
+    Matrix a = patternMatrix<double>(301, 103, 7, 13, 17, -8, 0.25);
+    Matrix b = patternMatrix<double>(37, 301, 7, 13, 17, -8, 0.25);
+
+    // Act
+    Matrix c = a*b;
+    Matrix expected = naiveMultiply(a, b);
+
+    // Assert
+    ASSERT_EQ(expected.cols(), c.cols());
+    ASSERT_EQ(expected.rows(), c.rows());
+    for (int i = 0; i < c.rows(); i++) {
+        for (int j = 0; j < c.cols(); j++) {
+            EXPECT_NEAR(expected.at(i, j), c.at(i, j), 1e-9);
+        }
+    }
+}
+
+static Vector sequenceVector(int dims) {
+    Vector vec(dims);
+    for (int i = 0; i < dims; i++) {
+        vec.at(i) = (i % 11 - 5) / 2.0;
+    }
+    return vec;
+}
+
+TEST(ML_LINEAR_ALGEBRA, Can_Do_Element_Wise_Vector_Arithmetic) {
+    // Arrange
+    int dims = 37;
+    Vector a = sequenceVector(dims);
+    Vector b = 2.0*a + 1.0;
+
+    // Act
+    Vector sum = a + b;
+    Vector diff = a - b;
+    Vector prod = a * b;
+
+    // Assert
+    for (int i = 0; i < dims; i++) {
+        EXPECT_DOUBLE_EQ(2.0*a.at(i) + 1.0, b.at(i));
+        EXPECT_DOUBLE_EQ(a.at(i) + b.at(i), sum.at(i));
+        EXPECT_DOUBLE_EQ(a.at(i) - b.at(i), diff.at(i));
+        EXPECT_DOUBLE_EQ(a.at(i) * b.at(i), prod.at(i));
+    }
+}
+
+TEST(ML_LINEAR_ALGEBRA, Can_Compute_Dot_And_Length) {
+    // Arrange
+    int dims = 101;
+    Vector a = sequenceVector(dims);
+    Vector b = a + 0.5;
+    double expectedDot = 0.0;
+    double expectedSquares = 0.0;
+    for (int i = 0; i < dims; i++) {
+        expectedDot += a.at(i)*b.at(i);
+        expectedSquares += a.at(i)*a.at(i);
+    }
+
+    // Act & Assert
+    EXPECT_NEAR(expectedDot, dot(a, b), 1e-9);
+    EXPECT_NEAR(sqrt(expectedSquares), a.length(), 1e-9);
+}
+
+TEST(ML_LINEAR_ALGEBRA, Can_Do_Element_Wise_Matrix_Arithmetic) {
+    // Arrange
+    Matrix a = patternMatrix<double>(7, 5, 7, 13, 17, -8, 0.25);
+    Matrix b = patternMatrix<double>(7, 5, 7, 13, 17, -8, 0.25) + 1.5;
+
+    // Act
+    Matrix sum = a + b;
+    Matrix diff = a - b;
+    Matrix scaled = 3*a;
+
+    // Assert
+    for (int i = 0; i < a.rows(); i++) {
+        for (int j = 0; j < a.cols(); j++) {
+            EXPECT_DOUBLE_EQ(a.at(i, j) + 1.5, b.at(i, j));
+            EXPECT_DOUBLE_EQ(a.at(i, j) + b.at(i, j), sum.at(i, j));
+            EXPECT_DOUBLE_EQ(-1.5, diff.at(i, j));
+            EXPECT_DOUBLE_EQ(3*a.at(i, j), scaled.at(i, j));
+        }
+    }
+}
+
+TEST(ML_LINEAR_ALGEBRA, Can_Evaluate_Chained_Vector_Expression) {
+    // Arrange
+    int dims = 29;
+    Vector x = sequenceVector(dims);
+    Vector y = x + 1.0;
+    Vector z = 0.5*x;
+    double a = 3.0;
+
+    // Act
+    Vector result = a*x + y - z;
+
+    // Assert
+    for (int i = 0; i < dims; i++) {
+        EXPECT_DOUBLE_EQ(a*x.at(i) + y.at(i) - z.at(i), result.at(i));
+    }
+}
+
+TEST(ML_LINEAR_ALGEBRA, Can_Assign_Expression_Containing_Destination) {
+    // Arrange
+    Vector x = sequenceVector(17);
+    Vector y = sequenceVector(17) + 2.0;
+    Vector expected(17);
+    for (int i = 0; i < 17; i++) {
+        expected.at(i) = 2.0*x.at(i) + y.at(i);
+    }
+
+    // Act
+    x = 2.0*x + y;
+
+    // Assert
+    EXPECT_EQ(expected, x);
+}
+
+TEST(ML_LINEAR_ALGEBRA, Can_Evaluate_Chained_Matrix_Expression) {
+    // Arrange
+    Matrix a = patternMatrix<double>(6, 4, 7, 13, 17, -8, 0.25);
+    Matrix b = Matrix(6, 4, 1.0);
+
+    // Act
+    Matrix result = a + 3*a - (b + 2.0);
+    Matrix product = (a + b) * Matrix::identity(6);
+
+    // Assert
+    EXPECT_EQ(4, result.rows());
+    EXPECT_EQ(6, result.cols());
+    for (int i = 0; i < a.rows(); i++) {
+        for (int j = 0; j < a.cols(); j++) {
+            EXPECT_DOUBLE_EQ(4*a.at(i, j) - 3.0, result.at(i, j));
+        }
+    }
+    EXPECT_TRUE(product == a + b);
+}
+
+TEST(ML_LINEAR_ALGEBRA, Can_Move_Vector_Without_Copying) {
+    // Arrange
+    Vector a = sequenceVector(10);
+    Vector expected = a;
+    const double* buffer = &a.at(0);
+
+    // Act
+    Vector b(std::move(a));
+    Vector c(1);
+    c = std::move(b);
+
+    // Assert
+    EXPECT_EQ(buffer, &c.at(0));
+    EXPECT_EQ(expected, c);
+    EXPECT_EQ(0, a.dims());
+    EXPECT_EQ(0, b.dims());
+}
+
+TEST(ML_LINEAR_ALGEBRA, Assignment_Reuses_Storage_Of_Same_Size) {
+    // Arrange
+    Matrix a = patternMatrix<double>(5, 4, 7, 13, 17, -8, 0.25);
+    Matrix b(5, 4);
+    Vector x = sequenceVector(8);
+    Vector y(8);
+    const double* matrixBuffer = &b.at(0, 0);
+    const double* vectorBuffer = &y.at(0);
+
+    // Act
+    b = a;
+    b = a + 2*a;
+    y = x;
+    y = x - 0.5*x;
+
+    // Assert
+    EXPECT_EQ(matrixBuffer, &b.at(0, 0));
+    EXPECT_EQ(vectorBuffer, &y.at(0));
+    EXPECT_EQ(3*a, b);
+    EXPECT_EQ(0.5*x, y);
+}
+
+TEST(ML_LINEAR_ALGEBRA, Can_Update_In_Place) {
+    // Arrange
+    Vector x = sequenceVector(19);
+    Vector y = x + 1.0;
+    Vector expected = y + 2.5*x;
+    Matrix a = patternMatrix<double>(3, 3, 7, 13, 17, -8, 0.25);
+    Matrix original = a;
+    Matrix b = Matrix::identity(3);
+
+    // Act
+    y += 2.5*x;
+    x -= x;
+    a += b;
+    a -= 2*b;
+    a *= 2.0;
+
+    // Assert
+    EXPECT_EQ(expected, y);
+    EXPECT_EQ(Vector(19), x);
+    EXPECT_EQ(2*(original - Matrix::identity(3)), a);
+
+    y *= y;
+    y *= 0.0;
+    EXPECT_EQ(Vector(19), y);
+}
+
+TEST(ML_LINEAR_ALGEBRA, Span_Aliases_Container_Storage) {
+    // Arrange
+    Vector vec(4, 1.0);
+    Matrix mat(3, 2, 2.0);
+
+    // Act
+    Span<double> vecSpan = vec.span();
+    Span<const double> matSpan = mat.span();
+    vecSpan[2] = 5.0;
+    mat.at(1, 2) = 7.0;
+
+    // Assert
+    EXPECT_EQ(vec.ptr(), vecSpan.data());
+    EXPECT_EQ(4u, vecSpan.size());
+    EXPECT_DOUBLE_EQ(5.0, vec.at(2));
+    EXPECT_EQ(mat.ptr(), matSpan.data());
+    EXPECT_EQ(6u, matSpan.size());
+    EXPECT_DOUBLE_EQ(7.0, matSpan[5]);
+}
@@ -0,0 +1,123 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/logistic.h"
+#include "ml/thread_pool.h"
+#include "test/test_helpers.h"
+
+#include <math.h>
+
+#include <vector>
+
+// The class whose score w_c . x + c / 2 is largest for w_c = (c, -c, c,
+// ...) - 1, with every tenth label flipped to the next class as noise.
+template <class T>
+static std::vector<int> logisticLabels(const BasicMatrix<T>& x, int classes) {
+    std::vector<int> labels(x.rows());
+    for (int i = 0; i < x.rows(); i++) {
+        double best = -1e300;
+        for (int c = 0; c < classes; c++) {
+            double score = c / 2.0;
+            for (int j = 0; j < x.cols(); j++) {
+                score += ((j % 2 ? -c : c) - 1) * x.at(i, j);
+            }
+            if (score > best) {
+                best = score;
+                labels[i] = c;
+            }
+        }
+        if (i % 10 == 0) {
+            labels[i] = (labels[i] + 1) % classes;
+        }
+    }
+    return labels;
+}
+
+template <class T>
+static double accuracy(const BasicLogisticRegression<T>& model,
+                       const BasicMatrix<T>& x,
+                       const std::vector<int>& labels) {
+    std::vector<int> predicted = model.predict(x);
+    int correct = 0;
+    for (size_t i = 0; i < labels.size(); i++) {
+        correct += predicted[i] == labels[i];
+    }
+    return static_cast<double>(correct) / labels.size();
+}
+
+TEST(ML_LOGISTIC, Fits_Binary_Labels) {
+    // Arrange
+    Matrix x = waveMatrix<double>(6, 3000);
+    std::vector<int> labels = logisticLabels(x, 2);
+
+    // Act
+    LogisticRegression model = fitLogisticRegression(x, labels, 2);
+    Matrix probabilities = model.predictProbabilities(x);
+
+    // Assert
+    EXPECT_EQ(2, model.classes());
+    EXPECT_EQ(1, model.weights().rows());
+    EXPECT_EQ(6, model.dims());
+    EXPECT_GT(accuracy(model, x, labels), 0.8);
+    // The noise keeps the weights finite; they point along (1, -1, ...).
+    EXPECT_GT(model.weights().at(0, 0), 0.5);
+    EXPECT_LT(model.weights().at(0, 1), -0.5);
+    for (int i = 0; i < 3000; i++) {
+        EXPECT_NEAR(1.0, probabilities.at(i, 0) + probabilities.at(i, 1),
+                    1e-12);
+    }
+}
+
+TEST(ML_LOGISTIC, Fits_Multinomial_Labels) {
+    // Arrange
+    Matrix x = waveMatrix<double>(5, 4000);
+    std::vector<int> labels = logisticLabels(x, 4);
+    LogisticOptions options;
+    options.l2 = 1e-3;
+    options.intercept = false;
+
+    // Act
+    LogisticRegression model = fitLogisticRegression(x, labels, 4);
+    LogisticRegression origin = fitLogisticRegression(x, labels, 4, options);
+    Matrix probabilities = model.predictProbabilities(x);
+
+    // Assert
+    EXPECT_EQ(4, model.weights().rows());
+    EXPECT_GT(accuracy(model, x, labels), 0.8);
+    EXPECT_GT(accuracy(origin, x, labels), 0.75);
+    EXPECT_EQ(0.0, origin.intercepts().at(2));
+    for (int i = 0; i < 4000; i += 7) {
+        double sum = 0;
+        for (int c = 0; c < 4; c++) {
+            sum += probabilities.at(i, c);
+        }
+        EXPECT_NEAR(1.0, sum, 1e-12);
+    }
+}
+
+TEST(ML_LOGISTIC, Float_And_Threads_Agree) {
+    // Arrange
+    FloatMatrix x = waveMatrix<float>(8, 5000);
+    std::vector<int> labels = logisticLabels(x, 3);
+    LogisticOptions options;
+    options.shards = 5;
+    options.lbfgs.maxIterations = 30;
+
+    // Act
+    ThreadPool::setGlobalThreads(1);
+    FloatLogisticRegression serial = fitLogisticRegression(x, labels, 3,
+                                                           options);
+    ThreadPool::setGlobalThreads(4);
+    FloatLogisticRegression parallel = fitLogisticRegression(x, labels, 3,
+                                                             options);
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    EXPECT_GT(accuracy(serial, x, labels), 0.8);
+    for (int c = 0; c < 3; c++) {
+        EXPECT_EQ(serial.intercepts().at(c), parallel.intercepts().at(c));
+        for (int j = 0; j < 8; j++) {
+            EXPECT_EQ(serial.weights().at(c, j), parallel.weights().at(c, j));
+        }
+    }
+}
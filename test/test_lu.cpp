@@ -0,0 +1,136 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/lu.h"
+#include "ml/thread_pool.h"
+#include "test/test_helpers.h"
+
+#include <math.h>
+
+#include <stdexcept>
+
+// Diagonally dominant, so well conditioned, but with off-diagonal
+// elements large enough that the pivot order changes.
+template <class T>
+static BasicMatrix<T> testMatrix(int n) {
+    BasicMatrix<T> a = patternMatrix<T>(n, n, 37, 11, 19, -9, 1 / 9.0);
+    for (int i = 0; i < n; i++) {
+        a.at(i, i) += T(n / 4 + 1);
+    }
+    return a;
+}
+
+TEST(ML_LU, Solves_With_Pivoting) {
+    // Arrange
+    Matrix a(3, 3);
+    a.at(0, 1) = 1;
+    a.at(0, 2) = 2;
+    a.at(1, 0) = 3;
+    a.at(1, 2) = 1;
+    a.at(2, 0) = 1;
+    a.at(2, 1) = 4;
+    Vector x(3);
+    x.at(0) = 1;
+    x.at(1) = -2;
+    x.at(2) = 3;
+    Vector b = a * x;
+
+    // Act
+    Lu lu(a);
+    Vector solved = lu.solve(b);
+
+    // Assert
+    EXPECT_EQ(1, lu.pivots()[0]);
+    EXPECT_NEAR(25.0, lu.determinant(), 1e-12);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_NEAR(x.at(i), solved.at(i), 1e-12);
+    }
+}
+
+TEST(ML_LU, Blocked_Factors_Reproduce_Matrix) {
+    // Arrange
+    const int kDims = 203;
+    Matrix a = testMatrix<double>(kDims);
+
+    // Act
+    Lu lu(a);
+
+    // Assert
+    Matrix l = Matrix::identity(kDims);
+    Matrix u(kDims, kDims);
+    for (int i = 0; i < kDims; i++) {
+        for (int j = 0; j < kDims; j++) {
+            (j < i ? l : u).at(i, j) = lu.factors().at(i, j);
+        }
+    }
+    Matrix pa = a;
+    for (int i = 0; i < kDims; i++) {
+        for (int j = 0; j < kDims; j++) {
+            std::swap(pa.at(i, j), pa.at(lu.pivots()[i], j));
+        }
+    }
+    EXPECT_LT(maxDifference(pa, Matrix(l * u)), 1e-10);
+}
+
+TEST(ML_LU, Inverse_And_Multiple_Right_Hand_Sides) {
+    // Arrange
+    const int kDims = 150;
+    Matrix a = testMatrix<double>(kDims);
+    FloatMatrix floatA = testMatrix<float>(kDims);
+    Matrix x(7, kDims);
+    for (int i = 0; i < kDims; i++) {
+        for (int j = 0; j < 7; j++) {
+            x.at(i, j) = (i + j) % 5 - 2.0;
+        }
+    }
+
+    // Act
+    Matrix inv = inverse(a);
+    Matrix solved = solve(a, Matrix(a * x));
+    FloatMatrix floatInv = inverse(floatA);
+
+    // Assert
+    EXPECT_LT(maxDifference(Matrix(a * inv), Matrix::identity(kDims)),
+              1e-12);
+    EXPECT_LT(maxDifference(solved, x), 1e-12);
+    EXPECT_LT(maxDifference(FloatMatrix(floatA * floatInv),
+                            FloatMatrix::identity(kDims)), 1e-5);
+}
+
+TEST(ML_LU, Singular_Matrix_Throws) {
+    // Arrange
+    Matrix a = testMatrix<double>(70);
+    for (int j = 0; j < a.cols(); j++) {
+        a.at(69, j) = a.at(3, j) + 2 * a.at(10, j);
+    }
+    Matrix zero(5, 5);
+
+    // Act
+    Lu lu(zero);
+
+    // Assert
+    EXPECT_TRUE(lu.singular());
+    EXPECT_EQ(0.0, lu.determinant());
+    EXPECT_THROW(lu.solve(Vector(5, 1.0)), std::runtime_error);
+    EXPECT_THROW(inverse(zero), std::runtime_error);
+    EXPECT_NEAR(0.0, determinant(a) / determinant(testMatrix<double>(70)),
+                1e-10);
+}
+
+TEST(ML_LU, Parallel_Matches_Serial) {
+    // Arrange
+    Matrix a = testMatrix<double>(300);
+    Vector b(300, 1.0);
+    ThreadPool::setGlobalThreads(1);
+    Vector serial = solve(a, b);
+
+    // Act
+    ThreadPool::setGlobalThreads(4);
+    Vector parallel = solve(a, b);
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    for (int i = 0; i < b.dims(); i++) {
+        EXPECT_NEAR(serial.at(i), parallel.at(i), 1e-12);
+    }
+}
@@ -0,0 +1,181 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/mapped_matrix.h"
+#include "ml/serialization.h"
+#include "test/test_helpers.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+static std::string tempPath(const std::string& name) {
+    const char* dir = getenv("TMPDIR");
+    char pid[32];
+    snprintf(pid, sizeof(pid), "%d", static_cast<int>(getpid()));
+    return std::string(dir != NULL ? dir : "/tmp") + "/ml-lib-" + pid +
+           "-" + name;
+}
+
+TEST(ML_MAPPED_MATRIX, Write_Then_Map_Round_Trips) {
+    // Arrange
+    std::string path = tempPath("round-trip.mat");
+    Matrix mat = patternMatrix<double>(7, 5, 3, 7, 23, -11, 0.5);
+    writeMatrixFile(path, mat);
+
+    // Act
+    Matrix mapped = mapMatrixFile(path);
+
+    // Assert
+    EXPECT_EQ(5, mapped.rows());
+    EXPECT_EQ(7, mapped.cols());
+    EXPECT_TRUE(mapped == mat);
+    EXPECT_TRUE(mapped * Matrix::identity(7) == mat);
+    remove(path.c_str());
+}
+
+TEST(ML_MAPPED_MATRIX, Copy_On_Write_Leaves_File_Untouched) {
+    // Arrange
+    std::string path = tempPath("cow.mat");
+    Matrix mat = patternMatrix<double>(3, 4, 3, 7, 23, -11, 0.5);
+    writeMatrixFile(path, mat);
+
+    // Act
+    {
+        Matrix mapped = mapMatrixFile(path, kMapCopyOnWrite);
+        mapped.at(2, 1) = 100.0;
+        mapped *= 2.0;
+        EXPECT_DOUBLE_EQ(200.0, mapped.at(2, 1));
+    }
+    Matrix reread = mapMatrixFile(path);
+
+    // Assert
+    EXPECT_TRUE(reread == mat);
+    remove(path.c_str());
+}
+
+TEST(ML_MAPPED_MATRIX, Shared_Writes_Reach_The_File) {
+    // Arrange
+    std::string path = tempPath("shared.mat");
+
+    // Act
+    {
+        Matrix created = createMatrixFile(path, 6, 2);
+        EXPECT_TRUE(created == Matrix(6, 2));
+        created = patternMatrix<double>(6, 2, 3, 7, 23, -11, 0.5);
+        Matrix copy = created;
+        copy.at(0, 0) = -1.0;
+    }
+    Matrix reread = mapMatrixFile(path, kMapShared);
+
+    // Assert
+    EXPECT_TRUE(reread == patternMatrix<double>(6, 2, 3, 7, 23, -11, 0.5));
+    remove(path.c_str());
+}
+
+static Matrix readMatrixFile(const std::string& path) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    return readMatrix(&in);
+}
+
+TEST(ML_MAPPED_MATRIX, Shared_Writes_Can_Be_Read_Back) {
+    // Arrange
+    std::string written = tempPath("modified.mat");
+    std::string streamed = tempPath("modified-checksum.mat");
+    writeMatrixFile(written, patternMatrix<double>(4, 3, 3, 7, 23, -11, 0.5));
+    {
+        std::ofstream out(streamed.c_str(), std::ios::binary);
+        writeMatrix(&out, patternMatrix<double>(4, 3, 3, 7, 23, -11, 0.5));
+    }
+    Matrix expected = patternMatrix<double>(4, 3, 3, 7, 23, -11, 0.5);
+    expected.at(1, 2) = 42.0;
+
+    // Act
+    {
+        Matrix first = mapMatrixFile(written, kMapShared);
+        first.at(1, 2) = 42.0;
+        Matrix second = mapMatrixFile(streamed, kMapShared);
+        second.at(1, 2) = 42.0;
+    }
+
+    // Assert
+    EXPECT_TRUE(readMatrixFile(written) == expected);
+    EXPECT_TRUE(readMatrixFile(streamed) == expected);
+    remove(written.c_str());
+    remove(streamed.c_str());
+}
+
+TEST(ML_MAPPED_MATRIX, Rejects_Sizes_That_Wrap) {
+    // Arrange: rows * cols * 8 is 2^64 + 537552, so the file would seem
+    // to hold the whole payload.
+    std::string path = tempPath("wrapping.mat");
+    writeMatrixFile(path, patternMatrix<double>(1, 1, 3, 7, 23, -11, 0.5));
+    std::string bytes;
+    {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+    }
+    uint64_t rows = 1073764994, cols = 2147437309;
+    memcpy(&bytes[16], &rows, sizeof(rows));
+    memcpy(&bytes[24], &cols, sizeof(cols));
+    bytes.resize(64 + 537552 + 8);
+    {
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size());
+    }
+
+    // Act & Assert
+    EXPECT_THROW(mapMatrixFile(path), std::runtime_error);
+    EXPECT_THROW(readMatrixFile(path), std::runtime_error);
+    remove(path.c_str());
+}
+
+TEST(ML_MAPPED_MATRIX, Views_Reach_Past_2_31_Elements) {
+    // Arrange: 2^31 + 2^16 elements in a sparse file; only the pages
+    // touched below are ever written.
+    const int kCols = 32769;
+    const int kRows = 65536;
+    std::string path = tempPath("large.mat");
+    {
+        Matrix mat = createMatrixFile(path, kCols, kRows);
+        mat.at(kRows - 1, 0) = 1.0;
+        mat.at(kRows - 1, kCols - 1) = 2.0;
+
+        // Act
+        VectorView last = mat.row(kRows - 1);
+        VectorView column = mat.col(kCols - 1);
+        MatrixView corner = mat.block(kRows - 2, kCols - 2, 2, 2);
+        MatrixView transposed = mat.transposed();
+
+        // Assert
+        EXPECT_EQ(&mat.at(kRows - 1, 0), last.ptr());
+        EXPECT_EQ(2.0, last.at(kCols - 1));
+        EXPECT_EQ(&mat.at(kRows - 1, kCols - 1), &column.at(kRows - 1));
+        EXPECT_EQ(&mat.at(kRows - 1, kCols - 1), &corner.at(1, 1));
+        EXPECT_EQ(1.0, transposed.at(0, kRows - 1));
+    }
+    remove(path.c_str());
+}
+
+TEST(ML_MAPPED_MATRIX, Rejects_Foreign_And_Missing_Files) {
+    // Arrange
+    std::string path = tempPath("foreign.mat");
+    FILE* file = fopen(path.c_str(), "wb");
+    ASSERT_TRUE(file != NULL);
+    fputs("definitely not a matrix file, but long enough for a header..",
+          file);
+    fclose(file);
+
+    // Act & Assert
+    EXPECT_THROW(mapMatrixFile(path), std::runtime_error);
+    remove(path.c_str());
+    EXPECT_THROW(mapMatrixFile(path), std::runtime_error);
+}
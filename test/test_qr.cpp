@@ -0,0 +1,99 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/qr.h"
+#include "ml/thread_pool.h"
+#include "test/test_helpers.h"
+
+#include <math.h>
+
+#include <stdexcept>
+
+TEST(ML_QR, Factors_Are_Orthogonal_And_Triangular) {
+    const int kShapes[][2] = {{1, 1}, {5, 3}, {40, 40}, {300, 70}};
+    for (const int* shape : kShapes) {
+        // Arrange
+        Matrix a = waveMatrix<double>(shape[1], shape[0], 2);
+
+        // Act
+        Qr qr(a);
+        Matrix q = qr.q();
+        Matrix r = qr.r();
+
+        // Assert
+        int n = shape[1];
+        EXPECT_LT(maxDifference(Matrix(q * r), a), 1e-12);
+        EXPECT_LT(orthogonalityError(q), 1e-12);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < i; j++) {
+                EXPECT_EQ(0.0, r.at(i, j));
+            }
+        }
+    }
+}
+
+TEST(ML_QR, Solves_Least_Squares) {
+    // Arrange
+    Matrix a = waveMatrix<double>(45, 200, 2);
+    Vector b(200);
+    for (int i = 0; i < b.dims(); i++) {
+        b.at(i) = cos(i * 0.1);
+    }
+    Matrix ata = Matrix(a.transposed()) * a;
+
+    // Act
+    Vector x = lstsq(a, b, kLstsqHouseholder);
+    Vector residual = a * x - b;
+
+    // Assert: the residual is orthogonal to the columns of A.
+    Vector normal = residual * a;
+    for (int j = 0; j < normal.dims(); j++) {
+        EXPECT_NEAR(0.0, normal.at(j), 1e-10 * ata.at(j, j));
+    }
+}
+
+TEST(ML_QR, Tsqr_Matches_Householder) {
+    // Arrange
+    Matrix a = waveMatrix<double>(30, 20000, 2);
+    Matrix b(2, 20000);
+    for (int i = 0; i < b.rows(); i++) {
+        double noise = 1e-4 * ((i * 7919) % 101 - 50);
+        b.at(i, 0) = a.at(i, 3) - 2 * a.at(i, 17) + noise;
+        b.at(i, 1) = cos(i * 0.001);
+    }
+    ThreadPool::setGlobalThreads(4);
+
+    // Act
+    Matrix tsqr = lstsq(a, b, kLstsqTsqr);
+    Matrix automatic = lstsq(a, b);
+    ThreadPool::setGlobalThreads(0);
+    Matrix householder = lstsq(a, b, kLstsqHouseholder);
+
+    // Assert
+    EXPECT_LT(maxDifference(tsqr, householder), 1e-10);
+    EXPECT_EQ(0.0, maxDifference(tsqr, automatic));
+    EXPECT_NEAR(-2.0, tsqr.at(17, 0), 1e-3);
+}
+
+TEST(ML_QR, Float_And_Rank_Deficient) {
+    // Arrange
+    FloatMatrix a = waveMatrix<float>(8, 50, 2);
+    FloatVector x(8, 1.0f);
+    FloatVector b = a * x;
+    Matrix deficient(3, 10);
+    for (int i = 0; i < 10; i++) {
+        deficient.at(i, 0) = i;
+        deficient.at(i, 1) = 2 * i;
+        deficient.at(i, 2) = 1;
+    }
+
+    // Act
+    FloatVector solved = lstsq(a, b);
+
+    // Assert
+    for (int i = 0; i < 8; i++) {
+        EXPECT_NEAR(1.0f, solved.at(i), 1e-4);
+    }
+    EXPECT_TRUE(Qr(deficient).rankDeficient());
+    EXPECT_THROW(lstsq(deficient, Vector(10, 1.0)), std::runtime_error);
+}
@@ -0,0 +1,125 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/regression.h"
+#include "ml/thread_pool.h"
+#include "test/test_helpers.h"
+
+#include <math.h>
+
+#include <stdexcept>
+
+// y = w . x + 3 for w = (1, -2, 3, ...), plus noise of the given size.
+template <class T>
+static BasicVector<T> regressionTargets(const BasicMatrix<T>& x, double noise) {
+    BasicVector<T> y(x.rows());
+    for (int i = 0; i < x.rows(); i++) {
+        double sum = 3 + noise * ((i * 7919) % 101 - 50) / 50.0;
+        for (int j = 0; j < x.cols(); j++) {
+            sum += (j % 2 ? -1 : 1) * (j + 1) * x.at(i, j);
+        }
+        y.at(i) = T(sum);
+    }
+    return y;
+}
+
+TEST(ML_REGRESSION, Closed_Form_Recovers_Weights) {
+    // Arrange
+    Matrix x = waveMatrix<double>(6, 500);
+    Vector y = regressionTargets(x, 0.0);
+
+    // Act
+    LinearRegression model = fitLinearRegression(x, y);
+    LinearRegression ridge = fitLinearRegression(x, y, 0.1);
+    LinearRegression origin = fitLinearRegression(x, y, 0.0, false);
+
+    // Assert
+    EXPECT_NEAR(3.0, model.intercept(), 1e-10);
+    for (int j = 0; j < 6; j++) {
+        EXPECT_NEAR((j % 2 ? -1 : 1) * (j + 1), model.weights().at(j), 1e-10);
+        EXPECT_LT(fabs(ridge.weights().at(j)), fabs(model.weights().at(j)));
+    }
+    EXPECT_EQ(0.0, origin.intercept());
+    Vector predicted = model.predict(x);
+    for (int i = 0; i < 500; i++) {
+        EXPECT_NEAR(y.at(i), predicted.at(i), 1e-10);
+    }
+    Vector sample(6);
+    for (int j = 0; j < 6; j++) {
+        sample.at(j) = x.at(17, j);
+    }
+    EXPECT_NEAR(y.at(17), model.predict(sample), 1e-10);
+}
+
+TEST(ML_REGRESSION, Ridge_Handles_Wide_Data) {
+    // Arrange: 40 features, 10 samples.
+    Matrix x = waveMatrix<double>(40, 10);
+    Vector y = regressionTargets(x, 0.0);
+
+    // Act
+    LinearRegression ridge = fitLinearRegression(x, y, 1e-3);
+
+    // Assert
+    EXPECT_THROW(fitLinearRegression(x, y), std::runtime_error);
+    Vector predicted = ridge.predict(x);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_NEAR(y.at(i), predicted.at(i), 0.5);
+    }
+}
+
+TEST(ML_REGRESSION, Sgd_Converges_To_Closed_Form) {
+    // Arrange
+    Matrix x = waveMatrix<double>(8, 4000);
+    Vector y = regressionTargets(x, 0.1);
+    LinearRegression exact = fitLinearRegression(x, y);
+    SgdOptions options;
+    options.batchSize = 32;
+    options.learningRate = 0.1;
+    options.shards = 1;
+    SgdRegression sequential(8, options);
+    options.shards = 4;
+    SgdRegression sharded(8, options);
+
+    // Act
+    sequential.fit(x, y, 40);
+    sharded.fit(x, y, 40);
+
+    // Assert
+    EXPECT_EQ(40 * 125, sequential.steps());
+    EXPECT_EQ(40 * 32, sharded.steps());
+    EXPECT_NEAR(exact.intercept(), sequential.model().intercept(), 0.02);
+    EXPECT_NEAR(exact.intercept(), sharded.model().intercept(), 0.02);
+    for (int j = 0; j < 8; j++) {
+        EXPECT_NEAR(exact.weights().at(j), sequential.model().weights().at(j),
+                    0.05) << j;
+        EXPECT_NEAR(exact.weights().at(j), sharded.model().weights().at(j),
+                    0.05) << j;
+    }
+}
+
+TEST(ML_REGRESSION, Float_And_Threads_Agree) {
+    // Arrange
+    FloatMatrix x = waveMatrix<float>(5, 1000);
+    FloatVector y = regressionTargets(x, 0.0);
+    SgdOptions options;
+    options.shards = 3;
+    options.decay = 0.01;
+    options.l2 = 1e-4;
+    FloatSgdRegression serial(5, options), parallel(5, options);
+
+    // Act
+    FloatLinearRegression exact = fitLinearRegression(x, y, 1e-4f);
+    ThreadPool::setGlobalThreads(1);
+    serial.fit(x, y, 5);
+    ThreadPool::setGlobalThreads(4);
+    parallel.fit(x, y, 5);
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    EXPECT_NEAR(3.0f, exact.intercept(), 1e-3);
+    EXPECT_EQ(serial.model().intercept(), parallel.model().intercept());
+    for (int j = 0; j < 5; j++) {
+        EXPECT_EQ(serial.model().weights().at(j),
+                  parallel.model().weights().at(j));
+    }
+}
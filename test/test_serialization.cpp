@@ -0,0 +1,155 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/serialization.h"
+#include "test/test_helpers.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+TEST(ML_SERIALIZATION, Matrix_And_Vector_Round_Trip) {
+    // Arrange
+    Matrix mat = patternMatrix<double>(5, 9, 5, 3, 13, -6, 0.75);
+    Vector vec(4);
+    vec.at(0) = 1.5;
+    vec.at(3) = -2.0;
+    std::stringstream stream;
+
+    // Act
+    writeMatrix(&stream, mat);
+    writeVector(&stream, vec, false);
+    Matrix matCopy = readMatrix(&stream);
+    Vector vecCopy = readVector(&stream);
+
+    // Assert
+    EXPECT_TRUE(matCopy == mat);
+    EXPECT_TRUE(vecCopy == vec);
+}
+
+TEST(ML_SERIALIZATION, Streams_Row_Chunks) {
+    // Arrange
+    Matrix mat = patternMatrix<double>(6, 10, 5, 3, 13, -6, 0.75);
+    std::stringstream stream;
+
+    // Act
+    MatrixWriter writer(&stream, 4, 10);
+    writer.writeRows(mat.block(0, 1, 3, 4));
+    writer.writeRows(mat.block(3, 1, 7, 4).transposed().transposed());
+    writer.finish();
+
+    MatrixReader reader(&stream);
+    Matrix head(4, 6);
+    Matrix tail(10, 4);
+    reader.readRows(head.view());
+    int left = reader.rowsLeft();
+    reader.readRows(tail.block(0, 2, 4, 4).transposed().transposed());
+
+    // Assert
+    EXPECT_EQ(10, writer.rowsWritten());
+    EXPECT_TRUE(reader.checksummed());
+    EXPECT_EQ(4, left);
+    EXPECT_EQ(0, reader.rowsLeft());
+    EXPECT_TRUE(head == mat.block(0, 1, 6, 4));
+    EXPECT_TRUE(tail.block(0, 2, 4, 4) == mat.block(6, 1, 4, 4));
+}
+
+TEST(ML_SERIALIZATION, Reads_Other_Byte_Order) {
+    // Arrange
+    Matrix mat = patternMatrix<double>(3, 2, 5, 3, 13, -6, 0.75);
+    std::stringstream stream;
+    writeMatrix(&stream, mat, false);
+    std::string bytes = stream.str();
+
+    // Byte-swap every multi-byte field as the other kind of host would
+    // have written it.
+    bytes[14] = bytes[14] == 0 ? 1 : 0;
+    std::reverse(bytes.begin() + 8, bytes.begin() + 12);
+    for (size_t offset = 16; offset < 40; offset += 8) {
+        std::reverse(bytes.begin() + offset, bytes.begin() + offset + 8);
+    }
+    for (size_t offset = 64; offset < bytes.size(); offset += 8) {
+        std::reverse(bytes.begin() + offset, bytes.begin() + offset + 8);
+    }
+    std::stringstream foreign(bytes);
+
+    // Act
+    Matrix copy = readMatrix(&foreign);
+
+    // Assert
+    EXPECT_TRUE(copy == mat);
+}
+
+TEST(ML_SERIALIZATION, Rejects_Corrupt_Input) {
+    // Arrange
+    std::stringstream stream;
+    writeMatrix(&stream, patternMatrix<double>(4, 4, 5, 3, 13, -6, 0.75));
+    std::string bytes = stream.str();
+    std::string flipped = bytes;
+    flipped[64 + 5*8 + 3] ^= 0x10;
+    std::stringstream corrupt(flipped);
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 20));
+    std::stringstream foreign("this is not a serialized ml-lib matrix, "
+                              "just some text of sufficient length");
+
+    // Act & Assert
+    EXPECT_THROW(readMatrix(&corrupt), std::runtime_error);
+    EXPECT_THROW(readMatrix(&truncated), std::runtime_error);
+    EXPECT_THROW(readMatrix(&foreign), std::runtime_error);
+    std::stringstream matrix(bytes);
+    EXPECT_THROW(readVector(&matrix), std::runtime_error);
+}
+
+namespace {
+
+// A string that reads like a pipe: it cannot tell or seek positions.
+class PipeBuffer : public std::stringbuf {
+ public:
+    explicit PipeBuffer(const std::string& bytes) : std::stringbuf(bytes) {}
+
+ protected:
+    pos_type seekoff(off_type, std::ios::seekdir, std::ios::openmode) {
+        return pos_type(off_type(-1));
+    }
+    pos_type seekpos(pos_type, std::ios::openmode) {
+        return pos_type(off_type(-1));
+    }
+};
+
+}  // namespace
+
+TEST(ML_SERIALIZATION, Rejects_Oversized_Header) {
+    // Arrange: a 3 x 4 matrix whose header claims 2^31 - 1 rows or
+    // columns.
+    std::stringstream stream;
+    writeMatrix(&stream, patternMatrix<double>(4, 3, 5, 3, 13, -6, 0.75));
+    std::string manyRows = stream.str();
+    std::string manyCols = manyRows;
+    uint64_t huge = 2147483647, one = 1;
+    memcpy(&manyRows[16], &huge, sizeof(huge));
+    memcpy(&manyCols[16], &one, sizeof(one));
+    memcpy(&manyCols[24], &huge, sizeof(huge));
+    std::stringstream seekableRows(manyRows);
+    std::stringstream seekableCols(manyCols);
+    PipeBuffer pipeBuffer(manyRows);
+    std::istream pipe(&pipeBuffer);
+
+    // Act & Assert
+    EXPECT_THROW(readMatrix(&seekableRows), std::runtime_error);
+    EXPECT_THROW(readVector(&seekableCols), std::runtime_error);
+    EXPECT_THROW(readMatrix(&pipe), std::runtime_error);
+}
+
+TEST(ML_SERIALIZATION, Reports_Write_Failures) {
+    // Arrange
+    std::stringstream broken;
+    broken.setstate(std::ios::badbit);
+
+    // Act & Assert
+    EXPECT_THROW(MatrixWriter writer(&broken, 3, 2), std::runtime_error);
+    EXPECT_THROW(writeVector(&broken, Vector(3)), std::runtime_error);
+}
@@ -0,0 +1,152 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/sparse.h"
+#include "ml/thread_pool.h"
+
+#include <math.h>
+
+// cols x rows matrix with roughly one element in seven set.
+static Matrix sparseDense(int cols, int rows) {
+    Matrix mat(cols, rows);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            if ((i * 31 + j * 17) % 7 == 0) {
+                mat.at(i, j) = 1.0 + (i + 2 * j) % 5;
+            }
+        }
+    }
+    return mat;
+}
+
+TEST(ML_SPARSE, Coo_Sums_Duplicates_When_Compressed) {
+    // Arrange
+    CooMatrix coo(4, 3);
+    coo.add(2, 3, 1.0);
+    coo.add(0, 1, 2.0);
+    coo.add(2, 0, 3.0);
+    coo.add(2, 3, 4.0);
+
+    // Act
+    CsrMatrix csr(coo);
+    CscMatrix csc(coo);
+
+    // Assert
+    EXPECT_EQ(3u, csr.nonZeros());
+    EXPECT_EQ(3u, csc.nonZeros());
+    EXPECT_DOUBLE_EQ(5.0, csr.at(2, 3));
+    EXPECT_DOUBLE_EQ(0.0, csr.at(1, 1));
+    EXPECT_DOUBLE_EQ(3.0, csc.at(2, 0));
+    EXPECT_EQ(0, csr.colIndex()[1]);
+    EXPECT_EQ(3, csr.colIndex()[2]);
+    EXPECT_EQ(coo.toDense(), csr.toDense());
+    EXPECT_EQ(coo.toDense(), csc.toDense());
+}
+
+TEST(ML_SPARSE, Converts_Between_Formats) {
+    // Arrange
+    Matrix dense = sparseDense(23, 17);
+
+    // Act
+    CsrMatrix csr(dense);
+    CscMatrix csc(csr);
+    CsrMatrix back(csc);
+    CscMatrix fromDense(dense);
+
+    // Assert
+    EXPECT_EQ(dense, csr.toDense());
+    EXPECT_EQ(dense, csc.toDense());
+    EXPECT_EQ(dense, back.toDense());
+    EXPECT_EQ(csr.rowStart(), back.rowStart());
+    EXPECT_EQ(csc.colStart(), fromDense.colStart());
+    EXPECT_EQ(Matrix(dense.transposed()), csr.transposed().toDense());
+    EXPECT_LT(csr.nonZeros(), dense.size() / 5);
+}
+
+TEST(ML_SPARSE, SpMV_Matches_Dense_Product) {
+    // Arrange
+    Matrix dense = sparseDense(61, 45);
+    Matrix x(1, 61);
+    Vector xv(61);
+    for (int i = 0; i < 61; i++) {
+        xv.at(i) = x.at(i, 0) = sin(i);
+    }
+    Matrix expected = dense * x;
+
+    // Act
+    Vector csrY = CsrMatrix(dense) * xv;
+    Vector cscY = CscMatrix(dense) * xv;
+    CooMatrix coo(61, 45);
+    for (int i = 0; i < 45; i++) {
+        for (int j = 0; j < 61; j++) {
+            if (dense.at(i, j) != 0) {
+                coo.add(i, j, dense.at(i, j));
+            }
+        }
+    }
+    Vector cooY = coo * xv;
+
+    // Assert
+    for (int i = 0; i < 45; i++) {
+        EXPECT_NEAR(expected.at(i, 0), csrY.at(i), 1e-12);
+        EXPECT_NEAR(expected.at(i, 0), cscY.at(i), 1e-12);
+        EXPECT_NEAR(expected.at(i, 0), cooY.at(i), 1e-12);
+    }
+}
+
+TEST(ML_SPARSE, SpMM_Matches_Dense_Product) {
+    // Arrange
+    Matrix dense = sparseDense(37, 29);
+    Matrix b(19, 37);
+    for (int i = 0; i < b.rows(); i++) {
+        for (int j = 0; j < b.cols(); j++) {
+            b.at(i, j) = cos(0.3 * i + j);
+        }
+    }
+    Matrix expected = dense * b;
+
+    // Act
+    Matrix csrC = CsrMatrix(dense) * b;
+    Matrix cscC = CscMatrix(dense) * b;
+    FloatMatrix floatC = BasicCsrMatrix<float>(elementCast<float>(dense)) *
+                         FloatMatrix(elementCast<float>(b));
+
+    // Assert
+    for (int i = 0; i < expected.rows(); i++) {
+        for (int j = 0; j < expected.cols(); j++) {
+            EXPECT_NEAR(expected.at(i, j), csrC.at(i, j), 1e-12);
+            EXPECT_NEAR(expected.at(i, j), cscC.at(i, j), 1e-12);
+            EXPECT_NEAR(expected.at(i, j), floatC.at(i, j), 1e-4);
+        }
+    }
+}
+
+TEST(ML_SPARSE, Parallel_Products_Match_Serial) {
+    // Arrange
+    Matrix dense = sparseDense(700, 600);
+    Matrix b(300, 700, 0.5);
+    Vector x(700, 0.25);
+    CsrMatrix csr(dense);
+    CscMatrix csc(dense);
+    ThreadPool::setGlobalThreads(1);
+    Vector serialCsrY = csr * x;
+    Vector serialCscY = csc * x;
+    Matrix serialCsrC = csr * b;
+    Matrix serialCscC = csc * b;
+
+    // Act
+    ThreadPool::setGlobalThreads(4);
+    Vector csrY = csr * x;
+    Vector cscY = csc * x;
+    Matrix csrC = csr * b;
+    Matrix cscC = csc * b;
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    EXPECT_EQ(serialCsrY, csrY);
+    EXPECT_EQ(serialCsrC, csrC);
+    EXPECT_EQ(serialCscC, cscC);
+    for (int i = 0; i < 600; i++) {
+        EXPECT_NEAR(serialCscY.at(i), cscY.at(i), 1e-12);
+    }
+}
@@ -0,0 +1,158 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/svd.h"
+#include "ml/thread_pool.h"
+#include "test/test_helpers.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+// Largest element of |U diag(s) V^T - A| over the leading columns of U
+// and V.
+template <class T>
+static double reconstructionError(const BasicMatrix<T>& a,
+                                  const BasicSvd<T>& svd) {
+    int p = svd.singularValues().dims();
+    BasicMatrix<T> us = svd.u().block(0, 0, a.rows(), p);
+    for (int i = 0; i < us.rows(); i++) {
+        for (int j = 0; j < p; j++) {
+            us.at(i, j) *= svd.singularValues().at(j);
+        }
+    }
+    BasicMatrix<T> vt = svd.v().block(0, 0, a.cols(), p).transposed();
+    BasicMatrix<T> product = us * vt;
+    double largest = 0;
+    for (int i = 0; i < a.rows(); i++) {
+        for (int j = 0; j < a.cols(); j++) {
+            largest = fmax(largest, fabs(product.at(i, j) - a.at(i, j)));
+        }
+    }
+    return largest;
+}
+
+TEST(ML_SVD, Thin_Svd_Reconstructs_Matrices) {
+    const int kShapes[][2] = {{1, 1}, {7, 3}, {3, 7}, {60, 60}, {200, 50},
+                              {50, 201}};
+    for (const int* shape : kShapes) {
+        // Arrange
+        Matrix a = waveMatrix<double>(shape[1], shape[0], 1);
+        int p = std::min(shape[0], shape[1]);
+
+        // Act
+        Svd svd(a);
+
+        // Assert
+        ASSERT_EQ(p, svd.singularValues().dims());
+        ASSERT_EQ(p, svd.u().cols());
+        ASSERT_EQ(p, svd.v().cols());
+        EXPECT_LT(reconstructionError(a, svd), 1e-12 * shape[0]) << shape[0];
+        EXPECT_LT(orthogonalityError(svd.u()), 1e-13 * shape[0]);
+        EXPECT_LT(orthogonalityError(svd.v()), 1e-13 * shape[1]);
+        for (int i = 1; i < p; i++) {
+            EXPECT_GE(svd.singularValues().at(i - 1),
+                      svd.singularValues().at(i));
+        }
+    }
+}
+
+TEST(ML_SVD, Full_Svd_Of_Rank_Deficient_Matrix) {
+    // Arrange: rank 3.
+    Matrix left = waveMatrix<double>(3, 30, 1);
+    Matrix right = waveMatrix<double>(10, 3, 1);
+    Matrix a = left * right;
+    Matrix zero(4, 6);
+
+    // Act
+    Svd svd(a, kSvdFull);
+    Svd zeroSvd(zero, kSvdFull);
+    Svd valuesOnly(a, kSvdNone);
+
+    // Assert
+    EXPECT_EQ(30, svd.u().cols());
+    EXPECT_EQ(10, svd.v().cols());
+    EXPECT_LT(orthogonalityError(svd.u()), 1e-13);
+    EXPECT_LT(orthogonalityError(svd.v()), 1e-13);
+    EXPECT_LT(reconstructionError(a, svd), 1e-12);
+    EXPECT_GT(svd.singularValues().at(2), 1.0);
+    EXPECT_LT(svd.singularValues().at(3), 1e-12);
+    EXPECT_LT(orthogonalityError(zeroSvd.u()), 1e-15);
+    EXPECT_LT(orthogonalityError(zeroSvd.v()), 1e-15);
+    EXPECT_EQ(0.0, zeroSvd.singularValues().at(0));
+    EXPECT_EQ(0, valuesOnly.u().rows());
+    for (int i = 0; i < 10; i++) {
+        EXPECT_NEAR(svd.singularValues().at(i),
+                    valuesOnly.singularValues().at(i), 1e-12);
+    }
+}
+
+TEST(ML_SVD, Randomized_Svd_Finds_Top_Components) {
+    // Arrange: five strong directions plus small noise, dense and CSR.
+    const int kRank = 5;
+    Matrix a = waveMatrix<double>(kRank, 2000, 1) *
+               waveMatrix<double>(300, kRank, 1);
+    for (int i = 0; i < a.rows(); i++) {
+        for (int j = 0; j < a.cols(); j++) {
+            a.at(i, j) += 1e-3 * ((i * 31 + j * 7) % 13 - 6);
+        }
+    }
+    CsrMatrix sparse(a);
+    ThreadPool::setGlobalThreads(4);
+
+    // Act
+    Svd exact(a, kSvdNone);
+    Svd dense = randomizedSvd(a, kRank);
+    Svd fromSparse = randomizedSvd(sparse, kRank);
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    ASSERT_EQ(kRank, dense.singularValues().dims());
+    EXPECT_EQ(2000, dense.u().rows());
+    EXPECT_EQ(300, dense.v().rows());
+    EXPECT_LT(orthogonalityError(dense.u()), 1e-13);
+    EXPECT_LT(orthogonalityError(dense.v()), 1e-13);
+    for (int i = 0; i < kRank; i++) {
+        double expected = exact.singularValues().at(i);
+        EXPECT_NEAR(expected, dense.singularValues().at(i), 1e-9 * expected);
+        EXPECT_NEAR(expected, fromSparse.singularValues().at(i),
+                    1e-9 * expected);
+    }
+}
+
+TEST(ML_SVD, Rejects_Non_Finite_Elements) {
+    // Arrange
+    Matrix withNan = waveMatrix<double>(8, 20, 1);
+    withNan.at(13, 2) = NAN;
+    FloatMatrix withInf = waveMatrix<float>(20, 8, 1);
+    withInf.at(0, 19) = INFINITY;
+
+    // Act & Assert
+    EXPECT_THROW(Svd svd(withNan), std::runtime_error);
+    EXPECT_THROW(Svd(withNan, kSvdNone), std::runtime_error);
+    EXPECT_THROW(FloatSvd svd(withInf), std::runtime_error);
+    EXPECT_THROW(randomizedSvd(withNan, 3), std::runtime_error);
+}
+
+TEST(ML_SVD, Float_And_Threads_Agree) {
+    // Arrange
+    FloatMatrix a = waveMatrix<float>(40, 90, 1);
+    Matrix b = waveMatrix<double>(120, 120, 1);
+
+    // Act
+    FloatSvd svd(a);
+    ThreadPool::setGlobalThreads(4);
+    Svd parallel(b);
+    ThreadPool::setGlobalThreads(1);
+    Svd serial(b);
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    EXPECT_LT(reconstructionError(a, svd), 1e-4);
+    EXPECT_LT(orthogonalityError(svd.u()), 1e-5);
+    for (int i = 0; i < 120; i++) {
+        EXPECT_EQ(serial.singularValues().at(i),
+                  parallel.singularValues().at(i));
+    }
+}
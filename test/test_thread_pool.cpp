@@ -0,0 +1,105 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/thread_pool.h"
+#include "ml/linear_algebra.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <stdexcept>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+using std::vector;
+
+TEST(ML_THREAD_POOL, Parallel_For_Visits_Every_Index_Once) {
+    // Arrange
+    ThreadPool pool(4);
+    int count = 1000;
+    vector<std::atomic<int> > visits(count);
+    for (int i = 0; i < count; i++) {
+        visits[i] = 0;
+    }
+
+    // Act
+    pool.parallelFor(count, [&visits](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            visits[i]++;
+        }
+    }, 7);
+
+    // Assert
+    EXPECT_EQ(4, pool.threads());
+    for (int i = 0; i < count; i++) {
+        EXPECT_EQ(1, visits[i].load());
+    }
+}
+
+TEST(ML_THREAD_POOL, Can_Nest_Parallel_Loops) {
+    // Arrange
+    ThreadPool pool(3);
+    std::atomic<int> total(0);
+
+    // Act
+    pool.parallelFor(16, [&pool, &total](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            pool.parallelFor(100, [&total](int b, int e) {
+                total += e - b;
+            });
+        }
+    });
+
+    // Assert
+    EXPECT_EQ(1600, total.load());
+}
+
+TEST(ML_THREAD_POOL, Rethrows_First_Exception_After_All_Chunks) {
+    // Arrange
+    ThreadPool pool(4);
+    std::atomic<int> running(0);
+    std::atomic<int> total(0);
+
+    // Act
+    EXPECT_THROW(pool.parallelFor(64, [&running](int begin, int end) {
+        running++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        running--;
+        if (begin <= 10 && 10 < end) {
+            throw std::runtime_error("chunk failed");
+        }
+    }), std::runtime_error);
+    int stillRunning = running.load();
+    pool.parallelFor(1000, [&total](int begin, int end) {
+        total += end - begin;
+    });
+
+    // Assert
+    EXPECT_EQ(0, stillRunning);
+    EXPECT_EQ(1000, total.load());
+}
+
+TEST(ML_THREAD_POOL, Parallel_Matrix_Multiply_Matches_Serial) {
+    // Arrange
+    Matrix a(300, 257);
+    Matrix b(190, 300);
+    for (int i = 0; i < a.rows(); i++) {
+        for (int j = 0; j < a.cols(); j++) {
+            a.at(i, j) = (i + 2*j) % 9 - 4;
+        }
+    }
+    for (int i = 0; i < b.rows(); i++) {
+        for (int j = 0; j < b.cols(); j++) {
+            b.at(i, j) = (3*i + j) % 7 - 3;
+        }
+    }
+    ThreadPool::setGlobalThreads(1);
+    Matrix serial = a*b;
+
+    // Act
+    ThreadPool::setGlobalThreads(4);
+    Matrix parallel = a*b;
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    EXPECT_EQ(serial, parallel);
+}
@@ -0,0 +1,119 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/linear_algebra.h"
+#include "ml/thread_pool.h"
+#include "test/test_helpers.h"
+
+template <class T>
+static bool isTransposeOf(const BasicMatrix<T>& t, const BasicMatrix<T>& mat) {
+    if (t.rows() != mat.cols() || t.cols() != mat.rows()) {
+        return false;
+    }
+    for (int i = 0; i < mat.rows(); i++) {
+        for (int j = 0; j < mat.cols(); j++) {
+            if (!(t.at(j, i) == mat.at(i, j))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+TEST(ML_TRANSPOSE, Copies_Transposed_Views) {
+    const int kSizes[] = {1, 3, 4, 8, 31, 33, 70, 129};
+    for (int rows : kSizes) {
+        for (int cols : kSizes) {
+            // Arrange
+            Matrix mat = patternMatrix<double>(cols, rows, 13, 5, 100);
+            FloatMatrix floatMat = patternMatrix<float>(cols, rows, 13, 5, 100);
+            Int8Matrix int8Mat = patternMatrix<int8_t>(cols, rows, 13, 5, 100);
+
+            // Act
+            Matrix t = mat.transposed();
+            FloatMatrix floatT = floatMat.transposed();
+            Int8Matrix int8T = int8Mat.transposed();
+
+            // Assert
+            ASSERT_TRUE(isTransposeOf(t, mat)) << rows << "x" << cols;
+            ASSERT_TRUE(isTransposeOf(floatT, floatMat))
+                << rows << "x" << cols;
+            ASSERT_TRUE(isTransposeOf(int8T, int8Mat))
+                << rows << "x" << cols;
+        }
+    }
+}
+
+TEST(ML_TRANSPOSE, Copies_Blocks) {
+    // Arrange
+    Matrix mat = patternMatrix<double>(50, 40, 13, 5, 100);
+
+    // Act
+    Matrix block = mat.block(3, 5, 20, 30);
+    Matrix blockT = mat.block(3, 5, 20, 30).transposed();
+
+    // Assert
+    ASSERT_EQ(20, block.rows());
+    EXPECT_EQ(mat.at(3, 5), block.at(0, 0));
+    EXPECT_EQ(mat.at(22, 34), block.at(19, 29));
+    EXPECT_TRUE(isTransposeOf(blockT, block));
+}
+
+TEST(ML_TRANSPOSE, Transposes_In_Place) {
+    const int kShapes[][2] = {{1, 7}, {5, 5}, {64, 64}, {67, 67},
+                              {3, 8}, {40, 13}, {100, 37}, {300, 257}};
+    for (const int* shape : kShapes) {
+        // Arrange
+        Matrix mat = patternMatrix<double>(shape[1], shape[0], 13, 5, 100);
+        Matrix assigned = mat;
+        BFloat16Matrix bf16 = patternMatrix<BFloat16>(shape[1], shape[0], 13,
+                                                      5, 100);
+        BFloat16Matrix bf16Original = bf16;
+        const double* buffer = mat.ptr();
+
+        // Act
+        Matrix original = mat;
+        mat.transposeInPlace();
+        assigned = assigned.transposed();
+        bf16.transposeInPlace();
+
+        // Assert
+        EXPECT_EQ(buffer, mat.ptr());
+        EXPECT_TRUE(isTransposeOf(mat, original));
+        EXPECT_EQ(mat, assigned);
+        EXPECT_TRUE(isTransposeOf(bf16, bf16Original));
+    }
+}
+
+TEST(ML_TRANSPOSE, Assigns_Overlapping_View) {
+    // Arrange
+    Matrix mat = patternMatrix<double>(6, 6, 13, 5, 100);
+    Matrix expected = mat.block(1, 1, 3, 4).transposed();
+
+    // Act
+    mat = mat.block(1, 1, 3, 4).transposed();
+
+    // Assert
+    EXPECT_EQ(expected, mat);
+}
+
+TEST(ML_TRANSPOSE, Parallel_Matches_Serial) {
+    // Arrange
+    FloatMatrix mat = patternMatrix<float>(700, 513, 13, 5, 100);
+    FloatMatrix square = patternMatrix<float>(600, 600, 13, 5, 100);
+    ThreadPool::setGlobalThreads(1);
+    FloatMatrix serial = mat.transposed();
+    FloatMatrix serialSquare = square;
+    serialSquare.transposeInPlace();
+
+    // Act
+    ThreadPool::setGlobalThreads(4);
+    FloatMatrix parallel = mat.transposed();
+    square.transposeInPlace();
+    ThreadPool::setGlobalThreads(0);
+
+    // Assert
+    EXPECT_EQ(serial, parallel);
+    EXPECT_EQ(serialSquare, square);
+    EXPECT_TRUE(isTransposeOf(parallel, mat));
+}
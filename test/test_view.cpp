@@ -0,0 +1,92 @@
+// Copyright 2016 Dolotov Evgeniy
+
+#include <gtest/gtest.h>
+#include "ml/linear_algebra.h"
+#include "test/test_helpers.h"
+
+#include <math.h>
+
+TEST(ML_VIEW, Row_And_Col_Alias_Matrix) {
+    // Arrange
+    Matrix mat = patternMatrix<double>(4, 3, 10, 1, 1000);
+
+    // Act
+    VectorView row = mat.row(1);
+    VectorView col = mat.col(2);
+    row.at(0) = -1.0;
+
+    // Assert
+    EXPECT_EQ(4, row.dims());
+    EXPECT_EQ(3, col.dims());
+    EXPECT_DOUBLE_EQ(-1.0, mat.at(1, 0));
+    EXPECT_DOUBLE_EQ(13.0, row.at(3));
+    EXPECT_DOUBLE_EQ(22.0, col.at(2));
+    EXPECT_EQ(&mat.at(1, 0), row.ptr());
+}
+
+TEST(ML_VIEW, Can_Do_Arithmetic_And_Dot_On_Views) {
+    // Arrange
+    Matrix mat = patternMatrix<double>(3, 3, 10, 1, 1000);
+    const Matrix& constMat = mat;
+
+    // Act
+    Vector sum = constMat.row(0) + 2.0*constMat.col(1);
+    double rowDot = dot(mat.row(1), mat.row(2));
+    double colDot = dot(mat.col(0), mat.row(0));
+    double mixedDot = dot(Vector(3, 1.0), mat.col(2));
+
+    // Assert
+    EXPECT_EQ(3, sum.dims());
+    for (int i = 0; i < 3; i++) {
+        EXPECT_DOUBLE_EQ(mat.at(0, i) + 2.0*mat.at(i, 1), sum.at(i));
+    }
+    EXPECT_DOUBLE_EQ(10*20 + 11*21 + 12*22, rowDot);
+    EXPECT_DOUBLE_EQ(0*0 + 10*1 + 20*2, colDot);
+    EXPECT_DOUBLE_EQ(2 + 12 + 22, mixedDot);
+    EXPECT_DOUBLE_EQ(sqrt(1.0 + 4.0), mat.block(0, 0, 1, 3).row(0).length());
+}
+
+TEST(ML_VIEW, Can_Write_Through_Views) {
+    // Arrange
+    Matrix mat = patternMatrix<double>(3, 2, 10, 1, 1000);
+    Matrix expected = patternMatrix<double>(3, 2, 10, 1, 1000);
+    expected.at(0, 0) += 2*expected.at(1, 0);
+    expected.at(0, 1) += 2*expected.at(1, 1);
+    expected.at(0, 2) += 2*expected.at(1, 2);
+
+    // Act
+    mat.row(0) += 2.0*mat.row(1);
+    mat.col(0) *= 1.0;
+
+    // Assert
+    EXPECT_EQ(expected, mat);
+
+    mat.row(1) = mat.row(0);
+    EXPECT_TRUE(mat.row(0) == mat.row(1));
+}
+
+TEST(ML_VIEW, Block_And_Transposed_Views) {
+    // Arrange
+    Matrix mat = patternMatrix<double>(4, 4, 10, 1, 1000);
+
+    // Act
+    ConstMatrixView block = mat.block(1, 2, 2, 2);
+    Matrix transposed = mat.transposed();
+    Matrix blockTransposed = mat.block(0, 1, 2, 3).transposed();
+    mat.block(2, 0, 2, 2) = Matrix(2, 2, 7.0);
+
+    // Assert
+    EXPECT_EQ(2, block.rows());
+    EXPECT_DOUBLE_EQ(12.0, block.at(0, 0));
+    EXPECT_DOUBLE_EQ(23.0, block.at(1, 1));
+    EXPECT_EQ(3, blockTransposed.rows());
+    EXPECT_EQ(2, blockTransposed.cols());
+    EXPECT_DOUBLE_EQ(13.0, blockTransposed.at(2, 1));
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            EXPECT_DOUBLE_EQ(10*j + i, transposed.at(i, j));
+        }
+    }
+    EXPECT_DOUBLE_EQ(7.0, mat.at(3, 1));
+    EXPECT_DOUBLE_EQ(32.0, mat.at(3, 2));
+}